@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Copyright 2016-2017 cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Benchmark and check of the batch GCC engine (#rmcat::GccBatchEngine)
+ * against one #rmcat::GccController per flow.
+ *
+ * Every frame period, each flow sends one frame through its own synthetic
+ * bottleneck (a FIFO whose capacity drops to a quarter of the nominal one
+ * halfway through the run), and gets the feedback of the frame right away.
+ * The same send and feedback calls go to the flow's GccController and to
+ * its GccBatchController. The controllers of all the flows are fed first,
+ * then the engine is flushed and their rates are read, so the engine
+ * processes the frames of all the flows in one batch.
+ *
+ * The GccController's rate drives the bottleneck, so that both see the
+ * same input. After every frame, the output of the delay-based detector
+ * (offset, threshold, hypothesis) of both must match. The rates are only
+ * reported: GccController's also follow the loss-based controller.
+ *
+ * Reports the wall-clock time per frame of both, and the number of
+ * mismatches; the exit code is 1 if there are any.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/gcc-controller.h"
+#include "ns3/gcc-batch-engine.h"
+#include "ns3/sim-perf-record.h"
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+const uint32_t BENCH_DEFAULT_CAPACITY =  1000000;  // in bps: 1Mbps per flow
+const uint32_t BENCH_DEFAULT_RINIT    =   500000;  // in bps: 500Kbps
+const uint32_t BENCH_DEFAULT_RMIN     =   150000;  // in bps: 150Kbps
+const uint32_t BENCH_DEFAULT_RMAX     = 10000000;  // in bps: 10Mbps
+const uint32_t BENCH_DEFAULT_PDELAY   =       50;  // in ms:  50ms
+const uint32_t BENCH_DEFAULT_FPS      =       30;
+const double BENCH_MAX_DETECTOR_DIFF  =     1e-6;  // in ms
+
+using namespace ns3;
+
+typedef std::chrono::steady_clock WallClock;
+
+static void DiscardLog (const std::string& log) {}
+
+/* Last output of a GccController's overuse detector */
+class DetectorRecord : public rmcat::GccObserver
+{
+public:
+    DetectorRecord () : offsetMs{0.}, thresholdMs{0.}, hypothesis{'N'}, updated{false} {}
+    virtual void onDetectorUpdate (double offset, double threshold, char hyp)
+    {
+        offsetMs = offset;
+        thresholdMs = threshold;
+        hypothesis = hyp;
+        updated = true;
+    }
+    virtual void onRateControlUpdate (char state, char region) {}
+    virtual void onLossFraction (float lossFraction) {}
+
+    double offsetMs;
+    double thresholdMs;
+    char hypothesis;
+    bool updated;
+};
+
+/* One flow: its bottleneck, and the two controllers fed with it */
+struct BenchFlow {
+    double capacityBps;
+    double queueFreeUs;         // when the bottleneck is done with the last frame
+    uint64_t lastSendUs;
+    uint64_t lastArrivalUs;
+    uint32_t lastSize;
+    uint16_t refSequence;
+    uint16_t batchSequence;
+    std::minstd_rand jitter;
+    std::shared_ptr<rmcat::GccController> ref;
+    std::shared_ptr<rmcat::GccBatchController> batch;
+    DetectorRecord detector;
+};
+
+struct BenchStats {
+    uint64_t frames;
+    uint64_t checked;
+    uint64_t mismatches;
+    double maxDetectorDiff;
+    double sumRateDiff;
+    WallClock::duration refWall;
+    WallClock::duration batchWall;
+};
+
+static std::vector<BenchFlow> s_flows;
+static std::shared_ptr<rmcat::GccBatchEngine> s_engine;
+static BenchStats s_stats;
+static uint64_t s_framePeriodUs;
+static double s_capacityDropTime;
+static double s_capacityAfterDrop;
+
+/*
+ * Send one frame of every flow through its bottleneck. Returns, per flow,
+ * the frame size, send and arrival times
+ */
+static void SendFrames (uint64_t nowUs,
+                        std::vector<uint32_t>& sizes,
+                        std::vector<uint64_t>& arrivalsUs)
+{
+    for (size_t i = 0; i < s_flows.size (); ++i) {
+        BenchFlow& flow = s_flows[i];
+        if (Simulator::Now ().GetSeconds () >= s_capacityDropTime) {
+            flow.capacityBps = std::min (flow.capacityBps, s_capacityAfterDrop);
+        }
+        const uint32_t size = std::max<uint32_t> (
+            flow.ref->getSendBps () / (8 * BENCH_DEFAULT_FPS), 100);
+        const double startUs = std::max (double (nowUs), flow.queueFreeUs);
+        flow.queueFreeUs = startUs + size * 8. * 1e6 / flow.capacityBps;
+        std::uniform_int_distribution<int> jitterUs (0, 1000);
+        const uint64_t arrivalUs = std::max<uint64_t> (
+            uint64_t (flow.queueFreeUs) + BENCH_DEFAULT_PDELAY * 1000 + jitterUs (flow.jitter),
+            flow.lastArrivalUs);
+        sizes[i] = size;
+        arrivalsUs[i] = arrivalUs;
+    }
+}
+
+static void FeedController (rmcat::SenderBasedController& controller,
+                            uint16_t& sequence,
+                            const BenchFlow& flow,
+                            uint64_t nowUs,
+                            uint32_t size,
+                            uint64_t arrivalUs)
+{
+    controller.processSendPacket (nowUs, sequence, size);
+    controller.processFeedback (nowUs, sequence, arrivalUs,
+                                arrivalUs - flow.lastArrivalUs,
+                                nowUs - flow.lastSendUs,
+                                int64_t (arrivalUs - flow.lastArrivalUs) -
+                                int64_t (nowUs - flow.lastSendUs),
+                                int (size) - int (flow.lastSize),
+                                int64_t (arrivalUs));
+    ++sequence;
+}
+
+static void CheckDetector (BenchFlow& flow)
+{
+    size_t index = 0;
+    if (!flow.detector.updated || !flow.batch->getFlow (index)) {
+        return;
+    }
+    flow.detector.updated = false;
+    const double diff = std::max (
+        std::fabs (flow.detector.offsetMs - s_engine->getModifiedOffset (index)),
+        std::fabs (flow.detector.thresholdMs - s_engine->getThreshold (index)));
+    s_stats.maxDetectorDiff = std::max (s_stats.maxDetectorDiff, diff);
+    ++s_stats.checked;
+    if (diff > BENCH_MAX_DETECTOR_DIFF ||
+        flow.detector.hypothesis != s_engine->getHypothesis (index)) {
+        if (s_stats.mismatches == 0) {
+            std::cout << "First mismatch at " << Simulator::Now ().GetSeconds ()
+                      << " s, flow " << index
+                      << ": offset " << flow.detector.offsetMs
+                      << " vs " << s_engine->getModifiedOffset (index)
+                      << ", threshold " << flow.detector.thresholdMs
+                      << " vs " << s_engine->getThreshold (index)
+                      << ", hypothesis " << flow.detector.hypothesis
+                      << " vs " << s_engine->getHypothesis (index) << std::endl;
+        }
+        ++s_stats.mismatches;
+    }
+}
+
+static void Tick (bool first)
+{
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    std::vector<uint32_t> sizes (s_flows.size ());
+    std::vector<uint64_t> arrivalsUs (s_flows.size ());
+    SendFrames (nowUs, sizes, arrivalsUs);
+
+    // Reference: one controller after the other
+    auto start = WallClock::now ();
+    for (size_t i = 0; i < s_flows.size (); ++i) {
+        BenchFlow& flow = s_flows[i];
+        FeedController (*flow.ref, flow.refSequence, flow, nowUs, sizes[i], arrivalsUs[i]);
+        flow.ref->getSendBps ();
+    }
+    s_stats.refWall += WallClock::now () - start;
+
+    // GccController configures itself with the first feedback: the engine
+    // starts with the second one, so that both see the same samples
+    if (!first) {
+        start = WallClock::now ();
+        for (size_t i = 0; i < s_flows.size (); ++i) {
+            BenchFlow& flow = s_flows[i];
+            FeedController (*flow.batch, flow.batchSequence, flow, nowUs, sizes[i], arrivalsUs[i]);
+        }
+        s_engine->flush ();
+        for (auto& flow : s_flows) {
+            flow.batch->getSendBps ();
+        }
+        s_stats.batchWall += WallClock::now () - start;
+
+        for (auto& flow : s_flows) {
+            CheckDetector (flow);
+            s_stats.sumRateDiff += std::fabs (double (flow.ref->getSendBps ()) -
+                                              double (flow.batch->getSendBps ()));
+        }
+        s_stats.frames += s_flows.size ();
+    }
+
+    for (size_t i = 0; i < s_flows.size (); ++i) {
+        s_flows[i].lastSendUs = nowUs;
+        s_flows[i].lastArrivalUs = arrivalsUs[i];
+        s_flows[i].lastSize = sizes[i];
+    }
+    Simulator::Schedule (MicroSeconds (s_framePeriodUs), &Tick, false);
+}
+
+int main (int argc, char *argv[])
+{
+    int nFlows = 20;
+    double duration = 30.;
+    uint32_t capacity = BENCH_DEFAULT_CAPACITY;
+    uint32_t seed = 1;
+    std::string perfFile = SimPerfRecord::GetDefaultFile ();
+
+    CommandLine cmd;
+    cmd.AddValue ("flows", "Number of GCC flows", nFlows);
+    cmd.AddValue ("duration", "Simulated time, in seconds", duration);
+    cmd.AddValue ("capacity", "Nominal bottleneck capacity per flow, in bps (a quarter of it midway)", capacity);
+    cmd.AddValue ("seed", "Seed of the arrival jitter", seed);
+    cmd.AddValue ("perffile", "File the performance record of the simulation is appended to", perfFile);
+    cmd.Parse (argc, argv);
+
+    NS_ASSERT (nFlows > 0);
+
+    s_framePeriodUs = 1000 * 1000 / BENCH_DEFAULT_FPS;
+    s_capacityDropTime = duration / 2.;
+    s_capacityAfterDrop = capacity / 4.;
+    s_stats = BenchStats{};
+    s_engine = std::make_shared<rmcat::GccBatchEngine> ();
+    s_flows.resize (nFlows);
+    for (int i = 0; i < nFlows; ++i) {
+        BenchFlow& flow = s_flows[i];
+        // Capacities from 50% to 125% of the nominal one
+        flow.capacityBps = capacity * (0.5 + 0.25 * (i % 4));
+        flow.queueFreeUs = 0.;
+        flow.lastSendUs = 0;
+        flow.lastArrivalUs = 0;
+        flow.lastSize = 0;
+        flow.refSequence = 1;
+        flow.batchSequence = 1;
+        flow.jitter.seed (seed + i);
+        flow.ref = std::make_shared<rmcat::GccController> ();
+        flow.batch = std::make_shared<rmcat::GccBatchController> (s_engine);
+        for (auto controller : {std::static_pointer_cast<rmcat::SenderBasedController> (flow.ref),
+                                std::static_pointer_cast<rmcat::SenderBasedController> (flow.batch)}) {
+            controller->setId (std::to_string (i));
+            controller->setInitBw (BENCH_DEFAULT_RINIT);
+            controller->setMinBw (BENCH_DEFAULT_RMIN);
+            controller->setMaxBw (BENCH_DEFAULT_RMAX);
+            controller->setLogCallback (DiscardLog);
+        }
+    }
+    // The flows' addresses are stable from here on
+    for (auto& flow : s_flows) {
+        flow.ref->setObserver (&flow.detector);
+    }
+
+    std::cout << "Running batch benchmark: " << nFlows << " flow(s), "
+              << capacity << " bps per flow, " << duration << " s" << std::endl;
+
+    SimPerfRecord perf;
+    Simulator::ScheduleNow (&Tick, true);
+    Simulator::Stop (Seconds (duration));
+    perf.Start ();
+    Simulator::Run ();
+    perf.Stop ();
+    perf.Append (perfFile, "gcc-batch-bench");
+    Simulator::Destroy ();
+
+    for (auto& flow : s_flows) {
+        flow.ref->setObserver (NULL);
+    }
+
+    const double frames = std::max<double> (s_stats.frames, 1.);
+    const double refNs = std::chrono::duration<double, std::nano> (s_stats.refWall).count ();
+    const double batchNs = std::chrono::duration<double, std::nano> (s_stats.batchWall).count ();
+    std::cout << "Frames per controller:      " << s_stats.frames << std::endl;
+    std::cout << "GccController, per frame:   " << refNs / frames << " ns" << std::endl;
+    std::cout << "Batch engine, per frame:    " << batchNs / frames << " ns" << std::endl;
+    std::cout << "Detector outputs checked:   " << s_stats.checked
+              << " (max diff " << s_stats.maxDetectorDiff << " ms)" << std::endl;
+    std::cout << "Detector mismatches:        " << s_stats.mismatches << std::endl;
+    std::cout << "Mean rate difference:       " << s_stats.sumRateDiff / frames
+              << " bps" << std::endl;
+
+    return s_stats.mismatches == 0 ? 0 : 1;
+}
@@ -29,9 +29,14 @@
  */
 
 #include "ns3/gcc-controller.h"
+#include "ns3/flow-state-exchange.h"
 #include "ns3/nada-controller.h"
+#include "ns3/dummy-controller.h"
 #include "ns3/gcc-sender.h"
 #include "ns3/gcc-receiver.h"
+#include "ns3/bottleneck-aqm.h"
+#include "ns3/sojourn-time-stats.h"
+#include "ns3/sim-perf-record.h"
 #include "ns3/rmcat-constants.h"
 #include "ns3/point-to-point-helper.h"
 #include "ns3/data-rate.h"
@@ -40,8 +45,10 @@
 #include "ns3/udp-client-server-helper.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/traffic-control-helper.h"
+#include "ns3/error-model.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/core-module.h"
+#include <sstream>
 
 // Maybe Ignore it 
 const uint32_t GCC_DEFAULT_RMIN  =  150000;  // in bps: 150Kbps
@@ -58,7 +65,10 @@ using namespace ns3;
 
 static NodeContainer BuildExampleTopo (uint64_t bps,
                                        uint32_t msDelay,
-                                       uint32_t msQdelay)
+                                       uint32_t msQdelay,
+                                       BottleneckAqm aqm,
+                                       double lossRate,
+                                       SojournTimeStats& stats)
 {
     NodeContainer nodes;
     nodes.Create (2);
@@ -67,9 +77,10 @@ static NodeContainer BuildExampleTopo (uint64_t bps,
     pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue  (DataRate (bps)));
     pointToPoint.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (msDelay)));
     auto bufSize = std::max<uint32_t> (DEFAULT_PACKET_SIZE, bps * msQdelay / 8000);
+    const uint32_t devBufSize = BottleneckAqmHelper::GetDeviceQueueBytes (aqm, bufSize);
     pointToPoint.SetQueue ("ns3::DropTailQueue",
                            "Mode", StringValue ("QUEUE_MODE_BYTES"),
-                           "MaxBytes", UintegerValue (bufSize));
+                           "MaxBytes", UintegerValue (devBufSize));
     NetDeviceContainer devices = pointToPoint.Install (nodes);
 
     InternetStackHelper stack;
@@ -81,9 +92,16 @@ static NodeContainer BuildExampleTopo (uint64_t bps,
     // Uncomment to capture simulated traffic
     // pointToPoint.EnablePcapAll ("rmcat-example");
 
-    // disable tc for now, some bug in ns3 causes extra delay
-    TrafficControlHelper tch;
-    tch.Uninstall (devices);
+    BottleneckAqmHelper::Install (devices, aqm, bufSize);
+    stats.Attach (devices.Get (0));
+
+    if (lossRate > 0.) {
+        // Random (e.g., wireless) losses on the forward path
+        Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel> ();
+        errorModel->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+        errorModel->SetRate (lossRate);
+        devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (errorModel));
+    }
 
     AsciiTraceHelper ascii;
     pointToPoint.EnableAsciiAll (ascii.CreateFileStream ("trace.tr"));
@@ -157,7 +175,65 @@ static void InstallUDP (Ptr<Node> sender,
     serverApps.Stop (Seconds (stopTime));
 }
 
+/* Simulcast layers (180p, 360p, 720p): minimum, target and maximum rates in bps */
+static const float LAYER_RATES[][3] = {
+    {  30000.f,  150000.f,  200000.f },
+    { 150000.f,  500000.f,  700000.f },
+    { 600000.f, 1700000.f, 2500000.f },
+};
+static const size_t MAX_LAYERS = sizeof (LAYER_RATES) / sizeof (LAYER_RATES[0]);
+
+/* Controller by name, for the shadow controllers; null if unknown */
+static std::shared_ptr<rmcat::SenderBasedController> CreateController (const std::string& name)
+{
+    if (name == "gcc") {
+        return std::make_shared<rmcat::GccController> ();
+    }
+    if (name == "nada") {
+        return std::make_shared<rmcat::NadaController> ();
+    }
+    if (name == "dummy") {
+        return std::make_shared<rmcat::DummyController> ();
+    }
+    return std::shared_ptr<rmcat::SenderBasedController>{};
+}
+
+/* Sinks of the GCC senders' trace sources, printed with their config path */
+static void TraceRate (std::string context, double oldValue, double newValue)
+{
+    std::cout << Simulator::Now ().GetMilliSeconds () << " " << context
+              << " " << newValue << std::endl;
+}
+
+static void TraceState (std::string context, char oldValue, char newValue)
+{
+    std::cout << Simulator::Now ().GetMilliSeconds () << " " << context
+              << " " << oldValue << " -> " << newValue << std::endl;
+}
+
+static void ConnectTraces ()
+{
+    const std::string path = "/NodeList/*/ApplicationList/*/$ns3::GccSender/";
+    Config::Connect (path + "TargetBitrate", MakeCallback (&TraceRate));
+    Config::Connect (path + "DetectorState", MakeCallback (&TraceState));
+    Config::Connect (path + "RateControlState", MakeCallback (&TraceState));
+}
+
 static void InstallApps (bool gcc,
+                         bool remb,
+                         bool ecn,
+                         bool nack,
+                         double fec,
+                         rmcat::FecMaskType fecMask,
+                         bool fecAdaptive,
+                         uint32_t layers,
+                         std::shared_ptr<rmcat::FlowStateExchange> fse,
+                         bool sharing,
+                         bool cwnd,
+                         uint32_t maxQDelayMs,
+                         bool shaping,
+                         double shapingSwitch,
+                         const std::vector<std::string>& shadows,
                          Ptr<Node> sender,
                          Ptr<Node> receiver,
                          uint16_t port,
@@ -178,13 +254,52 @@ static void InstallApps (bool gcc,
     Ptr<Ipv4> ipv4 = receiver->GetObject<Ipv4> ();
     Ipv4Address receiverIp = ipv4->GetAddress (1, 0).GetLocal ();
     sendApp->Setup (receiverIp, port); // initBw, minBw, maxBw);
+    if (fse) {
+        sendApp->SetFlowStateExchange (fse, 1.f);
+    }
+    for (const auto& name : shadows) {
+        sendApp->AddShadowController (CreateController (name), name);
+    }
+    if (ecn) {
+        sendApp->EnableEcn ();
+    }
+    if (nack) {
+        sendApp->EnableRtx ();
+    }
+    if (cwnd) {
+        sendApp->EnableCongestionWindow ();
+    }
+    sendApp->SetMaxQueueDelay (uint64_t (maxQDelayMs) * 1000);
+    sendApp->SetRateShaping (shaping);
+    if (shapingSwitch > 0.) {
+        Simulator::Schedule (Seconds (shapingSwitch), &GccSender::SetRateShaping,
+                             sendApp, !shaping);
+    }
+    if (fec > 0.) {
+        sendApp->EnableFec (fec, fecMask, fecAdaptive);
+    }
 
     const auto fps = 30.;		// Set Video Fps.
-    auto innerCodec = new syncodecs::StatisticsCodec{fps};
-    auto codec = new syncodecs::ShapedPacketizer{innerCodec, DEFAULT_PACKET_SIZE};
-    sendApp->SetCodec (std::shared_ptr<syncodecs::Codec>{codec});
+    // Not packetized: GccSender splits frames into packets itself
+    if (sharing) {
+        // Mostly idle, with bursts on content changes (application-limited)
+        sendApp->SetCodec (std::make_shared<syncodecs::SimpleContentSharingCodec> ());
+    } else {
+        auto codec = new syncodecs::StatisticsCodec{fps};
+        sendApp->SetCodec (std::shared_ptr<syncodecs::Codec>{codec});
+    }
+    for (uint32_t i = 0; i < layers; ++i) {
+        auto layerCodec = std::make_shared<syncodecs::StatisticsCodec> (fps);
+        sendApp->AddLayer (layerCodec, LAYER_RATES[i][0], LAYER_RATES[i][1], LAYER_RATES[i][2]);
+    }
 
     recvApp->Setup (port);
+    if (remb) {
+        recvApp->EnableRemoteEstimation (initBw, minBw, maxBw);
+    }
+    if (nack) {
+        recvApp->EnableNack ();
+    }
 
     sendApp->SetStartTime (Seconds (startTime));
     sendApp->SetStopTime (Seconds (stopTime));
@@ -202,6 +317,26 @@ int main (int argc, char *argv[])
 
     bool log = false;
     bool gcc = true;
+    bool remb = false;
+    bool ecn = false;
+    bool nack = false;
+    double fec = 0.;
+    std::string fecMaskName = "random";
+    bool fecAdaptive = true;
+    double lossRate = 0.;
+    uint32_t layers = 0;
+    bool coupled = false;
+    bool sharing = false;
+    bool cwnd = false;
+    uint32_t maxQDelayMs = 0;
+    bool shaping = false;
+    double shapingSwitch = 0.;
+    std::string shadowNames = "";
+    std::string gccConfig = "";
+    bool traces = false;
+    std::string perfFile = SimPerfRecord::GetDefaultFile ();
+    bool sbd = true;
+    std::string aqmName = "";
     
     std::string strArg  = "strArg default";
 
@@ -211,8 +346,63 @@ int main (int argc, char *argv[])
     cmd.AddValue ("udp",  "Number of UDP flows", nUdp);
     cmd.AddValue ("log", "Turn on logs", log);
     cmd.AddValue ("gcc", "true: use GCC, false: use dummy", gcc);   // Default is declared in rmcat-sender.cc
+    cmd.AddValue ("remb", "true: estimate at the receiver and send REMB, false: send per-packet feedback", remb);
+    cmd.AddValue ("ecn", "true: send ECN-capable packets (the bottleneck defaults to step marking), false: not ECN-capable", ecn);
+    cmd.AddValue ("nack", "true: retransmit lost packets requested with NACKs, false: no retransmissions", nack);
+    cmd.AddValue ("fec", "FEC protection ratio (FEC to media packets), the maximum one if adaptive; 0: no FEC", fec);
+    cmd.AddValue ("fecmask", "FEC mask: random (interleaved) or bursty (consecutive packets)", fecMaskName);
+    cmd.AddValue ("fecadaptive", "true: FEC protection follows the loss rate, false: fixed protection", fecAdaptive);
+    cmd.AddValue ("layers", "Number of simulcast layers (up to 3) sharing the target rate; 0: single encoding", layers);
+    cmd.AddValue ("fse", "true: couple the WebRTC flows of the sender with a flow state exchange, false: independent flows", coupled);
+    cmd.AddValue ("sbd", "true: group coupled flows with shared bottleneck detection, false: couple all of them", sbd);
+    cmd.AddValue ("sharing", "true: content sharing codec (application-limited), false: video codec", sharing);
+    cmd.AddValue ("cwnd", "true: bound the data in flight with a congestion window (pacer and encoder pushback), false: rate only", cwnd);
+    cmd.AddValue ("maxqdelay", "Maximum time (ms) packets wait in the sender's pacing queue (e.g., 500); 0: no limit", maxQDelayMs);
+    cmd.AddValue ("shaping", "true: shape the encoder and pacing rates with the pacing queue occupancy, false: both follow the target rate", shaping);
+    cmd.AddValue ("shapingswitch", "Time (s) at which rate shaping is switched the other way; 0: never", shapingSwitch);
+    cmd.AddValue ("shadow", "Comma-separated shadow controllers (gcc, nada, dummy) fed the same feedback as the primary one; estimates logged only", shadowNames);
+    cmd.AddValue ("gccconfig", "File of GCC controller parameters, one \"name value\" per line (see rmcat::GccConfig); empty: defaults", gccConfig);
+    cmd.AddValue ("traces", "true: print the target rate and the detector and rate control states of the GCC senders as they change, false: no traces", traces);
+    cmd.AddValue ("perffile", "File the performance record of the simulation is appended to", perfFile);
+    cmd.AddValue ("loss", "Random packet loss rate on the forward path", lossRate);
+    cmd.AddValue ("aqm", "Bottleneck queue: droptail, codel, fqcodel, pie, step or dualq", aqmName);
     cmd.Parse (argc, argv);
 
+    BottleneckAqm aqm = ecn ? AQM_STEP_MARKING : AQM_DROPTAIL;
+    if (!aqmName.empty () && !BottleneckAqmHelper::Parse (aqmName, aqm)) {
+        std::cerr << "Unknown AQM: " << aqmName << std::endl;
+        return 1;
+    }
+
+    rmcat::FecMaskType fecMask = rmcat::FEC_MASK_RANDOM;
+    if (fecMaskName == "bursty") {
+        fecMask = rmcat::FEC_MASK_BURSTY;
+    } else if (fecMaskName != "random") {
+        std::cerr << "Unknown FEC mask: " << fecMaskName << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> shadows{};
+    std::istringstream shadowStream{shadowNames};
+    std::string shadowName;
+    while (std::getline (shadowStream, shadowName, ',')) {
+        if (!CreateController (shadowName)) {
+            std::cerr << "Unknown shadow controller: " << shadowName << std::endl;
+            return 1;
+        }
+        shadows.push_back (shadowName);
+    }
+
+    rmcat::GccConfig gccConfigCheck;
+    if (!gccConfig.empty () && !gccConfigCheck.loadFile (gccConfig)) {
+        return 1;
+    }
+
+    if (layers > MAX_LAYERS) {
+        std::cerr << "Too many layers: " << layers << std::endl;
+        return 1;
+    }
+
     if (log) {
         LogComponentEnable ("GccSender", LOG_INFO);
         LogComponentEnable ("GccReceiver", LOG_INFO);
@@ -224,6 +414,9 @@ int main (int argc, char *argv[])
     Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));    // Tcp Type
     Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
 
+    // Applied by the senders to their GCC controllers
+    Config::SetDefault ("ns3::GccSender::GccConfigFile", StringValue (gccConfig));
+
     const uint64_t linkBw   = TOPO_DEFAULT_BW;
     const uint32_t msDelay  = TOPO_DEFAULT_PDELAY;
     const uint32_t msQDelay = TOPO_DEFAULT_QDELAY;
@@ -234,13 +427,21 @@ int main (int argc, char *argv[])
 
     const float endTime = 500.;
 
-    NodeContainer nodes = BuildExampleTopo (linkBw, msDelay, msQDelay);
+    SojournTimeStats stats;
+    NodeContainer nodes = BuildExampleTopo (linkBw, msDelay, msQDelay, aqm, lossRate, stats);
 
     int port = 8000;
+    // One flow state exchange per sender node
+    std::shared_ptr<rmcat::FlowStateExchange> fse{};
+    if (coupled) {
+        fse = std::make_shared<rmcat::FlowStateExchange> (sbd);
+    }
     for (int i = 0; i < nWebRTC; i++) {
         auto start = 10. * i;
         auto end = std::max (start + 1., endTime - start);
-        InstallApps (gcc, nodes.Get (0), nodes.Get (1), port++,
+        InstallApps (gcc, remb, ecn, nack, fec, fecMask, fecAdaptive, layers, fse, sharing, cwnd, maxQDelayMs,
+                     shaping, shapingSwitch, shadows,
+                     nodes.Get (0), nodes.Get (1), port++,
                      initBw, minBw, maxBw, start, end);
     }
 
@@ -260,10 +461,21 @@ int main (int argc, char *argv[])
         InstallUDP (nodes.Get (0), nodes.Get (1), port++,
                     bandwidth, pktSize, start, end);
     }
+
+    if (traces) {
+        ConnectTraces ();
+    }
    
     std::cout << "Running Simulation..." << std::endl;
     Simulator::Stop (Seconds (endTime));
+    SimPerfRecord perf;
+    perf.Start ();
     Simulator::Run ();
+    perf.Stop ();
+    perf.Print (std::cout, "gcc-example");
+    perf.Append (perfFile, "gcc-example");
+    std::cout << "Bottleneck (" << BottleneckAqmHelper::GetName (aqm) << ") ";
+    stats.Print (std::cout);
     Simulator::Destroy ();
     std::cout << "Done" << std::endl;
 
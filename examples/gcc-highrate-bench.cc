@@ -0,0 +1,201 @@
+/******************************************************************************
+ * Copyright 2016-2017 cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Benchmark of the GCC pipeline (sender, controller, receiver) with
+ * high-bitrate flows (e.g., 4K video or screen sharing at 20-50 Mbps):
+ *  - MTU-sized media packets
+ *  - Bitrate limits configured through the sender application
+ *  - Feedback batched by the receiver every feedback period
+ *
+ * Reports the simulator events processed per second of wall-clock time,
+ * and the wall-clock time spent per simulated second. The performance
+ * record of the run is appended to --perffile as well.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/gcc-controller.h"
+#include "ns3/gcc-sender.h"
+#include "ns3/gcc-receiver.h"
+#include "ns3/rmcat-constants.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/data-rate.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/sim-perf-record.h"
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+const uint32_t BENCH_DEFAULT_RATE   = 50000000;  // in bps: 50Mbps per flow
+const uint32_t BENCH_DEFAULT_RMIN   =  1000000;  // in bps: 1Mbps
+const uint32_t BENCH_DEFAULT_PDELAY =       20;  // in ms:  20ms
+const uint32_t BENCH_DEFAULT_QDELAY =      100;  // in ms: 100ms
+
+using namespace ns3;
+
+typedef std::chrono::steady_clock WallClock;
+
+static WallClock::time_point s_lastWall;
+static std::vector<double> s_wallPerSimSecond;
+
+static void SampleWallClock ()
+{
+    const auto now = WallClock::now ();
+    const std::chrono::duration<double> elapsed = now - s_lastWall;
+    s_wallPerSimSecond.push_back (elapsed.count ());
+    s_lastWall = now;
+    Simulator::Schedule (Seconds (1), &SampleWallClock);
+}
+
+static void DiscardLog (const std::string& log) {}
+
+static NodeContainer BuildBenchTopo (uint64_t bps,
+                                     uint32_t msDelay,
+                                     uint32_t msQdelay)
+{
+    NodeContainer nodes;
+    nodes.Create (2);
+
+    PointToPointHelper pointToPoint;
+    pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue  (DataRate (bps)));
+    pointToPoint.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (msDelay)));
+    auto bufSize = std::max<uint32_t> (DEFAULT_MTU, bps * msQdelay / 8000);
+    pointToPoint.SetQueue ("ns3::DropTailQueue",
+                           "Mode", StringValue ("QUEUE_MODE_BYTES"),
+                           "MaxBytes", UintegerValue (bufSize));
+    NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+    InternetStackHelper stack;
+    stack.Install (nodes);
+    Ipv4AddressHelper address;
+    address.SetBase ("10.1.1.0", "255.255.255.0");
+    address.Assign (devices);
+
+    // disable tc for now, some bug in ns3 causes extra delay
+    TrafficControlHelper tch;
+    tch.Uninstall (devices);
+
+    return nodes;
+}
+
+static void InstallApps (Ptr<Node> sender,
+                         Ptr<Node> receiver,
+                         uint16_t port,
+                         uint32_t packetSize,
+                         uint64_t feedbackPeriodUs,
+                         float initBw,
+                         float minBw,
+                         float maxBw,
+                         float startTime,
+                         float stopTime)
+{
+    Ptr<GccSender> sendApp = CreateObject<GccSender> ();
+    Ptr<GccReceiver> recvApp = CreateObject<GccReceiver> ();
+    sender->AddApplication (sendApp);
+    receiver->AddApplication (recvApp);
+
+    auto controller = std::make_shared<rmcat::GccController> ();
+    sendApp->SetController (controller);
+    sendApp->SetPacketSize (packetSize);
+    sendApp->SetCodecType (SYNCODEC_TYPE_PERFECT);
+
+    Ptr<Ipv4> ipv4 = receiver->GetObject<Ipv4> ();
+    Ipv4Address receiverIp = ipv4->GetAddress (1, 0).GetLocal ();
+    sendApp->Setup (receiverIp, port);
+    sendApp->SetRinit (initBw);
+    sendApp->SetRmin (minBw);
+    sendApp->SetRmax (maxBw);
+    // Keep console output out of the measurements
+    controller->setLogCallback (DiscardLog);
+
+    recvApp->Setup (port);
+    recvApp->SetFeedbackPeriod (feedbackPeriodUs);
+
+    sendApp->SetStartTime (Seconds (startTime));
+    sendApp->SetStopTime (Seconds (stopTime));
+
+    recvApp->SetStartTime (Seconds (startTime));
+    recvApp->SetStopTime (Seconds (stopTime));
+}
+
+int main (int argc, char *argv[])
+{
+    int nFlows = 1;
+    uint32_t rate = BENCH_DEFAULT_RATE;
+    uint32_t packetSize = MAX_PACKET_SIZE;
+    uint64_t feedbackPeriodUs = RMCAT_FEEDBACK_PERIOD_US;
+    double duration = 30.;
+    std::string perfFile = SimPerfRecord::GetDefaultFile ();
+
+    CommandLine cmd;
+    cmd.AddValue ("flows", "Number of GCC flows", nFlows);
+    cmd.AddValue ("rate", "Max (and initial) bitrate per flow, in bps", rate);
+    cmd.AddValue ("packetSize", "Media packet payload size, in bytes", packetSize);
+    cmd.AddValue ("feedbackPeriod", "Feedback period in us (0: per packet)", feedbackPeriodUs);
+    cmd.AddValue ("duration", "Simulated time, in seconds", duration);
+    cmd.AddValue ("perffile", "File the performance record of the simulation is appended to", perfFile);
+    cmd.Parse (argc, argv);
+
+    NS_ASSERT (nFlows > 0);
+    NS_ASSERT (packetSize <= MAX_PACKET_SIZE);
+
+    // Bottleneck leaves 20% headroom over the aggregate max bitrate
+    const uint64_t linkBw = uint64_t (rate) * nFlows * 6 / 5;
+    NodeContainer nodes = BuildBenchTopo (linkBw, BENCH_DEFAULT_PDELAY, BENCH_DEFAULT_QDELAY);
+
+    const float minBw = std::min (BENCH_DEFAULT_RMIN, rate);
+    int port = 8000;
+    for (int i = 0; i < nFlows; i++) {
+        InstallApps (nodes.Get (0), nodes.Get (1), port++, packetSize,
+                     feedbackPeriodUs, rate, minBw, rate, 0., duration);
+    }
+
+    std::cout << "Running benchmark: " << nFlows << " flow(s) at " << rate
+              << " bps, " << packetSize << "-byte packets, feedback every "
+              << feedbackPeriodUs << " us, " << duration << " s" << std::endl;
+
+    SimPerfRecord perf;
+    s_lastWall = WallClock::now ();
+    Simulator::Schedule (Seconds (1), &SampleWallClock);
+    Simulator::Stop (Seconds (duration));
+    perf.Start ();
+    Simulator::Run ();
+    perf.Stop ();
+    perf.Append (perfFile, "gcc-highrate-bench");
+    Simulator::Destroy ();
+
+    const uint64_t events = perf.GetEvents ();
+    const double wallTotal = perf.GetWallSeconds ();
+    const double maxWallPerSimSecond = s_wallPerSimSecond.empty () ? 0. :
+        *std::max_element (s_wallPerSimSecond.begin (), s_wallPerSimSecond.end ());
+    std::cout << "Events processed:           " << events << std::endl;
+    std::cout << "Wall-clock time:            " << wallTotal << " s" << std::endl;
+    std::cout << "Events per wall second:     " << events / wallTotal << std::endl;
+    std::cout << "Events per sim second:      " << events / duration << std::endl;
+    std::cout << "Wall time per sim second:   " << wallTotal / duration
+              << " s (max " << maxWallPerSimSecond << " s)" << std::endl;
+
+    return 0;
+}
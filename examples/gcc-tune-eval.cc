@@ -0,0 +1,257 @@
+/******************************************************************************
+ * Copyright 2016-2017 cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Single evaluation of a set of GCC parameters on one of the wired
+ * rmcat-eval-test scenarios, meant to be driven by tools/gcc_tune.py:
+ *  - 5.1: variable available capacity, one flow
+ *  - 5.2: variable available capacity, two flows
+ *  - 5.4: three competing flows
+ *  - 5.6: one flow competing with a long TCP flow
+ *
+ * The parameters (see #rmcat::GccConfig ) are read from a file
+ * (--config) and/or passed as a comma-separated list, e.g.,
+ * --params=k_up=0.01,k_down=0.04, which takes precedence.
+ * The outcome is printed as a single "tune_result" line with the
+ * utilization of the available capacity, the bottleneck queuing delay,
+ * the loss rate at the bottleneck and Jain's fairness index across flows.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/gcc-controller.h"
+#include "ns3/gcc-sender.h"
+#include "ns3/gcc-receiver.h"
+#include "ns3/wired-topo.h"
+#include "ns3/sim-perf-record.h"
+#include "ns3/packet-sink.h"
+#include "ns3/core-module.h"
+
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+const uint64_t TUNE_DEFAULT_BW     = 4 * (1u << 20);  // in bps: 4Mbps
+const uint32_t TUNE_DEFAULT_PDELAY =     50;          // in ms:   50ms
+const uint32_t TUNE_DEFAULT_QDELAY =    300;          // in ms:  300ms
+const uint32_t TUNE_RINIT = 150 * (1u << 10);         // in bps: 150Kbps
+const uint32_t TUNE_RMIN  = 150 * (1u << 10);         // in bps: 150Kbps
+const uint32_t TUNE_RMAX  = 1500 * (1u << 10);        // in bps: 1.5Mbps
+const uint32_t TUNE_CBR_PKTSIZE = 1000;
+const uint16_t TUNE_CBR_PORT = 4000;
+const uint16_t TUNE_TCP_PORT = 6000;
+const uint16_t TUNE_GCC_PORT = 8000;
+
+using namespace ns3;
+
+/** Description of one evaluation scenario */
+struct TuneScenario
+{
+    uint64_t capacity;              /**< physical bottleneck capacity, in bps */
+    uint32_t simTime;               /**< in seconds */
+    size_t numFlows;                /**< GCC flows */
+    std::vector<uint32_t> times;    /**< changes of the available capacity, in seconds */
+    std::vector<uint64_t> avail;    /**< available capacity, in bps */
+    uint32_t tcpStart;              /**< long TCP flow, if tcpStop > 0 */
+    uint32_t tcpStop;
+};
+
+static bool GetScenario (const std::string& name, TuneScenario& sc)
+{
+    sc.capacity = TUNE_DEFAULT_BW;
+    sc.simTime = 120;
+    sc.numFlows = 1;
+    sc.tcpStart = sc.tcpStop = 0;
+    if (name == "5.1") {
+        sc.times = {0, 40, 60, 80};
+        sc.avail = {1u << 20, 2500 * (1u << 10), 600 * (1u << 10), 1u << 20};
+    } else if (name == "5.2") {
+        sc.numFlows = 2;
+        sc.times = {0, 25, 50, 75, 100};
+        sc.avail = {4 * (1u << 20), 2 * (1u << 20), 3500 * (1u << 10),
+                    1 * (1u << 20), 2 * (1u << 20)};
+    } else if (name == "5.4") {
+        sc.capacity = 3600 * (1u << 10);
+        sc.numFlows = 3;
+    } else if (name == "5.6") {
+        sc.capacity = 2 * (1u << 20);
+        sc.simTime = 300;
+        sc.tcpStart = 60;
+        sc.tcpStop = 240;
+    } else {
+        return false;
+    }
+    if (sc.times.empty ()) {
+        sc.times.push_back (0);
+        sc.avail.push_back (sc.capacity);
+    }
+    return true;
+}
+
+static void DiscardLog (const std::string& log) {}
+
+/*
+ * Realize the time-varying available capacity with non-adaptive UDP
+ * background traffic, as the rmcat wired test cases do
+ */
+static void SetUpPath (WiredTopo& topo, const TuneScenario& sc)
+{
+    for (size_t i = 0; i < sc.times.size (); ++i) {
+        const uint64_t rate = sc.capacity - sc.avail[i];
+        if (rate > 0) {
+            const uint32_t endTime = (i < sc.times.size () - 1) ? sc.times[i + 1] : sc.simTime;
+            ApplicationContainer cbrApps = topo.InstallCBR (TUNE_CBR_PORT + i, rate,
+                                                            TUNE_CBR_PKTSIZE, true);
+            cbrApps.Get (0)->SetStartTime (Seconds (sc.times[i]));
+            cbrApps.Get (0)->SetStopTime (Seconds (endTime));
+        }
+    }
+}
+
+/* Capacity (in bits) the flows could have used, capped by their max bitrate */
+static double UsableBits (const TuneScenario& sc, double flowsMaxBps, double stopTime)
+{
+    double bits = 0.;
+    for (size_t i = 0; i < sc.times.size (); ++i) {
+        const double endTime = (i < sc.times.size () - 1) ? sc.times[i + 1] : stopTime;
+        const double duration = std::min (endTime, stopTime) - sc.times[i];
+        if (duration > 0.) {
+            bits += std::min (double (sc.avail[i]), flowsMaxBps) * duration;
+        }
+    }
+    return bits;
+}
+
+int main (int argc, char *argv[])
+{
+    std::string scenario = "5.1";
+    std::string configFile;
+    std::string params;
+    uint32_t seed = 1;
+    std::string perfFile = SimPerfRecord::GetDefaultFile ();
+
+    CommandLine cmd;
+    cmd.AddValue ("scenario", "rmcat wired scenario: 5.1, 5.2, 5.4 or 5.6", scenario);
+    cmd.AddValue ("config", "File of GCC parameters, one \"name value\" per line", configFile);
+    cmd.AddValue ("params", "GCC parameters, as name=value[,name=value...]", params);
+    cmd.AddValue ("seed", "Run number of the random number generator", seed);
+    cmd.AddValue ("perffile", "File the performance record of the simulation is appended to", perfFile);
+    cmd.Parse (argc, argv);
+
+    TuneScenario sc;
+    if (!GetScenario (scenario, sc)) {
+        std::cerr << "Unknown scenario: " << scenario << std::endl;
+        return 1;
+    }
+    rmcat::GccConfig config;
+    if ((!configFile.empty () && !config.loadFile (configFile)) || !config.parse (params)) {
+        return 1;
+    }
+    RngSeedManager::SetRun (seed);
+
+    Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
+    Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
+    Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (0));
+
+    WiredTopo topo;
+    topo.Build (sc.capacity, TUNE_DEFAULT_PDELAY, TUNE_DEFAULT_QDELAY);
+    SetUpPath (topo, sc);
+
+    const uint32_t stopTime = sc.simTime - 1;
+    std::vector<Ptr<GccReceiver> > gccRecv;
+    for (size_t i = 0; i < sc.numFlows; ++i) {
+        std::stringstream ss;
+        ss << "gcc_fwd_" << i;
+        ApplicationContainer apps = topo.InstallGCC (ss.str (), TUNE_GCC_PORT + (i * 2), 0, true);
+        Ptr<GccSender> send = DynamicCast<GccSender> (apps.Get (0));
+        gccRecv.push_back (DynamicCast<GccReceiver> (apps.Get (1)));
+
+        auto controller = std::make_shared<rmcat::GccController> (config);
+        controller->setId (ss.str ());
+        controller->setLogCallback (DiscardLog);
+        send->SetController (controller);
+        send->SetRinit (TUNE_RINIT);
+        send->SetRmin (TUNE_RMIN);
+        send->SetRmax (TUNE_RMAX);
+        send->SetStartTime (Seconds (0));
+        send->SetStopTime (Seconds (stopTime));
+        gccRecv.back ()->SetStartTime (Seconds (0));
+        gccRecv.back ()->SetStopTime (Seconds (stopTime));
+    }
+
+    Ptr<PacketSink> tcpSink;
+    if (sc.tcpStop > 0) {
+        ApplicationContainer apps = topo.InstallTCP ("tcp_0", TUNE_TCP_PORT, true);
+        apps.Get (0)->SetStartTime (Seconds (sc.tcpStart));
+        apps.Get (0)->SetStopTime (Seconds (sc.tcpStop));
+        tcpSink = DynamicCast<PacketSink> (apps.Get (1));
+    }
+
+    Simulator::Stop (Seconds (sc.simTime));
+    SimPerfRecord perf;
+    perf.Start ();
+    Simulator::Run ();
+    perf.Stop ();
+    perf.Append (perfFile, "gcc-tune-eval-" + scenario);
+
+    // Per-flow average rates, over the time each flow was active
+    std::vector<double> rates;
+    double rxBits = 0.;
+    for (const auto& recv : gccRecv) {
+        const double bits = recv->GetReceivedBytes () * 8.;
+        rxBits += bits;
+        rates.push_back (bits / stopTime);
+    }
+    double usable = UsableBits (sc, TUNE_RMAX * double (sc.numFlows), stopTime);
+    if (tcpSink) {
+        // The TCP flow is entitled to its share of the capacity as well
+        const double bits = tcpSink->GetTotalRx () * 8.;
+        rxBits += bits;
+        rates.push_back (bits / (sc.tcpStop - sc.tcpStart));
+        usable = double (sc.capacity) * stopTime;
+    }
+
+    double sum = 0.;
+    double sumSq = 0.;
+    for (const double rate : rates) {
+        sum += rate;
+        sumSq += rate * rate;
+    }
+    const double fairness = sumSq > 0. ? sum * sum / (rates.size () * sumSq) : 0.;
+    const SojournTimeStats& stats = topo.GetBottleneckStats ();
+    const uint64_t total = stats.GetCount () + stats.GetDrops ();
+
+    double latencyMs = 0.;
+    for (const auto& recv : gccRecv) {
+        latencyMs += recv->GetJitterBuffer ().getMeanLatencyMs () / gccRecv.size ();
+    }
+
+    std::cout << "tune_result scenario: " << scenario
+              << " util: " << (usable > 0. ? std::min (1., rxBits / usable) : 0.)
+              << " qdelay_mean_ms: " << stats.GetMean ().GetSeconds () * 1000.
+              << " qdelay_p95_ms: " << stats.GetPercentile (95.).GetSeconds () * 1000.
+              << " latency_ms: " << latencyMs
+              << " loss: " << (total > 0 ? double (stats.GetDrops ()) / total : 0.)
+              << " fairness: " << fairness
+              << std::endl;
+
+    Simulator::Destroy ();
+    return 0;
+}
@@ -33,6 +33,7 @@
 #include "ns3/gcc-sender.h"
 #include "ns3/gcc-receiver.h"
 #include "ns3/rmcat-constants.h"
+#include "ns3/sim-perf-record.h"
 #include "ns3/point-to-point-helper.h"
 #include "ns3/data-rate.h"
 #include "ns3/bulk-send-helper.h"
@@ -227,8 +228,8 @@ static void InstallApps (bool gcc,
     sendApp->Setup (receiverIp, port); // initBw, minBw, maxBw);
 
     const auto fps = 30.;		// Set Video Fps.
-    auto innerCodec = new syncodecs::StatisticsCodec{fps};
-    auto codec = new syncodecs::ShapedPacketizer{innerCodec, DEFAULT_PACKET_SIZE};
+    // Not packetized: GccSender splits frames into packets itself
+    auto codec = new syncodecs::StatisticsCodec{fps};
     sendApp->SetCodec (std::shared_ptr<syncodecs::Codec>{codec});
 
     recvApp->Setup (port);
@@ -293,6 +294,7 @@ int main (int argc, char *argv[])
 
     bool log = false;
     bool gcc = true;
+    std::string perfFile = SimPerfRecord::GetDefaultFile ();
 
     std::string strArg  = "strArg default";
 
@@ -303,6 +305,7 @@ int main (int argc, char *argv[])
     cmd.AddValue ("udp",  "Number of UDP flows", nUdp);
     cmd.AddValue ("log", "Turn on logs", log);
     cmd.AddValue ("gcc", "true: use GCC, false: use dummy", gcc);   // Default is declared in rmcat-sender.cc
+    cmd.AddValue ("perffile", "File the performance record of the simulation is appended to", perfFile);
     cmd.Parse (argc, argv);
 
     if (log) {
@@ -375,7 +378,12 @@ int main (int argc, char *argv[])
 
     std::cout << "Running Simulation..." << std::endl;
     Simulator::Stop (Seconds (endTime));
+    SimPerfRecord perf;
+    perf.Start ();
     Simulator::Run ();
+    perf.Stop ();
+    perf.Print (std::cout, "rmcat-simple-eval");
+    perf.Append (perfFile, "rmcat-simple-eval");
     Simulator::Destroy ();
     std::cout << "Done" << std::endl;
 
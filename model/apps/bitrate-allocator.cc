@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Layer bitrate allocation implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "bitrate-allocator.h"
+#include <algorithm>
+#include <cassert>
+
+namespace rmcat {
+
+static const float kEnableHysteresis = 1.2f;    /**< margin on the minimum rate to re-enable a layer */
+
+BitrateAllocator::BitrateAllocator() :
+    m_layers{},
+    m_activeUs{} {
+    reset();
+}
+
+BitrateAllocator::~BitrateAllocator() {}
+
+void BitrateAllocator::reset() {
+    m_layers.clear();
+    m_active = 0;
+    m_started = false;
+    m_lastUs = 0;
+    m_activeUs.clear();
+    m_switchesUp = 0;
+    m_switchesDown = 0;
+}
+
+void BitrateAllocator::addLayer(float minBps, float targetBps, float maxBps) {
+    assert(minBps <= targetBps);
+    assert(targetBps <= maxBps);
+    m_layers.push_back(Layer{minBps, targetBps, maxBps});
+    m_activeUs.push_back(0);
+    if (m_active == 0) {
+        m_active = 1; // base layer
+    }
+}
+
+size_t BitrateAllocator::getNumLayers() const {
+    return m_layers.size();
+}
+
+bool BitrateAllocator::allocate(uint64_t nowUs, float availableBps, std::vector<float>& layerBps) {
+    assert(!m_layers.empty());
+    if (m_started) {
+        assert(nowUs >= m_lastUs);
+        m_activeUs[m_active - 1] += nowUs - m_lastUs;
+    }
+    m_started = true;
+    m_lastUs = nowUs;
+
+    // Enable layers bottom-up while the rate left covers their minimum
+    size_t active = 1;
+    float lowerBps = 0.f; // target rates of the lower layers
+    for (size_t i = 1; i < m_layers.size(); ++i) {
+        lowerBps += m_layers[i - 1].targetBps;
+        const float factor = (i < m_active) ? 1.f : kEnableHysteresis;
+        if (availableBps < lowerBps + m_layers[i].minBps * factor) {
+            break;
+        }
+        active = i + 1;
+    }
+
+    layerBps.assign(m_layers.size(), 0.f);
+    float leftBps = availableBps;
+    for (size_t i = 0; i < active; ++i) {
+        const float capBps = (i + 1 == active) ? m_layers[i].maxBps : m_layers[i].targetBps;
+        layerBps[i] = std::max(0.f, std::min(leftBps, capBps));
+        leftBps -= layerBps[i];
+    }
+
+    const bool changed = active != m_active;
+    if (active > m_active) {
+        m_switchesUp += uint32_t(active - m_active);
+    } else if (active < m_active) {
+        m_switchesDown += uint32_t(m_active - active);
+    }
+    m_active = active;
+    return changed;
+}
+
+size_t BitrateAllocator::getActiveLayers() const {
+    return m_active;
+}
+
+uint32_t BitrateAllocator::getSwitchesUp() const {
+    return m_switchesUp;
+}
+
+uint32_t BitrateAllocator::getSwitchesDown() const {
+    return m_switchesDown;
+}
+
+void BitrateAllocator::print(uint64_t nowUs, std::ostream& os) const {
+    os << "layers:"
+       << " active: " << m_active << "/" << m_layers.size()
+       << " up: " << m_switchesUp
+       << " down: " << m_switchesDown
+       << " time(ms) per active layers:";
+    for (size_t i = 0; i < m_activeUs.size(); ++i) {
+        uint64_t us = m_activeUs[i];
+        if (m_started && i + 1 == m_active && nowUs > m_lastUs) {
+            us += nowUs - m_lastUs;
+        }
+        os << " " << us / 1000;
+    }
+}
+
+}
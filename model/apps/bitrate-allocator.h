@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Layer bitrate allocation interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef BITRATE_ALLOCATOR_H
+#define BITRATE_ALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Split of the sender's target rate among the layers of a layered
+ * (simulcast or scalable) encoding.
+ *
+ * Layers are ordered from the lowest (base) layer up. The base layer is
+ * always enabled; an upper layer is enabled when the rate left after
+ * giving every lower layer its target rate reaches the layer's minimum
+ * rate. To avoid layers flapping on and off, a disabled layer needs some
+ * extra margin on top of its minimum rate to be enabled again
+ * (hysteresis). Lower layers get their target rate, and the highest
+ * enabled layer gets the rest, up to its maximum rate.
+ *
+ * Layer switches and the time spent with each number of enabled layers are
+ * recorded, so as to evaluate how the layers follow the available rate.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class BitrateAllocator {
+public:
+    /** Class constructor */
+    BitrateAllocator();
+
+    /** Class destructor */
+    ~BitrateAllocator();
+
+    /** Remove all layers and forget the statistics */
+    void reset();
+
+    /**
+     * Add a layer on top of the existing ones
+     *
+     * @param [in] minBps Minimum rate the layer can be encoded at, in bps
+     * @param [in] targetBps Rate of the layer when upper layers are enabled
+     * @param [in] maxBps Rate the layer is capped at, in bps
+     */
+    void addLayer(float minBps, float targetBps, float maxBps);
+
+    /** Number of layers added */
+    size_t getNumLayers() const;
+
+    /**
+     * Split the available rate among the layers
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [in] availableBps Rate to split, in bps
+     * @param [out] layerBps Rate of every layer, 0 for the disabled ones
+     *
+     * @retval true if layers were enabled or disabled, false otherwise
+     */
+    bool allocate(uint64_t nowUs, float availableBps, std::vector<float>& layerBps);
+
+    /** Number of enabled layers after the last allocation */
+    size_t getActiveLayers() const;
+
+    uint32_t getSwitchesUp() const;     /**< times a layer was enabled */
+    uint32_t getSwitchesDown() const;   /**< times a layer was disabled */
+
+    /**
+     * Write a one-line summary of the statistics, with no line break
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(uint64_t nowUs, std::ostream& os) const;
+
+private:
+    struct Layer {
+        float minBps;
+        float targetBps;
+        float maxBps;
+    };
+
+    std::vector<Layer> m_layers;
+    size_t m_active;
+    bool m_started;
+    uint64_t m_lastUs;
+    std::vector<uint64_t> m_activeUs;   // time spent, by number of enabled layers - 1
+    uint32_t m_switchesUp;
+    uint32_t m_switchesDown;
+};
+
+}
+
+#endif /* BITRATE_ALLOCATOR_H */
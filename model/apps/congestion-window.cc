@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Congestion window pushback implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "congestion-window.h"
+#include <algorithm>
+#include <cassert>
+
+namespace rmcat {
+
+static const uint64_t kAdditionalWindowUs = 100 * 1000;  /**< window margin on top of the min RTT */
+static const uint32_t kMinWindowBytes = 2 * 1500;         /**< a couple of full packets */
+static const uint64_t kMaxInFlightUs = 1000 * 1000;      /**< packets forgotten beyond */
+static const double kMinPushbackRatio = 0.1;
+
+CongestionWindow::CongestionWindow() :
+    m_inFlight{} {
+    reset();
+}
+
+CongestionWindow::~CongestionWindow() {}
+
+void CongestionWindow::reset() {
+    m_inFlight.clear();
+    m_outstandingBytes = 0;
+    m_targetBps = 0.f;
+    m_minRttUs = 0;
+    m_pushbackRatio = 1.;
+    m_maxOutstandingBytes = 0;
+    m_congestedChecks = 0;
+}
+
+void CongestionWindow::setTargetRate(float bitrateBps) {
+    m_targetBps = bitrateBps;
+}
+
+void CongestionWindow::onPacketSent(uint64_t nowUs, uint64_t id, uint32_t size) {
+    m_inFlight.push_back(InFlight{id, nowUs, size});
+    m_outstandingBytes += size;
+    m_maxOutstandingBytes = std::max(m_maxOutstandingBytes, m_outstandingBytes);
+}
+
+void CongestionWindow::onPacketAcked(uint64_t nowUs, uint64_t id) {
+    while (!m_inFlight.empty() && m_inFlight.front().id <= id) {
+        if (m_inFlight.front().id == id) {
+            const uint64_t rttUs = nowUs - m_inFlight.front().sendUs;
+            if (m_minRttUs == 0 || rttUs < m_minRttUs) {
+                m_minRttUs = std::max<uint64_t>(rttUs, 1);
+            }
+        }
+        pop();
+    }
+}
+
+/* As WebRTC's CongestionWindowPushbackController */
+void CongestionWindow::updatePushback(uint32_t queuedBytes) {
+    const uint32_t window = getWindowBytes();
+    if (window == 0) {
+        return;
+    }
+    const double fillRatio = double(m_outstandingBytes + queuedBytes) / window;
+    if (fillRatio > 1.5) {
+        m_pushbackRatio *= 0.9;
+    } else if (fillRatio > 1.) {
+        m_pushbackRatio *= 0.95;
+    } else if (fillRatio < 0.1) {
+        m_pushbackRatio = 1.;
+    } else {
+        m_pushbackRatio *= 1.05;
+    }
+    m_pushbackRatio = std::min(std::max(m_pushbackRatio, kMinPushbackRatio), 1.);
+}
+
+bool CongestionWindow::isCongested(uint64_t nowUs) {
+    expire(nowUs);
+    const uint32_t window = getWindowBytes();
+    const bool congested = window > 0 && m_outstandingBytes >= window;
+    if (congested) {
+        ++m_congestedChecks;
+    }
+    return congested;
+}
+
+double CongestionWindow::getPushbackRatio() const {
+    return m_pushbackRatio;
+}
+
+uint32_t CongestionWindow::getWindowBytes() const {
+    if (m_minRttUs == 0) {
+        return 0;
+    }
+    const double bytes = double(m_targetBps) * (m_minRttUs + kAdditionalWindowUs) / 8e6;
+    return std::max(uint32_t(bytes), kMinWindowBytes);
+}
+
+uint32_t CongestionWindow::getOutstandingBytes() const {
+    return m_outstandingBytes;
+}
+
+uint64_t CongestionWindow::getMinRttUs() const {
+    return m_minRttUs;
+}
+
+void CongestionWindow::expire(uint64_t nowUs) {
+    while (!m_inFlight.empty() && nowUs - m_inFlight.front().sendUs > kMaxInFlightUs) {
+        pop();
+    }
+}
+
+void CongestionWindow::pop() {
+    assert(m_outstandingBytes >= m_inFlight.front().size);
+    m_outstandingBytes -= m_inFlight.front().size;
+    m_inFlight.pop_front();
+}
+
+void CongestionWindow::print(std::ostream& os) const {
+    os << "cwnd:"
+       << " window: " << getWindowBytes()
+       << " max outstanding: " << m_maxOutstandingBytes
+       << " held back: " << m_congestedChecks
+       << " min rtt(ms): " << m_minRttUs / 1000
+       << " pushback: " << m_pushbackRatio;
+}
+
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Congestion window pushback interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef CONGESTION_WINDOW_H
+#define CONGESTION_WINDOW_H
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Bound on the data in flight of a rate-controlled sender, as WebRTC's
+ * congestion window pushback does.
+ *
+ * Packets are in flight from the time they are sent until the feedback
+ * reports them, or a later packet (the earlier ones are then lost or
+ * late). The window is the target rate times the minimal round-trip time
+ * plus a margin. When the bytes in flight reach the window, the sender is
+ * to stop sending until feedback comes back: if feedback stalls or the
+ * path delay suddenly grows, the queue at the bottleneck cannot exceed
+ * about one window. Besides, a pushback ratio scales down the encoder's
+ * target rate while the window is filling up, so that media does not
+ * pile up in the sender's pacing queue instead.
+ *
+ * Packets in flight for too long are forgotten, so that the sender
+ * recovers if all the feedback is lost.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class CongestionWindow {
+public:
+    /** Class constructor */
+    CongestionWindow();
+
+    /** Class destructor */
+    ~CongestionWindow();
+
+    /** Forget all packets in flight, the RTT and the statistics */
+    void reset();
+
+    /**
+     * Set the target rate the window is computed from
+     *
+     * @param [in] bitrateBps Target rate of the sender, in bps
+     */
+    void setTargetRate(float bitrateBps);
+
+    /**
+     * Account for a packet sent
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [in] id Unwrapped transport-wide sequence of the packet, as
+     *                the controller's (see SenderBasedController::unwrapSequence)
+     * @param [in] size Size of the packet, in bytes
+     */
+    void onPacketSent(uint64_t nowUs, uint64_t id, uint32_t size);
+
+    /**
+     * Account for a packet reported in the feedback: it and the packets
+     * sent before it are no longer in flight
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [in] id Unwrapped transport-wide sequence of the packet
+     */
+    void onPacketAcked(uint64_t nowUs, uint64_t id);
+
+    /**
+     * Update the pushback ratio, after a batch of feedback
+     *
+     * @param [in] queuedBytes Bytes waiting in the sender's pacing queue
+     */
+    void updatePushback(uint32_t queuedBytes);
+
+    /**
+     * Whether the data in flight fills the window: the sender is to hold
+     * back its packets
+     *
+     * @param [in] nowUs Current time in microseconds
+     */
+    bool isCongested(uint64_t nowUs);
+
+    /** Factor in (0, 1] the encoder's target rate is to be scaled by */
+    double getPushbackRatio() const;
+
+    uint32_t getWindowBytes() const;       /**< 0 if no RTT measured yet */
+    uint32_t getOutstandingBytes() const;  /**< bytes in flight */
+    uint64_t getMinRttUs() const;          /**< 0 if no RTT measured yet */
+
+    /**
+     * Write a one-line summary of the statistics, with no line break
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(std::ostream& os) const;
+
+private:
+    struct InFlight {
+        uint64_t id;        /**< unwrapped sequence */
+        uint64_t sendUs;
+        uint32_t size;
+    };
+
+    void expire(uint64_t nowUs);
+    void pop();
+
+    std::deque<InFlight> m_inFlight;
+    uint32_t m_outstandingBytes;
+    float m_targetBps;
+    uint64_t m_minRttUs;
+    double m_pushbackRatio;
+
+    uint32_t m_maxOutstandingBytes;
+    uint64_t m_congestedChecks;     /**< times the sender was held back */
+};
+
+}
+
+#endif /* CONGESTION_WINDOW_H */
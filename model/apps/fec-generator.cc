@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Sender forward error correction (FEC) implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "fec-generator.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace rmcat {
+
+static const size_t kMaxBlockPackets = 48;  /**< media packets protected together */
+
+/*
+ * FEC header (network byte order):
+ *   0-1    base sequence number
+ *   2-9    mask
+ *   10-13  timestamp recovery
+ *   14     marker recovery (most significant bit)
+ *   15     reserved
+ *   16-17  length recovery
+ *   18-19  reserved
+ */
+void FecPacket::write(uint8_t* buf) const {
+    std::fill(buf, buf + FEC_HEADER_SIZE, 0);
+    buf[0] = uint8_t(baseSeq >> 8);
+    buf[1] = uint8_t(baseSeq);
+    for (int i = 0; i < 8; ++i) {
+        buf[2 + i] = uint8_t(mask >> (56 - 8 * i));
+    }
+    for (int i = 0; i < 4; ++i) {
+        buf[10 + i] = uint8_t(tsRecovery >> (24 - 8 * i));
+    }
+    buf[14] = markerRecovery ? 0x80 : 0;
+    buf[16] = uint8_t(lengthRecovery >> 8);
+    buf[17] = uint8_t(lengthRecovery);
+}
+
+void FecPacket::read(const uint8_t* buf, uint32_t payloadSize) {
+    baseSeq = uint16_t((buf[0] << 8) | buf[1]);
+    mask = 0;
+    for (int i = 0; i < 8; ++i) {
+        mask = (mask << 8) | buf[2 + i];
+    }
+    tsRecovery = 0;
+    for (int i = 0; i < 4; ++i) {
+        tsRecovery = (tsRecovery << 8) | buf[10 + i];
+    }
+    markerRecovery = (buf[14] & 0x80) != 0;
+    lengthRecovery = uint16_t((buf[16] << 8) | buf[17]);
+    size = payloadSize;
+}
+
+FecGenerator::FecGenerator() :
+    m_ratio{0.},
+    m_mask{FEC_MASK_RANDOM},
+    m_block{} {
+    reset();
+}
+
+FecGenerator::~FecGenerator() {}
+
+void FecGenerator::reset() {
+    m_block.clear();
+    m_mediaPackets = 0;
+    m_fecPackets = 0;
+}
+
+void FecGenerator::setProtection(double ratio, FecMaskType mask) {
+    m_ratio = std::min(std::max(ratio, 0.), 1.);
+    m_mask = mask;
+    if (m_ratio <= 0.) {
+        m_block.clear();
+    }
+}
+
+double FecGenerator::getProtection() const {
+    return m_ratio;
+}
+
+void FecGenerator::addMediaPacket(uint16_t sequence, uint32_t rtpTimestamp, bool marker,
+                                  uint32_t size, std::vector<FecPacket>& fecPackets) {
+    if (m_ratio <= 0. && m_block.empty()) {
+        return;
+    }
+    if (!m_block.empty() && uint16_t(sequence - m_block.back().sequence) != 1) {
+        m_block.clear(); // Sequence jump (e.g., pause): restart the block
+    }
+    m_block.push_back(MediaPacket{sequence, rtpTimestamp, marker, size});
+    const size_t nFec = size_t(std::lround(m_block.size() * m_ratio));
+    if ((marker && nFec > 0) || m_block.size() >= kMaxBlockPackets) {
+        generate(fecPackets);
+    }
+}
+
+void FecGenerator::generate(std::vector<FecPacket>& fecPackets) {
+    const size_t nMedia = m_block.size();
+    const size_t nFec = std::min(nMedia, std::max<size_t>(1, std::lround(nMedia * m_ratio)));
+    const uint16_t baseSeq = m_block.front().sequence;
+    for (size_t i = 0; i < nFec; ++i) {
+        FecPacket fec{baseSeq, 0, 0, false, 0, 0};
+        uint32_t maxSize = 0;
+        for (size_t j = 0; j < nMedia; ++j) {
+            const bool protect = (m_mask == FEC_MASK_RANDOM) ?
+                                 (j % nFec == i) :
+                                 (j * nFec / nMedia == i);
+            if (!protect) {
+                continue;
+            }
+            const MediaPacket& media = m_block[j];
+            fec.mask |= uint64_t(1) << j;
+            fec.tsRecovery ^= media.rtpTimestamp;
+            fec.markerRecovery ^= media.marker;
+            fec.lengthRecovery ^= uint16_t(media.size);
+            maxSize = std::max(maxSize, media.size);
+        }
+        assert(fec.mask != 0);
+        fec.size = FEC_HEADER_SIZE + maxSize;
+        fecPackets.push_back(fec);
+    }
+    m_mediaPackets += nMedia;
+    m_fecPackets += nFec;
+    m_block.clear();
+}
+
+uint64_t FecGenerator::getMediaPackets() const {
+    return m_mediaPackets;
+}
+
+uint64_t FecGenerator::getFecPackets() const {
+    return m_fecPackets;
+}
+
+}
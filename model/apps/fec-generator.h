@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Sender forward error correction (FEC) interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef FEC_GENERATOR_H
+#define FEC_GENERATOR_H
+
+#include "rmcat-constants.h"
+#include <cstdint>
+#include <vector>
+
+namespace rmcat {
+
+/**
+ * How the media packets of a block are distributed among its FEC packets
+ */
+enum FecMaskType {
+    FEC_MASK_RANDOM = 0,    /**< interleaved: against random losses */
+    FEC_MASK_BURSTY         /**< consecutive packets: against loss bursts */
+};
+
+/**
+ * XOR-based FEC packet (in the spirit of RFC 8627, FlexFEC) protecting up
+ * to 64 media packets, designated by a base sequence number and a bit mask.
+ * The recovery fields are the XOR of the corresponding fields of the
+ * protected packets: with all of them but one, the missing one is the XOR
+ * of the others and the FEC packet. Payload bytes are not simulated.
+ */
+struct FecPacket {
+    uint16_t baseSeq;           /**< sequence of the first protected packet */
+    uint64_t mask;              /**< bit i: packet baseSeq + i is protected */
+    uint32_t tsRecovery;        /**< XOR of the RTP timestamps */
+    bool markerRecovery;        /**< XOR of the marker bits */
+    uint16_t lengthRecovery;    /**< XOR of the payload sizes */
+    uint32_t size;              /**< payload size of the FEC packet, header included */
+
+    /**
+     * Write the FEC header
+     *
+     * @param [out] buf Buffer of at least #FEC_HEADER_SIZE bytes
+     */
+    void write(uint8_t* buf) const;
+
+    /**
+     * Read the FEC header
+     *
+     * @param [in] buf Buffer of at least #FEC_HEADER_SIZE bytes
+     * @param [in] payloadSize Size of the FEC packet's payload
+     */
+    void read(const uint8_t* buf, uint32_t payloadSize);
+};
+
+/**
+ * Groups outgoing media packets into blocks, and generates the FEC packets
+ * protecting each block: the ratio of FEC to media packets is the
+ * protection level. A block ends with a frame as soon as it is large
+ * enough for one FEC packet, or when it reaches the maximum size.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class FecGenerator {
+public:
+    /** Class constructor */
+    FecGenerator();
+
+    /** Class destructor */
+    ~FecGenerator();
+
+    /** Forget the current block and the statistics */
+    void reset();
+
+    /**
+     * Set the protection level, applied from the next block
+     *
+     * @param [in] ratio Ratio of FEC packets to media packets, in [0, 1]
+     * @param [in] mask Distribution of the media packets among FEC packets
+     */
+    void setProtection(double ratio, FecMaskType mask);
+
+    /** Current ratio of FEC packets to media packets */
+    double getProtection() const;
+
+    /**
+     * Account for a media packet being sent
+     *
+     * @param [in] sequence RTP sequence number
+     * @param [in] rtpTimestamp RTP timestamp
+     * @param [in] marker RTP marker bit: last packet of the frame
+     * @param [in] size Payload size
+     * @param [out] fecPackets FEC packets to send, if the block ended
+     */
+    void addMediaPacket(uint16_t sequence, uint32_t rtpTimestamp, bool marker,
+                        uint32_t size, std::vector<FecPacket>& fecPackets);
+
+    uint64_t getMediaPackets() const;   /**< media packets protected */
+    uint64_t getFecPackets() const;     /**< FEC packets generated */
+
+private:
+    struct MediaPacket {
+        uint16_t sequence;
+        uint32_t rtpTimestamp;
+        bool marker;
+        uint32_t size;
+    };
+
+    void generate(std::vector<FecPacket>& fecPackets);
+
+    double m_ratio;
+    FecMaskType m_mask;
+    std::vector<MediaPacket> m_block;
+    uint64_t m_mediaPackets;
+    uint64_t m_fecPackets;
+};
+
+}
+
+#endif /* FEC_GENERATOR_H */
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver forward error correction (FEC) recovery implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "fec-receiver.h"
+#include <algorithm>
+
+namespace rmcat {
+
+static const size_t kWindowSize = 1024;         /**< media packets kept; divides 2^16 */
+static const size_t kMaxFecPackets = 64;        /**< FEC packets waiting for recovery */
+
+FecReceiver::FecReceiver() :
+    m_window(kWindowSize),
+    m_fecPackets{} {
+    reset();
+}
+
+FecReceiver::~FecReceiver() {}
+
+void FecReceiver::reset() {
+    std::fill(m_window.begin(), m_window.end(), Slot{false, MediaPacket{0, 0, false, 0}});
+    m_highestValid = false;
+    m_highestSeq = 0;
+    m_fecPackets.clear();
+    m_fecReceived = 0;
+    m_recovered = 0;
+}
+
+bool FecReceiver::isReceived(uint16_t sequence) const {
+    const Slot& slot = m_window[sequence % kWindowSize];
+    return slot.valid && slot.packet.sequence == sequence;
+}
+
+void FecReceiver::store(const MediaPacket& packet) {
+    m_window[packet.sequence % kWindowSize] = Slot{true, packet};
+    if (!m_highestValid || int16_t(packet.sequence - m_highestSeq) > 0) {
+        m_highestValid = true;
+        m_highestSeq = packet.sequence;
+    }
+}
+
+bool FecReceiver::tooOld(const FecPacket& fec) const {
+    // Its first packets may already have been overwritten in the window
+    return m_highestValid &&
+           int16_t(m_highestSeq - fec.baseSeq) >= int16_t(kWindowSize - 64);
+}
+
+void FecReceiver::insertMedia(const MediaPacket& packet, std::vector<MediaPacket>& recovered) {
+    if (isReceived(packet.sequence)) {
+        return; // Duplicate
+    }
+    store(packet);
+    if (!m_fecPackets.empty()) {
+        recover(recovered);
+    }
+}
+
+void FecReceiver::insertFec(const FecPacket& fec, std::vector<MediaPacket>& recovered) {
+    ++m_fecReceived;
+    if (m_fecPackets.size() >= kMaxFecPackets) {
+        m_fecPackets.pop_front();
+    }
+    m_fecPackets.push_back(fec);
+    recover(recovered);
+}
+
+void FecReceiver::recover(std::vector<MediaPacket>& recovered) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (auto it = m_fecPackets.begin(); it != m_fecPackets.end();) {
+            const FecPacket& fec = *it;
+            if (tooOld(fec)) {
+                it = m_fecPackets.erase(it);
+                continue;
+            }
+            size_t missing = 0;
+            uint16_t missingSeq = 0;
+            MediaPacket packet{0, fec.tsRecovery, fec.markerRecovery, fec.lengthRecovery};
+            for (int i = 0; i < 64 && missing < 2; ++i) {
+                if ((fec.mask & (uint64_t(1) << i)) == 0) {
+                    continue;
+                }
+                const uint16_t sequence = uint16_t(fec.baseSeq + i);
+                if (!isReceived(sequence)) {
+                    ++missing;
+                    missingSeq = sequence;
+                    continue;
+                }
+                const MediaPacket& other = m_window[sequence % kWindowSize].packet;
+                packet.rtpTimestamp ^= other.rtpTimestamp;
+                packet.marker ^= other.marker;
+                packet.size ^= other.size;
+            }
+            if (missing >= 2) {
+                ++it;
+                continue;
+            }
+            if (missing == 1) {
+                packet.sequence = missingSeq;
+                store(packet);
+                recovered.push_back(packet);
+                ++m_recovered;
+                progress = true;
+            }
+            it = m_fecPackets.erase(it);
+        }
+    }
+}
+
+uint64_t FecReceiver::getFecReceived() const {
+    return m_fecReceived;
+}
+
+uint64_t FecReceiver::getRecovered() const {
+    return m_recovered;
+}
+
+void FecReceiver::print(std::ostream& os) const {
+    os << "fec:"
+       << " received: " << m_fecReceived
+       << " recovered: " << m_recovered;
+}
+
+}
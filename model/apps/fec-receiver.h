@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver forward error correction (FEC) recovery interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef FEC_RECEIVER_H
+#define FEC_RECEIVER_H
+
+#include "fec-generator.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Recovers lost media packets from the FEC packets of #FecGenerator.
+ *
+ * The headers of the media packets received recently are kept in a window
+ * indexed by sequence number. An FEC packet with exactly one of its
+ * protected packets missing recovers it; one with none missing is
+ * discarded. A recovered packet may in turn complete another FEC packet.
+ * FEC packets still waiting are bounded in number, and dropped once their
+ * packets leave the window.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class FecReceiver {
+public:
+    /** Header fields of a media packet, as received or recovered */
+    struct MediaPacket {
+        uint16_t sequence;
+        uint32_t rtpTimestamp;
+        bool marker;
+        uint32_t size;
+    };
+
+    /** Class constructor */
+    FecReceiver();
+
+    /** Class destructor */
+    ~FecReceiver();
+
+    /** Forget all packets and statistics */
+    void reset();
+
+    /**
+     * Account for a received media packet (retransmissions included)
+     *
+     * @param [in] packet Header fields of the packet
+     * @param [out] recovered Media packets recovered thanks to it
+     */
+    void insertMedia(const MediaPacket& packet, std::vector<MediaPacket>& recovered);
+
+    /**
+     * Account for a received FEC packet
+     *
+     * @param [in] fec The FEC packet
+     * @param [out] recovered Media packets recovered thanks to it
+     */
+    void insertFec(const FecPacket& fec, std::vector<MediaPacket>& recovered);
+
+    uint64_t getFecReceived() const;        /**< FEC packets received */
+    uint64_t getRecovered() const;          /**< media packets recovered */
+
+    /**
+     * Write a one-line summary of the statistics, with no line break
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(std::ostream& os) const;
+
+private:
+    struct Slot {
+        bool valid;
+        MediaPacket packet;
+    };
+
+    bool isReceived(uint16_t sequence) const;
+    void store(const MediaPacket& packet);
+    bool tooOld(const FecPacket& fec) const;
+    void recover(std::vector<MediaPacket>& recovered);
+
+    std::vector<Slot> m_window;     /**< by sequence modulo its size */
+    bool m_highestValid;
+    uint16_t m_highestSeq;
+    std::deque<FecPacket> m_fecPackets;
+    uint64_t m_fecReceived;
+    uint64_t m_recovered;
+};
+
+}
+
+#endif /* FEC_RECEIVER_H */
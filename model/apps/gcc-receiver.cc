@@ -31,24 +31,85 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/sim-perf-record.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 NS_LOG_COMPONENT_DEFINE ("GccReceiver");
 
 #define LOGTIMER 10
 #define RTTLOG 1
 namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (GccReceiver);
+
+TypeId GccReceiver::GetTypeId ()
+{
+    static TypeId tid = TypeId ("ns3::GccReceiver")
+      .SetParent<Application> ()
+      .AddConstructor<GccReceiver> ()
+      .AddTraceSource ("RxPacket",
+                       "Arrival of an RTP packet",
+                       MakeTraceSourceAccessor (&GccReceiver::m_rxPacketTrace),
+                       "ns3::GccReceiver::RxPacketTracedCallback")
+      .AddTraceSource ("Feedback",
+                       "Feedback packet sent",
+                       MakeTraceSourceAccessor (&GccReceiver::m_feedbackTrace),
+                       "ns3::GccReceiver::FeedbackTracedCallback")
+      .AddTraceSource ("RemoteEstimate",
+                       "Bitrate estimated at the receiver and sent in REMB messages, in bps",
+                       MakeTraceSourceAccessor (&GccReceiver::m_remoteEstimate),
+                       "ns3::TracedValueCallback::Uint32")
+    ;
+    return tid;
+}
+
 GccReceiver::GccReceiver ()
 : m_running{false}
 , m_waiting{false}
 , m_ssrc{0}
+, m_remoteSsrcValid{false}
 , m_remoteSsrc{0}
 , m_srcIp{}
 , m_srcPort{}
 , m_socket{NULL}
 , m_header{}
 , m_sendEvent{}
-, m_periodUs{RMCAT_FEEDBACK_PERIOD_US}
+, m_periodUs{0}
+, m_remoteEstimation{false}
+, m_initBw{0}
+, m_minBw{0}
+, m_maxBw{0}
+, m_estimator{}
+, m_jitterBuffer{}
+, m_nack{false}
+, m_nackGenerator{}
+, m_nackEvent{}
+, m_fecReceiver{}
+, m_rtcpEvent{}
+, m_rtpStatsValid{false}
+, m_maxSeq{0}
+, m_cycles{0}
+, m_baseSeq{0}
+, m_received{0}
+, m_expectedPrior{0}
+, m_receivedPrior{0}
+, m_lastTransit{0}
+, m_jitter{0.}
+, m_lsr{0}
+, m_lsrRecvUs{0}
+, m_rxBytes{0}
+, m_totalRxBytes{0}
+, m_lastReportUs{0}
+, m_avgRtcpSize{0.}
+, m_rtcpInitial{true}
 , m_movertt{0}
+, m_rxPacketTrace{}
+, m_feedbackTrace{}
+, m_remoteEstimate{0}
 {}
 
 GccReceiver::~GccReceiver () {}
@@ -60,17 +121,85 @@ void GccReceiver::Setup (uint16_t port)
     auto ret = m_socket->Bind (local);
     NS_ASSERT (ret == 0);
     m_socket->SetRecvCallback (MakeCallback (&GccReceiver::RecvPacket, this));
+    // Deliver the TOS byte of received packets, to echo their ECN codepoint
+    m_socket->SetIpRecvTos (true);
 
     m_running = false;
     m_waiting = true;
 }
 
+void GccReceiver::SetFeedbackPeriod (uint64_t periodUs)
+{
+    NS_ASSERT (!m_running);
+    m_periodUs = periodUs;
+}
+
+void GccReceiver::EnableRemoteEstimation (float initBw, float minBw, float maxBw)
+{
+    NS_ASSERT (!m_running);
+    NS_ASSERT (minBw <= initBw);
+    NS_ASSERT (initBw <= maxBw);
+    m_remoteEstimation = true;
+    m_initBw = initBw;
+    m_minBw = minBw;
+    m_maxBw = maxBw;
+}
+
+const rmcat::JitterBuffer& GccReceiver::GetJitterBuffer () const
+{
+    return m_jitterBuffer;
+}
+
+void GccReceiver::EnableNack ()
+{
+    NS_ASSERT (!m_running);
+    m_nack = true;
+}
+
+const rmcat::NackGenerator& GccReceiver::GetNackGenerator () const
+{
+    return m_nackGenerator;
+}
+
+const rmcat::FecReceiver& GccReceiver::GetFecReceiver () const
+{
+    return m_fecReceiver;
+}
+
+uint64_t GccReceiver::GetReceivedBytes () const
+{
+    return m_totalRxBytes;
+}
+
 void GccReceiver::StartApplication ()
 {
     m_running = true;
     m_ssrc = rand ();
     m_header.SetSendSsrc (m_ssrc);
-    Time tFirst {MicroSeconds (m_periodUs)};
+    if (m_remoteEstimation) {
+        m_estimator.setBitrates (m_initBw, m_minBw, m_maxBw);
+    } else if (m_periodUs > 0) {
+        Time tFirst {MicroSeconds (m_periodUs)};
+        m_sendEvent = Simulator::Schedule (tFirst, &GccReceiver::SendFeedback, this, true);
+    }
+    m_jitterBuffer.reset ();
+    m_remoteSsrcValid = false;
+    m_fecReceiver.reset ();
+    if (m_nack) {
+        m_nackGenerator.reset ();
+        m_nackEvent = Simulator::Schedule (MicroSeconds (RMCAT_NACK_PERIOD_US),
+                                           &GccReceiver::SendNack, this);
+    }
+
+    // RTCP: one sender and one receiver per session
+    m_rtpStatsValid = false;
+    m_lsr = 0;
+    m_rxBytes = 0;
+    m_totalRxBytes = 0;
+    m_avgRtcpSize = ReceiverReportHeader{}.GetSerializedSize () +
+                    RtcpReportBlock::m_size + IPV4_UDP_OVERHEAD;
+    m_rtcpInitial = true;
+    ScheduleReceiverReport (Simulator::Now ().GetMicroSeconds ());
 
     m_timer = ns3::Seconds(0);
     m_numPackets = 0;
@@ -85,6 +214,23 @@ void GccReceiver::StopApplication ()
     m_waiting = true;
     m_header.Clear ();
     Simulator::Cancel (m_sendEvent);
+    Simulator::Cancel (m_rtcpEvent);
+    Simulator::Cancel (m_nackEvent);
+
+    m_jitterBuffer.advance (Simulator::Now ().GetMicroSeconds ());
+    std::ostringstream os;
+    m_jitterBuffer.print (os);
+    NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+    if (m_nack) {
+        os.str ("");
+        m_nackGenerator.print (os);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+    }
+    if (m_fecReceiver.getFecReceived () > 0) {
+        os.str ("");
+        m_fecReceiver.print (os);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+    }
 }
 
 void GccReceiver::RecvPacket (Ptr<Socket> socket)
@@ -107,6 +253,19 @@ void GccReceiver::RecvPacket (Ptr<Socket> socket)
     }
 
     NS_ASSERT (packet);
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    SocketIpTosTag tosTag{};
+    uint8_t ecn = 0;
+    if (packet->RemovePacketTag (tosTag)) {
+        ecn = tosTag.GetTos () & ECN_MASK;
+    }
+    RtcpHeader common{};
+    packet->PeekHeader (common);
+    if (common.GetPacketType () == RtcpHeader::RTCP_SR) {
+        RecvSenderReport (packet, nowUs);
+        return;
+    }
+
     RtpHeader header{};
     NS_LOG_INFO ("GccReceiver::RecvPacket, " << packet->ToString ());
     packet->RemoveHeader (header);
@@ -114,18 +273,46 @@ void GccReceiver::RecvPacket (Ptr<Socket> socket)
     const auto srcPort = InetSocketAddress::ConvertFrom (remoteAddr).GetPort ();
     if (m_waiting) {
         m_waiting = false;
-        m_remoteSsrc = header.GetSsrc ();
         m_srcIp = srcIp;
         m_srcPort = srcPort;
     } else {
-        // Only one flow supported
-        NS_ASSERT (m_remoteSsrc == header.GetSsrc ());
         NS_ASSERT (m_srcIp == srcIp);
         NS_ASSERT (m_srcPort == srcPort);
     }
-    uint64_t txTimestampUs = header.GetTimestamp();
-    uint64_t recvTimestampUs = Simulator::Now ().GetMicroSeconds ();
-    std::cout << "current rtt : " << (recvTimestampUs - txTimestampUs) << std::endl;
+    // Only one flow supported: a media stream, with its retransmission and
+    // FEC streams
+    const bool rtx = header.GetPayloadType () == RTX_PAYLOAD_TYPE;
+    const bool fec = header.GetPayloadType () == FEC_PAYLOAD_TYPE;
+    if (!rtx && !fec) {
+        if (!m_remoteSsrcValid) {
+            m_remoteSsrcValid = true;
+            m_remoteSsrc = header.GetSsrc ();
+        }
+        NS_ASSERT (m_remoteSsrc == header.GetSsrc ());
+    }
+    // Retransmissions start with the original sequence number (RFC 4588)
+    uint16_t mediaSeq = header.GetSequence ();
+    if (rtx && !header.IsPadding ()) {
+        uint8_t osn[RTX_OSN_SIZE];
+        packet->CopyData (osn, RTX_OSN_SIZE);
+        mediaSeq = (uint16_t (osn[0]) << 8) | osn[1];
+    }
+    // The RTP timestamp is the capture time of the frame; delay-based
+    // estimation needs the send time of each packet
+    const uint32_t sendTimeUs = header.HasSendTime () ? header.GetSendTime () :
+                                                        header.GetTimestamp ();
+    uint64_t txTimestampUs = sendTimeUs;
+    uint64_t recvTimestampUs = nowUs;
+    if (!rtx && !fec) {
+        UpdateRtpStats (header.GetSequence (), header.GetTimestamp (), recvTimestampUs);
+    }
+    m_rxBytes += packet->GetSize () + header.GetSerializedSize ();
+    m_totalRxBytes += packet->GetSize () + header.GetSerializedSize ();
+    // Feedback on all the streams, by transport-wide sequence
+    const uint16_t sequence = header.HasTransportSequence () ? header.GetTransportSequence () :
+                                                               header.GetSequence ();
+    m_rxPacketTrace (sequence, packet->GetSize () + header.GetSerializedSize (), ecn);
+    NS_LOG_DEBUG ("GccReceiver::RecvPacket, current rtt : " << (recvTimestampUs - txTimestampUs));
     m_movertt = m_movertt * .5 + (recvTimestampUs - txTimestampUs) * .5;
     
     if(m_rttT + ns3::Seconds(RTTLOG) < ns3::Simulator::Now()) {
@@ -133,30 +320,83 @@ void GccReceiver::RecvPacket (Ptr<Socket> socket)
         m_rttT = ns3::Simulator::Now();
     }
     
-    AddFeedback (header.GetSequence (), recvTimestampUs);
-    m_sendEvent = Simulator::ScheduleNow(&GccReceiver::SendFeedback, this, false);
+    if (!header.IsPadding ()) {
+        std::vector<rmcat::FecReceiver::MediaPacket> recovered{};
+        if (fec) {
+            std::vector<uint8_t> fecHeader (FEC_HEADER_SIZE, 0);
+            packet->CopyData (fecHeader.data (), FEC_HEADER_SIZE);
+            rmcat::FecPacket fecPacket{};
+            fecPacket.read (fecHeader.data (), packet->GetSize ());
+            m_fecReceiver.insertFec (fecPacket, recovered);
+        } else {
+            DeliverMedia (recvTimestampUs, mediaSeq, header.GetTimestamp (),
+                          header.IsMarker (), rtx);
+            const uint32_t size = packet->GetSize () - (rtx ? RTX_OSN_SIZE : 0);
+            m_fecReceiver.insertMedia (rmcat::FecReceiver::MediaPacket{
+                                           mediaSeq, header.GetTimestamp (),
+                                           header.IsMarker (), size},
+                                       recovered);
+        }
+        for (const auto& media : recovered) {
+            DeliverMedia (recvTimestampUs, media.sequence, media.rtpTimestamp,
+                          media.marker, false);
+        }
+    }
+
+    if (m_remoteEstimation) {
+        // Only the estimate goes back to the sender
+        m_estimator.processPacket (recvTimestampUs, sendTimeUs, packet->GetSize ());
+        uint32_t bitrateBps = 0;
+        if (m_estimator.rembDue (recvTimestampUs, bitrateBps)) {
+            SendRemb (bitrateBps);
+        }
+        return;
+    }
+
+    if (!m_remoteSsrcValid) {
+        return; // Feedback goes under the media SSRC, not known yet
+    }
+    AddFeedback (sequence, recvTimestampUs, ecn);
+    if (m_periodUs == 0) {
+        m_sendEvent = Simulator::ScheduleNow(&GccReceiver::SendFeedback, this, false);
+    }
+}
+
+void GccReceiver::DeliverMedia (uint64_t nowUs,
+                                uint16_t sequence,
+                                uint32_t rtpTimestamp,
+                                bool marker,
+                                bool retransmitted)
+{
+    m_jitterBuffer.insertPacket (nowUs, sequence, rtpTimestamp, marker);
+    if (m_nack) {
+        m_nackGenerator.onPacket (nowUs, sequence, retransmitted);
+    }
 }
 
 void GccReceiver::AddFeedback (uint16_t sequence,
-                                 uint64_t recvTimestampUs)
+                                 uint64_t recvTimestampUs,
+                                 uint8_t ecn)
 {
-    auto res = m_header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs);
+    auto res = m_header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs, ecn);
     // std::cout << "AddFeedback:: " << sequence << "\n";
     if (res == CCFeedbackHeader::CCFB_TOO_LONG) {
         SendFeedback (false);
-        res = m_header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs);
+        res = m_header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs, ecn);
     }
     NS_ASSERT (res == CCFeedbackHeader::CCFB_NONE);
 }
 
 void GccReceiver::SendFeedback (bool reschedule)
 {
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
     if (m_running && !m_header.Empty ()) {
         //TODO (authors): If packet empty, easiest is to send it as is. Propose to authors
         auto packet = Create<Packet> ();
         packet->AddHeader (m_header);
         NS_LOG_INFO ("GccReceiver::SendFeedback, " << packet->ToString ());
         m_socket->SendTo (packet, 0, InetSocketAddress{m_srcIp, m_srcPort});
+        m_feedbackTrace (packet->GetSize ());
 
         m_header.Clear ();
         m_header.SetSendSsrc (m_ssrc);
@@ -168,5 +408,146 @@ void GccReceiver::SendFeedback (bool reschedule)
     }
 }
 
+void GccReceiver::SendRemb (uint32_t bitrateBps)
+{
+    RembHeader header{};
+    header.SetSendSsrc (m_ssrc);
+    header.SetBitrate (bitrateBps);
+    header.AddSsrc (m_remoteSsrc);
+    m_remoteEstimate = bitrateBps;
+    auto packet = Create<Packet> ();
+    packet->AddHeader (header);
+    NS_LOG_INFO ("GccReceiver::SendRemb, " << packet->ToString ());
+    m_socket->SendTo (packet, 0, InetSocketAddress{m_srcIp, m_srcPort});
+}
+
+void GccReceiver::SendNack ()
+{
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    std::vector<uint16_t> sequences{};
+    m_nackGenerator.getNackList (nowUs, sequences);
+    if (!sequences.empty () && m_remoteSsrcValid) {
+        NackHeader header{};
+        header.SetSendSsrc (m_ssrc);
+        header.SetMediaSsrc (m_remoteSsrc);
+        for (const auto& sequence : sequences) {
+            header.AddSequence (sequence);
+        }
+        auto packet = Create<Packet> ();
+        packet->AddHeader (header);
+        NS_LOG_INFO ("GccReceiver::SendNack, " << packet->ToString ());
+        m_socket->SendTo (packet, 0, InetSocketAddress{m_srcIp, m_srcPort});
+    }
+    m_nackEvent = Simulator::Schedule (MicroSeconds (RMCAT_NACK_PERIOD_US),
+                                       &GccReceiver::SendNack, this);
+}
+
+void GccReceiver::RecvSenderReport (Ptr<Packet> packet, uint64_t nowUs)
+{
+    SenderReportHeader header{};
+    NS_LOG_INFO ("GccReceiver::RecvSenderReport, " << packet->ToString ());
+    m_avgRtcpSize = (packet->GetSize () + IPV4_UDP_OVERHEAD) / 16. + m_avgRtcpSize * 15. / 16.;
+    packet->RemoveHeader (header);
+    if (!m_remoteSsrcValid || header.GetSendSsrc () != m_remoteSsrc) {
+        return; // Not (yet) the stream being received
+    }
+    m_lsr = header.GetCompactNtp ();
+    m_lsrRecvUs = nowUs;
+    m_jitterBuffer.setCaptureReference (header.GetRtpTimestamp (), header.GetNtpTimestampUs ());
+}
+
+void GccReceiver::UpdateRtpStats (uint16_t sequence,
+                                  uint32_t rtpTimestamp,
+                                  uint64_t recvTimestampUs)
+{
+    // RTP timestamps use a 90 kHz clock, so does the jitter
+    const int32_t transit = int32_t (uint32_t (recvTimestampUs * 90 / 1000) - rtpTimestamp);
+    if (!m_rtpStatsValid) {
+        m_rtpStatsValid = true;
+        m_baseSeq = sequence;
+        m_maxSeq = sequence;
+        m_cycles = 0;
+        m_received = 0;
+        m_expectedPrior = 0;
+        m_receivedPrior = 0;
+        m_lastTransit = transit;
+        m_jitter = 0.;
+    } else {
+        const uint16_t delta = sequence - m_maxSeq; // wraps properly
+        if (delta != 0 && delta < 0x8000) {
+            if (sequence < m_maxSeq) {
+                m_cycles += 0x10000;
+            }
+            m_maxSeq = sequence;
+        }
+        // Jitter estimate (RFC 3550, appendix A.8)
+        const double d = std::abs (double (transit) - double (m_lastTransit));
+        m_jitter += (d - m_jitter) / 16.;
+        m_lastTransit = transit;
+    }
+    ++m_received;
+}
+
+void GccReceiver::SendReceiverReport ()
+{
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    if (m_waiting) {
+        // Nobody to send the report to yet
+        ScheduleReceiverReport (nowUs);
+        return;
+    }
+
+    ReceiverReportHeader header{};
+    header.SetSendSsrc (m_ssrc);
+    if (m_rtpStatsValid) {
+        // Loss statistics (RFC 3550, appendix A.3)
+        const uint32_t extMax = m_cycles + m_maxSeq;
+        const uint32_t expected = extMax - m_baseSeq + 1;
+        const uint32_t expectedInterval = expected - m_expectedPrior;
+        const uint32_t receivedInterval = m_received - m_receivedPrior;
+        const int64_t lostInterval = int64_t (expectedInterval) - int64_t (receivedInterval);
+        m_expectedPrior = expected;
+        m_receivedPrior = m_received;
+
+        RtcpReportBlock block{};
+        block.m_ssrc = m_remoteSsrc;
+        if (expectedInterval > 0 && lostInterval > 0) {
+            block.m_fractionLost = uint8_t (std::min<int64_t> ((lostInterval << 8) / expectedInterval, 255));
+        }
+        block.m_cumulativeLost = int32_t (int64_t (expected) - int64_t (m_received));
+        block.m_extHighestSeq = extMax;
+        block.m_jitter = uint32_t (m_jitter);
+        if (m_lsr != 0) {
+            block.m_lsr = m_lsr;
+            block.m_dlsr = RtcpUsToCompactNtp (nowUs - m_lsrRecvUs);
+        }
+        header.AddReportBlock (block);
+    }
+
+    auto packet = Create<Packet> ();
+    packet->AddHeader (header);
+    NS_LOG_INFO ("GccReceiver::SendReceiverReport, " << packet->ToString ());
+    m_socket->SendTo (packet, 0, InetSocketAddress{m_srcIp, m_srcPort});
+    m_avgRtcpSize = (packet->GetSize () + IPV4_UDP_OVERHEAD) / 16. + m_avgRtcpSize * 15. / 16.;
+    m_rtcpInitial = false;
+    ScheduleReceiverReport (nowUs);
+}
+
+void GccReceiver::ScheduleReceiverReport (uint64_t nowUs)
+{
+    // Session bandwidth as received since the previous report
+    double sessionBwBps = 0.;
+    if (nowUs > m_lastReportUs && m_rxBytes > 0) {
+        sessionBwBps = double (m_rxBytes) * 8. * 1000. * 1000. / double (nowUs - m_lastReportUs);
+    }
+    m_rxBytes = 0;
+    m_lastReportUs = nowUs;
+    const double rtcpInterval = RtcpReportInterval (2, 1, sessionBwBps, false,
+                                                    m_avgRtcpSize, m_rtcpInitial);
+    m_rtcpEvent = Simulator::Schedule (Seconds (rtcpInterval), &GccReceiver::SendReceiverReport, this);
+}
+
 }
 
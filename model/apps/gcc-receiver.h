@@ -29,44 +29,159 @@
 #define RMCAT_RECEIVER_H
 
 #include "rtp-header.h"
+#include "jitter-buffer.h"
+#include "nack-generator.h"
+#include "fec-receiver.h"
+#include "ns3/remote-bitrate-estimator.h"
 #include "ns3/socket.h"
 #include "ns3/application.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 
 class GccReceiver: public Application
 {
 public:
+    /**
+     * Trace sources: RxPacket, on the arrival of every RTP packet; Feedback,
+     * on every feedback packet sent; RemoteEstimate, the bitrate sent in
+     * REMB messages (see #EnableRemoteEstimation )
+     */
+    static TypeId GetTypeId ();
+
+    /**
+     * TracedCallback signature for the arrival of RTP packets
+     *
+     * @param [in] sequence Transport-wide sequence number of the packet
+     * @param [in] size Size of the packet, including its RTP header
+     * @param [in] ecn ECN codepoint of the packet
+     */
+    typedef void (* RxPacketTracedCallback) (uint16_t sequence, uint32_t size, uint8_t ecn);
+
+    /**
+     * TracedCallback signature for feedback packets sent
+     *
+     * @param [in] size Size of the feedback packet
+     */
+    typedef void (* FeedbackTracedCallback) (uint32_t size);
+
     GccReceiver ();
     virtual ~GccReceiver ();
 
     void Setup (uint16_t port);
 
+    /**
+     * Batch the feedback of all packets received during @p periodUs into
+     * one report. The default (0) sends one report per received packet.
+     * Note that batched arrival times are only accurate to the 1/1024 s
+     * resolution of the report's arrival time offsets
+     */
+    void SetFeedbackPeriod (uint64_t periodUs);
+
+    /**
+     * Estimate the bitrate at the receiver (REMB architecture) instead of
+     * sending per-packet feedback: the receiver runs the delay-based part of
+     * GCC and only sends REMB messages, once a second or when the estimate
+     * drops
+     *
+     * @param [in] initBw Initial bitrate in bps
+     * @param [in] minBw Minimal bitrate in bps
+     * @param [in] maxBw Maximal bitrate in bps
+     */
+    void EnableRemoteEstimation (float initBw, float minBw, float maxBw);
+
+    /**
+     * Playout statistics of the received video: frames rendered and
+     * dropped, freezes and glass-to-glass latency
+     */
+    const rmcat::JitterBuffer& GetJitterBuffer () const;
+
+    /**
+     * Request the retransmission of lost media packets with generic NACKs
+     * (RFC 4585), checked for every #RMCAT_NACK_PERIOD_US. The sender
+     * needs retransmissions enabled (see #ns3::GccSender::EnableRtx)
+     */
+    void EnableNack ();
+
+    /** Loss detection and recovery statistics */
+    const rmcat::NackGenerator& GetNackGenerator () const;
+
+    /** FEC recovery statistics; FEC packets are decoded whenever received */
+    const rmcat::FecReceiver& GetFecReceiver () const;
+
+    /** Media bytes (RTP header and payload) received since the start */
+    uint64_t GetReceivedBytes () const;
+
 private:
     virtual void StartApplication ();
     virtual void StopApplication ();
 
     void RecvPacket (Ptr<Socket> socket);
     void AddFeedback (uint16_t sequence,
-                      uint64_t recvTimestampUs);
+                      uint64_t recvTimestampUs,
+                      uint8_t ecn);
     void SendFeedback (bool reschedule);
+    void SendRemb (uint32_t bitrateBps);
+    void SendNack ();
+    void DeliverMedia (uint64_t nowUs, uint16_t sequence, uint32_t rtpTimestamp,
+                       bool marker, bool retransmitted);
+    void RecvSenderReport (Ptr<Packet> packet, uint64_t nowUs);
+    void UpdateRtpStats (uint16_t sequence, uint32_t rtpTimestamp, uint64_t recvTimestampUs);
+    void SendReceiverReport ();
+    void ScheduleReceiverReport (uint64_t nowUs);
 
 private:
     bool m_running;
     bool m_waiting;
     uint32_t m_ssrc;
+    bool m_remoteSsrcValid;     // First media packet received
     uint32_t m_remoteSsrc;
     Ipv4Address m_srcIp;
     uint16_t m_srcPort;
     Ptr<Socket> m_socket;
     CCFeedbackHeader m_header;
     EventId m_sendEvent;
-    uint64_t m_periodUs;
+    uint64_t m_periodUs;    // 0: feedback sent for every packet
+    bool m_remoteEstimation;
+    float m_initBw;
+    float m_minBw;
+    float m_maxBw;
+    rmcat::RemoteBitrateEstimator m_estimator;
+    rmcat::JitterBuffer m_jitterBuffer;
+    bool m_nack;
+    rmcat::NackGenerator m_nackGenerator;
+    EventId m_nackEvent;
+    rmcat::FecReceiver m_fecReceiver;
+
+    /* Reception statistics for RTCP receiver reports (RFC 3550, appendix A) */
+    EventId m_rtcpEvent;
+    bool m_rtpStatsValid;
+    uint16_t m_maxSeq;
+    uint32_t m_cycles;          // Sequence wraps, shifted by 16 bits
+    uint32_t m_baseSeq;
+    uint32_t m_received;
+    uint32_t m_expectedPrior;
+    uint32_t m_receivedPrior;
+    int32_t m_lastTransit;      // In RTP timestamp units (90 kHz)
+    double m_jitter;
+    uint32_t m_lsr;             // Compact NTP timestamp of the last SR
+    uint64_t m_lsrRecvUs;       // Arrival time of the last SR
+    uint64_t m_rxBytes;         // Received since the last report
+    uint64_t m_totalRxBytes;    // Received since the start
+    uint64_t m_lastReportUs;
+    double m_avgRtcpSize;       // bytes, including UDP/IP headers
+    bool m_rtcpInitial;
 
     double m_numPackets;
     ns3::Time m_timer;
     ns3::Time m_rttT;
     double m_movertt;
+
+    /* Trace sources */
+    TracedCallback<uint16_t, uint32_t, uint8_t> m_rxPacketTrace;
+    TracedCallback<uint32_t> m_feedbackTrace;
+    TracedValue<uint32_t> m_remoteEstimate;     // bps
 };
 
 }
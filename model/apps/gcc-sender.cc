@@ -33,15 +33,87 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
 #include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/trace-source-accessor.h"
 #include "ns3/gcc-controller.h"
+#include "ns3/sim-perf-record.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
 #include <sys/stat.h>
 
 NS_LOG_COMPONENT_DEFINE ("GccSender");
 
 namespace ns3 {
 
+static const uint32_t RTX_HISTORY_SIZE = 1024;          // packets; divides 2^16
+static const uint64_t RTX_DEFAULT_RTT_US = 100 * 1000;  // until the first receiver report
+static const double FEC_LOSS_GAIN = 2.;                 // adaptive FEC ratio per unit of loss
+static const uint64_t CWND_POLL_US = 5 * 1000;          // pacer check while the window is full
+static const double MIN_PUSHBACK_BPS = 30000.;          // encoder rate floor under pushback
+static const uint64_t CC_TIMER_PERIOD_US = 25 * 1000;   // controller timer (e.g., feedback timeout)
+
+NS_OBJECT_ENSURE_REGISTERED (GccSender);
+
+TypeId GccSender::GetTypeId ()
+{
+    static TypeId tid = TypeId ("ns3::GccSender")
+      .SetParent<Application> ()
+      .AddConstructor<GccSender> ()
+      .AddAttribute ("GccConfigFile",
+                     "File with the parameters of the GCC controller",
+                     StringValue (""),
+                     MakeStringAccessor (&GccSender::m_gccConfigFile),
+                     MakeStringChecker ())
+      .AddAttribute ("GccParameters",
+                     "GCC controller parameters, as name=value[,name=value...]",
+                     StringValue (""),
+                     MakeStringAccessor (&GccSender::m_gccParameters),
+                     MakeStringChecker ())
+      .AddTraceSource ("TargetBitrate",
+                       "Target rate of the media, in bps",
+                       MakeTraceSourceAccessor (&GccSender::m_rBitrate),
+                       "ns3::TracedValueCallback::Double")
+      .AddTraceSource ("PacingQueueBytes",
+                       "Bytes waiting in the pacing queue",
+                       MakeTraceSourceAccessor (&GccSender::m_PacingQBytes),
+                       "ns3::TracedValueCallback::Uint32")
+      .AddTraceSource ("DelayOffset",
+                       "Delay-gradient offset of the GCC overuse detector, in ms",
+                       MakeTraceSourceAccessor (&GccSender::m_delayOffset),
+                       "ns3::TracedValueCallback::Double")
+      .AddTraceSource ("DelayThreshold",
+                       "Adaptive threshold of the GCC overuse detector, in ms",
+                       MakeTraceSourceAccessor (&GccSender::m_delayThreshold),
+                       "ns3::TracedValueCallback::Double")
+      .AddTraceSource ("DetectorState",
+                       "Hypothesis of the GCC overuse detector: O, N or U",
+                       MakeTraceSourceAccessor (&GccSender::m_detectorState),
+                       "ns3::GccSender::StateTracedCallback")
+      .AddTraceSource ("RateControlState",
+                       "State of the GCC delay-based rate control: H, I or D",
+                       MakeTraceSourceAccessor (&GccSender::m_rateControlState),
+                       "ns3::GccSender::StateTracedCallback")
+      .AddTraceSource ("RateControlRegion",
+                       "Region of the GCC delay-based rate control: M or N",
+                       MakeTraceSourceAccessor (&GccSender::m_rateControlRegion),
+                       "ns3::GccSender::StateTracedCallback")
+      .AddTraceSource ("LossFraction",
+                       "Loss fraction fed to the GCC loss-based controller",
+                       MakeTraceSourceAccessor (&GccSender::m_lossFraction),
+                       "ns3::TracedValueCallback::Double")
+      .AddTraceSource ("Feedback",
+                       "Arrival of a feedback packet",
+                       MakeTraceSourceAccessor (&GccSender::m_feedbackTrace),
+                       "ns3::GccSender::FeedbackTracedCallback")
+    ;
+    return tid;
+}
+
 GccSender::GccSender ()
 : m_destIP{}
 , m_destPort{0}
@@ -49,8 +121,16 @@ GccSender::GccSender ()
 , m_minBw{0}
 , m_maxBw{0}
 , m_paused{false}
+, m_ecn{false}
+, m_rtx{false}
+, m_packetSize{DEFAULT_PACKET_SIZE}
 , m_ssrc{0}
+, m_rtxSsrc{0}
 , m_sequence{0}
+, m_rtpSequence{0}
+, m_rtxSequence{0}
+, m_fecSsrc{0}
+, m_fecSequence{0}
 , m_first_seq{0}	// First sequence number.
 , m_gid{0}		// Group id
 , m_prev_seq{0}		// Seq number of previous feedback packet
@@ -60,26 +140,94 @@ GccSender::GccSender ()
 , m_prev_group_seq{0}   // End Sequence number of previous feedback pkt.
 , m_curr_group_start_seq{0}
 , m_rtpTsOffset{0}
+, m_frameRtpTs{0}
+, m_frameBytesLeft{0}
+, m_framePktsLeft{0}
+, m_framePktInterval{0.}
 , m_prev_feedback_time{0.}
 , m_groupchanged{false}
 , m_socket{NULL}
 , m_enqueueEvent{}
 , m_sendEvent{}
 , m_sendOversleepEvent{}
+, m_probeEvent{}
+, m_rtcpEvent{}
+, m_probeCluster{}
+, m_probePktsLeft{0}
+, m_packetCount{0}
+, m_octetCount{0}
+, m_avgRtcpSize{0.}
+, m_rtcpInitial{true}
+, m_lastRrValid{false}
+, m_lastRrExtSeq{0}
+, m_rttUs{RTX_DEFAULT_RTT_US}
+, m_rtxHistory{}
+, m_rtxPackets{0}
+, m_fec{false}
+, m_fecAdaptive{false}
+, m_fecMaxProtection{0.}
+, m_fecMask{rmcat::FEC_MASK_RANDOM}
+, m_fecGenerator{}
+, m_maxQueueDelayUs{0}
+, m_lastMediaTs{0}
+, m_lastMediaMarker{true}
+, m_framesDropped{0}
+, m_maxQueueDelaySeenUs{0}
+, m_cwndEnabled{false}
+, m_cwnd{}
+, m_fse{}
+, m_fsePriority{1.f}
+, m_fseFlow{0}
+, m_fseRegistered{false}
+, m_fseRateBps{0.f}
+, m_rateShaping{false}
+, m_frameInterval{0.}
 , m_rVin{0.}
 , m_rSend{0.}
 , m_rBitrate{0.}
-, m_rateShapingBytes{0}
 , m_PacingQBytes{0}
+, m_PacingQPriority{0}
 , m_nextSendTstmpUs{0}
 , m_firstFeedback{true}
 , m_group_size_inter{0}
 , m_group_size{0}
 , m_prev_group_size{0}
+, m_traceAdapter{*this}
+, m_delayOffset{0.}
+, m_delayThreshold{0.}
+, m_detectorState{'N'}
+, m_rateControlState{'H'}
+, m_rateControlRegion{'M'}
+, m_lossFraction{0.}
+, m_feedbackTrace{}
 {}
 
 GccSender::~GccSender () {}
 
+GccSender::GccTraceAdapter::GccTraceAdapter (GccSender& sender)
+: m_sender (sender)
+{}
+
+void GccSender::GccTraceAdapter::onDetectorUpdate (double offsetMs,
+                                                   double thresholdMs,
+                                                   char hypothesis)
+{
+    m_sender.m_delayOffset = offsetMs;
+    m_sender.m_delayThreshold = thresholdMs;
+    m_sender.m_detectorState = hypothesis;
+}
+
+void GccSender::GccTraceAdapter::onRateControlUpdate (char state, char region)
+{
+    m_sender.m_rateControlState = state;
+    m_sender.m_rateControlRegion = region;
+}
+
+void GccSender::GccTraceAdapter::onLossFraction (float lossFraction)
+{
+    m_sender.m_lossFraction = lossFraction;
+}
+
 void GccSender::PauseResume (bool pause)
 {
     NS_ASSERT (pause != m_paused);
@@ -87,27 +235,64 @@ void GccSender::PauseResume (bool pause)
         Simulator::Cancel (m_enqueueEvent);
         Simulator::Cancel (m_sendEvent);
         Simulator::Cancel (m_sendOversleepEvent);
-        m_rateShapingBuf.clear ();
-        m_rateShapingBytes = 0;
+        Simulator::Cancel (m_probeEvent);
+        Simulator::Cancel (m_timerEvent);
+        m_probePktsLeft = 0;
 
         m_PacingQ.clear();
         m_PacingQBytes = 0;
+        m_PacingQPriority = 0;
+        m_framePktsLeft = 0;
+        m_frameBytesLeft = 0;
+        if (m_fseRegistered) {
+            m_fse->deregisterFlow (m_fseFlow);
+            m_fseRegistered = false;
+        }
     } else {
         m_rBitrate = m_initBw;    
  
         m_rVin = m_initBw;
         m_rSend = m_initBw;
+        // No feedback was due while paused
+        const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+        RestartFeedbackTimeout (m_controller, nowUs);
+        for (auto& shadow : m_shadows) {
+            RestartFeedbackTimeout (shadow.controller, nowUs);
+        }
+        if (m_fse) {
+            m_fseFlow = m_fse->registerFlow (m_fsePriority, m_initBw);
+            m_fseRegistered = true;
+            ApplyFseRate (true);
+        }
         m_enqueueEvent = Simulator::ScheduleNow (&GccSender::EnqueuePacket, this);
         m_nextSendTstmpUs = 0;
+        m_probeEvent = Simulator::ScheduleNow (&GccSender::StartProbeCluster, this);
+        StartControllerTimer ();
     }
     m_paused = pause;
 }
 
+void GccSender::RestartFeedbackTimeout (std::shared_ptr<rmcat::SenderBasedController> controller,
+                                        uint64_t nowUs)
+{
+    auto gcc = std::dynamic_pointer_cast<rmcat::GccController> (controller);
+    if (gcc) {
+        gcc->restartFeedbackTimeout (nowUs);
+    }
+}
+
 void GccSender::SetCodec (std::shared_ptr<syncodecs::Codec> codec)
 {
     m_codec = codec;
 }
 
+void GccSender::SetPacketSize (uint32_t packetSize)
+{
+    NS_ASSERT (packetSize > 0);
+    NS_ASSERT (packetSize <= MAX_PACKET_SIZE);
+    m_packetSize = packetSize;
+}
+
 // TODO (deferred): allow flexible input of video traffic trace path via config file, etc.
 void GccSender::SetCodecType (SyncodecType codecType)
 {
@@ -115,21 +300,20 @@ void GccSender::SetCodecType (SyncodecType codecType)
     switch (codecType) {
         case SYNCODEC_TYPE_PERFECT:
         {
-            codec = new syncodecs::PerfectCodec{DEFAULT_PACKET_SIZE};
+            codec = new syncodecs::PerfectCodec{m_packetSize};
             break;
         }
         case SYNCODEC_TYPE_FIXFPS:
         {
             const auto fps = SYNCODEC_DEFAULT_FPS;
-            auto innerCodec = new syncodecs::SimpleFpsBasedCodec{fps};
-            codec = new syncodecs::ShapedPacketizer{innerCodec, DEFAULT_PACKET_SIZE};
+            // Frames are packetized by the sender (see EnqueuePacket)
+            codec = new syncodecs::SimpleFpsBasedCodec{fps};
             break;
         }
         case SYNCODEC_TYPE_STATS:
         {
             const auto fps = SYNCODEC_DEFAULT_FPS;
-            auto innerStCodec = new syncodecs::StatisticsCodec{fps};
-            codec = new syncodecs::ShapedPacketizer{innerStCodec, DEFAULT_PACKET_SIZE};
+            codec = new syncodecs::StatisticsCodec{fps};
             break;
         }
         case SYNCODEC_TYPE_TRACE:
@@ -158,7 +342,7 @@ void GccSender::SetCodecType (SyncodecType codecType)
             NS_ASSERT_MSG (!traceDir.empty (), "Traces file not found in candidate paths");
 
             auto filePrefix = "chat";
-            auto innerCodec = (codecType == SYNCODEC_TYPE_TRACE) ?
+            codec = (codecType == SYNCODEC_TYPE_TRACE) ?
                                  new syncodecs::TraceBasedCodecWithScaling{
                                     traceDir,        // path to traces directory
                                     filePrefix,      // video filename
@@ -169,24 +353,30 @@ void GccSender::SetCodecType (SyncodecType codecType)
                                     filePrefix,      // video filename
                                     SYNCODEC_DEFAULT_FPS,             // Default FPS: 30fps
                                     true};           // fixed mode: image resolution doesn't change
-
-            codec = new syncodecs::ShapedPacketizer{innerCodec, DEFAULT_PACKET_SIZE};
             break;
         }
         case SYNCODEC_TYPE_SHARING:
         {
-            auto innerShCodec = new syncodecs::SimpleContentSharingCodec{};
-            codec = new syncodecs::ShapedPacketizer{innerShCodec, DEFAULT_PACKET_SIZE};
+            codec = new syncodecs::SimpleContentSharingCodec{};
             break;
         }
         default:  // defaults to perfect codec
-            codec = new syncodecs::PerfectCodec{DEFAULT_PACKET_SIZE};
+            codec = new syncodecs::PerfectCodec{m_packetSize};
     }
 
     // update member variable
     m_codec = std::shared_ptr<syncodecs::Codec>{codec};
 }
 
+void GccSender::AddLayer (std::shared_ptr<syncodecs::Codec> codec,
+                          float minBps, float targetBps, float maxBps)
+{
+    NS_ASSERT (codec);
+    NS_ASSERT (minBps > 0 && minBps <= targetBps && targetBps <= maxBps);
+    m_layerCodecs.push_back (codec);
+    m_allocator.addLayer (minBps, targetBps, maxBps);
+}
+
 void GccSender::SetController (std::shared_ptr<rmcat::SenderBasedController> controller)
 {
     m_controller = controller;
@@ -196,7 +386,7 @@ void GccSender::Setup (Ipv4Address destIP,
                          uint16_t destPort)
 {
     if (!m_codec) {
-        m_codec = std::make_shared<syncodecs::PerfectCodec> (DEFAULT_PACKET_SIZE);
+        m_codec = std::make_shared<syncodecs::PerfectCodec> (m_packetSize);
     }
 
     if (!m_controller) {
@@ -205,37 +395,142 @@ void GccSender::Setup (Ipv4Address destIP,
     } else {
         m_controller->reset ();
     }
+    for (auto& shadow : m_shadows) {
+        shadow.controller->reset ();
+    }
 
     m_destIP = destIP;
     m_destPort = destPort;
 }
 
+void GccSender::EnableEcn ()
+{
+    m_ecn = true;
+}
+
+void GccSender::EnableRtx ()
+{
+    m_rtx = true;
+}
+
+void GccSender::EnableCongestionWindow ()
+{
+    m_cwndEnabled = true;
+}
+
+void GccSender::SetMaxQueueDelay (uint64_t maxQueueDelayUs)
+{
+    m_maxQueueDelayUs = maxQueueDelayUs;
+}
+
+void GccSender::SetRateShaping (bool enable)
+{
+    m_rateShaping = enable;
+    NS_LOG_INFO ("GccSender::SetRateShaping, rate shaping " << (enable ? "on" : "off"));
+}
+
+void GccSender::EnableFec (double protection, rmcat::FecMaskType mask, bool adaptive)
+{
+    NS_ASSERT (protection > 0. && protection <= 1.);
+    m_fec = true;
+    m_fecMaxProtection = protection;
+    m_fecMask = mask;
+    m_fecAdaptive = adaptive;
+}
+
+void GccSender::AddShadowController (std::shared_ptr<rmcat::SenderBasedController> controller,
+                                     const std::string& name)
+{
+    NS_ASSERT (controller);
+    controller->setInitBw (m_initBw);
+    controller->setMinBw (m_minBw);
+    controller->setMaxBw (m_maxBw);
+    m_shadows.push_back (ShadowController{name, controller, 0., 0., 0});
+}
+
+void GccSender::SetFlowStateExchange (std::shared_ptr<rmcat::FlowStateExchange> fse,
+                                      float priority)
+{
+    NS_ASSERT (priority > 0);
+    m_fse = fse;
+    m_fsePriority = priority;
+}
+
 // Set Functions
 void GccSender::SetRinit (float r)
 {
     m_initBw = r;
     if (m_controller) m_controller->setInitBw (m_initBw);
+    for (auto& shadow : m_shadows) {
+        shadow.controller->setInitBw (m_initBw);
+    }
 }
 
 void GccSender::SetRmin (float r)
 {
     m_minBw = r;
     if (m_controller) m_controller->setMinBw (m_minBw);
+    for (auto& shadow : m_shadows) {
+        shadow.controller->setMinBw (m_minBw);
+    }
 }
 
 void GccSender::SetRmax (float r)
 {
     m_maxBw = r;
     if (m_controller) m_controller->setMaxBw (m_maxBw);
+    for (auto& shadow : m_shadows) {
+        shadow.controller->setMaxBw (m_maxBw);
+    }
+}
+
+/*
+ * The attributes are applied on top of the controller's own parameters,
+ * once the controller is known for sure
+ */
+void GccSender::ApplyGccConfig ()
+{
+    auto gcc = std::dynamic_pointer_cast<rmcat::GccController> (m_controller);
+    if (!gcc || (m_gccConfigFile.empty () && m_gccParameters.empty ())) {
+        return;
+    }
+    rmcat::GccConfig config = gcc->getConfig ();
+    if ((!m_gccConfigFile.empty () && !config.loadFile (m_gccConfigFile)) ||
+        !config.parse (m_gccParameters)) {
+        NS_FATAL_ERROR ("Invalid GCC configuration: " << m_gccConfigFile
+                        << " " << m_gccParameters);
+    }
+    gcc->setConfig (config);
 }
 
 void GccSender::StartApplication ()
 {
+    ApplyGccConfig ();
+    auto gcc = std::dynamic_pointer_cast<rmcat::GccController> (m_controller);
+    if (gcc) {
+        gcc->setObserver (&m_traceAdapter);
+    }
     m_ssrc = rand ();
+    m_rtxSsrc = rand ();
     // RTP initial values for sequence number and timestamp SHOULD be random (RFC 3550)
     m_sequence = rand ();
     m_first_seq = m_sequence;
+    m_rtpSequence = rand ();
+    m_rtxSequence = rand ();
+    m_rttUs = RTX_DEFAULT_RTT_US;
+    m_rtxHistory.assign (m_rtx ? RTX_HISTORY_SIZE : 0, RtxEntry{false, 0, 0, 0, false, 0});
+    m_rtxPackets = 0;
+    m_fecSsrc = rand ();
+    m_fecSequence = rand ();
+    m_fecGenerator.reset ();
+    m_cwnd.reset ();
+    m_lastMediaMarker = true;
+    m_framesDropped = 0;
+    m_maxQueueDelaySeenUs = 0;
+    m_fecGenerator.setProtection (m_fecAdaptive ? 0. : m_fecMaxProtection, m_fecMask);
     m_rtpTsOffset = rand ();
+    m_framePktsLeft = 0;
+    m_frameBytesLeft = 0;
 
     NS_ASSERT (m_minBw <= m_initBw);
     NS_ASSERT (m_initBw <= m_maxBw);
@@ -245,11 +540,21 @@ void GccSender::StartApplication ()
     m_rVin = m_initBw;
     m_rSend = m_initBw;
 
+    if (m_fse) {
+        // A joining flow gets its share of its group's rate right away
+        m_fseFlow = m_fse->registerFlow (m_fsePriority, m_initBw);
+        m_fseRegistered = true;
+        ApplyFseRate (true);
+    }
+
     if (m_socket == NULL) {
         m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
         auto res = m_socket->Bind ();
         NS_ASSERT (res == 0);
     }
+    if (m_ecn) {
+        m_socket->SetIpTos (ECN_ECT1);
+    }
     m_socket->SetRecvCallback (MakeCallback (&GccSender::RecvPacket, this));
 
     m_prev_time = ns3::Simulator::Now().GetMicroSeconds();
@@ -260,6 +565,22 @@ void GccSender::StartApplication ()
 
     m_enqueueEvent = Simulator::Schedule (Seconds (0.0), &GccSender::EnqueuePacket, this);
     m_nextSendTstmpUs = 0;
+
+    // Start-up probing
+    m_probePktsLeft = 0;
+    m_probeEvent = Simulator::ScheduleNow (&GccSender::StartProbeCluster, this);
+
+    StartControllerTimer ();
+
+    // RTCP: one sender and one receiver per session
+    m_packetCount = 0;
+    m_octetCount = 0;
+    m_avgRtcpSize = SenderReportHeader{}.GetSerializedSize () + IPV4_UDP_OVERHEAD;
+    m_rtcpInitial = true;
+    m_lastRrValid = false;
+    const double rtcpInterval = RtcpReportInterval (2, 1, m_rBitrate, true,
+                                                    m_avgRtcpSize, m_rtcpInitial);
+    m_rtcpEvent = Simulator::Schedule (Seconds (rtcpInterval), &GccSender::SendSenderReport, this);
 }
 
 void GccSender::StopApplication ()
@@ -267,35 +588,125 @@ void GccSender::StopApplication ()
     Simulator::Cancel (m_enqueueEvent);
     Simulator::Cancel (m_sendEvent);
     Simulator::Cancel (m_sendOversleepEvent);
+    Simulator::Cancel (m_probeEvent);
+    Simulator::Cancel (m_rtcpEvent);
+    Simulator::Cancel (m_timerEvent);
+    m_probePktsLeft = 0;
     
     m_PacingQ.clear();
     m_PacingQBytes = 0;
+    m_PacingQPriority = 0;
+    m_framePktsLeft = 0;
+    m_frameBytesLeft = 0;
+
+    if (m_fseRegistered) {
+        std::ostringstream os;
+        m_fse->print (os);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+        m_fse->deregisterFlow (m_fseFlow);
+        m_fseRegistered = false;
+    }
+
+    auto gcc = std::dynamic_pointer_cast<rmcat::GccController> (m_controller);
+    if (gcc) {
+        gcc->setObserver (NULL);
+    }
 
-    m_rateShapingBuf.clear ();
-    m_rateShapingBytes = 0;
+    // Memory used by the controller's packet histories
+    m_controller->logHistoryStats ();
+    if (m_rtx) {
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId ()
+                     << " retransmissions: " << m_rtxPackets);
+    }
+    if (m_maxQueueDelayUs > 0) {
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId ()
+                     << " pacer: max queue delay(ms): " << m_maxQueueDelaySeenUs / 1000.
+                     << " frames dropped: " << m_framesDropped);
+    }
+    if (m_cwndEnabled) {
+        std::ostringstream os;
+        m_cwnd.print (os);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+    }
+    for (const auto& shadow : m_shadows) {
+        const uint64_t n = std::max<uint64_t> (shadow.samples, 1);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId ()
+                     << " shadow " << shadow.name
+                     << ": mean rate(bps): " << shadow.sumBps / n
+                     << " mean abs diff to primary(bps): " << shadow.sumAbsDiffBps / n
+                     << " samples: " << shadow.samples);
+    }
+    if (!m_layerCodecs.empty ()) {
+        std::ostringstream os;
+        m_allocator.print (Simulator::Now ().GetMicroSeconds (), os);
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId () << " " << os.str ());
+    }
+    if (m_fec) {
+        NS_LOG_INFO ("Node ID : " << GetNode ()->GetId ()
+                     << " fec: media: " << m_fecGenerator.getMediaPackets ()
+                     << " fec: " << m_fecGenerator.getFecPackets ()
+                     << " protection: " << m_fecGenerator.getProtection ());
+    }
 }
 
+/*
+ * Frames from the codec are split into packets of at most m_packetSize
+ * bytes, enqueued evenly over the frame interval (as
+ * syncodecs::ShapedPacketizer does). All packets of a frame carry the
+ * frame's capture time as RTP timestamp and the last one has the marker
+ * bit set, so that the receiver can reassemble and play out frames
+ */
 void GccSender::EnqueuePacket ()
 {
-    syncodecs::Codec& codec = *m_codec;
-    codec.setTargetRate (m_rBitrate);	// Media rate.
-    ++codec; // Advance codec/packetizer to next frame/packet
-    const auto bytesToSend = codec->first.size ();
+    SimPerfRecord::Count (SimPerfRecord::CODEC);
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    if (m_framePktsLeft == 0) {
+        if (m_fseRegistered) {
+            ApplyFseRate (false);
+        }
+        UpdateFecProtection ();
+        CalcBufferParams ();
+        // Media rate: FEC packets take their share of the target rate
+        const double protection = m_fec ? m_fecGenerator.getProtection () : 0.;
+        double mediaBps = m_rVin / (1. + protection);
+        if (m_cwndEnabled) {
+            mediaBps = std::max (mediaBps * m_cwnd.getPushbackRatio (),
+                                 std::min (mediaBps, MIN_PUSHBACK_BPS));
+        }
+        if (m_maxQueueDelayUs > 0) {
+            if (GetQueueDelayUs (nowUs) > m_maxQueueDelayUs) {
+                DropQueuedFrames ();
+            }
+            // Leave room to drain the backlog within the limit
+            const double drainBps = m_PacingQBytes.Get () * 8. * 1000. * 1000. / m_maxQueueDelayUs;
+            mediaBps = std::max (mediaBps - drainBps, std::min (mediaBps, MIN_PUSHBACK_BPS));
+        }
+        double frameInterval = 0.;
+        const uint32_t frameBytes = EncodeFrame (mediaBps, frameInterval);
+        NS_ASSERT (frameBytes > 0);
+        m_frameInterval = frameInterval;
+        m_frameRtpTs = m_rtpTsOffset + uint32_t (nowUs * 90 / 1000); // 90 kHz clock
+        m_frameBytesLeft = frameBytes;
+        m_framePktsLeft = (frameBytes + m_packetSize - 1) / m_packetSize;
+        m_framePktInterval = frameInterval / m_framePktsLeft;
+    }
+    // Spread the frame's bytes evenly among its remaining packets
+    const uint32_t bytesToSend = (m_frameBytesLeft + m_framePktsLeft - 1) / m_framePktsLeft;
     NS_ASSERT (bytesToSend > 0);
-    NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
+    NS_ASSERT (bytesToSend <= m_packetSize);
+    m_frameBytesLeft -= bytesToSend;
+    --m_framePktsLeft;
 
     // Push into Pacing Queue Buffer.
-    m_PacingQ.push_back (bytesToSend);
+    m_PacingQ.push_back (PacedPacket{bytesToSend, m_frameRtpTs, m_framePktsLeft == 0,
+                                     PKT_MEDIA, 0, rmcat::FecPacket{}, nowUs});
     m_PacingQBytes += bytesToSend;
 
-//    m_rateShapingBuf.push_back (bytesToSend);
-//    m_rateShapingBytes += bytesToSend;
-
     NS_LOG_INFO ("GccSender::EnqueuePacket, packet enqueued, packet length: " << bytesToSend
                  << ", buffer size: " << m_PacingQ.size ()
                  << ", buffer bytes: " << m_PacingQBytes);
 
-    double secsToNextEnqPacket = codec->second;
+    double secsToNextEnqPacket = m_framePktInterval;
     // std::cout << "secToNextEnqPacket:: " << secsToNextEnqPacket << "\n";
 
     Time tNext{Seconds (secsToNextEnqPacket)};
@@ -309,32 +720,176 @@ void GccSender::EnqueuePacket ()
 
     if (m_PacingQ.size () == 1) {
         // Buffer was empty
+        StartSendTimer (bytesToSend);
+    }
+}
+
+/*
+ * Get the next frame from the codec, or from the codecs of all enabled
+ * layers, at the given media rate. Returns the frame size in bytes, and
+ * the time until the next frame in seconds
+ */
+uint32_t GccSender::EncodeFrame (double mediaBps, double& frameInterval)
+{
+    if (m_layerCodecs.empty ()) {
+        syncodecs::Codec& codec = *m_codec;
+        codec.setTargetRate (mediaBps);
+        ++codec; // Advance codec/packetizer to next frame/packet
+        frameInterval = codec->second;
+        return codec->first.size ();
+    }
+
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    if (m_allocator.allocate (nowUs, float (mediaBps), m_layerBps)) {
+        NS_LOG_INFO ("GccSender::EncodeFrame, active layers: "
+                     << m_allocator.getActiveLayers () << ", media rate: " << mediaBps);
+    }
+    uint32_t frameBytes = 0;
+    for (size_t i = 0; i < m_layerCodecs.size (); ++i) {
+        if (m_layerBps[i] <= 0.f) {
+            continue; // disabled layer: not encoded
+        }
+        syncodecs::Codec& codec = *m_layerCodecs[i];
+        codec.setTargetRate (m_layerBps[i]);
+        ++codec;
+        frameBytes += codec->first.size ();
+        if (i == 0) {
+            frameInterval = codec->second;
+        }
+    }
+    return frameBytes;
+}
+
+void GccSender::StartSendTimer (uint32_t bytesToSend)
+{
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    const uint64_t usToNextSentPacket = nowUs < m_nextSendTstmpUs ?
+                                                m_nextSendTstmpUs - nowUs : 0;
+    NS_LOG_INFO ("(Re-)starting the send timer: nowUs " << nowUs
+                 << ", bytesToSend " << bytesToSend
+                 << ", usToNextSentPacket " << usToNextSentPacket
+                 << ", m_rBitrate " << m_rBitrate);
+
+   //  std::cout << "usToNextSentPacket:: " << usToNextSentPacket << "\n";
+    Time tNext{MicroSeconds (usToNextSentPacket)};
+    m_sendEvent = Simulator::Schedule (tNext, &GccSender::SendPacket, this, usToNextSentPacket);
+}
+
+/* Retransmissions and FEC packets go ahead of new media */
+void GccSender::EnqueuePriority (PacedPacket pkt)
+{
+    pkt.enqueueUs = Simulator::Now ().GetMicroSeconds ();
+    m_PacingQ.push_front (pkt);
+    m_PacingQBytes += pkt.size;
+    ++m_PacingQPriority;
+    if (!USE_BUFFER) {
+        m_sendEvent = Simulator::ScheduleNow (&GccSender::SendPacket, this, 0);
+    } else if (m_PacingQ.size () == 1) {
+        // Buffer was empty
+        StartSendTimer (pkt.size);
+    }
+}
+
+/*
+ * Time the oldest packet has been waiting in the pacing queue. Priority
+ * packets are pushed at the front, so the queue holds them newest first,
+ * followed by the media packets oldest first: the oldest of each is next
+ * to the boundary between the two
+ */
+uint64_t GccSender::GetQueueDelayUs (uint64_t nowUs) const
+{
+    uint64_t oldestUs = nowUs;
+    if (m_PacingQPriority > 0) {
+        oldestUs = std::min (oldestUs, m_PacingQ[m_PacingQPriority - 1].enqueueUs);
+    }
+    if (m_PacingQ.size () > m_PacingQPriority) {
+        oldestUs = std::min (oldestUs, m_PacingQ[m_PacingQPriority].enqueueUs);
+    }
+    return nowUs - oldestUs;
+}
+
+/*
+ * Drop the queued media packets of the frames none of whose packets were
+ * sent yet, so that the receiver sees no gap. The frame being sent, if
+ * any, goes on; retransmissions and FEC packets are kept
+ */
+void GccSender::DropQueuedFrames ()
+{
+    std::deque<PacedPacket> kept{};
+    bool dropped = false;
+    uint32_t droppedTs = 0;
+    for (const auto& pkt : m_PacingQ) {
+        const bool started = !m_lastMediaMarker && pkt.rtpTimestamp == m_lastMediaTs;
+        if (pkt.type != PKT_MEDIA || started) {
+            kept.push_back (pkt);
+            continue;
+        }
+        if (!dropped || pkt.rtpTimestamp != droppedTs) {
+            ++m_framesDropped;
+        }
+        dropped = true;
+        droppedTs = pkt.rtpTimestamp;
+        NS_ASSERT (m_PacingQBytes >= pkt.size);
+        m_PacingQBytes -= pkt.size;
+    }
+    if (dropped) {
+        NS_LOG_INFO ("GccSender::DropQueuedFrames, frames dropped: " << m_framesDropped
+                     << ", buffer size: " << kept.size ()
+                     << ", buffer bytes: " << m_PacingQBytes);
+    }
+    m_PacingQ.swap (kept);
+    if (USE_BUFFER && m_PacingQ.empty () && m_sendEvent.IsRunning ()) {
+        // No packet left for the pending send: the next packet enqueued
+        // restarts the send timer, still no earlier than the pacing allows
         const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
-        const uint64_t usToNextSentPacket = nowUs < m_nextSendTstmpUs ?
-                                                    m_nextSendTstmpUs - nowUs : 0;
-        NS_LOG_INFO ("(Re-)starting the send timer: nowUs " << nowUs
-                     << ", bytesToSend " << bytesToSend
-                     << ", usToNextSentPacket " << usToNextSentPacket
-                     << ", m_rBitrate " << m_rBitrate
-                     << ", secsToNextEnqPacket " << secsToNextEnqPacket);
-        
-       //  std::cout << "usToNextSentPacket:: " << usToNextSentPacket << "\n";
-        Time tNext{MicroSeconds (usToNextSentPacket)};
-        m_sendEvent = Simulator::Schedule (tNext, &GccSender::SendPacket, this, usToNextSentPacket);
+        m_nextSendTstmpUs = nowUs + Simulator::GetDelayLeft (m_sendEvent).GetMicroSeconds ();
+        Simulator::Cancel (m_sendEvent);
     }
 }
 
+void GccSender::UpdateFecProtection ()
+{
+    if (!m_fec || !m_fecAdaptive) {
+        return;
+    }
+    const double loss = m_controller->getLossFraction ();
+    m_fecGenerator.setProtection (std::min (m_fecMaxProtection, FEC_LOSS_GAIN * loss),
+                                  m_fecMask);
+}
+
 void GccSender::SendPacket (uint64_t usSlept)
 {
+    SimPerfRecord::Count (SimPerfRecord::PACER);
     NS_ASSERT (m_PacingQ.size () > 0);
     NS_ASSERT (m_PacingQBytes < MAX_QUEUE_SIZE_SANITY);
 
-    const auto bytesToSend = m_PacingQ.front ();
+    if (m_cwndEnabled) {
+        m_cwnd.setTargetRate (m_rBitrate);
+        if (m_cwnd.isCongested (Simulator::Now ().GetMicroSeconds ())) {
+            // Window full: hold the packet back until feedback comes back
+            m_sendEvent = Simulator::Schedule (MicroSeconds (CWND_POLL_US),
+                                               &GccSender::SendPacket, this, CWND_POLL_US);
+            return;
+        }
+    }
+
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    const PacedPacket pkt = m_PacingQ.front ();
+    const auto bytesToSend = pkt.size;
     NS_ASSERT (bytesToSend > 0);
-    NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
+    NS_ASSERT (bytesToSend <= m_packetSize + (pkt.type == PKT_FEC ? FEC_HEADER_SIZE : 0));
     m_PacingQ.pop_front ();
+    if (m_PacingQPriority > 0) {
+        NS_ASSERT (pkt.type != PKT_MEDIA);
+        --m_PacingQPriority;
+    }
     NS_ASSERT (m_PacingQBytes >= bytesToSend);
     m_PacingQBytes -= bytesToSend;
+    m_maxQueueDelaySeenUs = std::max (m_maxQueueDelaySeenUs, nowUs - pkt.enqueueUs);
+    if (pkt.type == PKT_MEDIA) {
+        m_lastMediaTs = pkt.rtpTimestamp;
+        m_lastMediaMarker = pkt.marker;
+    }
 
     NS_LOG_INFO ("GccSender::SendPacket, packet dequeued, packet length: " << bytesToSend
                  << ", buffer size: " << m_PacingQ.size ()
@@ -348,16 +903,26 @@ void GccSender::SendPacket (uint64_t usSlept)
     uint64_t oversleepUs = 0;
     Time tOver{MicroSeconds (oversleepUs)};
     m_sendOversleepEvent = Simulator::Schedule (tOver, &GccSender::SendOverSleep,
-                                                this, bytesToSend);
+                                                this, pkt, 0);
+
+    // Pace faster than the target rate if needed to drain the queue
+    // before its oldest packet exceeds the delay limit
+    CalcBufferParams ();
+    double pacingBps = m_rSend;
+    if (m_maxQueueDelayUs > 0 && m_PacingQBytes > 0) {
+        const uint64_t delayUs = GetQueueDelayUs (nowUs);
+        const uint64_t timeLeftUs = m_maxQueueDelayUs > delayUs + 1000 ?
+                                    m_maxQueueDelayUs - delayUs : 1000;
+        pacingBps = std::max (pacingBps, m_PacingQBytes.Get () * 8. * 1000. * 1000. / timeLeftUs);
+    }
 
     // usToNextSentPacketD = Time to send current data frame.
     // schedule next sendData
-    const double usToNextSentPacketD = double (bytesToSend) * 8. / m_rBitrate;
+    const double usToNextSentPacketD = double (bytesToSend) * 8. * 1000. * 1000. / pacingBps;
     const uint64_t usToNextSentPacket = uint64_t (usToNextSentPacketD);
 
     if (!USE_BUFFER || m_PacingQ.size () == 0) {
         // Buffer became empty
-        const auto nowUs = Simulator::Now ().GetMicroSeconds ();
         m_nextSendTstmpUs = nowUs + usToNextSentPacket;
         return;
     }
@@ -366,27 +931,149 @@ void GccSender::SendPacket (uint64_t usSlept)
     m_sendEvent = Simulator::Schedule (tNext, &GccSender::SendPacket, this, usToNextSentPacket);
 }
 
-void GccSender::SendOverSleep (uint32_t bytesToSend) {
+/*
+ * Media packets go on the media stream. Retransmissions and probe padding
+ * go on the retransmission stream (RFC 4588), FEC packets on the FEC
+ * stream, so that the media sequence numbers stay contiguous for frame
+ * reassembly. The transport-wide sequence number, in the header extension,
+ * covers all streams: the controller sees and gets feedback on every
+ * packet sent
+ */
+void GccSender::SendOverSleep (PacedPacket pkt, int probeClusterId) {
     const auto nowUs = Simulator::Now ().GetMicroSeconds ();
-    
-    m_controller->processSendPacket (nowUs, m_sequence, bytesToSend);
+    const bool rtxStream = pkt.type == PKT_RTX || probeClusterId > 0;
+    const bool fecStream = pkt.type == PKT_FEC;
+    const uint32_t bytesToSend = pkt.size + (pkt.type == PKT_RTX ? RTX_OSN_SIZE : 0);
+
+    {
+        SimPerfRecord::ControllerScope scope;
+        m_controller->processSendPacket (nowUs, m_sequence, bytesToSend, probeClusterId);
+        for (auto& shadow : m_shadows) {
+            shadow.controller->processSendPacket (nowUs, m_sequence, bytesToSend, probeClusterId);
+        }
+    }
+    if (m_cwndEnabled) {
+        m_cwnd.onPacketSent (nowUs, m_controller->unwrapSequence (m_sequence), bytesToSend);
+    }
 
-    ns3::RtpHeader header{96}; // 96: dynamic payload type, according to RFC 3551
-    header.SetSequence (m_sequence++);
+    uint8_t payloadType = RTP_MEDIA_PAYLOAD_TYPE;
+    uint32_t ssrc = m_ssrc;
+    uint16_t sequence = m_rtpSequence;
+    if (rtxStream) {
+        payloadType = RTX_PAYLOAD_TYPE;
+        ssrc = m_rtxSsrc;
+        sequence = m_rtxSequence++;
+    } else if (fecStream) {
+        payloadType = FEC_PAYLOAD_TYPE;
+        ssrc = m_fecSsrc;
+        sequence = m_fecSequence++;
+    }
+    ns3::RtpHeader header{payloadType};
+    header.SetSequence (sequence);
+    // Probe packets carry no media, only padding
+    header.SetPadding (probeClusterId > 0);
     NS_ASSERT (nowUs >= 0);
     
-    header.SetTimestamp (Simulator::Now ().GetMicroSeconds());
-    header.SetSsrc (m_ssrc);
-
-    auto packet = Create<Packet> (bytesToSend);
+    header.SetMarker (pkt.marker);
+    header.SetTimestamp (pkt.rtpTimestamp);
+    // Send time (used for delay-based estimation), in the header extension
+    header.SetSendTime (uint32_t (nowUs));
+    header.SetTransportSequence (m_sequence++);
+    header.SetSsrc (ssrc);
+
+    Ptr<Packet> packet;
+    if (fecStream) {
+        // Payload starts with the FEC header
+        std::vector<uint8_t> payload (bytesToSend, 0);
+        pkt.fec.write (payload.data ());
+        packet = Create<Packet> (payload.data (), bytesToSend);
+    } else if (pkt.type == PKT_RTX) {
+        // Payload starts with the original sequence number
+        std::vector<uint8_t> payload (bytesToSend, 0);
+        payload[0] = uint8_t (pkt.sequence >> 8);
+        payload[1] = uint8_t (pkt.sequence & 0xff);
+        packet = Create<Packet> (payload.data (), bytesToSend);
+        ++m_rtxPackets;
+    } else {
+        packet = Create<Packet> (bytesToSend);
+    }
     packet->AddHeader (header);
+    const bool mediaStream = !rtxStream && !fecStream;
+    if (mediaStream) {
+        if (m_rtx) {
+            m_rtxHistory[m_rtpSequence % RTX_HISTORY_SIZE] =
+                RtxEntry{true, m_rtpSequence, pkt.size, pkt.rtpTimestamp, pkt.marker, 0};
+        }
+        ++m_rtpSequence;
+        ++m_packetCount;
+        m_octetCount += bytesToSend;
+    }
 
     NS_LOG_INFO ("GccSender::SendOverSleep, " << packet->ToString ());
     m_socket->SendTo (packet, 0, InetSocketAddress{m_destIP, m_destPort});
+
+    if (mediaStream && m_fec) {
+        std::vector<rmcat::FecPacket> fecPackets{};
+        m_fecGenerator.addMediaPacket (sequence, pkt.rtpTimestamp, pkt.marker, pkt.size,
+                                       fecPackets);
+        // In order, ahead of new media
+        for (auto it = fecPackets.rbegin (); it != fecPackets.rend (); ++it) {
+            EnqueuePriority (PacedPacket{it->size, pkt.rtpTimestamp, false, PKT_FEC, 0, *it, 0});
+        }
+    }
+}
+
+/*
+ * Probe clusters are sent on top of the media packets, paced at the
+ * cluster's rate. They consist of padding-only packets, so that they do not
+ * interfere with the codec and the pacing queue
+ */
+void GccSender::StartProbeCluster ()
+{
+    if (m_probePktsLeft > 0) {
+        return; // A cluster is still being sent
+    }
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    if (!m_controller->getProbeCluster (nowUs, m_probeCluster)) {
+        return;
+    }
+    NS_ASSERT (m_probeCluster.id > 0);
+    NS_ASSERT (m_probeCluster.bitrateBps > 0);
+    const uint32_t pktsForBytes = (m_probeCluster.minBytes + m_packetSize - 1) /
+                                  m_packetSize;
+    m_probePktsLeft = std::max (m_probeCluster.minPackets, pktsForBytes);
+    NS_LOG_INFO ("GccSender::StartProbeCluster, cluster " << m_probeCluster.id
+                 << ", bitrate " << m_probeCluster.bitrateBps
+                 << ", packets " << m_probePktsLeft);
+    SendProbePacket ();
+}
+
+void GccSender::SendProbePacket ()
+{
+    SimPerfRecord::Count (SimPerfRecord::PACER);
+    NS_ASSERT (m_probePktsLeft > 0);
+    const uint32_t bytesToSend = m_packetSize;
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    const uint32_t rtpTimestamp = m_rtpTsOffset + uint32_t (nowUs * 90 / 1000);
+    SendOverSleep (PacedPacket{bytesToSend, rtpTimestamp, false, PKT_MEDIA, 0, rmcat::FecPacket{},
+                               Simulator::Now ().GetMicroSeconds ()},
+                   m_probeCluster.id);
+    --m_probePktsLeft;
+
+    if (m_probePktsLeft == 0) {
+        // Cluster over; there may be another one waiting
+        StartProbeCluster ();
+        return;
+    }
+    const double usToNextProbePacketD = double (bytesToSend) * 8. * 1000. * 1000. /
+                                        m_probeCluster.bitrateBps;
+    Time tNext{MicroSeconds (uint64_t (usToNextProbePacketD))};
+    m_probeEvent = Simulator::Schedule (tNext, &GccSender::SendProbePacket, this);
 }
 
 void GccSender::RecvPacket (Ptr<Socket> socket)
 {
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
     Address remoteAddr;
     auto Packet = m_socket->RecvFrom (remoteAddr);
     NS_ASSERT (Packet);
@@ -396,8 +1083,25 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
     NS_ASSERT (rIPAddress == m_destIP);
     NS_ASSERT (rport == m_destPort);
 
-    // get the feedback header
     const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    RtcpHeader common{};
+    Packet->PeekHeader (common);
+    if (common.GetPacketType () == RtcpHeader::RTP_PSFB &&
+        common.GetTypeOrCount () == RtcpHeader::RTCP_PSFB_AFB) {
+        RecvRemb (Packet, nowUs);
+        return;
+    }
+    if (common.GetPacketType () == RtcpHeader::RTCP_RR) {
+        RecvReceiverReport (Packet, nowUs);
+        return;
+    }
+    if (common.GetPacketType () == RtcpHeader::RTP_FB &&
+        common.GetTypeOrCount () == RtcpHeader::RTCP_RTPFB_GNACK) {
+        RecvNack (Packet, nowUs);
+        return;
+    }
+
+    // get the feedback header
     CCFeedbackHeader header{};
     NS_LOG_INFO ("GccSender::RecvPacket, " << Packet->ToString ());
     Packet->RemoveHeader (header);
@@ -405,12 +1109,12 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
     header.GetSsrcList (ssrcList);
     if (ssrcList.count (m_ssrc) == 0) {
         NS_LOG_INFO ("GccSender::Received Feedback packet with no data for SSRC " << m_ssrc);
-        CalcBufferParams (nowUs);
         return;
     }
     std::vector<std::pair<uint16_t,
                           CCFeedbackHeader::MetricBlock> > feedback{};
     const bool res = header.GetMetricList (m_ssrc, feedback);
+    m_feedbackTrace (feedback.size ());
     auto l_inter_arrival = 0;
     auto l_inter_departure = 0;
     int64_t l_inter_delay_var = 0;
@@ -418,21 +1122,30 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
     NS_ASSERT (res);
     for (auto& item : feedback) {
         const auto sequence = item.first;
+        // Lookups are done by unwrapped sequence, which survives wrapping
+        const uint64_t id = m_controller->unwrapSequence (sequence);
         // std::cout << m_ssrc << "\trecv seq. :: " << sequence << "\n";
         const auto timestampUs = item.second.m_timestampUs;
-        const auto curr_pkt_send_time = m_controller->GetPacketTxTimestamp(sequence);
+        const auto curr_pkt_send_time = m_controller->GetPacketTxTimestamp(id);
+        if (m_cwndEnabled) {
+            m_cwnd.onPacketAcked (nowUs, id);
+        }
+        if (m_fseRegistered && curr_pkt_send_time != uint64_t (-1)) {
+            // Shared bottleneck detection
+            m_fse->onDelaySample (m_fseFlow, nowUs, timestampUs - curr_pkt_send_time);
+        }
 
         if(m_firstFeedback){
             // std::cout << m_ssrc << "\tFirst Feedback\n";
             m_gid = 0;
-            m_curr_group_start_seq = sequence;		// Sequence of Group's first packet
-            m_curr_group_time = m_controller->GetPacketTxTimestamp(sequence);        // Departure time of Group's first packet
+            m_curr_group_start_seq = id;		// Sequence of Group's first packet
+            m_curr_group_time = m_controller->GetPacketTxTimestamp(id);        // Departure time of Group's first packet
             m_firstFeedback = false;
             
             m_group_size = 0;
-            m_group_size += m_controller->GetPacketSize(sequence);
+            m_group_size += m_controller->GetPacketSize(id);
             m_prev_time = timestampUs;
-            m_prev_seq = sequence;
+            m_prev_seq = id;
             continue;
         }
         /* 
@@ -451,9 +1164,9 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
                 m_prev_group_size = m_group_size;
                 
                 m_group_size = 0;
-                m_group_size += m_controller->GetPacketSize(sequence);
+                m_group_size += m_controller->GetPacketSize(id);
 
-                m_curr_group_start_seq = sequence;
+                m_curr_group_start_seq = id;
 
 		m_prev_group_atime = m_prev_time;	// Arrival time of Previous Group's last packet.
 		m_curr_group_time = curr_pkt_send_time;
@@ -486,9 +1199,9 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
                 m_prev_group_size = m_group_size;
 
                 m_group_size = 0;
-                m_group_size += m_controller->GetPacketSize(sequence);
+                m_group_size += m_controller->GetPacketSize(id);
 
-                m_curr_group_start_seq = sequence;
+                m_curr_group_start_seq = id;
 /*	        std::cout << m_ssrc << "\t" << m_gid << " Group Changed\n";
                 std::cout << "1. " << m_prev_group_seq << "\n";
                 std::cout << "2. " << m_prev_group_atime << "\n";
@@ -504,13 +1217,13 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
             const auto ecn = item.second.m_ecn;
             NS_ASSERT (timestampUs <= nowUs);
         
-            m_controller->processFeedback (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
+            FeedbackToControllers (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
 
             // Increment
             // Group Size, previous packet receive time, previous packet sequence.
-            m_group_size += m_controller->GetPacketSize(sequence);
+            m_group_size += m_controller->GetPacketSize(id);
             m_prev_time = timestampUs;
-            m_prev_seq = sequence;
+            m_prev_seq = id;
 
             continue;
         }
@@ -525,12 +1238,12 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
            
             NS_ASSERT (timestampUs <= nowUs);
         
-            m_controller->processFeedback (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
+            FeedbackToControllers (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
 
             // Increment
-            m_group_size += m_controller->GetPacketSize(sequence);
+            m_group_size += m_controller->GetPacketSize(id);
             m_prev_time = timestampUs;
-            m_prev_seq = sequence;
+            m_prev_seq = id;
 
             continue;
         } else {
@@ -543,9 +1256,9 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
                 m_prev_group_size = m_group_size;
 
                 m_group_size = 0;
-                m_group_size += m_controller->GetPacketSize(sequence);
+                m_group_size += m_controller->GetPacketSize(id);
 
-                m_curr_group_start_seq = sequence;
+                m_curr_group_start_seq = id;
 
 		m_prev_group_atime = m_prev_time;	// Arrival time of Previous Group's last packet.
 		m_curr_group_time = curr_pkt_send_time;
@@ -575,9 +1288,9 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
                 m_prev_group_size = m_group_size;
 
                 m_group_size = 0;
-                m_group_size += m_controller->GetPacketSize(sequence);
+                m_group_size += m_controller->GetPacketSize(id);
 
-                m_curr_group_start_seq = sequence;
+                m_curr_group_start_seq = id;
   /*              std::cout << m_ssrc << "\tGroup Changed\n";
                 std::cout << "1. " << m_prev_group_seq << "\n";
                 std::cout << "2. " << m_prev_group_atime << "\n";
@@ -594,42 +1307,277 @@ void GccSender::RecvPacket (Ptr<Socket> socket)
         const auto ecn = item.second.m_ecn;
         NS_ASSERT (timestampUs <= nowUs);
         
-        m_controller->processFeedback (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
+        FeedbackToControllers (nowUs, sequence, timestampUs, l_inter_arrival, l_inter_departure, l_inter_delay_var, m_group_size_inter, m_prev_time, ecn);
 
     
         // Increment
-        m_group_size += m_controller->GetPacketSize(sequence);
+        m_group_size += m_controller->GetPacketSize(id);
         m_prev_time = timestampUs;
-        m_prev_seq = sequence;
+        m_prev_seq = id;
     }
 
-    // TODO MAYBE THIS PART IS NOT NEEDED.
-    // CalcBufferParams (nowUs);
-    const auto r_rate = m_controller->getSendBps();
-    m_rBitrate = r_rate;
+    UpdateRate ();
+    LogShadowRates (nowUs);
+    if (m_cwndEnabled) {
+        m_cwnd.updatePushback (m_PacingQBytes);
+    }
+
+    // The estimate may have triggered further probing
+    StartProbeCluster ();
 }
 
-void GccSender::CalcBufferParams (uint64_t nowUs)
+/* The timer only runs if a controller, primary or shadow, acts upon it */
+void GccSender::StartControllerTimer ()
 {
-    /*
-    //Calculate rate shaping buffer parameters
-    const auto r_ref = m_controller->getBandwidth (nowUs); // bandwidth in bps
-    float bufferLen;
-    //Purpose: smooth out timing issues between send and receive
-    // feedback for the common case: buffer oscillating between 0 and 1 packets
-    if (m_rateShapingBuf.size () > 1) {
-        bufferLen = static_cast<float> (m_rateShapingBytes);
-    } else {
-        bufferLen = 0;
+    bool usesTimer = m_controller->usesTimer ();
+    for (const auto& shadow : m_shadows) {
+        usesTimer = usesTimer || shadow.controller->usesTimer ();
+    }
+    if (usesTimer) {
+        m_timerEvent = Simulator::Schedule (MicroSeconds (CC_TIMER_PERIOD_US),
+                                            &GccSender::ControllerTimer, this);
+    }
+}
+
+/*
+ * Lets the controller act when no feedback comes in (e.g., feedback lost on
+ * a congested reverse path); the rate only changes if the controller says so
+ */
+void GccSender::ControllerTimer ()
+{
+    const uint32_t prevBps = m_controller->getSendBps ();
+    {
+        SimPerfRecord::ControllerScope scope;
+        m_controller->processTimer (Simulator::Now ().GetMicroSeconds ());
+        for (auto& shadow : m_shadows) {
+            shadow.controller->processTimer (Simulator::Now ().GetMicroSeconds ());
+        }
+    }
+    if (m_controller->getSendBps () != prevBps) {
+        NS_LOG_INFO ("GccSender::ControllerTimer, new rate: " << m_controller->getSendBps ());
+        UpdateRate ();
+    }
+    m_timerEvent = Simulator::Schedule (MicroSeconds (CC_TIMER_PERIOD_US),
+                                        &GccSender::ControllerTimer, this);
+}
+
+/* Every controller, primary and shadows, gets the same feedback */
+void GccSender::FeedbackToControllers (uint64_t nowUs, uint16_t sequence, uint64_t rxTimestampUs,
+                                       uint64_t interArrival, uint64_t interDeparture,
+                                       int64_t interDelayVar, int interGroupSize,
+                                       int64_t arrivalTime, uint8_t ecn)
+{
+    SimPerfRecord::ControllerScope scope;
+    m_controller->processFeedback (nowUs, sequence, rxTimestampUs, interArrival, interDeparture,
+                                   interDelayVar, interGroupSize, arrivalTime, ecn);
+    for (auto& shadow : m_shadows) {
+        shadow.controller->processFeedback (nowUs, sequence, rxTimestampUs, interArrival,
+                                            interDeparture, interDelayVar, interGroupSize,
+                                            arrivalTime, ecn);
     }
+}
 
-    syncodecs::Codec& codec = *m_codec;
+/*
+ * Estimates of the shadow controllers next to the primary's, which drives
+ * the traffic. Also accumulated for the summary printed at the end
+ */
+void GccSender::LogShadowRates (uint64_t nowUs)
+{
+    if (m_shadows.empty ()) {
+        return;
+    }
+    const double primaryBps = m_controller->getSendBps ();
+    std::ostringstream os;
+    os << "shadow_log ts: " << nowUs / 1000 << " primary: " << primaryBps;
+    for (auto& shadow : m_shadows) {
+        const double bps = shadow.controller->getSendBps ();
+        os << " " << shadow.name << ": " << bps;
+        shadow.sumBps += bps;
+        shadow.sumAbsDiffBps += std::fabs (bps - primaryBps);
+        ++shadow.samples;
+    }
+    NS_LOG_INFO (os.str ());
+}
 
-    // TODO (deferred): encapsulate rate shaping buffer in a separate class
-    if (USE_BUFFER && static_cast<bool> (codec)) {
-        const float fps = 1. / static_cast<float>  (codec->second);
-        m_rVin = std::max<float> (m_minBw, r_ref - BETA_V * 8. * bufferLen * fps);
-        m_rSend = r_ref + BETA_S * 8. * bufferLen * fps;
+/* New rate from the controller, shared out by the flow state exchange if coupled */
+void GccSender::UpdateRate ()
+{
+    if (!m_fseRegistered) {
+        m_rBitrate = m_controller->getSendBps ();
+        return;
+    }
+    // No maximal rate set: the application takes whatever it gets
+    const float desiredBps = m_maxBw > 0 ? m_maxBw : std::numeric_limits<float>::max ();
+    m_fse->update (m_fseFlow, m_controller->getSendBps (), desiredBps);
+    ApplyFseRate (true);
+}
+
+/*
+ * The rate assigned to the flow changes as well when the other flows of its
+ * group update theirs: the controller goes on from the assigned rate
+ */
+void GccSender::ApplyFseRate (bool force)
+{
+    const float rate = m_fse->getRate (m_fseFlow);
+    if (!force && rate == m_fseRateBps) {
+        return;
+    }
+    m_fseRateBps = rate;
+    m_controller->setCurrentBw (rate);
+    m_rBitrate = std::max (rate, m_minBw);
+    if (m_maxBw > 0) {
+        m_rBitrate = std::min (m_rBitrate.Get (), double (m_maxBw));
+    }
+}
+
+void GccSender::RecvRemb (Ptr<Packet> packet, uint64_t nowUs)
+{
+    RembHeader header{};
+    NS_LOG_INFO ("GccSender::RecvRemb, " << packet->ToString ());
+    packet->RemoveHeader (header);
+    if (header.GetSsrcs ().count (m_ssrc) == 0) {
+        NS_LOG_INFO ("GccSender::Received REMB packet with no data for SSRC " << m_ssrc);
+        return;
+    }
+    {
+        SimPerfRecord::ControllerScope scope;
+        m_controller->processRemb (nowUs, header.GetBitrate ());
+        for (auto& shadow : m_shadows) {
+            shadow.controller->processRemb (nowUs, header.GetBitrate ());
+        }
+    }
+    UpdateRate ();
+    LogShadowRates (nowUs);
+}
+
+void GccSender::RecvNack (Ptr<Packet> packet, uint64_t nowUs)
+{
+    NackHeader header{};
+    NS_LOG_INFO ("GccSender::RecvNack, " << packet->ToString ());
+    packet->RemoveHeader (header);
+    if (!m_rtx || header.GetMediaSsrc () != m_ssrc) {
+        return;
+    }
+    std::vector<uint16_t> sequences{};
+    header.GetSequences (sequences);
+    // Ahead of new media, in the order requested
+    for (auto it = sequences.rbegin (); it != sequences.rend (); ++it) {
+        RtxEntry& entry = m_rtxHistory[*it % RTX_HISTORY_SIZE];
+        if (!entry.valid || entry.sequence != *it) {
+            NS_LOG_INFO ("GccSender::RecvNack, packet " << *it << " no longer in history");
+            continue;
+        }
+        if (entry.lastRtxUs != 0 && nowUs < entry.lastRtxUs + m_rttUs) {
+            // The previous retransmission may still be on its way
+            continue;
+        }
+        entry.lastRtxUs = nowUs;
+        EnqueuePriority (PacedPacket{entry.size, entry.rtpTimestamp, entry.marker,
+                                     PKT_RTX, entry.sequence, rmcat::FecPacket{}, 0});
+    }
+}
+
+void GccSender::SendSenderReport ()
+{
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
+    const uint64_t nowUs = Simulator::Now ().GetMicroSeconds ();
+    SenderReportHeader header{};
+    header.SetSendSsrc (m_ssrc);
+    header.SetNtpTimestampUs (nowUs);
+    // Same 90 kHz clock as the media packets, so that the receiver can map
+    // RTP timestamps to capture wallclock times
+    header.SetRtpTimestamp (m_rtpTsOffset + uint32_t (nowUs * 90 / 1000));
+    header.SetPacketCount (m_packetCount);
+    header.SetOctetCount (m_octetCount);
+
+    auto packet = Create<Packet> ();
+    packet->AddHeader (header);
+    NS_LOG_INFO ("GccSender::SendSenderReport, " << packet->ToString ());
+    m_socket->SendTo (packet, 0, InetSocketAddress{m_destIP, m_destPort});
+    UpdateAvgRtcpSize (packet->GetSize ());
+    m_rtcpInitial = false;
+
+    const double rtcpInterval = RtcpReportInterval (2, 1, m_rBitrate, true,
+                                                    m_avgRtcpSize, m_rtcpInitial);
+    m_rtcpEvent = Simulator::Schedule (Seconds (rtcpInterval), &GccSender::SendSenderReport, this);
+}
+
+void GccSender::RecvReceiverReport (Ptr<Packet> packet, uint64_t nowUs)
+{
+    ReceiverReportHeader header{};
+    NS_LOG_INFO ("GccSender::RecvReceiverReport, " << packet->ToString ());
+    UpdateAvgRtcpSize (packet->GetSize ());
+    packet->RemoveHeader (header);
+    for (const auto& block : header.GetReportBlocks ()) {
+        if (block.m_ssrc != m_ssrc) {
+            continue;
+        }
+        // RTT = A - LSR - DLSR (RFC 3550, section 6.4.1)
+        uint64_t rttUs = 0;
+        if (block.m_lsr != 0) {
+            const uint32_t arrival = RtcpUsToCompactNtp (nowUs);
+            const int32_t rtt = int32_t (arrival - block.m_lsr - block.m_dlsr);
+            if (rtt > 0) {
+                rttUs = RtcpCompactNtpToUs (uint32_t (rtt));
+                m_rttUs = rttUs;
+            }
+        }
+        uint32_t packetsExpected = 0;
+        if (m_lastRrValid) {
+            packetsExpected = block.m_extHighestSeq - m_lastRrExtSeq;
+        }
+        m_lastRrValid = true;
+        m_lastRrExtSeq = block.m_extHighestSeq;
+
+        NS_LOG_INFO ("GccSender::RecvReceiverReport, rtt " << rttUs
+                     << " us, fraction lost " << int (block.m_fractionLost)
+                     << ", cumulative lost " << block.m_cumulativeLost
+                     << ", jitter " << block.m_jitter);
+        const uint32_t prevBps = m_controller->getSendBps ();
+        {
+            SimPerfRecord::ControllerScope scope;
+            m_controller->processReceiverReport (nowUs, rttUs, block.m_fractionLost,
+                                                 packetsExpected);
+            for (auto& shadow : m_shadows) {
+                shadow.controller->processReceiverReport (nowUs, rttUs, block.m_fractionLost,
+                                                          packetsExpected);
+            }
+        }
+        // Loss-based change of the estimate: with REMB, no transport feedback
+        // would pick it up until the next REMB
+        if (m_controller->getSendBps () != prevBps) {
+            NS_LOG_INFO ("GccSender::RecvReceiverReport, new rate: " << m_controller->getSendBps ());
+            UpdateRate ();
+        }
+        return;
+    }
+    NS_LOG_INFO ("GccSender::Received RR packet with no data for SSRC " << m_ssrc);
+}
+
+void GccSender::UpdateAvgRtcpSize (uint32_t packetSize)
+{
+    // RFC 3550, section 6.3.3
+    const double size = packetSize + IPV4_UDP_OVERHEAD;
+    m_avgRtcpSize = size / 16. + m_avgRtcpSize * 15. / 16.;
+}
+
+/*
+ * Encoder and sending rates around the target rate (draft-ietf-rmcat-nada,
+ * section 5.2), with the pacing queue as the rate shaping buffer
+ */
+void GccSender::CalcBufferParams ()
+{
+    const double r_ref = m_rBitrate;
+    //Purpose: smooth out timing issues between send and receive
+    // feedback for the common case: buffer oscillating between 0 and 1 packets
+    const double bufferLen = m_PacingQ.size () > 1 ? m_PacingQBytes.Get () : 0.;
+
+    if (m_rateShaping && m_frameInterval > 0.) {
+        const double fps = 1. / m_frameInterval;
+        m_rVin = std::max (r_ref - GCC_BETA_V * 8. * bufferLen * fps,
+                           std::min (r_ref, MIN_PUSHBACK_BPS));
+        m_rVin = std::max (m_rVin, double (m_minBw));
+        m_rSend = r_ref + GCC_BETA_S * 8. * bufferLen * fps;
         NS_LOG_INFO ("New rate shaping buffer parameters: r_ref " << r_ref
                      << ", m_rVin " << m_rVin
                      << ", m_rSend " << m_rSend
@@ -639,7 +1587,6 @@ void GccSender::CalcBufferParams (uint64_t nowUs)
         m_rVin = r_ref;
         m_rSend = r_ref;
     }
-    */
 }
 
 }
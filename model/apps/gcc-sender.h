@@ -29,17 +29,54 @@
 #define RMCAT_SENDER_H
 
 #include "rmcat-constants.h"
+#include "fec-generator.h"
+#include "bitrate-allocator.h"
+#include "congestion-window.h"
 #include "ns3/syncodecs.h"
 #include "ns3/sender-based-controller.h"
+#include "ns3/gcc-controller.h"
+#include "ns3/flow-state-exchange.h"
 #include "ns3/socket.h"
 #include "ns3/application.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace ns3 {
 
 class GccSender: public Application
 {
 public:
+    /**
+     * Attributes: GccConfigFile, a file of GCC parameters (see
+     * #rmcat::GccConfig ), and GccParameters, a list of name=value
+     * overrides applied after it. Both only apply if the controller is a
+     * #rmcat::GccController , when the application starts
+     *
+     * Trace sources: TargetBitrate and PacingQueueBytes; DelayOffset,
+     * DelayThreshold, DetectorState, RateControlState, RateControlRegion and
+     * LossFraction, from a #rmcat::GccController only; Feedback, on the
+     * arrival of every feedback packet
+     */
+    static TypeId GetTypeId ();
+
+    /**
+     * TracedValue callback signature for the states of the controller (see
+     * #rmcat::GccObserver )
+     *
+     * @param [in] oldValue Previous state
+     * @param [in] newValue New state
+     */
+    typedef void (* StateTracedCallback) (char oldValue, char newValue);
+
+    /**
+     * TracedCallback signature for the arrival of feedback
+     *
+     * @param [in] packets Number of packets reported in the feedback
+     */
+    typedef void (* FeedbackTracedCallback) (uint32_t packets);
 
     GccSender ();
     virtual ~GccSender ();
@@ -49,64 +86,329 @@ public:
     void SetCodec (std::shared_ptr<syncodecs::Codec> codec);
     void SetCodecType (SyncodecType codecType);
 
+    /**
+     * Set the maximum payload size of media (and probe) packets, up to
+     * MAX_PACKET_SIZE. Must be called before SetCodecType and Setup, as
+     * frames are split into packets of this size
+     */
+    void SetPacketSize (uint32_t packetSize);
+
+    /**
+     * Add a layer to a layered (simulcast or scalable) encoding, on top of
+     * the layers already added. Once layers are added, the codec set with
+     * SetCodec or SetCodecType is no longer used: each layer is encoded by
+     * its own codec, at the rate allocated to it out of the target rate.
+     * Layers are enabled and disabled as the target rate changes; the frames
+     * of all enabled layers are sent together, at the frame interval of the
+     * base (first) layer
+     *
+     * @param [in] codec Codec encoding the layer
+     * @param [in] minBps Minimum rate the layer can be encoded at
+     * @param [in] targetBps Rate of the layer when upper layers are enabled
+     * @param [in] maxBps Rate the layer is capped at
+     */
+    void AddLayer (std::shared_ptr<syncodecs::Codec> codec,
+                   float minBps, float targetBps, float maxBps);
+
     void SetController (std::shared_ptr<rmcat::SenderBasedController> controller);
 
+    /**
+     * Add a shadow controller, run next to the one set with SetController
+     * (the primary). Shadows are fed the same sent packets, feedback,
+     * REMB messages and receiver reports as the primary, but never drive
+     * the traffic: their estimates are only logged next to the primary's,
+     * so that controllers can be compared on the very same run
+     *
+     * @param [in] controller Shadow controller
+     * @param [in] name Name of the controller in the logs
+     */
+    void AddShadowController (std::shared_ptr<rmcat::SenderBasedController> controller,
+                              const std::string& name);
+
+    /**
+     * Couple the congestion controller with those of the other flows
+     * registered with the same flow state exchange (RFC 8699), typically
+     * all the flows of the sender node. The controller's rate is shared out
+     * among the flows found to share a bottleneck, and the controller goes
+     * on from the share assigned to this flow. Must be called before the
+     * application starts
+     *
+     * @param [in] fse Flow state exchange shared by the coupled flows
+     * @param [in] priority Weight of this flow in the share of the rate
+     */
+    void SetFlowStateExchange (std::shared_ptr<rmcat::FlowStateExchange> fse,
+                               float priority);
+
     void SetRinit (float Rinit);
     void SetRmin (float Rmin);
     void SetRmax (float Rmax);
 
     void Setup (Ipv4Address dest_ip, uint16_t dest_port);
 
+    /**
+     * Send media packets as ECN-capable, with the ECT(1) codepoint (L4S
+     * identifier, RFC 9331). The receiver echoes the codepoint of every
+     * packet in its feedback, so that the controller reacts to CE marks
+     * set by an AQM before the bottleneck queue builds up
+     */
+    void EnableEcn ();
+
+    /**
+     * Retransmit the media packets NACKed by the receiver (RFC 4585), on
+     * the retransmission stream (RFC 4588). Recently sent packets are kept
+     * in a bounded history; retransmissions go through the pacing queue,
+     * ahead of new media, and count towards the sending rate like any
+     * other packet
+     */
+    void EnableRtx ();
+
+    /**
+     * Protect the media packets with XOR-based forward error correction,
+     * sent on a separate FEC stream. The media rate leaves room for the
+     * FEC packets within the controller's target rate
+     *
+     * @param [in] protection Ratio of FEC packets to media packets; when
+     *                        adaptive, the maximum ratio
+     * @param [in] mask How the media packets are distributed among the FEC
+     *                  packets of a block
+     * @param [in] adaptive Whether the ratio follows the loss rate seen by
+     *                      the controller (none without losses)
+     */
+    void EnableFec (double protection, rmcat::FecMaskType mask, bool adaptive);
+
+    /**
+     * Bound the data in flight to a window derived from the target rate
+     * and the minimal RTT. The pacer holds packets back while the window
+     * is full (e.g., feedback stalls or the path delay jumps), and the
+     * encoder's target rate is pushed back while the window fills up
+     */
+    void EnableCongestionWindow ();
+
+    /**
+     * Bound the time packets spend in the pacing queue (no limit by
+     * default). The pacer speeds up so as to drain the queue before its
+     * oldest packet exceeds the limit, and the encoder's target rate leaves
+     * room for the backlog. If the limit is exceeded nonetheless (e.g., the
+     * codec overshoots), the frames not sent yet are dropped
+     *
+     * @param [in] maxQueueDelayUs Limit in microseconds, 0 for no limit
+     */
+    void SetMaxQueueDelay (uint64_t maxQueueDelayUs = PACER_MAX_QUEUE_DELAY_US);
+
+    /**
+     * Switch the rate shaping buffer on or off; it may be switched at any
+     * time while the application runs. When on, the pacing queue acts as
+     * the rate shaping buffer of draft-ietf-rmcat-nada: the encoder's target
+     * rate is lowered, and the pacing rate raised, in proportion to the
+     * bytes queued (GCC_BETA_V and GCC_BETA_S). When off, both follow the
+     * controller's rate
+     *
+     * @param [in] enable Whether to shape the rates with the buffer occupancy
+     */
+    void SetRateShaping (bool enable);
+
 private:
+    /* Forwards the state of a GCC controller to the trace sources */
+    class GccTraceAdapter: public rmcat::GccObserver
+    {
+    public:
+        explicit GccTraceAdapter (GccSender& sender);
+        virtual void onDetectorUpdate (double offsetMs, double thresholdMs, char hypothesis);
+        virtual void onRateControlUpdate (char state, char region);
+        virtual void onLossFraction (float lossFraction);
+    private:
+        GccSender& m_sender;
+    };
+
+    enum PacketType {
+        PKT_MEDIA = 0,
+        PKT_RTX,                // Retransmission
+        PKT_FEC
+    };
+
+    /* Packet waiting in the pacing queue */
+    struct PacedPacket {
+        uint32_t size;
+        uint32_t rtpTimestamp;  // Capture time of its frame (90 kHz)
+        bool marker;            // Last packet of its frame
+        PacketType type;
+        uint16_t sequence;      // Original RTP sequence of a retransmission
+        rmcat::FecPacket fec;   // FEC packets only
+        uint64_t enqueueUs;     // Time it entered the pacing queue
+    };
+
     virtual void StartApplication ();
     virtual void StopApplication ();
 
     void EnqueuePacket ();
+    uint32_t EncodeFrame (double mediaBps, double& frameInterval);
     void SendPacket (uint64_t usSlept);
-    void SendOverSleep (uint32_t bytesToSend);
+    void StartSendTimer (uint32_t bytesToSend);
+    void EnqueuePriority (PacedPacket pkt);
+    uint64_t GetQueueDelayUs (uint64_t nowUs) const;
+    void DropQueuedFrames ();
+    void UpdateFecProtection ();
+    void SendOverSleep (PacedPacket pkt, int probeClusterId);
+    void StartProbeCluster ();
+    void SendProbePacket ();
     void RecvPacket (Ptr<Socket> socket);
-    void CalcBufferParams (uint64_t nowUs);
+    void StartControllerTimer ();
+    void ControllerTimer ();
+    void FeedbackToControllers (uint64_t nowUs, uint16_t sequence, uint64_t rxTimestampUs,
+                                uint64_t interArrival, uint64_t interDeparture,
+                                int64_t interDelayVar, int interGroupSize,
+                                int64_t arrivalTime, uint8_t ecn);
+    void LogShadowRates (uint64_t nowUs);
+    void UpdateRate ();
+    void ApplyFseRate (bool force);
+    void RecvRemb (Ptr<Packet> packet, uint64_t nowUs);
+    void RecvNack (Ptr<Packet> packet, uint64_t nowUs);
+    void SendSenderReport ();
+    void RecvReceiverReport (Ptr<Packet> packet, uint64_t nowUs);
+    void UpdateAvgRtcpSize (uint32_t packetSize);
+    void CalcBufferParams ();
+    void ApplyGccConfig ();
+    static void RestartFeedbackTimeout (std::shared_ptr<rmcat::SenderBasedController> controller,
+                                        uint64_t nowUs);
 
 private:
     std::shared_ptr<syncodecs::Codec> m_codec;
     std::shared_ptr<rmcat::SenderBasedController> m_controller;
+    std::string m_gccConfigFile;    // GccConfigFile attribute
+    std::string m_gccParameters;    // GccParameters attribute
+
+    /* Shadow controllers: same input as m_controller, no effect on the traffic */
+    struct ShadowController {
+        std::string name;
+        std::shared_ptr<rmcat::SenderBasedController> controller;
+        double sumBps;          // Sum of the estimates logged
+        double sumAbsDiffBps;   // Sum of the differences to the primary's
+        uint64_t samples;
+    };
+    std::vector<ShadowController> m_shadows;
     Ipv4Address m_destIP;
     uint16_t m_destPort;
     float m_initBw;
     float m_minBw;
     float m_maxBw;
     bool m_paused;
+    bool m_ecn;
+    bool m_rtx;
+    uint32_t m_packetSize;
     uint32_t m_ssrc;
-    uint16_t m_sequence;
+    uint32_t m_rtxSsrc;         // Retransmissions and probe padding
+    uint16_t m_sequence;        // Transport-wide, keys the controller's feedback
+    uint16_t m_rtpSequence;
+    uint16_t m_rtxSequence;
+    uint32_t m_fecSsrc;
+    uint16_t m_fecSequence;
     uint16_t m_first_seq;
     uint32_t m_gid;
-    uint32_t m_prev_seq;		// Sequence number of previous feedback pkt
+    uint64_t m_prev_seq;		// Unwrapped sequence of previous feedback pkt
     uint64_t m_prev_time;	        // Timestmp of previous feedback pkt
 
     uint64_t m_curr_group_time;
     uint64_t m_prev_group_atime;    // Arrival time of previous group
-    uint32_t m_prev_group_seq;	// End Sequnce number of previous feedback pkt
-    uint32_t m_curr_group_start_seq;
+    uint64_t m_prev_group_seq;	// Unwrapped end sequence of previous feedback pkt
+    uint64_t m_curr_group_start_seq;
     uint32_t m_rtpTsOffset;
+
+    /* Frame being packetized: its packets are enqueued evenly over the
+     * frame interval, as syncodecs::ShapedPacketizer does */
+    uint32_t m_frameRtpTs;      // Capture time of the frame (90 kHz)
+    uint32_t m_frameBytesLeft;
+    uint32_t m_framePktsLeft;
+    double m_framePktInterval;  // seconds
+
     uint64_t m_prev_feedback_time;
     bool m_groupchanged;
     Ptr<Socket> m_socket;
     EventId m_enqueueEvent;
     EventId m_sendEvent;
     EventId m_sendOversleepEvent;
+    EventId m_probeEvent;
+    EventId m_rtcpEvent;
+    EventId m_timerEvent;
+
+    /* Probe cluster being sent, paced independently of the media packets */
+    rmcat::SenderBasedController::ProbeCluster m_probeCluster;
+    uint32_t m_probePktsLeft;
+
+    /* RTCP sender reports (RFC 3550) */
+    uint32_t m_packetCount;
+    uint32_t m_octetCount;
+    double m_avgRtcpSize;       // bytes, including UDP/IP headers
+    bool m_rtcpInitial;         // no report sent yet
+    bool m_lastRrValid;
+    uint32_t m_lastRrExtSeq;    // Extended highest sequence of the previous report
+    uint64_t m_rttUs;           // Last RTT measured with the receiver reports
+
+    /* Retransmission history, indexed by RTP sequence modulo its size */
+    struct RtxEntry {
+        bool valid;
+        uint16_t sequence;
+        uint32_t size;
+        uint32_t rtpTimestamp;
+        bool marker;
+        uint64_t lastRtxUs;     // 0: never retransmitted
+    };
+    std::vector<RtxEntry> m_rtxHistory;
+    uint32_t m_rtxPackets;
 
+    /* Forward error correction */
+    bool m_fec;
+    bool m_fecAdaptive;
+    double m_fecMaxProtection;
+    rmcat::FecMaskType m_fecMask;
+    rmcat::FecGenerator m_fecGenerator;
+
+    /* Pacing queue delay limit */
+    uint64_t m_maxQueueDelayUs;     // 0: no limit
+    uint32_t m_lastMediaTs;         // Frame of the last media packet dequeued ...
+    bool m_lastMediaMarker;         // ... and whether it was the frame's last one
+    uint32_t m_framesDropped;
+    uint64_t m_maxQueueDelaySeenUs;
+
+    /* Congestion window pushback */
+    bool m_cwndEnabled;
+    rmcat::CongestionWindow m_cwnd;
+
+    /* Coupled congestion control */
+    std::shared_ptr<rmcat::FlowStateExchange> m_fse;
+    float m_fsePriority;
+    size_t m_fseFlow;
+    bool m_fseRegistered;
+    float m_fseRateBps;         // Last rate assigned to the flow
+
+    /* Layered encoding: one codec per layer */
+    std::vector<std::shared_ptr<syncodecs::Codec> > m_layerCodecs;
+    rmcat::BitrateAllocator m_allocator;
+    std::vector<float> m_layerBps;
+
+    bool m_rateShaping;
+    double m_frameInterval;     // seconds, of the last frame encoded
     double m_rVin; //bps
     double m_rSend; //bps
-    double m_rBitrate;  // Target Bit Rate.
-    std::deque<uint32_t> m_rateShapingBuf;
-    std::deque<uint32_t> m_PacingQ;
-    uint32_t m_rateShapingBytes;
-    uint32_t m_PacingQBytes;
+    TracedValue<double> m_rBitrate;  // Target Bit Rate.
+
+    std::deque<PacedPacket> m_PacingQ;  // Also the rate shaping buffer
+    size_t m_PacingQPriority;           // Retransmissions/FEC packets at its front
+    TracedValue<uint32_t> m_PacingQBytes;
     uint64_t m_nextSendTstmpUs;
     bool m_firstFeedback;
     int m_group_size_inter;
     int m_group_size;
     int m_prev_group_size;
+
+    /* Trace sources fed by the controller */
+    GccTraceAdapter m_traceAdapter;
+    TracedValue<double> m_delayOffset;      // ms
+    TracedValue<double> m_delayThreshold;   // ms
+    TracedValue<char> m_detectorState;
+    TracedValue<char> m_rateControlState;
+    TracedValue<char> m_rateControlRegion;
+    TracedValue<double> m_lossFraction;
+    TracedCallback<uint32_t> m_feedbackTrace;
 };
 
 }
@@ -0,0 +1,321 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver jitter buffer and playout model implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "jitter-buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace rmcat {
+
+static const int64_t kRtpTicksPerMs = 90;           /**< 90 kHz video clock */
+static const size_t kMaxPendingFrames = 64;         /**< oldest frame is dropped beyond */
+static const double kDelayGain = 1. / 16.;          /**< smoothing of the transit statistics */
+static const double kDelayStdDevs = 3.;             /**< target delay: mean + 3 std devs */
+static const uint64_t kMaxTargetDelayUs = 1000 * 1000;
+static const double kFrameIntervalGain = 1. / 30.;  /**< smoothing of the render intervals */
+static const uint64_t kFreezeExtraUs = 150 * 1000;  /**< freeze: interval > avg + 150 ms ... */
+static const double kFreezeRatio = 3.;              /**< ... and > 3 times the average */
+static const size_t kLatencyBins = 2001;            /**< 0 to 2 s, then one open-ended bin */
+
+JitterBuffer::JitterBuffer() :
+    m_frames{},
+    m_latencyHistogram(kLatencyBins, 0) {
+    reset();
+}
+
+JitterBuffer::~JitterBuffer() {}
+
+void JitterBuffer::reset() {
+    m_frames.clear();
+    m_unwrapValid = false;
+    m_lastSeq = 0;
+    m_lastSeq64 = 0;
+    m_lastTs = 0;
+    m_lastTs64 = 0;
+    m_removedValid = false;
+    m_removedTs = 0;
+    m_removedEndValid = false;
+    m_removedEndSeq = 0;
+    m_transitValid = false;
+    m_minTransitUs = 0;
+    m_meanDelayUs = 0.;
+    m_varDelayUs2 = 0.;
+    m_renderedValid = false;
+    m_lastRenderUs = 0;
+    m_avgFrameIntervalUs = 0.;
+    m_framesRendered = 0;
+    m_framesDropped = 0;
+    m_freezeCount = 0;
+    m_freezeDurationUs = 0;
+    m_captureRefValid = false;
+    m_captureRefTs = 0;
+    m_captureRefUs = 0;
+    std::fill(m_latencyHistogram.begin(), m_latencyHistogram.end(), 0);
+    m_latencySamples = 0;
+    m_latencySumMs = 0.;
+    m_maxLatencyMs = 0;
+}
+
+int64_t JitterBuffer::unwrapSequence(uint16_t sequence) {
+    const int64_t seq64 = m_lastSeq64 + int16_t(sequence - m_lastSeq); // wraps properly
+    if (seq64 > m_lastSeq64) {
+        m_lastSeq64 = seq64;
+        m_lastSeq = sequence;
+    }
+    return seq64;
+}
+
+int64_t JitterBuffer::unwrapTimestamp(uint32_t rtpTimestamp) {
+    const int64_t ts64 = m_lastTs64 + int32_t(rtpTimestamp - m_lastTs); // wraps properly
+    if (ts64 > m_lastTs64) {
+        m_lastTs64 = ts64;
+        m_lastTs = rtpTimestamp;
+    }
+    return ts64;
+}
+
+void JitterBuffer::insertPacket(uint64_t arrivalUs, uint16_t sequence,
+                                uint32_t rtpTimestamp, bool marker) {
+    advance(arrivalUs);
+
+    if (!m_unwrapValid) {
+        m_unwrapValid = true;
+        m_lastSeq = sequence;
+        m_lastSeq64 = sequence;
+        m_lastTs = rtpTimestamp;
+        m_lastTs64 = rtpTimestamp;
+    }
+    const int64_t seq64 = unwrapSequence(sequence);
+    const int64_t ts64 = unwrapTimestamp(rtpTimestamp);
+    if (m_removedValid && ts64 <= m_removedTs) {
+        return; // Too late: the frame was already rendered or dropped
+    }
+
+    auto it = m_frames.find(ts64);
+    if (it == m_frames.end()) {
+        if (m_frames.size() >= kMaxPendingFrames) {
+            drop(m_frames.begin());
+        }
+        it = m_frames.insert(std::make_pair(ts64, Frame{seq64, seq64, 0, false, false, 0})).first;
+    }
+    Frame& frame = it->second;
+    if (frame.complete) {
+        return; // Duplicate
+    }
+    frame.minSeq = std::min(frame.minSeq, seq64);
+    frame.maxSeq = std::max(frame.maxSeq, seq64);
+    ++frame.packets;
+    frame.marker = frame.marker || marker;
+
+    checkComplete(it, arrivalUs);
+    // The next frame may be waiting for this frame's boundaries
+    auto next = std::next(it);
+    if (next != m_frames.end()) {
+        checkComplete(next, arrivalUs);
+    }
+}
+
+void JitterBuffer::checkComplete(FrameMap::iterator it, uint64_t nowUs) {
+    Frame& frame = it->second;
+    if (frame.complete || !frame.marker ||
+        frame.packets != uint64_t(frame.maxSeq - frame.minSeq + 1)) {
+        return;
+    }
+    // The frame's first packet follows the previous frame's last one
+    if (it != m_frames.begin()) {
+        if (frame.minSeq != std::prev(it)->second.maxSeq + 1) {
+            return;
+        }
+    } else if (m_removedValid && m_removedEndValid) {
+        if (frame.minSeq != m_removedEndSeq + 1) {
+            return;
+        }
+    }
+    onComplete(it->first, frame, nowUs);
+}
+
+void JitterBuffer::onComplete(int64_t rtpTs, Frame& frame, uint64_t nowUs) {
+    frame.complete = true;
+
+    // Capture time on the RTP clock, in us (arbitrary origin)
+    const int64_t captureUs = rtpTs * 1000 / kRtpTicksPerMs;
+    const int64_t transitUs = int64_t(nowUs) - captureUs;
+    if (!m_transitValid) {
+        m_transitValid = true;
+        m_minTransitUs = transitUs;
+    } else if (transitUs < m_minTransitUs) {
+        // Keep the mean relative to the new minimum
+        m_meanDelayUs += double(m_minTransitUs - transitUs);
+        m_minTransitUs = transitUs;
+    }
+    const double delayUs = double(transitUs - m_minTransitUs);
+    const double diff = delayUs - m_meanDelayUs;
+    m_meanDelayUs += kDelayGain * diff;
+    m_varDelayUs2 += kDelayGain * (diff * diff - m_varDelayUs2);
+
+    const int64_t scheduledUs = captureUs + m_minTransitUs + int64_t(getTargetDelayUs());
+    frame.renderUs = std::max<uint64_t>(nowUs, std::max<int64_t>(scheduledUs, 0));
+}
+
+void JitterBuffer::advance(uint64_t nowUs) {
+    while (!m_frames.empty()) {
+        auto head = m_frames.begin();
+        if (head->second.complete) {
+            if (head->second.renderUs > nowUs) {
+                break;
+            }
+            render(head->first, head->second);
+            m_frames.erase(head);
+            continue;
+        }
+        // Incomplete frame: skipped once a later frame is due
+        bool laterDue = false;
+        for (auto it = std::next(head); it != m_frames.end(); ++it) {
+            if (it->second.complete) {
+                laterDue = it->second.renderUs <= nowUs;
+                break;
+            }
+        }
+        if (!laterDue) {
+            break;
+        }
+        drop(head);
+    }
+}
+
+void JitterBuffer::render(int64_t rtpTs, const Frame& frame) {
+    // Frames are played out in order
+    const uint64_t renderUs = m_renderedValid ? std::max(frame.renderUs, m_lastRenderUs) :
+                                                frame.renderUs;
+    if (m_renderedValid) {
+        const uint64_t intervalUs = renderUs - m_lastRenderUs;
+        const double avg = m_avgFrameIntervalUs;
+        if (avg > 0. && intervalUs > std::max(kFreezeRatio * avg, avg + kFreezeExtraUs)) {
+            ++m_freezeCount;
+            m_freezeDurationUs += intervalUs;
+        } else if (avg == 0.) {
+            m_avgFrameIntervalUs = double(intervalUs);
+        } else {
+            m_avgFrameIntervalUs += kFrameIntervalGain * (double(intervalUs) - avg);
+        }
+    }
+    m_renderedValid = true;
+    m_lastRenderUs = renderUs;
+    ++m_framesRendered;
+
+    if (m_captureRefValid) {
+        const int64_t sinceRefUs = int64_t(int32_t(uint32_t(rtpTs) - m_captureRefTs)) *
+                                   1000 / kRtpTicksPerMs;
+        const int64_t latencyUs = int64_t(renderUs) - (int64_t(m_captureRefUs) + sinceRefUs);
+        if (latencyUs >= 0) {
+            const uint64_t latencyMs = uint64_t(latencyUs / 1000);
+            ++m_latencyHistogram[std::min<uint64_t>(latencyMs, kLatencyBins - 1)];
+            ++m_latencySamples;
+            m_latencySumMs += double(latencyUs) / 1000.;
+            m_maxLatencyMs = std::max(m_maxLatencyMs, latencyMs);
+        }
+    }
+
+    m_removedValid = true;
+    m_removedTs = rtpTs;
+    m_removedEndValid = frame.marker;
+    m_removedEndSeq = frame.maxSeq;
+}
+
+void JitterBuffer::drop(FrameMap::iterator it) {
+    ++m_framesDropped;
+    m_removedValid = true;
+    m_removedTs = it->first;
+    m_removedEndValid = it->second.marker;
+    m_removedEndSeq = it->second.maxSeq;
+    m_frames.erase(it);
+}
+
+void JitterBuffer::setCaptureReference(uint32_t rtpTimestamp, uint64_t ntpUs) {
+    m_captureRefValid = true;
+    m_captureRefTs = rtpTimestamp;
+    m_captureRefUs = ntpUs;
+}
+
+uint64_t JitterBuffer::getTargetDelayUs() const {
+    const double target = m_meanDelayUs + kDelayStdDevs * std::sqrt(m_varDelayUs2);
+    return std::min<uint64_t>(uint64_t(std::max(target, 0.)), kMaxTargetDelayUs);
+}
+
+uint64_t JitterBuffer::getFramesRendered() const {
+    return m_framesRendered;
+}
+
+uint64_t JitterBuffer::getFramesDropped() const {
+    return m_framesDropped;
+}
+
+uint64_t JitterBuffer::getFreezeCount() const {
+    return m_freezeCount;
+}
+
+uint64_t JitterBuffer::getFreezeDurationUs() const {
+    return m_freezeDurationUs;
+}
+
+uint64_t JitterBuffer::getLatencySamples() const {
+    return m_latencySamples;
+}
+
+double JitterBuffer::getMeanLatencyMs() const {
+    return m_latencySamples > 0 ? m_latencySumMs / m_latencySamples : 0.;
+}
+
+uint32_t JitterBuffer::getLatencyPercentileMs(double percentile) const {
+    const double target = m_latencySamples * std::min(std::max(percentile, 0.), 100.) / 100.;
+    uint64_t cumulative = 0;
+    for (size_t bin = 0; bin < m_latencyHistogram.size(); ++bin) {
+        cumulative += m_latencyHistogram[bin];
+        if (cumulative > 0 && cumulative >= target) {
+            return bin + 1 < m_latencyHistogram.size() ? uint32_t(bin + 1) :
+                                                         uint32_t(m_maxLatencyMs);
+        }
+    }
+    return uint32_t(m_maxLatencyMs);
+}
+
+void JitterBuffer::print(std::ostream& os) const {
+    os << "playout:"
+       << " rendered: " << m_framesRendered
+       << " dropped: " << m_framesDropped
+       << " freezes: " << m_freezeCount
+       << " freeze(ms): " << m_freezeDurationUs / 1000
+       << " target(ms): " << getTargetDelayUs() / 1000
+       << " latency(ms) mean: " << getMeanLatencyMs()
+       << " p50: " << getLatencyPercentileMs(50.)
+       << " p95: " << getLatencyPercentileMs(95.)
+       << " p99: " << getLatencyPercentileMs(99.)
+       << " max: " << m_maxLatencyMs;
+}
+
+}
@@ -0,0 +1,186 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver jitter buffer and playout model interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Frame-aware receive pipeline: reassembles video frames from RTP packets,
+ * holds them in an adaptive jitter buffer and simulates their playout, in
+ * order to measure what the user experiences.
+ *
+ * Packets of a frame share the RTP timestamp (90 kHz capture clock), the
+ * last one has the marker bit set. A frame is complete once all packets
+ * from the one after the previous frame's marker up to its own marker are
+ * in. Complete frames are rendered in order, at their capture time plus the
+ * smallest transit time seen plus the target delay; the target delay
+ * follows the variation of the frame transit times (mean plus three
+ * standard deviations). Incomplete frames are dropped once a later frame
+ * is rendered.
+ *
+ * Glass-to-glass latency (capture to render) needs the capture time in
+ * wallclock: it comes from the RTP/NTP timestamp pair of the sender
+ * reports, so frames rendered before the first report are not sampled.
+ * Latencies go into a histogram with 1-ms bins, and the number of pending
+ * frames is bounded: the per-packet cost does not grow with the length of
+ * the run.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class JitterBuffer {
+public:
+    /** Class constructor */
+    JitterBuffer();
+
+    /** Class destructor */
+    ~JitterBuffer();
+
+    /** Forget all frames and statistics */
+    void reset();
+
+    /**
+     * Account for a received media packet. Frames due before its arrival
+     * are rendered first
+     *
+     * @param [in] arrivalUs Arrival time of the packet, in microseconds
+     * @param [in] sequence RTP sequence number
+     * @param [in] rtpTimestamp RTP timestamp (90 kHz capture clock)
+     * @param [in] marker RTP marker bit: last packet of the frame
+     */
+    void insertPacket(uint64_t arrivalUs, uint16_t sequence,
+                      uint32_t rtpTimestamp, bool marker);
+
+    /**
+     * Provide the mapping between the RTP clock and the sender's wallclock
+     * carried by the last sender report
+     *
+     * @param [in] rtpTimestamp RTP timestamp of the sender report
+     * @param [in] ntpUs NTP timestamp of the sender report, in microseconds
+     */
+    void setCaptureReference(uint32_t rtpTimestamp, uint64_t ntpUs);
+
+    /**
+     * Render the frames that are due by @p nowUs
+     *
+     * @param [in] nowUs Current time in microseconds
+     */
+    void advance(uint64_t nowUs);
+
+    /** Current target delay of the jitter buffer, in microseconds */
+    uint64_t getTargetDelayUs() const;
+
+    uint64_t getFramesRendered() const;     /**< frames played out */
+    uint64_t getFramesDropped() const;      /**< frames never complete in time */
+    uint64_t getFreezeCount() const;        /**< number of video freezes */
+    uint64_t getFreezeDurationUs() const;   /**< total duration of the freezes */
+    uint64_t getLatencySamples() const;     /**< frames with a latency sample */
+    double getMeanLatencyMs() const;        /**< mean glass-to-glass latency */
+
+    /**
+     * Get a percentile of the glass-to-glass frame latency, with a 1-ms
+     * resolution
+     *
+     * @param [in] percentile Percentile to compute, in [0, 100]
+     * @retval Upper bound (in ms) of the histogram bin containing it
+     */
+    uint32_t getLatencyPercentileMs(double percentile) const;
+
+    /**
+     * Write a one-line summary of the statistics, with no line break
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(std::ostream& os) const;
+
+private:
+    struct Frame {
+        int64_t minSeq;
+        int64_t maxSeq;
+        uint32_t packets;
+        bool marker;
+        bool complete;
+        uint64_t renderUs;
+    };
+    typedef std::map<int64_t, Frame> FrameMap;  // by unwrapped RTP timestamp
+
+    int64_t unwrapSequence(uint16_t sequence);
+    int64_t unwrapTimestamp(uint32_t rtpTimestamp);
+    void checkComplete(FrameMap::iterator it, uint64_t nowUs);
+    void onComplete(int64_t rtpTs, Frame& frame, uint64_t nowUs);
+    void render(int64_t rtpTs, const Frame& frame);
+    void drop(FrameMap::iterator it);
+
+    FrameMap m_frames;          /**< frames not yet rendered nor dropped */
+
+    /* Unwrapping of the 16-bit sequence numbers and 32-bit timestamps */
+    bool m_unwrapValid;
+    uint16_t m_lastSeq;
+    int64_t m_lastSeq64;
+    uint32_t m_lastTs;
+    int64_t m_lastTs64;
+
+    /* Last frame removed from m_frames (rendered or dropped) */
+    bool m_removedValid;
+    int64_t m_removedTs;        /**< its RTP timestamp */
+    bool m_removedEndValid;
+    int64_t m_removedEndSeq;    /**< its last sequence number, if known */
+
+    /* Jitter estimation on the frame transit times */
+    bool m_transitValid;
+    int64_t m_minTransitUs;     /**< smallest completion time - capture time */
+    double m_meanDelayUs;       /**< mean transit above the smallest one */
+    double m_varDelayUs2;       /**< its variance */
+
+    /* Playout */
+    bool m_renderedValid;
+    uint64_t m_lastRenderUs;
+    double m_avgFrameIntervalUs;
+    uint64_t m_framesRendered;
+    uint64_t m_framesDropped;
+    uint64_t m_freezeCount;
+    uint64_t m_freezeDurationUs;
+
+    /* Glass-to-glass latency */
+    bool m_captureRefValid;
+    uint32_t m_captureRefTs;
+    uint64_t m_captureRefUs;
+    std::vector<uint64_t> m_latencyHistogram;   /**< 1-ms bins, the last one is open-ended */
+    uint64_t m_latencySamples;
+    double m_latencySumMs;
+    uint64_t m_maxLatencyMs;
+};
+
+}
+
+#endif /* JITTER_BUFFER_H */
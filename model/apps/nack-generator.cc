@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver NACK generation implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "nack-generator.h"
+#include <algorithm>
+
+namespace rmcat {
+
+static const size_t kMaxMissing = 1000;             /**< oldest missing packet given up on beyond */
+static const int64_t kReorderingPackets = 3;        /**< later packets before a packet is NACKed ... */
+static const uint64_t kReorderingUs = 10 * 1000;    /**< ... or time it has been missing */
+static const uint32_t kMaxRetries = 10;             /**< requests per packet */
+static const uint64_t kInitialRttUs = 100 * 1000;   /**< until the first measurement */
+static const uint64_t kMinRetryUs = 5 * 1000;       /**< minimum interval between requests */
+static const double kRttGain = 1. / 8.;             /**< smoothing of the RTT samples */
+
+NackGenerator::NackGenerator() :
+    m_missing{} {
+    reset();
+}
+
+NackGenerator::~NackGenerator() {}
+
+void NackGenerator::reset() {
+    m_missing.clear();
+    m_seqValid = false;
+    m_highestSeq = 0;
+    m_highestSeq64 = 0;
+    m_rttUs = kInitialRttUs;
+    m_packetsMissing = 0;
+    m_packetsNacked = 0;
+    m_nacksSent = 0;
+    m_packetsRecovered = 0;
+    m_packetsLost = 0;
+}
+
+void NackGenerator::onPacket(uint64_t nowUs, uint16_t sequence, bool retransmitted) {
+    if (!m_seqValid) {
+        m_seqValid = true;
+        m_highestSeq = sequence;
+        m_highestSeq64 = sequence;
+        return;
+    }
+    const int64_t seq64 = m_highestSeq64 + int16_t(sequence - m_highestSeq); // wraps properly
+    if (seq64 > m_highestSeq64) {
+        // Every packet in between is missing
+        for (int64_t missing = m_highestSeq64 + 1; missing < seq64; ++missing) {
+            if (m_missing.size() >= kMaxMissing) {
+                giveUp(m_missing.begin());
+            }
+            m_missing.insert(std::make_pair(missing, Missing{nowUs, 0, 0}));
+            ++m_packetsMissing;
+        }
+        m_highestSeq64 = seq64;
+        m_highestSeq = sequence;
+        return;
+    }
+
+    auto it = m_missing.find(seq64);
+    if (it == m_missing.end()) {
+        return; // Duplicate, or given up on
+    }
+    if (retransmitted) {
+        ++m_packetsRecovered;
+        if (it->second.retries == 1) {
+            // Unambiguous: answer to the only request
+            const double sample = double(nowUs - it->second.lastSentUs);
+            m_rttUs += kRttGain * (sample - m_rttUs);
+        }
+    }
+    m_missing.erase(it);
+}
+
+void NackGenerator::getNackList(uint64_t nowUs, std::vector<uint16_t>& sequences) {
+    const uint64_t retryUs = std::max(uint64_t(m_rttUs), kMinRetryUs);
+    for (auto it = m_missing.begin(); it != m_missing.end();) {
+        Missing& missing = it->second;
+        const bool reordered = m_highestSeq64 - it->first < kReorderingPackets &&
+                               nowUs < missing.detectedUs + kReorderingUs;
+        if (reordered || (missing.retries > 0 && nowUs < missing.lastSentUs + retryUs)) {
+            ++it;
+            continue;
+        }
+        if (missing.retries >= kMaxRetries) {
+            giveUp(it++);
+            continue;
+        }
+        if (missing.retries == 0) {
+            ++m_packetsNacked;
+        }
+        ++missing.retries;
+        missing.lastSentUs = nowUs;
+        ++m_nacksSent;
+        sequences.push_back(uint16_t(it->first));
+        ++it;
+    }
+}
+
+void NackGenerator::giveUp(MissingMap::iterator it) {
+    ++m_packetsLost;
+    m_missing.erase(it);
+}
+
+uint64_t NackGenerator::getRttUs() const {
+    return uint64_t(m_rttUs);
+}
+
+uint64_t NackGenerator::getPacketsMissing() const {
+    return m_packetsMissing;
+}
+
+uint64_t NackGenerator::getPacketsNacked() const {
+    return m_packetsNacked;
+}
+
+uint64_t NackGenerator::getNacksSent() const {
+    return m_nacksSent;
+}
+
+uint64_t NackGenerator::getPacketsRecovered() const {
+    return m_packetsRecovered;
+}
+
+uint64_t NackGenerator::getPacketsLost() const {
+    return m_packetsLost;
+}
+
+void NackGenerator::print(std::ostream& os) const {
+    os << "nack:"
+       << " missing: " << m_packetsMissing
+       << " nacked: " << m_packetsNacked
+       << " requests: " << m_nacksSent
+       << " recovered: " << m_packetsRecovered
+       << " lost: " << m_packetsLost
+       << " rtt(ms): " << getRttUs() / 1000;
+}
+
+}
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receiver NACK generation interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef NACK_GENERATOR_H
+#define NACK_GENERATOR_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Loss detection and retransmission requests (generic NACK, RFC 4585) for
+ * a media stream.
+ *
+ * Gaps in the sequence numbers are recorded as missing packets. A missing
+ * packet is requested once it can no longer be a reordered one: several
+ * later packets arrived, or it has been missing for a while. It is
+ * requested again, up to a limit, if not received one round trip after
+ * the previous request. The round-trip time is measured from the requests
+ * to the retransmissions they trigger.
+ *
+ * The list of missing packets is bounded: beyond, the oldest ones are given
+ * up on.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class NackGenerator {
+public:
+    /** Class constructor */
+    NackGenerator();
+
+    /** Class destructor */
+    ~NackGenerator();
+
+    /** Forget all missing packets and statistics */
+    void reset();
+
+    /**
+     * Account for a received media packet
+     *
+     * @param [in] nowUs Arrival time of the packet, in microseconds
+     * @param [in] sequence RTP sequence number of the media packet (for a
+     *                      retransmission, the original one)
+     * @param [in] retransmitted Whether the packet is a retransmission
+     */
+    void onPacket(uint64_t nowUs, uint16_t sequence, bool retransmitted);
+
+    /**
+     * Get the packets to request now, and account for their request
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [out] sequences Sequence numbers to be NACKed, in increasing order
+     */
+    void getNackList(uint64_t nowUs, std::vector<uint16_t>& sequences);
+
+    /** Round-trip time from a request to its retransmission, in microseconds */
+    uint64_t getRttUs() const;
+
+    uint64_t getPacketsMissing() const;     /**< gaps detected */
+    uint64_t getPacketsNacked() const;      /**< missing packets requested */
+    uint64_t getNacksSent() const;          /**< requests, repeated ones included */
+    uint64_t getPacketsRecovered() const;   /**< missing packets retransmitted */
+    uint64_t getPacketsLost() const;        /**< missing packets given up on */
+
+    /**
+     * Write a one-line summary of the statistics, with no line break
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(std::ostream& os) const;
+
+private:
+    struct Missing {
+        uint64_t detectedUs;
+        uint64_t lastSentUs;
+        uint32_t retries;
+    };
+    typedef std::map<int64_t, Missing> MissingMap;  // by unwrapped sequence
+
+    void giveUp(MissingMap::iterator it);
+
+    MissingMap m_missing;
+    bool m_seqValid;
+    uint16_t m_highestSeq;
+    int64_t m_highestSeq64;
+    double m_rttUs;
+
+    uint64_t m_packetsMissing;
+    uint64_t m_packetsNacked;
+    uint64_t m_nacksSent;
+    uint64_t m_packetsRecovered;
+    uint64_t m_packetsLost;
+};
+
+}
+
+#endif /* NACK_GENERATOR_H */
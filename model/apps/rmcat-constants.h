@@ -35,7 +35,39 @@ const uint32_t DEFAULT_PACKET_SIZE = 1000;
 const uint32_t IPV4_HEADER_SIZE = 20;
 const uint32_t UDP_HEADER_SIZE = 8;
 const uint32_t IPV4_UDP_OVERHEAD = IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
+const uint32_t RTP_HEADER_SIZE = 12;
+const uint32_t RTP_HEADER_EXT_SIZE = 12; // Send time and transport-wide sequence (see RtpHeader)
+const uint32_t RTX_OSN_SIZE = 2;         // Original sequence number of a retransmission (RFC 4588)
+const uint32_t FEC_HEADER_SIZE = 20;     // FEC header of a protection packet (see rmcat::FecPacket)
+const uint8_t RTP_MEDIA_PAYLOAD_TYPE = 96; // dynamic payload types (RFC 3551)
+const uint8_t RTX_PAYLOAD_TYPE = 97;       // retransmission stream (RFC 4588)
+const uint8_t FEC_PAYLOAD_TYPE = 98;       // FEC stream (as in RFC 8627)
+const uint32_t DEFAULT_MTU = 1500;
+// Largest media payload that fits in one MTU-sized IP packet (no fragmentation),
+// header extension included, even when retransmitted or protected by FEC (the
+// FEC header being the longer of the two)
+const uint32_t MAX_PACKET_SIZE = DEFAULT_MTU - IPV4_UDP_OVERHEAD - RTP_HEADER_SIZE -
+                                 RTP_HEADER_EXT_SIZE - FEC_HEADER_SIZE;
 const uint64_t RMCAT_FEEDBACK_PERIOD_US = 30 * 1000; // Recommend 30ms, at least 100ms
+const uint64_t RMCAT_NACK_PERIOD_US = 10 * 1000;     // Loss detection timer
+const uint64_t PACER_MAX_QUEUE_DELAY_US = 500 * 1000; // Suggested sender-side latency bound
+
+// ECN codepoints, the two low-order bits of the IP TOS byte (RFC 3168)
+const uint8_t ECN_NOT_ECT = 0x00;
+const uint8_t ECN_ECT1 = 0x01;
+const uint8_t ECN_ECT0 = 0x02;
+const uint8_t ECN_CE = 0x03;
+const uint8_t ECN_MASK = 0x03;
+
+// Queue management at the bottleneck link
+enum BottleneckAqm {
+    AQM_DROPTAIL = 0,   // drop-tail device queue, no traffic control
+    AQM_CODEL,
+    AQM_FQ_CODEL,
+    AQM_PIE,
+    AQM_STEP_MARKING,   // shallow ECN step marking, see #ns3::StepMarkingQueueDisc
+    AQM_DUALQ           // coupled L4S/classic AQM, see #ns3::DualQCoupledQueueDisc
+};
 
 // syncodec parameters
 const uint32_t SYNCODEC_DEFAULT_FPS = 30;
@@ -59,6 +91,15 @@ enum SyncodecType {
 const bool USE_BUFFER = true;
 const float BETA_V = 1e-5;
 const float BETA_S = 1e-5;
+
+/**
+ * Parameters of the rate shaping buffer of #ns3::GccSender (draft-ietf-rmcat-nada,
+ * section 5.2), where the buffer is the pacing queue. With unit gains, the encoder
+ * slows down, and the pacer speeds up, by the rate that would drain the queue
+ * within one frame interval.
+ */
+const float GCC_BETA_V = 1.;
+const float GCC_BETA_S = 1.;
 const uint32_t MAX_QUEUE_SIZE_SANITY = 80 * 1000 * 1000; //bytes
 
 /* topology parameters */
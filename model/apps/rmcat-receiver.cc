@@ -27,10 +27,12 @@
 
 #include "rmcat-receiver.h"
 #include "rtp-header.h"
+#include "rmcat-constants.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/sim-perf-record.h"
 
 NS_LOG_COMPONENT_DEFINE ("RmcatReceiver");
 
@@ -54,6 +56,8 @@ void RmcatReceiver::Setup (uint16_t port)
     auto ret = m_socket->Bind (local);
     NS_ASSERT (ret == 0);
     m_socket->SetRecvCallback (MakeCallback (&RmcatReceiver::RecvPacket,this));
+    // Deliver the TOS byte of received packets, to echo their ECN codepoint
+    m_socket->SetIpRecvTos (true);
 
     m_running = false;
     m_waiting = true;
@@ -79,6 +83,11 @@ void RmcatReceiver::RecvPacket (Ptr<Socket> socket)
     Address remoteAddr{};
     auto packet = m_socket->RecvFrom (remoteAddr);
     NS_ASSERT (packet);
+    SocketIpTosTag tosTag{};
+    uint8_t ecn = 0;
+    if (packet->RemovePacketTag (tosTag)) {
+        ecn = tosTag.GetTos () & ECN_MASK;
+    }
     RtpHeader header{};
     NS_LOG_INFO ("RmcatReceiver::RecvPacket, " << packet->ToString ());
     packet->RemoveHeader (header);
@@ -97,12 +106,14 @@ void RmcatReceiver::RecvPacket (Ptr<Socket> socket)
     }
 
     uint64_t recvTimestampUs = Simulator::Now ().GetMicroSeconds ();
-    SendFeedback (header.GetSequence (), recvTimestampUs);
+    SendFeedback (header.GetSequence (), recvTimestampUs, ecn);
 }
 
 void RmcatReceiver::SendFeedback (uint16_t sequence,
-                                  uint64_t recvTimestampUs)
+                                  uint64_t recvTimestampUs,
+                                  uint8_t ecn)
 {
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
     // TODO (next patch): We need to aggregate feedback information
     //                    (for the moment, one feedback packet per media packet)
     //                     - add member of type feedback header
@@ -111,7 +122,7 @@ void RmcatReceiver::SendFeedback (uint16_t sequence,
 
     CCFeedbackHeader header{};
     header.SetSendSsrc (m_ssrc);
-    auto res = header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs);
+    auto res = header.AddFeedback (m_remoteSsrc, sequence, recvTimestampUs, ecn);
     NS_ASSERT (res == CCFeedbackHeader::CCFB_NONE);
     auto packet = Create<Packet> ();
     packet->AddHeader (header);
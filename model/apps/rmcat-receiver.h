@@ -47,7 +47,8 @@ private:
 
     void RecvPacket (Ptr<Socket> socket);
     void SendFeedback (uint16_t sequence,
-                       uint64_t recvTimestamp);
+                       uint64_t recvTimestamp,
+                       uint8_t ecn);
 
 private:
     bool m_running;
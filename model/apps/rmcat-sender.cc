@@ -29,11 +29,15 @@
 #include "rtp-header.h"
 #include "ns3/dummy-controller.h"
 #include "ns3/nada-controller.h"
+#include "ns3/gcc-controller.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
 #include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/sim-perf-record.h"
 
 #include <sys/stat.h>
 
@@ -41,6 +45,27 @@ NS_LOG_COMPONENT_DEFINE ("RmcatSender");
 
 namespace ns3 {
 
+NS_OBJECT_ENSURE_REGISTERED (RmcatSender);
+
+TypeId RmcatSender::GetTypeId ()
+{
+    static TypeId tid = TypeId ("ns3::RmcatSender")
+      .SetParent<Application> ()
+      .AddConstructor<RmcatSender> ()
+      .AddAttribute ("GccConfigFile",
+                     "File with the parameters of the GCC controller",
+                     StringValue (""),
+                     MakeStringAccessor (&RmcatSender::m_gccConfigFile),
+                     MakeStringChecker ())
+      .AddAttribute ("GccParameters",
+                     "GCC controller parameters, as name=value[,name=value...]",
+                     StringValue (""),
+                     MakeStringAccessor (&RmcatSender::m_gccParameters),
+                     MakeStringChecker ())
+    ;
+    return tid;
+}
+
 RmcatSender::RmcatSender ()
 : m_destIP{}
 , m_destPort{0}
@@ -51,6 +76,7 @@ RmcatSender::RmcatSender ()
 , m_ssrc{0}
 , m_sequence{0}
 , m_rtpTsOffset{0}
+, m_ecn{false}
 , m_socket{NULL}
 , m_enqueueEvent{}
 , m_sendEvent{}
@@ -59,6 +85,7 @@ RmcatSender::RmcatSender ()
 , m_rSend{0.}
 , m_rateShapingBytes{0}
 , m_nextSendTstmp{0}
+, m_warmStart{false}
 {}
 
 RmcatSender::~RmcatSender () {}
@@ -187,6 +214,44 @@ void RmcatSender::Setup (Ipv4Address destIP,
     m_destPort = destPort;
 }
 
+void RmcatSender::EnableEcn ()
+{
+    m_ecn = true;
+}
+
+void RmcatSender::SaveState (std::ostream& os) const
+{
+    NS_ASSERT (m_controller);
+    os << "rmcat-sender 1\n";
+    os << m_sequence << " " << m_rVin << " " << m_rSend << "\n";
+    m_controller->saveState (os);
+}
+
+bool RmcatSender::RestoreState (std::istream& is)
+{
+    NS_ASSERT (m_controller);
+    std::string tag;
+    int version = 0;
+    uint16_t sequence = 0;
+    double rVin = 0.;
+    double rSend = 0.;
+    is >> tag >> version >> sequence >> rVin >> rSend;
+    if (!is || tag != "rmcat-sender" || version != 1) {
+        NS_LOG_INFO ("RmcatSender::RestoreState, bad sender state header");
+        return false;
+    }
+    if (!m_controller->restoreState (is)) {
+        NS_LOG_INFO ("RmcatSender::RestoreState, could not restore controller state");
+        return false;
+    }
+    // In-transit packets belong to the network the checkpoint was taken in
+    m_sequence = m_controller->forgetInTransitPackets ();
+    m_rVin = rVin;
+    m_rSend = rSend;
+    m_warmStart = true;
+    return true;
+}
+
 void RmcatSender::SetRinit (float r)
 {
     m_initBw = r;
@@ -205,24 +270,51 @@ void RmcatSender::SetRmax (float r)
     if (m_controller) m_controller->setMaxBw (m_maxBw);
 }
 
+/*
+ * The attributes are applied on top of the controller's own parameters,
+ * once the controller is known for sure
+ */
+void RmcatSender::ApplyGccConfig ()
+{
+    auto gcc = std::dynamic_pointer_cast<rmcat::GccController> (m_controller);
+    if (!gcc || (m_gccConfigFile.empty () && m_gccParameters.empty ())) {
+        return;
+    }
+    rmcat::GccConfig config = gcc->getConfig ();
+    if ((!m_gccConfigFile.empty () && !config.loadFile (m_gccConfigFile)) ||
+        !config.parse (m_gccParameters)) {
+        NS_FATAL_ERROR ("Invalid GCC configuration: " << m_gccConfigFile
+                        << " " << m_gccParameters);
+    }
+    gcc->setConfig (config);
+}
+
 void RmcatSender::StartApplication ()
 {
+    ApplyGccConfig ();
     m_ssrc = rand ();
     // RTP initial values for sequence number and timestamp SHOULD be random (RFC 3550)
-    m_sequence = rand ();
+    const uint16_t sequence = rand ();
     m_rtpTsOffset = rand ();
 
     NS_ASSERT (m_minBw <= m_initBw);
     NS_ASSERT (m_initBw <= m_maxBw);
 
-    m_rVin = m_initBw;
-    m_rSend = m_initBw;
+    // A warm-started sender continues the restored sequence and rates
+    if (!m_warmStart) {
+        m_sequence = sequence;
+        m_rVin = m_initBw;
+        m_rSend = m_initBw;
+    }
 
     if (m_socket == NULL) {
         m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
         auto res = m_socket->Bind ();
         NS_ASSERT (res == 0);
     }
+    if (m_ecn) {
+        m_socket->SetIpTos (ECN_ECT1);
+    }
     m_socket->SetRecvCallback (MakeCallback (&RmcatSender::RecvPacket, this));
 
     m_enqueueEvent = Simulator::Schedule (Seconds (0.0), &RmcatSender::EnqueuePacket, this);
@@ -236,10 +328,14 @@ void RmcatSender::StopApplication ()
     Simulator::Cancel (m_sendOversleepEvent);
     m_rateShapingBuf.clear ();
     m_rateShapingBytes = 0;
+
+    // Memory used by the controller's packet histories
+    m_controller->logHistoryStats ();
 }
 
 void RmcatSender::EnqueuePacket ()
 {
+    SimPerfRecord::Count (SimPerfRecord::CODEC);
     syncodecs::Codec& codec = *m_codec;
     codec.setTargetRate (m_rVin);
     ++codec; // Advance codec/packetizer to next frame/packet
@@ -283,6 +379,7 @@ void RmcatSender::EnqueuePacket ()
 
 void RmcatSender::SendPacket (uint64_t msSlept)
 {
+    SimPerfRecord::Count (SimPerfRecord::PACER);
     NS_ASSERT (m_rateShapingBuf.size () > 0);
     NS_ASSERT (m_rateShapingBytes < MAX_QUEUE_SIZE_SANITY);
 
@@ -305,7 +402,10 @@ void RmcatSender::SendPacket (uint64_t msSlept)
     m_sendOversleepEvent = Simulator::Schedule (tOver, &RmcatSender::SendOverSleep,
                                                 this, m_sequence, nowUs, bytesToSend);
 
-    m_controller->processSendPacket (nowUs / 1000, m_sequence++, bytesToSend); // TODO (next patch): change param to Us
+    {
+        SimPerfRecord::ControllerScope scope;
+        m_controller->processSendPacket (nowUs / 1000, m_sequence++, bytesToSend); // TODO (next patch): change param to Us
+    }
 
     // schedule next sendData
     const double msToNextSentPacketD = double (bytesToSend) * 8. * 1000. / m_rSend;
@@ -340,6 +440,7 @@ void RmcatSender::SendOverSleep (uint16_t seq, int64_t nowUs, uint32_t bytesToSe
 
 void RmcatSender::RecvPacket (Ptr<Socket> socket)
 {
+    SimPerfRecord::Count (SimPerfRecord::FEEDBACK);
     Address remoteAddr;
     auto Packet = m_socket->RecvFrom (remoteAddr);
     NS_ASSERT (Packet);
@@ -365,12 +466,13 @@ void RmcatSender::RecvPacket (Ptr<Socket> socket)
                           CCFeedbackHeader::MetricBlock> > feedback{};
     const bool res = header.GetMetricList (m_ssrc, feedback);
     NS_ASSERT (res);
+    SimPerfRecord::ControllerScope scope;
     for (auto& item : feedback) {
         const auto sequence = item.first;
         const auto timestampUs = item.second.m_timestampUs;
         const auto ecn = item.second.m_ecn;
         NS_ASSERT (timestampUs <= nowUs);
-        m_controller->processFeedback (nowUs / 1000, sequence, timestampUs / 1000, 0, 0, 0 , 0,ecn); // TODO (next patch): Change params to Us
+        m_controller->processFeedback (nowUs / 1000, sequence, timestampUs / 1000, 0, 0, 0, 0, 0, ecn); // TODO (next patch): Change params to Us
     }
     CalcBufferParams (nowUs / 1000);
 }
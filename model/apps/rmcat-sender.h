@@ -34,12 +34,20 @@
 #include "ns3/socket.h"
 #include "ns3/application.h"
 #include <memory>
+#include <string>
 
 namespace ns3 {
 
 class RmcatSender: public Application
 {
 public:
+    /**
+     * Attributes: GccConfigFile, a file of GCC parameters (see
+     * #rmcat::GccConfig ), and GccParameters, a list of name=value
+     * overrides applied after it. Both only apply if the controller is a
+     * #rmcat::GccController , when the application starts
+     */
+    static TypeId GetTypeId ();
 
     RmcatSender ();
     virtual ~RmcatSender ();
@@ -57,9 +65,37 @@ public:
 
     void Setup (Ipv4Address dest_ip, uint16_t dest_port);
 
+    /**
+     * Send media packets as ECN-capable, with the ECT(1) codepoint (see
+     * #GccSender::EnableEcn ). The #RmcatReceiver echoes the codepoint of
+     * every packet in its feedback
+     */
+    void EnableEcn ();
+
+    /**
+     * Checkpoint the sender and its congestion controller. The state can
+     * be loaded into another sender with #RestoreState , e.g., to fork
+     * several scenario variants from a single warm-up run
+     *
+     * @param [out] os Stream the state is written to
+     */
+    void SaveState (std::ostream& os) const;
+
+    /**
+     * Warm-start this sender from a checkpoint written by #SaveState .
+     * Must be called before the application starts; the application must
+     * start at (or after) the time the checkpoint was taken. Packets that
+     * were in transit when the checkpoint was taken are forgotten
+     *
+     * @param [in] is Stream the state is read from
+     * @retval true if the state was restored, false otherwise
+     */
+    bool RestoreState (std::istream& is);
+
 private:
     virtual void StartApplication ();
     virtual void StopApplication ();
+    void ApplyGccConfig ();
 
     void EnqueuePacket ();
     void SendPacket (uint64_t msSlept);
@@ -70,6 +106,8 @@ private:
 private:
     std::shared_ptr<syncodecs::Codec> m_codec;
     std::shared_ptr<rmcat::SenderBasedController> m_controller;
+    std::string m_gccConfigFile;    // GccConfigFile attribute
+    std::string m_gccParameters;    // GccParameters attribute
     Ipv4Address m_destIP;
     uint16_t m_destPort;
     float m_initBw;
@@ -79,6 +117,7 @@ private:
     uint32_t m_ssrc;
     uint16_t m_sequence;
     uint32_t m_rtpTsOffset;
+    bool m_ecn;
     Ptr<Socket> m_socket;
     EventId m_enqueueEvent;
     EventId m_sendEvent;
@@ -89,6 +128,7 @@ private:
     std::deque<uint32_t> m_rateShapingBuf;
     uint32_t m_rateShapingBytes;
     uint64_t m_nextSendTstmp;
+    bool m_warmStart;
 };
 
 }
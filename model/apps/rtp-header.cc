@@ -27,6 +27,9 @@
  */
 
 #include "rtp-header.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
 
 namespace ns3 {
 
@@ -60,6 +63,11 @@ RtpHeader::RtpHeader ()
 , m_timestamp{0}
 , m_ssrc{0}
 , m_csrcs{}
+, m_sendTimeValid{false}
+, m_sendTime{0}
+, m_transportSeqValid{false}
+, m_transportSeq{0}
+, m_extLength{0}
 {}
 
 RtpHeader::RtpHeader (uint8_t payloadType)
@@ -72,6 +80,11 @@ RtpHeader::RtpHeader (uint8_t payloadType)
 , m_timestamp{0}
 , m_ssrc{0}
 , m_csrcs{}
+, m_sendTimeValid{false}
+, m_sendTime{0}
+, m_transportSeqValid{false}
+, m_transportSeq{0}
+, m_extLength{0}
 {}
 
 RtpHeader::~RtpHeader () {}
@@ -97,7 +110,8 @@ uint32_t RtpHeader::GetSerializedSize () const
            sizeof (m_sequence)  +
            sizeof (m_timestamp) +
            sizeof (m_ssrc) +
-           (m_csrcs.size () & 0x0f) * sizeof (decltype (m_csrcs)::value_type);
+           (m_csrcs.size () & 0x0f) * sizeof (decltype (m_csrcs)::value_type) +
+           (m_extension ? 4 + m_extLength * 4 : 0);
 }
 
 void RtpHeader::Serialize (Buffer::Iterator start) const
@@ -124,6 +138,25 @@ void RtpHeader::Serialize (Buffer::Iterator start) const
     for (const auto& csrc : m_csrcs) {
         start.WriteHtonU32 (csrc);
     }
+    if (m_extension) {
+        start.WriteHtonU16 (RTP_ONE_BYTE_EXT_PROFILE);
+        start.WriteHtonU16 (m_extLength);
+        uint32_t written = 0;
+        if (m_sendTimeValid) {
+            start.WriteU8 ((RTP_EXT_SEND_TIME_ID << 4) | (RTP_EXT_SEND_TIME_LEN - 1));
+            start.WriteHtonU32 (m_sendTime);
+            written += 1 + RTP_EXT_SEND_TIME_LEN;
+        }
+        if (m_transportSeqValid) {
+            start.WriteU8 ((RTP_EXT_TRANSPORT_SEQ_ID << 4) | (RTP_EXT_TRANSPORT_SEQ_LEN - 1));
+            start.WriteHtonU16 (m_transportSeq);
+            written += 1 + RTP_EXT_TRANSPORT_SEQ_LEN;
+        }
+        NS_ASSERT (written <= m_extLength * 4u);
+        for (; written < m_extLength * 4u; ++written) {
+            start.WriteU8 (0); // padding
+        }
+    }
 }
 
 uint32_t RtpHeader::Deserialize (Buffer::Iterator start)
@@ -147,6 +180,40 @@ uint32_t RtpHeader::Deserialize (Buffer::Iterator start)
         NS_ASSERT (m_csrcs.count (csrc) == 0);
         m_csrcs.insert (csrc);
     }
+    m_sendTimeValid = false;
+    m_sendTime = 0;
+    m_transportSeqValid = false;
+    m_transportSeq = 0;
+    m_extLength = 0;
+    if (m_extension) {
+        const uint16_t profile = start.ReadNtohU16 ();
+        m_extLength = start.ReadNtohU16 ();
+        uint32_t read = 0;
+        while (read < m_extLength * 4u) {
+            const uint8_t elemHeader = start.ReadU8 ();
+            ++read;
+            if (profile != RTP_ONE_BYTE_EXT_PROFILE || elemHeader == 0) {
+                continue; // unknown profile or padding: skip
+            }
+            const uint8_t id = elemHeader >> 4;
+            const uint8_t len = (elemHeader & 0x0f) + 1;
+            if (id == 15 || read + len > m_extLength * 4u) {
+                // Reserved id: stop parsing (RFC 8285, section 4.2)
+                start.Next (m_extLength * 4u - read);
+                break;
+            }
+            if (id == RTP_EXT_SEND_TIME_ID && len == RTP_EXT_SEND_TIME_LEN) {
+                m_sendTime = start.ReadNtohU32 ();
+                m_sendTimeValid = true;
+            } else if (id == RTP_EXT_TRANSPORT_SEQ_ID && len == RTP_EXT_TRANSPORT_SEQ_LEN) {
+                m_transportSeq = start.ReadNtohU16 ();
+                m_transportSeqValid = true;
+            } else {
+                start.Next (len);
+            }
+            read += len;
+        }
+    }
     NS_ASSERT (version == RTP_VERSION);
     return GetSerializedSize ();
 }
@@ -163,6 +230,12 @@ void RtpHeader::Print (std::ostream& os) const
        << ", sequence = " << m_sequence
        << ", timestamp = " << m_timestamp
        << ", ssrc = " << m_ssrc;
+    if (m_sendTimeValid) {
+        os << ", send time = " << m_sendTime;
+    }
+    if (m_transportSeqValid) {
+        os << ", transport sequence = " << m_transportSeq;
+    }
     size_t i = 0;
     for (const auto& csrc : m_csrcs) {
         os << ", CSRC#" << i << " = " << csrc;
@@ -189,6 +262,11 @@ bool RtpHeader::IsExtension () const
 void RtpHeader::SetExtension (bool extension)
 {
     m_extension = extension;
+    if (!extension) {
+        m_sendTimeValid = false;
+        m_transportSeqValid = false;
+        m_extLength = 0;
+    }
 }
 
 bool RtpHeader::IsMarker () const
@@ -242,6 +320,54 @@ void RtpHeader::SetTimestamp (uint64_t timestamp)
     m_timestamp = timestamp;
 }
 
+bool RtpHeader::HasSendTime () const
+{
+    return m_sendTimeValid;
+}
+
+uint32_t RtpHeader::GetSendTime () const
+{
+    return m_sendTime;
+}
+
+void RtpHeader::SetSendTime (uint32_t sendTimeUs)
+{
+    m_sendTime = sendTimeUs;
+    m_sendTimeValid = true;
+    UpdateExtLength ();
+}
+
+bool RtpHeader::HasTransportSequence () const
+{
+    return m_transportSeqValid;
+}
+
+uint16_t RtpHeader::GetTransportSequence () const
+{
+    return m_transportSeq;
+}
+
+void RtpHeader::SetTransportSequence (uint16_t sequence)
+{
+    m_transportSeq = sequence;
+    m_transportSeqValid = true;
+    UpdateExtLength ();
+}
+
+void RtpHeader::UpdateExtLength ()
+{
+    // One-byte elements, padded to a 32-bit boundary
+    uint32_t bytes = 0;
+    if (m_sendTimeValid) {
+        bytes += 1 + RTP_EXT_SEND_TIME_LEN;
+    }
+    if (m_transportSeqValid) {
+        bytes += 1 + RTP_EXT_TRANSPORT_SEQ_LEN;
+    }
+    m_extension = true;
+    m_extLength = std::max<uint16_t> (m_extLength, uint16_t ((bytes + 3) / 4));
+}
+
 const std::set<uint32_t>& RtpHeader::GetCsrcs () const
 {
     return m_csrcs;
@@ -414,12 +540,359 @@ void RtcpHeader::SetSendSsrc (uint32_t sendSsrc)
 }
 
 
+constexpr uint32_t RtcpReportBlock::m_size;
+
+RtcpReportBlock::RtcpReportBlock ()
+: m_ssrc{0}
+, m_fractionLost{0}
+, m_cumulativeLost{0}
+, m_extHighestSeq{0}
+, m_jitter{0}
+, m_lsr{0}
+, m_dlsr{0}
+{}
+
+void RtcpReportBlock::Serialize (Buffer::Iterator& start) const
+{
+    // Cumulative loss is clamped to the 24-bit signed range (RFC 3550)
+    const int32_t lost = std::max (-0x800000, std::min (0x7fffff, m_cumulativeLost));
+    start.WriteHtonU32 (m_ssrc);
+    start.WriteHtonU32 ((uint32_t (m_fractionLost) << 24) | (uint32_t (lost) & 0xffffff));
+    start.WriteHtonU32 (m_extHighestSeq);
+    start.WriteHtonU32 (m_jitter);
+    start.WriteHtonU32 (m_lsr);
+    start.WriteHtonU32 (m_dlsr);
+}
+
+void RtcpReportBlock::Deserialize (Buffer::Iterator& start)
+{
+    m_ssrc = start.ReadNtohU32 ();
+    const uint32_t word = start.ReadNtohU32 ();
+    m_fractionLost = uint8_t (word >> 24);
+    m_cumulativeLost = int32_t (word & 0xffffff);
+    if (m_cumulativeLost & 0x800000) {
+        m_cumulativeLost -= 0x1000000; // sign extension
+    }
+    m_extHighestSeq = start.ReadNtohU32 ();
+    m_jitter = start.ReadNtohU32 ();
+    m_lsr = start.ReadNtohU32 ();
+    m_dlsr = start.ReadNtohU32 ();
+}
+
+void RtcpReportBlock::Print (std::ostream& os) const
+{
+    os << "<SSRC = " << m_ssrc
+       << ", fraction lost = " << int (m_fractionLost)
+       << ", cumulative lost = " << m_cumulativeLost
+       << ", ext. highest seq = " << m_extHighestSeq
+       << ", jitter = " << m_jitter
+       << ", LSR = " << m_lsr
+       << ", DLSR = " << m_dlsr << ">";
+}
+
+uint32_t RtcpUsToCompactNtp (uint64_t tsUs)
+{
+    // Seconds in the upper 16 bits, fraction in the lower 16 bits
+    const uint64_t seconds = tsUs / 1000000;
+    const uint64_t fraction = ((tsUs % 1000000) << 16) / 1000000;
+    return uint32_t ((seconds << 16) | fraction);
+}
+
+uint64_t RtcpCompactNtpToUs (uint32_t ntp)
+{
+    return (uint64_t (ntp >> 16) * 1000000) +
+           ((uint64_t (ntp & 0xffff) * 1000000) >> 16);
+}
+
+double RtcpReportInterval (uint32_t members, uint32_t senders, double sessionBwBps,
+                           bool weSent, double avgRtcpSize, bool initial)
+{
+    // Constants of RFC 3550, appendix A.7
+    const double RTCP_MIN_TIME = 5.;
+    const double RTCP_SENDER_BW_FRACTION = 0.25;
+    const double RTCP_RCVR_BW_FRACTION = 1. - RTCP_SENDER_BW_FRACTION;
+    const double RTCP_BW_FRACTION = 0.05;
+    const double COMPENSATION = 2.71828 - 1.5;
+
+    double minTime = RTCP_MIN_TIME;
+    if (sessionBwBps > 0.) {
+        // Reduced minimum (section 6.2)
+        minTime = std::min (minTime, 360. / (sessionBwBps / 1000.));
+    }
+    if (initial) {
+        minTime /= 2.;
+    }
+
+    double n = members;
+    double rtcpBw = sessionBwBps * RTCP_BW_FRACTION / 8.; // octets per second
+    if (senders <= members * RTCP_SENDER_BW_FRACTION) {
+        if (weSent) {
+            rtcpBw *= RTCP_SENDER_BW_FRACTION;
+            n = senders;
+        } else {
+            rtcpBw *= RTCP_RCVR_BW_FRACTION;
+            n -= senders;
+        }
+    }
+
+    double t = minTime;
+    if (rtcpBw > 0.) {
+        t = std::max (t, avgRtcpSize * n / rtcpBw);
+    }
+    // Randomize to [0.5, 1.5] times the interval, then compensate for the
+    // timer reconsideration algorithm
+    t *= double (rand ()) / double (RAND_MAX) + 0.5;
+    return t / COMPENSATION;
+}
+
+SenderReportHeader::SenderReportHeader ()
+: RtcpHeader{RTCP_SR}
+, m_ntpTimestampUs{0}
+, m_rtpTimestamp{0}
+, m_packetCount{0}
+, m_octetCount{0}
+, m_reportBlocks{}
+{
+    m_length += 5; // sender info
+}
+
+SenderReportHeader::~SenderReportHeader () {}
+
+void SenderReportHeader::Clear ()
+{
+    RtcpHeader::Clear ();
+    m_packetType = RTCP_SR;
+    m_length += 5; // sender info
+    m_ntpTimestampUs = 0;
+    m_rtpTimestamp = 0;
+    m_packetCount = 0;
+    m_octetCount = 0;
+    m_reportBlocks.clear ();
+}
+
+TypeId SenderReportHeader::GetTypeId ()
+{
+    static TypeId tid = TypeId ("SenderReportHeader")
+      .SetParent<RtcpHeader> ()
+      .AddConstructor<SenderReportHeader> ()
+    ;
+    return tid;
+}
+
+TypeId SenderReportHeader::GetInstanceTypeId () const
+{
+    return GetTypeId ();
+}
+
+uint32_t SenderReportHeader::GetSerializedSize () const
+{
+    NS_ASSERT (m_length >= 6);
+    const auto commonHdrSize = RtcpHeader::GetSerializedSize ();
+    return commonHdrSize + (m_length - 1) * 4;
+}
+
+void SenderReportHeader::Serialize (Buffer::Iterator start) const
+{
+    NS_ASSERT (m_length == 6 + m_reportBlocks.size () * RtcpReportBlock::m_size / 4);
+    NS_ASSERT (m_typeOrCnt == m_reportBlocks.size ());
+    RtcpHeader::SerializeCommon (start);
+
+    const uint64_t seconds = m_ntpTimestampUs / 1000000;
+    const uint64_t fraction = ((m_ntpTimestampUs % 1000000) << 32) / 1000000;
+    start.WriteHtonU32 (uint32_t (seconds));
+    start.WriteHtonU32 (uint32_t (fraction));
+    start.WriteHtonU32 (m_rtpTimestamp);
+    start.WriteHtonU32 (m_packetCount);
+    start.WriteHtonU32 (m_octetCount);
+    for (const auto& block : m_reportBlocks) {
+        block.Serialize (start);
+    }
+}
+
+uint32_t SenderReportHeader::Deserialize (Buffer::Iterator start)
+{
+    (void) RtcpHeader::DeserializeCommon (start);
+    NS_ASSERT (m_packetType == RTCP_SR);
+    NS_ASSERT (m_length == 6 + m_typeOrCnt * RtcpReportBlock::m_size / 4);
+    const uint64_t seconds = start.ReadNtohU32 ();
+    const uint64_t fraction = start.ReadNtohU32 ();
+    m_ntpTimestampUs = seconds * 1000000 + ((fraction * 1000000) >> 32);
+    m_rtpTimestamp = start.ReadNtohU32 ();
+    m_packetCount = start.ReadNtohU32 ();
+    m_octetCount = start.ReadNtohU32 ();
+    m_reportBlocks.assign (m_typeOrCnt, RtcpReportBlock{});
+    for (auto& block : m_reportBlocks) {
+        block.Deserialize (start);
+    }
+    return GetSerializedSize ();
+}
+
+void SenderReportHeader::Print (std::ostream& os) const
+{
+    RtcpHeader::PrintN (os);
+    os << ", NTP timestamp = " << m_ntpTimestampUs << " us"
+       << ", RTP timestamp = " << m_rtpTimestamp
+       << ", packet count = " << m_packetCount
+       << ", octet count = " << m_octetCount;
+    for (const auto& block : m_reportBlocks) {
+        os << ", ";
+        block.Print (os);
+    }
+    os << std::endl;
+}
+
+uint64_t SenderReportHeader::GetNtpTimestampUs () const
+{
+    return m_ntpTimestampUs;
+}
+
+void SenderReportHeader::SetNtpTimestampUs (uint64_t ntpUs)
+{
+    m_ntpTimestampUs = ntpUs;
+}
+
+uint32_t SenderReportHeader::GetCompactNtp () const
+{
+    return RtcpUsToCompactNtp (m_ntpTimestampUs);
+}
+
+uint32_t SenderReportHeader::GetRtpTimestamp () const
+{
+    return m_rtpTimestamp;
+}
+
+void SenderReportHeader::SetRtpTimestamp (uint32_t rtpTimestamp)
+{
+    m_rtpTimestamp = rtpTimestamp;
+}
+
+uint32_t SenderReportHeader::GetPacketCount () const
+{
+    return m_packetCount;
+}
+
+void SenderReportHeader::SetPacketCount (uint32_t packetCount)
+{
+    m_packetCount = packetCount;
+}
+
+uint32_t SenderReportHeader::GetOctetCount () const
+{
+    return m_octetCount;
+}
+
+void SenderReportHeader::SetOctetCount (uint32_t octetCount)
+{
+    m_octetCount = octetCount;
+}
+
+const std::vector<RtcpReportBlock>& SenderReportHeader::GetReportBlocks () const
+{
+    return m_reportBlocks;
+}
+
+bool SenderReportHeader::AddReportBlock (const RtcpReportBlock& block)
+{
+    if (m_reportBlocks.size () >= 0x1f) {
+        return false;
+    }
+    m_reportBlocks.push_back (block);
+    m_typeOrCnt = uint8_t (m_reportBlocks.size ());
+    m_length += RtcpReportBlock::m_size / 4;
+    return true;
+}
+
+ReceiverReportHeader::ReceiverReportHeader ()
+: RtcpHeader{RTCP_RR}
+, m_reportBlocks{}
+{}
+
+ReceiverReportHeader::~ReceiverReportHeader () {}
+
+void ReceiverReportHeader::Clear ()
+{
+    RtcpHeader::Clear ();
+    m_packetType = RTCP_RR;
+    m_reportBlocks.clear ();
+}
+
+TypeId ReceiverReportHeader::GetTypeId ()
+{
+    static TypeId tid = TypeId ("ReceiverReportHeader")
+      .SetParent<RtcpHeader> ()
+      .AddConstructor<ReceiverReportHeader> ()
+    ;
+    return tid;
+}
+
+TypeId ReceiverReportHeader::GetInstanceTypeId () const
+{
+    return GetTypeId ();
+}
+
+uint32_t ReceiverReportHeader::GetSerializedSize () const
+{
+    NS_ASSERT (m_length >= 1);
+    const auto commonHdrSize = RtcpHeader::GetSerializedSize ();
+    return commonHdrSize + (m_length - 1) * 4;
+}
+
+void ReceiverReportHeader::Serialize (Buffer::Iterator start) const
+{
+    NS_ASSERT (m_length == 1 + m_reportBlocks.size () * RtcpReportBlock::m_size / 4);
+    NS_ASSERT (m_typeOrCnt == m_reportBlocks.size ());
+    RtcpHeader::SerializeCommon (start);
+    for (const auto& block : m_reportBlocks) {
+        block.Serialize (start);
+    }
+}
+
+uint32_t ReceiverReportHeader::Deserialize (Buffer::Iterator start)
+{
+    (void) RtcpHeader::DeserializeCommon (start);
+    NS_ASSERT (m_packetType == RTCP_RR);
+    NS_ASSERT (m_length == 1 + m_typeOrCnt * RtcpReportBlock::m_size / 4);
+    m_reportBlocks.assign (m_typeOrCnt, RtcpReportBlock{});
+    for (auto& block : m_reportBlocks) {
+        block.Deserialize (start);
+    }
+    return GetSerializedSize ();
+}
+
+void ReceiverReportHeader::Print (std::ostream& os) const
+{
+    RtcpHeader::PrintN (os);
+    for (const auto& block : m_reportBlocks) {
+        os << ", ";
+        block.Print (os);
+    }
+    os << std::endl;
+}
+
+const std::vector<RtcpReportBlock>& ReceiverReportHeader::GetReportBlocks () const
+{
+    return m_reportBlocks;
+}
+
+bool ReceiverReportHeader::AddReportBlock (const RtcpReportBlock& block)
+{
+    if (m_reportBlocks.size () >= 0x1f) {
+        return false;
+    }
+    m_reportBlocks.push_back (block);
+    m_typeOrCnt = uint8_t (m_reportBlocks.size ());
+    m_length += RtcpReportBlock::m_size / 4;
+    return true;
+}
+
+
 constexpr uint16_t CCFeedbackHeader::MetricBlock::m_overrange;
 constexpr uint16_t CCFeedbackHeader::MetricBlock::m_unavailable;
 
 CCFeedbackHeader::CCFeedbackHeader ()
 : RtcpHeader{RTP_FB, RTCP_RTPFB_CC}
 , m_reportBlocks{}
+, m_gaps{}
 , m_latestTsUs{0}
 {
     ++m_length; // report timestamp field
@@ -434,6 +907,7 @@ void CCFeedbackHeader::Clear ()
     m_typeOrCnt = RTCP_RTPFB_CC;
     ++m_length; // report timestamp field
     m_reportBlocks.clear ();
+    m_gaps.clear ();
     m_latestTsUs = 0;
 }
 
@@ -464,10 +938,13 @@ CCFeedbackHeader::AddFeedback (uint32_t ssrc, uint16_t seq, uint64_t timestampUs
     auto& mb = rb[seq];
     mb.m_timestampUs = timestampUs;
     mb.m_ecn = ecn;
+    InsertGap (ssrc, seq);
     if (!UpdateLength ()) {
+        EraseGap (ssrc, seq);
         rb.erase (seq);
         if (rb.empty ()) {
             m_reportBlocks.erase (ssrc);
+            m_gaps.erase (ssrc);
         }
         return CCFB_TOO_LONG;
     }
@@ -687,17 +1164,97 @@ CCFeedbackHeader::CalculateBeginStopSeq (const ReportBlock_t& rb)
     return std::make_pair (max_hi, max_lo);
 }
 
+uint32_t CCFeedbackHeader::SeqGap (uint16_t low, uint16_t high)
+{
+    const uint16_t gap = high - low; //this wraps properly
+    return gap == 0 ? 0x10000 : gap; // a single sequence is a full-circle gap
+}
+
+void CCFeedbackHeader::InsertGap (uint32_t ssrc, uint16_t seq)
+{
+    const auto& rb = m_reportBlocks[ssrc];
+    auto& gaps = m_gaps[ssrc];
+    if (gaps.size () + 1 != rb.size ()) {
+        // Report block not built with AddFeedback (e.g., deserialized)
+        RebuildGaps (ssrc);
+        return;
+    }
+    if (rb.size () == 1) {
+        gaps.insert (SeqGap (seq, seq));
+        return;
+    }
+    // The new sequence splits the gap between its two neighbours
+    const auto it = rb.find (seq);
+    NS_ASSERT (it != rb.end ());
+    auto next = std::next (it);
+    if (next == rb.end ()) {
+        next = rb.begin ();
+    }
+    const auto prev = (it == rb.begin ()) ? std::prev (rb.end ()) : std::prev (it);
+    const auto old = gaps.find (SeqGap (prev->first, next->first));
+    NS_ASSERT (old != gaps.end ());
+    gaps.erase (old);
+    gaps.insert (SeqGap (prev->first, seq));
+    gaps.insert (SeqGap (seq, next->first));
+}
+
+void CCFeedbackHeader::EraseGap (uint32_t ssrc, uint16_t seq)
+{
+    const auto& rb = m_reportBlocks[ssrc];
+    auto& gaps = m_gaps[ssrc];
+    NS_ASSERT (gaps.size () == rb.size ());
+    if (rb.size () == 1) {
+        gaps.clear ();
+        return;
+    }
+    // Merge the two gaps around the sequence
+    const auto it = rb.find (seq);
+    NS_ASSERT (it != rb.end ());
+    auto next = std::next (it);
+    if (next == rb.end ()) {
+        next = rb.begin ();
+    }
+    const auto prev = (it == rb.begin ()) ? std::prev (rb.end ()) : std::prev (it);
+    const auto low = gaps.find (SeqGap (prev->first, seq));
+    NS_ASSERT (low != gaps.end ());
+    gaps.erase (low);
+    const auto high = gaps.find (SeqGap (seq, next->first));
+    NS_ASSERT (high != gaps.end ());
+    gaps.erase (high);
+    gaps.insert (SeqGap (prev->first, next->first));
+}
+
+void CCFeedbackHeader::RebuildGaps (uint32_t ssrc)
+{
+    const auto& rb = m_reportBlocks[ssrc];
+    auto& gaps = m_gaps[ssrc];
+    gaps.clear ();
+    if (rb.empty ()) {
+        return;
+    }
+    uint16_t low = rb.rbegin ()->first; // gap across wrapping
+    for (const auto& mb : rb) {
+        gaps.insert (SeqGap (low, mb.first));
+        low = mb.first;
+    }
+}
+
 bool CCFeedbackHeader::UpdateLength ()
 {
     size_t len = 1; // SSRC of packet sender
     for (const auto& rb : m_reportBlocks) {
         ++len; // SSRC
         ++len; // begin & end seq
-        const auto beginStop = CalculateBeginStopSeq (rb.second);
-        const uint16_t beginSeq = beginStop.first;
-        const uint16_t stopSeq = beginStop.second;
-        const uint16_t nMetricBlocks = stopSeq - beginSeq; //this wraps properly
-        const uint16_t nPaddingBlocks = nMetricBlocks % 2;
+        // The report block spans all sequences but those in the biggest gap
+        uint32_t nMetricBlocks = 0;
+        const auto gaps = m_gaps.find (rb.first);
+        if (gaps != m_gaps.end () && gaps->second.size () == rb.second.size ()) {
+            nMetricBlocks = 0x10000 - *gaps->second.rbegin () + 1;
+        } else {
+            const auto beginStop = CalculateBeginStopSeq (rb.second);
+            nMetricBlocks = uint16_t (beginStop.second - beginStop.first); //this wraps properly
+        }
+        const uint32_t nPaddingBlocks = nMetricBlocks % 2;
         len += (nMetricBlocks + nPaddingBlocks) / 2; // metric blocks are 16 bits long
     }
     ++len; // report timestamp field
@@ -738,4 +1295,254 @@ uint32_t CCFeedbackHeader::UsToNtp (uint64_t tsUs)
     return uint32_t (tsSeconds * double (0x10000));
 }
 
+
+constexpr uint32_t RembHeader::m_rembId;
+
+RembHeader::RembHeader ()
+: RtcpHeader{RTP_PSFB, RTCP_PSFB_AFB}
+, m_exp{0}
+, m_mantissa{0}
+, m_ssrcs{}
+{
+    m_length += 3; // media source SSRC, unique identifier, num SSRC & bitrate
+}
+
+RembHeader::~RembHeader () {}
+
+void RembHeader::Clear ()
+{
+    RtcpHeader::Clear ();
+    m_packetType = RTP_PSFB;
+    m_typeOrCnt = RTCP_PSFB_AFB;
+    m_length += 3; // media source SSRC, unique identifier, num SSRC & bitrate
+    m_exp = 0;
+    m_mantissa = 0;
+    m_ssrcs.clear ();
+}
+
+TypeId RembHeader::GetTypeId ()
+{
+    static TypeId tid = TypeId ("RembHeader")
+      .SetParent<RtcpHeader> ()
+      .AddConstructor<RembHeader> ()
+    ;
+    return tid;
+}
+
+TypeId RembHeader::GetInstanceTypeId () const
+{
+    return GetTypeId ();
+}
+
+uint32_t RembHeader::GetSerializedSize () const
+{
+    NS_ASSERT (m_length >= 4);
+    const auto commonHdrSize = RtcpHeader::GetSerializedSize ();
+    return commonHdrSize + (m_length - 1) * 4;
+}
+
+void RembHeader::Serialize (Buffer::Iterator start) const
+{
+    NS_ASSERT (m_length == 4 + m_ssrcs.size ());
+    NS_ASSERT (m_ssrcs.size () <= 0xff);
+    NS_ASSERT (m_exp <= 0x3f);
+    NS_ASSERT (m_mantissa <= 0x3ffff);
+    RtcpHeader::SerializeCommon (start);
+
+    start.WriteHtonU32 (0); // media source SSRC
+    start.WriteHtonU32 (m_rembId);
+    start.WriteU8 (uint8_t (m_ssrcs.size ()));
+    start.WriteU8 (uint8_t ((m_exp << 2) | (m_mantissa >> 16)));
+    start.WriteHtonU16 (uint16_t (m_mantissa & 0xffff));
+    for (const auto& ssrc : m_ssrcs) {
+        start.WriteHtonU32 (ssrc);
+    }
+}
+
+uint32_t RembHeader::Deserialize (Buffer::Iterator start)
+{
+    (void) RtcpHeader::DeserializeCommon (start);
+    NS_ASSERT (m_packetType == RTP_PSFB);
+    NS_ASSERT (m_typeOrCnt == RTCP_PSFB_AFB);
+    NS_ASSERT (m_length >= 4);
+    (void) start.ReadNtohU32 (); // media source SSRC
+    const uint32_t id = start.ReadNtohU32 ();
+    NS_ASSERT (id == m_rembId);
+    const uint8_t nSsrcs = start.ReadU8 ();
+    NS_ASSERT (m_length == 4 + nSsrcs);
+    const uint8_t octet = start.ReadU8 ();
+    m_exp = octet >> 2;
+    m_mantissa = (uint32_t (octet & 0x03) << 16) | start.ReadNtohU16 ();
+    m_ssrcs.clear ();
+    for (uint8_t i = 0; i < nSsrcs; ++i) {
+        m_ssrcs.insert (start.ReadNtohU32 ());
+    }
+    return GetSerializedSize ();
+}
+
+void RembHeader::Print (std::ostream& os) const
+{
+    RtcpHeader::PrintN (os);
+    os << ", REMB bitrate = " << GetBitrate ()
+       << " (exp = " << int (m_exp) << ", mantissa = " << m_mantissa << ")";
+    size_t i = 0;
+    for (const auto& ssrc : m_ssrcs) {
+        os << ", SSRC#" << i << " = " << ssrc;
+        ++i;
+    }
+    os << std::endl;
+}
+
+uint64_t RembHeader::GetBitrate () const
+{
+    return uint64_t (m_mantissa) << m_exp;
+}
+
+void RembHeader::SetBitrate (uint64_t bitrateBps)
+{
+    // Smallest exponent that makes the mantissa fit in 18 bits
+    uint8_t exp = 0;
+    while ((bitrateBps >> exp) > 0x3ffff) {
+        ++exp;
+    }
+    NS_ASSERT (exp <= 0x3f);
+    m_exp = exp;
+    m_mantissa = uint32_t (bitrateBps >> exp);
+}
+
+const std::set<uint32_t>& RembHeader::GetSsrcs () const
+{
+    return m_ssrcs;
+}
+
+bool RembHeader::AddSsrc (uint32_t ssrc)
+{
+    if (m_ssrcs.count (ssrc) != 0 || m_ssrcs.size () >= 0xff) {
+        return false;
+    }
+    m_ssrcs.insert (ssrc);
+    ++m_length;
+    return true;
+}
+
+NackHeader::NackHeader ()
+: RtcpHeader{RTP_FB, RTCP_RTPFB_GNACK}
+, m_mediaSsrc{0}
+, m_fci{}
+{
+    ++m_length; // media source SSRC
+}
+
+NackHeader::~NackHeader () {}
+
+void NackHeader::Clear ()
+{
+    RtcpHeader::Clear ();
+    m_packetType = RTP_FB;
+    m_typeOrCnt = RTCP_RTPFB_GNACK;
+    ++m_length; // media source SSRC
+    m_mediaSsrc = 0;
+    m_fci.clear ();
+}
+
+TypeId NackHeader::GetTypeId ()
+{
+    static TypeId tid = TypeId ("NackHeader")
+      .SetParent<RtcpHeader> ()
+      .AddConstructor<NackHeader> ()
+    ;
+    return tid;
+}
+
+TypeId NackHeader::GetInstanceTypeId () const
+{
+    return GetTypeId ();
+}
+
+uint32_t NackHeader::GetSerializedSize () const
+{
+    NS_ASSERT (m_length >= 2);
+    const auto commonHdrSize = RtcpHeader::GetSerializedSize ();
+    return commonHdrSize + (m_length - 1) * 4;
+}
+
+void NackHeader::Serialize (Buffer::Iterator start) const
+{
+    NS_ASSERT (m_length == 2 + m_fci.size ());
+    RtcpHeader::SerializeCommon (start);
+
+    start.WriteHtonU32 (m_mediaSsrc);
+    for (const auto& fci : m_fci) {
+        start.WriteHtonU16 (fci.first);
+        start.WriteHtonU16 (fci.second);
+    }
+}
+
+uint32_t NackHeader::Deserialize (Buffer::Iterator start)
+{
+    (void) RtcpHeader::DeserializeCommon (start);
+    NS_ASSERT (m_packetType == RTP_FB);
+    NS_ASSERT (m_typeOrCnt == RTCP_RTPFB_GNACK);
+    NS_ASSERT (m_length >= 2);
+    m_mediaSsrc = start.ReadNtohU32 ();
+    m_fci.clear ();
+    for (uint16_t i = 2; i < m_length; ++i) {
+        const uint16_t pid = start.ReadNtohU16 ();
+        const uint16_t blp = start.ReadNtohU16 ();
+        m_fci.push_back (std::make_pair (pid, blp));
+    }
+    return GetSerializedSize ();
+}
+
+void NackHeader::Print (std::ostream& os) const
+{
+    RtcpHeader::PrintN (os);
+    os << ", media SSRC = " << m_mediaSsrc << ", NACKed =";
+    std::vector<uint16_t> sequences{};
+    GetSequences (sequences);
+    for (const auto& sequence : sequences) {
+        os << " " << sequence;
+    }
+    os << std::endl;
+}
+
+uint32_t NackHeader::GetMediaSsrc () const
+{
+    return m_mediaSsrc;
+}
+
+void NackHeader::SetMediaSsrc (uint32_t mediaSsrc)
+{
+    m_mediaSsrc = mediaSsrc;
+}
+
+void NackHeader::AddSequence (uint16_t sequence)
+{
+    if (!m_fci.empty ()) {
+        auto& last = m_fci.back ();
+        const uint16_t delta = sequence - last.first; // wraps properly
+        if (delta == 0) {
+            return;
+        }
+        if (delta <= 16) {
+            last.second |= uint16_t (1 << (delta - 1));
+            return;
+        }
+    }
+    m_fci.push_back (std::make_pair (sequence, uint16_t (0)));
+    ++m_length;
+}
+
+void NackHeader::GetSequences (std::vector<uint16_t>& sequences) const
+{
+    for (const auto& fci : m_fci) {
+        sequences.push_back (fci.first);
+        for (uint16_t i = 0; i < 16; ++i) {
+            if (fci.second & (1 << i)) {
+                sequences.push_back (uint16_t (fci.first + i + 1));
+            }
+        }
+    }
+}
+
 }
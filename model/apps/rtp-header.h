@@ -33,6 +33,7 @@
 #include "ns3/type-id.h"
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -41,6 +42,23 @@ bool RtpHdrGetBit (uint8_t val, uint8_t pos);
 
 const uint8_t RTP_VERSION = 2;
 
+/** One-byte header extensions (RFC 8285) */
+const uint16_t RTP_ONE_BYTE_EXT_PROFILE = 0xBEDE;
+/**
+ * Extension element carrying the send time of the packet in us (32 bits,
+ * wrapping), as abs-send-time does with a coarser resolution. Lets the RTP
+ * timestamp carry the capture time of the frame
+ */
+const uint8_t RTP_EXT_SEND_TIME_ID = 1;
+const uint8_t RTP_EXT_SEND_TIME_LEN = 4;
+/**
+ * Extension element carrying a transport-wide sequence number (16 bits),
+ * shared by all the streams of a sender: congestion control feedback is
+ * keyed by it (draft-holmer-rmcat-transport-wide-cc-extensions)
+ */
+const uint8_t RTP_EXT_TRANSPORT_SEQ_ID = 2;
+const uint8_t RTP_EXT_TRANSPORT_SEQ_LEN = 2;
+
 //-------------------- RTP HEADER (RFC 3550) ----------------------//
 //   0                   1                   2                   3
 //   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -54,6 +72,14 @@ const uint8_t RTP_VERSION = 2;
 //  |            contributing source (CSRC) identifiers             |
 //  |                             ....                              |
 //  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |       0xBE    |    0xDE       |           length=2            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  ID=1 | len=3 |          send time (us)                       |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  send time    |  ID=2 | len=1 |  transport-wide sequence      |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// The header extension (X=1) is only present when the send time or the
+// transport-wide sequence is set; missing elements are replaced by padding
 class RtpHeader : public Header
 {
 public:
@@ -82,10 +108,18 @@ public:
     void SetSsrc (uint32_t ssrc);
     uint32_t GetTimestamp () const;
     void SetTimestamp (uint64_t timestamp);
+    bool HasSendTime () const;
+    uint32_t GetSendTime () const;
+    void SetSendTime (uint32_t sendTimeUs);
+    bool HasTransportSequence () const;
+    uint16_t GetTransportSequence () const;
+    void SetTransportSequence (uint16_t sequence);
     const std::set<uint32_t>& GetCsrcs () const;
     bool AddCsrc (uint32_t csrc);
 
 protected:
+    void UpdateExtLength ();
+
     bool m_padding;
     bool m_extension;
     bool m_marker;
@@ -94,6 +128,11 @@ protected:
     uint32_t m_timestamp;
     uint32_t m_ssrc;
     std::set<uint32_t> m_csrcs;
+    bool m_sendTimeValid;
+    uint32_t m_sendTime;
+    bool m_transportSeqValid;
+    uint16_t m_transportSeq;
+    uint16_t m_extLength;   // in 32-bit words, without the 4-octet extension header
 };
 
 
@@ -150,6 +189,17 @@ public:
         RTCP_RTPFB_CC     = 15,  // TODO (deferred): Change to IANA-assigned value
     };
 
+    enum PsFeedbackType {
+        RTCP_PSFB_PLI  =  1,
+        RTCP_PSFB_SLI  =  2,
+        RTCP_PSFB_RPSI =  3,
+        RTCP_PSFB_FIR  =  4,
+        RTCP_PSFB_TSTR =  5,
+        RTCP_PSFB_TSTN =  6,
+        RTCP_PSFB_VBCM =  7,
+        RTCP_PSFB_AFB  = 15,  // Application layer feedback (e.g., REMB)
+    };
+
     RtcpHeader ();
     RtcpHeader (uint8_t packetType);
     RtcpHeader (uint8_t packetType, uint8_t subType);
@@ -184,6 +234,152 @@ protected:
     uint32_t m_sendSsrc;
 };
 
+//--------------- RTCP REPORT BLOCK (RFC 3550) --------------------//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//  |                 SSRC_1 (SSRC of first source)                 |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  | fraction lost |       cumulative number of packets lost       |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |           extended highest sequence number received           |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                      interarrival jitter                      |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                         last SR (LSR)                         |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                   delay since last SR (DLSR)                  |
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+class RtcpReportBlock
+{
+public:
+    static constexpr uint32_t m_size = 24; /**< Serialized size in bytes */
+
+    RtcpReportBlock ();
+    void Serialize (ns3::Buffer::Iterator& start) const;
+    void Deserialize (ns3::Buffer::Iterator& start);
+    void Print (std::ostream& os) const;
+
+    uint32_t m_ssrc;
+    uint8_t m_fractionLost;    /**< Fraction lost since the previous report, Q8 */
+    int32_t m_cumulativeLost;  /**< 24-bit signed on the wire */
+    uint32_t m_extHighestSeq;
+    uint32_t m_jitter;         /**< In RTP timestamp units */
+    uint32_t m_lsr;            /**< Compact NTP timestamp of the last SR, 0 if none */
+    uint32_t m_dlsr;           /**< Delay since the last SR, in 1/65536 s */
+};
+
+/**
+ * Compact (middle 32 bits) NTP timestamp of a time in microseconds,
+ * as used by the LSR and DLSR fields of report blocks
+ */
+uint32_t RtcpUsToCompactNtp (uint64_t tsUs);
+uint64_t RtcpCompactNtpToUs (uint32_t ntp);
+
+/**
+ * RTCP transmission interval (RFC 3550, section 6.3.1 and appendix A.7),
+ * already randomized and compensated. The minimum interval is the
+ * "reduced minimum" of section 6.2 (360 / session bandwidth in kbps
+ * seconds, at most 5 s), so that reports keep up with high-rate sessions
+ *
+ * @param [in] members Number of members of the session (including us)
+ * @param [in] senders Number of senders of the session
+ * @param [in] sessionBwBps Session bandwidth in bps, 0 if not known yet
+ * @param [in] weSent Whether we sent media since the last report
+ * @param [in] avgRtcpSize Average size of the RTCP packets, in bytes
+ * @param [in] initial Whether no report has been sent yet
+ * @retval Interval until the next report, in seconds
+ */
+double RtcpReportInterval (uint32_t members, uint32_t senders, double sessionBwBps,
+                           bool weSent, double avgRtcpSize, bool initial);
+
+//--------------- RTCP SENDER REPORT (RFC 3550) -------------------//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |V=2|P|    RC   |   PT=SR=200   |             length            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                         SSRC of sender                        |
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//  |              NTP timestamp, most significant word             |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |             NTP timestamp, least significant word             |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                         RTP timestamp                         |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                     sender's packet count                     |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                      sender's octet count                     |
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//  |                 report blocks (RtcpReportBlock)               |
+//  |                             ....                              |
+class SenderReportHeader : public RtcpHeader
+{
+public:
+    SenderReportHeader ();
+    virtual ~SenderReportHeader ();
+    virtual void Clear ();
+
+    static ns3::TypeId GetTypeId ();
+    virtual ns3::TypeId GetInstanceTypeId () const;
+    virtual uint32_t GetSerializedSize () const;
+    virtual void Serialize (ns3::Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+    virtual void Print (std::ostream& os) const;
+
+    /** NTP timestamp, kept in microseconds (NTP time of the simulator) */
+    uint64_t GetNtpTimestampUs () const;
+    void SetNtpTimestampUs (uint64_t ntpUs);
+    /** Middle 32 bits of the NTP timestamp, to be echoed as LSR */
+    uint32_t GetCompactNtp () const;
+    uint32_t GetRtpTimestamp () const;
+    void SetRtpTimestamp (uint32_t rtpTimestamp);
+    uint32_t GetPacketCount () const;
+    void SetPacketCount (uint32_t packetCount);
+    uint32_t GetOctetCount () const;
+    void SetOctetCount (uint32_t octetCount);
+    const std::vector<RtcpReportBlock>& GetReportBlocks () const;
+    bool AddReportBlock (const RtcpReportBlock& block);
+
+protected:
+    uint64_t m_ntpTimestampUs;
+    uint32_t m_rtpTimestamp;
+    uint32_t m_packetCount;
+    uint32_t m_octetCount;
+    std::vector<RtcpReportBlock> m_reportBlocks;
+};
+
+//-------------- RTCP RECEIVER REPORT (RFC 3550) ------------------//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |V=2|P|    RC   |   PT=RR=201   |             length            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                     SSRC of packet sender                     |
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//  |                 report blocks (RtcpReportBlock)               |
+//  |                             ....                              |
+class ReceiverReportHeader : public RtcpHeader
+{
+public:
+    ReceiverReportHeader ();
+    virtual ~ReceiverReportHeader ();
+    virtual void Clear ();
+
+    static ns3::TypeId GetTypeId ();
+    virtual ns3::TypeId GetInstanceTypeId () const;
+    virtual uint32_t GetSerializedSize () const;
+    virtual void Serialize (ns3::Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+    virtual void Print (std::ostream& os) const;
+
+    const std::vector<RtcpReportBlock>& GetReportBlocks () const;
+    bool AddReportBlock (const RtcpReportBlock& block);
+
+protected:
+    std::vector<RtcpReportBlock> m_reportBlocks;
+};
+
 //-- RCTP CCFB HEADER (draft-ietf-avtcore-cc-feedback-message-01) -//
 //   0                   1                   2                   3
 //   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -256,11 +452,112 @@ protected:
     static uint16_t NtpToAto (uint32_t ntp, uint32_t ntpRef);
     static uint32_t AtoToNtp (uint16_t ato, uint32_t ntpRef);
 
+    /*
+     * The length of a report block only depends on the biggest gap between
+     * (cyclically) consecutive sequence numbers. The gaps of each report
+     * block are kept up to date as feedback is added, so that the length of
+     * the packet can be updated in O(log n) rather than O(n) per sequence.
+     */
+    typedef std::multiset<uint32_t> GapSet_t;
+    static uint32_t SeqGap (uint16_t low, uint16_t high);
+    void InsertGap (uint32_t ssrc, uint16_t seq);
+    void EraseGap (uint32_t ssrc, uint16_t seq);
+    void RebuildGaps (uint32_t ssrc);
+
     bool UpdateLength ();
     std::map<uint32_t /* SSRC */, ReportBlock_t> m_reportBlocks;
+    std::map<uint32_t /* SSRC */, GapSet_t> m_gaps;
     uint64_t m_latestTsUs;
 };
 
+
+//------ RCTP REMB HEADER (draft-alvestrand-rmcat-remb-03) --------//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |V=2|P| FMT=15  |   PT=206      |             length            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                  SSRC of packet sender                        |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                  SSRC of media source (unused) = 0            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  Unique identifier 'R' 'E' 'M' 'B'                            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  Num SSRC     | BR Exp    |  BR Mantissa                      |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |   SSRC feedback                                               |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  ...                                                          |
+class RembHeader : public RtcpHeader
+{
+public:
+    RembHeader ();
+    virtual ~RembHeader ();
+    virtual void Clear ();
+
+    static ns3::TypeId GetTypeId ();
+    virtual ns3::TypeId GetInstanceTypeId () const;
+    virtual uint32_t GetSerializedSize () const;
+    virtual void Serialize (ns3::Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+    virtual void Print (std::ostream& os) const;
+
+    /** Bitrate as carried in the message (mantissa/exponent, rounded down) */
+    uint64_t GetBitrate () const;
+    void SetBitrate (uint64_t bitrateBps);
+    const std::set<uint32_t>& GetSsrcs () const;
+    bool AddSsrc (uint32_t ssrc);
+
+protected:
+    static constexpr uint32_t m_rembId = 0x52454d42; // 'R' 'E' 'M' 'B'
+    uint8_t m_exp;
+    uint32_t m_mantissa;
+    std::set<uint32_t> m_ssrcs;
+};
+
+//------------ RCTP GENERIC NACK HEADER (RFC 4585) ----------------//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |V=2|P|  FMT=1  |   PT=205      |             length            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                  SSRC of packet sender                        |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                  SSRC of media source                         |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |            PID                |             BLP               |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  ...                                                          |
+// PID: lost packet; bit i of BLP set: packet PID+i+1 lost as well
+class NackHeader : public RtcpHeader
+{
+public:
+    NackHeader ();
+    virtual ~NackHeader ();
+    virtual void Clear ();
+
+    static ns3::TypeId GetTypeId ();
+    virtual ns3::TypeId GetInstanceTypeId () const;
+    virtual uint32_t GetSerializedSize () const;
+    virtual void Serialize (ns3::Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+    virtual void Print (std::ostream& os) const;
+
+    uint32_t GetMediaSsrc () const;
+    void SetMediaSsrc (uint32_t mediaSsrc);
+
+    /**
+     * Request the retransmission of a packet. Sequences added in increasing
+     * order share FCI entries
+     */
+    void AddSequence (uint16_t sequence);
+    void GetSequences (std::vector<uint16_t>& sequences) const;
+
+protected:
+    uint32_t m_mediaSsrc;
+    std::vector<std::pair<uint16_t, uint16_t> > m_fci;  // (PID, BLP)
+};
+
 }
 
 #endif /* RTP_HEADER_H */
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Application-limited region detector implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "alr-detector.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace rmcat {
+
+static const double kBandwidthUsageRatio = 0.65;   /**< budget rate, x estimate */
+static const int64_t kWindowMs = 500;              /**< budget cap, in time at the budget rate */
+static const double kStartBudgetRatio = 0.80;      /**< unused budget to enter ALR ... */
+static const double kStopBudgetRatio = 0.50;       /**< ... and to leave it */
+
+static const char* kAlrStateTag = "alr-detector";
+static const int kAlrStateVersion = 1;
+
+AlrDetector::AlrDetector() {
+    reset();
+}
+
+void AlrDetector::reset() {
+    m_targetBps = 0;
+    m_budgetBytes = 0.;
+    m_lastSendMs = -1;
+    m_alrStartMs = -1;
+}
+
+void AlrDetector::setEstimatedBitrate(uint32_t bitrateBps) {
+    m_targetBps = uint32_t(kBandwidthUsageRatio * bitrateBps);
+}
+
+void AlrDetector::onBytesSent(uint32_t bytes, int64_t nowMs) {
+    if (m_lastSendMs < 0) {
+        m_lastSendMs = nowMs;
+        return;
+    }
+    const int64_t deltaMs = std::max<int64_t>(nowMs - m_lastSendMs, 0);
+    m_lastSendMs = nowMs;
+
+    // Unused budget builds up, within the window
+    const double maxBytes = double(m_targetBps) * kWindowMs / 8000.;
+    if (maxBytes <= 0.) {
+        return;
+    }
+    m_budgetBytes = std::min(m_budgetBytes + double(m_targetBps) * deltaMs / 8000., maxBytes);
+    m_budgetBytes = std::max(m_budgetBytes - bytes, -maxBytes);
+
+    const double ratio = m_budgetBytes / maxBytes;
+    if (m_alrStartMs < 0 && ratio > kStartBudgetRatio) {
+        m_alrStartMs = nowMs;
+    } else if (m_alrStartMs >= 0 && ratio < kStopBudgetRatio) {
+        m_alrStartMs = -1;
+    }
+}
+
+bool AlrDetector::inAlr() const {
+    return m_alrStartMs >= 0;
+}
+
+int64_t AlrDetector::getAlrStartTimeMs() const {
+    return m_alrStartMs;
+}
+
+void AlrDetector::saveState(std::ostream& os) const {
+    os << kAlrStateTag << " " << kAlrStateVersion << "\n";
+    os << m_targetBps << " " << m_budgetBytes << " "
+       << m_lastSendMs << " " << m_alrStartMs << "\n";
+}
+
+bool AlrDetector::restoreState(std::istream& is) {
+    std::string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != kAlrStateTag || version != kAlrStateVersion) {
+        std::cerr << "AlrDetector::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    if (!(is >> m_targetBps >> m_budgetBytes >> m_lastSendMs >> m_alrStartMs)) {
+        std::cerr << "AlrDetector::restoreState,"
+                  << " truncated or corrupted state" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
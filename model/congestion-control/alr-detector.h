@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Application-limited region detector interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef ALR_DETECTOR_H
+#define ALR_DETECTOR_H
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace rmcat {
+
+/**
+ * Detects when the sender is application-limited: the media it actually
+ * sends uses only a small part of the estimated bandwidth (e.g., a content
+ * sharing codec with a static screen).
+ *
+ * Sent bytes are checked against a budget that grows at a fraction of the
+ * estimate and is capped to a short window. The sender enters the
+ * application-limited region (ALR) when most of the budget is left unused,
+ * and leaves it once the usage gets back up.
+ *
+ * While application-limited, the feedback says nothing about rates above
+ * the sending rate: the estimate is not to grow on it, and probing is the
+ * only way to find out whether more bandwidth is available.
+ *
+ * Like the rest of the controllers, this class is independent from NS3.
+ */
+class AlrDetector {
+public:
+    /** Class constructor */
+    AlrDetector();
+
+    /** Reset to the state of a freshly constructed object */
+    void reset();
+
+    /**
+     * Inform of the current bandwidth estimate, which the budget grows with
+     *
+     * @param [in] bitrateBps Current estimate in bps
+     */
+    void setEstimatedBitrate(uint32_t bitrateBps);
+
+    /**
+     * Account for a packet leaving the sender (after pacing). Probe
+     * packets are not to be accounted for, as they are not media
+     *
+     * @param [in] bytes Size of the packet in bytes
+     * @param [in] nowMs Time the packet is sent, in milliseconds
+     */
+    void onBytesSent(uint32_t bytes, int64_t nowMs);
+
+    /** Whether the sender is currently application-limited */
+    bool inAlr() const;
+
+    /** Time the current ALR started, in milliseconds; -1 if not in ALR */
+    int64_t getAlrStartTimeMs() const;
+
+    /** Write the state of the object to a stream (text format) */
+    void saveState(std::ostream& os) const;
+
+    /** Load the state written by #saveState . Returns false on error */
+    bool restoreState(std::istream& is);
+
+private:
+    uint32_t m_targetBps;       /**< rate the budget grows at */
+    double m_budgetBytes;       /**< unused budget, negative if overused */
+    int64_t m_lastSendMs;       /**< -1 if nothing sent yet */
+    int64_t m_alrStartMs;       /**< -1 if not in ALR */
+};
+
+}
+
+#endif /* ALR_DETECTOR_H */
@@ -0,0 +1,319 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Flow state exchange (coupled congestion control) implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "flow-state-exchange.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace rmcat {
+
+static const uint64_t kIntervalUs = 350 * 1000;   /**< delay averaging interval (T in RFC 8382) */
+static const size_t kMaxIntervals = 20;           /**< intervals kept per flow */
+static const size_t kMinIntervals = 10;           /**< intervals needed to take a decision */
+static const double kMinVariationUs = 1000.;      /**< mean deviation of a congested flow's delay */
+static const double kGroupCorrelation = 0.5;      /**< correlation to group two flows ... */
+static const double kUngroupCorrelation = 0.2;    /**< ... and to split them again */
+
+FlowStateExchange::FlowStateExchange(bool detectSharing) :
+    m_detectSharing{detectSharing},
+    m_flows{},
+    m_groupRateBps{},
+    m_regroup{false} {}
+
+FlowStateExchange::~FlowStateExchange() {}
+
+size_t FlowStateExchange::registerFlow(float priority, float initBps) {
+    assert(priority > 0.f);
+    const size_t id = m_flows.size();
+    size_t group = id;
+    if (!m_detectSharing) {
+        // All flows in the group of the first active one
+        for (const auto& flow : m_flows) {
+            if (flow.active) {
+                group = flow.group;
+                break;
+            }
+        }
+    }
+    Flow flow{};
+    flow.active = true;
+    flow.priority = priority;
+    flow.rateBps = initBps;
+    flow.desiredBps = initBps;
+    flow.group = group;
+    flow.interval = -1;
+    m_flows.push_back(flow);
+    m_groupRateBps.resize(m_flows.size(), 0.f);
+    m_groupRateBps[group] += initBps;
+    allocate(group);
+    return id;
+}
+
+void FlowStateExchange::deregisterFlow(size_t flow) {
+    assert(flow < m_flows.size());
+    Flow& f = m_flows[flow];
+    if (!f.active) {
+        return;
+    }
+    f.active = false;
+    m_groupRateBps[f.group] = std::max(0.f, m_groupRateBps[f.group] - f.rateBps);
+    f.means.clear();
+    f.owdCount = 0;
+    m_regroup = true;
+}
+
+float FlowStateExchange::update(size_t flow, float ccBps, float desiredBps) {
+    assert(flow < m_flows.size());
+    assert(m_flows[flow].active);
+    if (m_regroup) {
+        regroup();
+    }
+    Flow& f = m_flows[flow];
+    f.desiredBps = desiredBps;
+    // The controller went on from the rate the FSE assigned to the flow
+    m_groupRateBps[f.group] = std::max(0.f, m_groupRateBps[f.group] + ccBps - f.rateBps);
+    allocate(f.group);
+    return f.rateBps;
+}
+
+float FlowStateExchange::getRate(size_t flow) const {
+    assert(flow < m_flows.size());
+    return m_flows[flow].rateBps;
+}
+
+void FlowStateExchange::onDelaySample(size_t flow, uint64_t nowUs, uint64_t owdUs) {
+    assert(flow < m_flows.size());
+    Flow& f = m_flows[flow];
+    if (!f.active || !m_detectSharing) {
+        return;
+    }
+    const int64_t interval = int64_t(nowUs / kIntervalUs);
+    if (interval != f.interval) {
+        if (f.owdCount > 0) {
+            f.means.push_back(std::make_pair(f.interval, f.owdSum / f.owdCount));
+            if (f.means.size() > kMaxIntervals) {
+                f.means.pop_front();
+            }
+            m_regroup = true;
+        }
+        f.interval = interval;
+        f.owdSum = 0.;
+        f.owdCount = 0;
+    }
+    // Signed: the clock offset between endpoints may make it "negative"
+    f.owdSum += double(int64_t(owdUs));
+    ++f.owdCount;
+}
+
+size_t FlowStateExchange::getGroup(size_t flow) const {
+    assert(flow < m_flows.size());
+    return m_flows[flow].group;
+}
+
+/* The delay of a flow going through a congested queue varies */
+bool FlowStateExchange::congested(const Flow& flow) const {
+    if (flow.means.size() < kMinIntervals) {
+        return false;
+    }
+    double avg = 0.;
+    for (const auto& m : flow.means) {
+        avg += m.second;
+    }
+    avg /= flow.means.size();
+    double deviation = 0.;
+    for (const auto& m : flow.means) {
+        deviation += std::fabs(m.second - avg);
+    }
+    deviation /= flow.means.size();
+    return deviation >= kMinVariationUs;
+}
+
+/* Correlation of the mean delays of two flows over their common intervals */
+double FlowStateExchange::correlation(const Flow& a, const Flow& b) const {
+    std::vector<std::pair<double, double> > common{};
+    auto ia = a.means.begin();
+    auto ib = b.means.begin();
+    while (ia != a.means.end() && ib != b.means.end()) {
+        if (ia->first < ib->first) {
+            ++ia;
+        } else if (ib->first < ia->first) {
+            ++ib;
+        } else {
+            common.push_back(std::make_pair(ia->second, ib->second));
+            ++ia;
+            ++ib;
+        }
+    }
+    if (common.size() < kMinIntervals) {
+        return 0.;
+    }
+    double avgA = 0., avgB = 0.;
+    for (const auto& c : common) {
+        avgA += c.first;
+        avgB += c.second;
+    }
+    avgA /= common.size();
+    avgB /= common.size();
+    double cov = 0., varA = 0., varB = 0.;
+    for (const auto& c : common) {
+        cov += (c.first - avgA) * (c.second - avgB);
+        varA += (c.first - avgA) * (c.first - avgA);
+        varB += (c.second - avgB) * (c.second - avgB);
+    }
+    if (varA <= 0. || varB <= 0.) {
+        return 0.;
+    }
+    return cov / std::sqrt(varA * varB);
+}
+
+size_t FlowStateExchange::findRoot(std::vector<size_t>& parent, size_t i) const {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void FlowStateExchange::regroup() {
+    m_regroup = false;
+    if (!m_detectSharing) {
+        return;
+    }
+    const size_t n = m_flows.size();
+    std::vector<bool> isCongested(n, false);
+    for (size_t i = 0; i < n; ++i) {
+        isCongested[i] = m_flows[i].active && congested(m_flows[i]);
+    }
+    std::vector<size_t> parent(n);
+    for (size_t i = 0; i < n; ++i) {
+        parent[i] = i;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!m_flows[i].active) {
+            continue;
+        }
+        for (size_t j = i + 1; j < n; ++j) {
+            if (!m_flows[j].active) {
+                continue;
+            }
+            const bool bothCongested = isCongested[i] && isCongested[j];
+            const double corr = bothCongested ? correlation(m_flows[i], m_flows[j]) : 0.;
+            // Grouped flows stay so until clearly behind different bottlenecks
+            const bool link = (m_flows[i].group == m_flows[j].group) ?
+                              !(bothCongested && corr < kUngroupCorrelation) :
+                              (bothCongested && corr >= kGroupCorrelation);
+            if (link) {
+                const size_t ri = findRoot(parent, i);
+                const size_t rj = findRoot(parent, j);
+                // The lowest flow id names the group
+                parent[std::max(ri, rj)] = std::min(ri, rj);
+            }
+        }
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < n; ++i) {
+        if (m_flows[i].active) {
+            const size_t group = findRoot(parent, i);
+            changed = changed || group != m_flows[i].group;
+            m_flows[i].group = group;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+    // The calculated rate of a group is that of its flows
+    m_groupRateBps.assign(n, 0.f);
+    for (const auto& flow : m_flows) {
+        if (flow.active) {
+            m_groupRateBps[flow.group] += flow.rateBps;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (m_flows[i].active && m_flows[i].group == i) {
+            allocate(i);
+        }
+    }
+}
+
+/*
+ * Share the group's rate in proportion to the priorities. Flows reaching
+ * their desired rate get just that; what they leave goes to the others
+ */
+void FlowStateExchange::allocate(size_t group) {
+    std::vector<Flow*> left{};
+    float desiredSum = 0.f;
+    for (auto& flow : m_flows) {
+        if (flow.active && flow.group == group) {
+            left.push_back(&flow);
+            desiredSum += flow.desiredBps;
+        }
+    }
+    // Rate beyond what all the flows desire would build up unused
+    m_groupRateBps[group] = std::min(m_groupRateBps[group], desiredSum);
+    float rateLeft = m_groupRateBps[group];
+    while (!left.empty()) {
+        float prioritySum = 0.f;
+        for (const auto flow : left) {
+            prioritySum += flow->priority;
+        }
+        const float share = rateLeft / prioritySum;
+        bool capped = false;
+        for (auto it = left.begin(); it != left.end();) {
+            if ((*it)->priority * share >= (*it)->desiredBps) {
+                (*it)->rateBps = (*it)->desiredBps;
+                rateLeft -= (*it)->desiredBps;
+                it = left.erase(it);
+                capped = true;
+            } else {
+                ++it;
+            }
+        }
+        if (!capped) {
+            for (auto flow : left) {
+                flow->rateBps = flow->priority * share;
+            }
+            break;
+        }
+    }
+}
+
+void FlowStateExchange::print(std::ostream& os) const {
+    os << "fse:";
+    for (size_t i = 0; i < m_flows.size(); ++i) {
+        const auto& flow = m_flows[i];
+        if (flow.active) {
+            os << " flow: " << i
+               << " group: " << flow.group
+               << " rate: " << flow.rateBps;
+        }
+    }
+}
+
+}
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+
+/**
+ * @file
+ * Flow state exchange (coupled congestion control) interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef FLOW_STATE_EXCHANGE_H
+#define FLOW_STATE_EXCHANGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+#include <ostream>
+
+namespace rmcat {
+
+/**
+ * Flow state exchange (FSE) coupling the congestion controllers of the
+ * flows of one sender endpoint, following the active FSE algorithm for
+ * rate-based controllers of RFC 8699.
+ *
+ * Flows register with the FSE and report every new rate their controller
+ * computes (#update). The FSE keeps, per flow group (FG) of flows sharing
+ * a bottleneck, the sum of the calculated rates, and hands it out to the
+ * flows of the group in proportion to their priorities, capped at the rate
+ * each flow desires (leftovers go to the other flows). Controllers are
+ * then to continue from the rate assigned to their flow, so that the
+ * flows of a group behave as a single one towards the bottleneck instead
+ * of competing with each other.
+ *
+ * Flow groups come from a simplified shared bottleneck detection (SBD,
+ * inspired by RFC 8382): flows report their one-way delay samples, which
+ * are averaged over fixed intervals; flows whose averages vary (i.e., the
+ * flow goes through a congested queue) and are correlated with each other
+ * are grouped together. Flows not (yet) found to share a bottleneck are
+ * in a group of their own, where the FSE passes their controller's rate
+ * through. Alternatively, detection can be turned off, in which case all
+ * flows form a single group.
+ *
+ * Like the controllers, this class is independent from NS3.
+ */
+class FlowStateExchange {
+public:
+    /**
+     * Class constructor
+     *
+     * @param [in] detectSharing Whether to group flows with shared
+     *                           bottleneck detection, rather than all
+     *                           flows together
+     */
+    FlowStateExchange(bool detectSharing=true);
+
+    /** Class destructor */
+    ~FlowStateExchange();
+
+    /**
+     * Register a new flow
+     *
+     * @param [in] priority Weight of the flow in the share of its group's rate
+     * @param [in] initBps Initial rate of the flow's controller, in bps
+     * @retval the id of the flow, to be passed to the other calls
+     */
+    size_t registerFlow(float priority, float initBps);
+
+    /**
+     * Remove a flow (stopped or paused): its rate is no longer part of
+     * its group's
+     *
+     * @param [in] flow Id of the flow
+     */
+    void deregisterFlow(size_t flow);
+
+    /**
+     * Account for a new rate computed by the controller of a flow, and
+     * update the rates of all the flows of its group
+     *
+     * @param [in] flow Id of the flow
+     * @param [in] ccBps Rate computed by the flow's controller, in bps
+     * @param [in] desiredBps Rate the flow's application can use, in bps
+     * @retval the rate assigned to the flow, in bps
+     */
+    float update(size_t flow, float ccBps, float desiredBps);
+
+    /**
+     * Get the rate currently assigned to a flow. The rate of a flow changes
+     * when the other flows of its group update theirs
+     *
+     * @param [in] flow Id of the flow
+     * @retval the rate assigned to the flow, in bps
+     */
+    float getRate(size_t flow) const;
+
+    /**
+     * Feed the shared bottleneck detection with a one-way delay sample.
+     * Only differences between samples matter: the clocks of the endpoints
+     * need not be synchronized
+     *
+     * @param [in] flow Id of the flow
+     * @param [in] nowUs Current time in microseconds
+     * @param [in] owdUs One-way delay of a packet of the flow, in microseconds
+     */
+    void onDelaySample(size_t flow, uint64_t nowUs, uint64_t owdUs);
+
+    /**
+     * Get the group a flow currently belongs to. Flows in the same group
+     * share the same group id
+     *
+     * @param [in] flow Id of the flow
+     * @retval the group's id
+     */
+    size_t getGroup(size_t flow) const;
+
+    /**
+     * Write a one-line summary of the registered flows, with their group
+     * and assigned rate, with no line break
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void print(std::ostream& os) const;
+
+private:
+    struct Flow {
+        bool active;
+        float priority;
+        float rateBps;      /**< rate assigned to the flow (FSE_R) */
+        float desiredBps;   /**< rate the application can use (DR) */
+        size_t group;
+        /* Shared bottleneck detection */
+        int64_t interval;   /**< index of the current interval */
+        double owdSum;
+        uint32_t owdCount;
+        std::deque<std::pair<int64_t, double> > means;  /**< mean OWD by interval */
+    };
+
+    bool congested(const Flow& flow) const;
+    double correlation(const Flow& a, const Flow& b) const;
+    void regroup();
+    void allocate(size_t group);
+    size_t findRoot(std::vector<size_t>& parent, size_t i) const;
+
+    bool m_detectSharing;
+    std::vector<Flow> m_flows;
+    std::vector<float> m_groupRateBps;  /**< sum of the calculated rates (S_CR), by group */
+    bool m_regroup;                     /**< new delay intervals since the last grouping */
+};
+
+}
+
+#endif /* FLOW_STATE_EXCHANGE_H */
@@ -0,0 +1,442 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Batch (structure-of-arrays) GCC engine implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "gcc-batch-engine.h"
+#include "gcc-kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+namespace rmcat {
+
+/* Sizes of the state, as in GccController. The tunables are in GccConfig */
+enum { kMinFramePeriodHistoryLength = 60 };
+enum { kDeltaCounterMax = 1000 };
+static const int64_t kDefaultRttMs = 200;
+
+GccBatchEngine::GccBatchEngine()
+: GccBatchEngine{GccConfig{}} {}
+
+GccBatchEngine::GccBatchEngine(const GccConfig& config)
+: m_config{config}
+, m_pending{}
+, m_tickMs{-1} {}
+
+GccBatchEngine::~GccBatchEngine() {}
+
+size_t GccBatchEngine::addFlow(uint32_t initBps, uint32_t minBps, uint32_t maxBps) {
+    const size_t flow = m_bitrate.size();
+
+    m_numDeltas.push_back(0);
+    m_slope.push_back(0.);
+    m_offset.push_back(0.);
+    m_prevOffset.push_back(0.);
+    m_E00.push_back(0.);
+    m_E01.push_back(0.);
+    m_E10.push_back(0.);
+    m_E11.push_back(0.);
+    m_avgNoise.push_back(0.);
+    m_varNoise.push_back(0.);
+    m_tsDeltaHist.resize(m_tsDeltaHist.size() + kMinFramePeriodHistoryLength, 0.);
+    m_tsDeltaHistLen.push_back(0);
+    m_tsDeltaHistPos.push_back(0);
+
+    m_threshold.push_back(0.);
+    m_utLastUpdateMs.push_back(-1);
+    m_detPrevOffset.push_back(0.);
+    m_timeOverUsing.push_back(-1);
+    m_overuseCounter.push_back(0);
+    m_hypothesis.push_back('N');
+
+    m_minBps.push_back(minBps);
+    m_maxBps.push_back(std::max(minBps, maxBps));
+    m_bitrate.push_back(initBps);
+    m_incomingBps.push_back(0);
+    m_rttMs.push_back(kDefaultRttMs);
+    m_rateInitialized.push_back(0);
+    m_timeFirstIncomingMs.push_back(-1);
+    m_avgMaxKbps.push_back(-1.f);
+    m_varMaxKbps.push_back(0.4f);
+    m_rateState.push_back('H');
+    m_rateRegion.push_back('M');
+    m_timeLastChangeMs.push_back(-1);
+    m_lastUpdateMs.push_back(-1);
+    m_dirty.push_back(0);
+
+    resetFlow(flow);
+    m_bitrate[flow] = std::min(std::max(initBps, m_minBps[flow]), m_maxBps[flow]);
+    return flow;
+}
+
+void GccBatchEngine::resetFlow(size_t flow) {
+    assert(flow < numFlows());
+    m_numDeltas[flow] = 0;
+    m_slope[flow] = m_config.initialSlope;
+    m_offset[flow] = 0.;
+    m_prevOffset[flow] = 0.;
+    m_E00[flow] = 100.;
+    m_E01[flow] = 0.;
+    m_E10[flow] = 0.;
+    m_E11[flow] = 1e-1;
+    m_avgNoise[flow] = 0.;
+    m_varNoise[flow] = m_config.initialVarNoise;
+    m_tsDeltaHistLen[flow] = 0;
+    m_tsDeltaHistPos[flow] = 0;
+
+    m_threshold[flow] = m_config.initialThresholdMs;
+    m_utLastUpdateMs[flow] = -1;
+    m_detPrevOffset[flow] = 0.;
+    m_timeOverUsing[flow] = -1;
+    m_overuseCounter[flow] = 0;
+    m_hypothesis[flow] = 'N';
+
+    m_incomingBps[flow] = 0;
+    m_rateInitialized[flow] = 0;
+    m_timeFirstIncomingMs[flow] = -1;
+    m_avgMaxKbps[flow] = -1.f;
+    m_varMaxKbps[flow] = 0.4f;
+    m_rateState[flow] = 'H';
+    m_rateRegion[flow] = 'M';
+    m_timeLastChangeMs[flow] = -1;
+    m_lastUpdateMs[flow] = -1;
+    m_dirty[flow] = 0;
+}
+
+size_t GccBatchEngine::numFlows() const {
+    return m_bitrate.size();
+}
+
+const GccConfig& GccBatchEngine::getConfig() const {
+    return m_config;
+}
+
+void GccBatchEngine::setBitrate(size_t flow, uint32_t bps) {
+    assert(flow < numFlows());
+    // Pending samples were received at the old rate
+    flush();
+    m_bitrate[flow] = std::min(std::max(bps, m_minBps[flow]), m_maxBps[flow]);
+}
+
+void GccBatchEngine::setRtt(size_t flow, int64_t rttMs) {
+    assert(flow < numFlows());
+    m_rttMs[flow] = rttMs;
+}
+
+void GccBatchEngine::submit(const Sample& sample, int64_t nowMs) {
+    if (sample.flow >= numFlows()) {
+        std::cerr << "GccBatchEngine::submit,"
+                  << " unknown flow: " << sample.flow << std::endl;
+        return;
+    }
+    if (!m_pending.empty() && nowMs != m_tickMs) {
+        flush();
+    }
+    m_tickMs = nowMs;
+    m_pending.push_back(sample);
+}
+
+size_t GccBatchEngine::pending() const {
+    return m_pending.size();
+}
+
+void GccBatchEngine::flush() {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    // A flow may have several samples in the same tick; they are applied
+    // in order. The rate control then runs once per flow that got samples
+    for (const Sample& s : m_pending) {
+        processSample(s);
+        m_dirty[s.flow] = 1;
+    }
+    m_pending.clear();
+
+    for (size_t flow = 0; flow < numFlows(); ++flow) {
+        if (m_dirty[flow]) {
+            updateRate(flow, m_tickMs);
+            m_dirty[flow] = 0;
+        }
+    }
+}
+
+/* Overuse estimator and detector, as GccController::processFeedback */
+void GccBatchEngine::processSample(const Sample& s) {
+    const size_t f = s.flow;
+    if (s.incomingBps > 0) {
+        m_incomingBps[f] = s.incomingBps;
+    }
+
+    // The minimum frame period is the minimum over a short ring buffer
+    double* hist = &m_tsDeltaHist[f * kMinFramePeriodHistoryLength];
+    double minFramePeriod = s.tsDeltaMs;
+    if (m_tsDeltaHistLen[f] >= kMinFramePeriodHistoryLength) {
+        // Oldest entry is dropped before taking the minimum
+        --m_tsDeltaHistLen[f];
+    }
+    const size_t len = m_tsDeltaHistLen[f];
+    const size_t pos = m_tsDeltaHistPos[f];
+    for (size_t k = 0; k < len; ++k) {
+        const size_t idx = (pos + kMinFramePeriodHistoryLength - 1 - k) %
+                           kMinFramePeriodHistoryLength;
+        minFramePeriod = std::min(minFramePeriod, hist[idx]);
+    }
+    hist[pos] = s.tsDeltaMs;
+    m_tsDeltaHistPos[f] = (pos + 1) % kMinFramePeriodHistoryLength;
+    ++m_tsDeltaHistLen[f];
+
+    m_numDeltas[f] = std::min<uint16_t>(m_numDeltas[f] + 1, kDeltaCounterMax);
+
+    double E[2][2] = {{m_E00[f], m_E01[f]}, {m_E10[f], m_E11[f]}};
+    gccEstimatorUpdate(m_config, s.tDeltaMs - s.tsDeltaMs, s.sizeDelta, minFramePeriod,
+                       m_numDeltas[f], m_hypothesis[f], m_slope[f], m_offset[f],
+                       m_prevOffset[f], E, m_avgNoise[f], m_varNoise[f]);
+    m_E00[f] = E[0][0];
+    m_E01[f] = E[0][1];
+    m_E10[f] = E[1][0];
+    m_E11[f] = E[1][1];
+
+    if (m_numDeltas[f] < 2) {
+        return;
+    }
+    const double T = gccModifiedOffset(m_config, m_numDeltas[f], m_offset[f]);
+    m_hypothesis[f] = gccDetect(m_config, T, m_offset[f], s.tsDeltaMs, m_threshold[f],
+                                m_hypothesis[f], m_timeOverUsing[f], m_overuseCounter[f],
+                                m_detPrevOffset[f]);
+    gccUpdateThreshold(m_config, T, s.arrivalMs, m_threshold[f], m_utLastUpdateMs[f]);
+}
+
+void GccBatchEngine::updateRate(size_t flow, int64_t nowMs) {
+    const uint32_t incomingBps = m_incomingBps[flow];
+    bool update = m_lastUpdateMs[flow] == -1 ||
+                  nowMs - m_lastUpdateMs[flow] > m_config.updateIntervalMs;
+    if (!update && m_hypothesis[flow] == 'O' && incomingBps > 0) {
+        // Time to reduce further?
+        update = nowMs - m_timeLastChangeMs[flow] >= gccReductionIntervalMs(m_rttMs[flow]) ||
+                 (m_rateInitialized[flow] &&
+                  incomingBps < uint32_t(0.5 * m_bitrate[flow]));
+    }
+    if (update) {
+        bool initialized = m_rateInitialized[flow];
+        gccInitializeBitrate(m_config, incomingBps, nowMs, initialized,
+                             m_timeFirstIncomingMs[flow], m_bitrate[flow]);
+        m_rateInitialized[flow] = initialized;
+        m_bitrate[flow] = changeBitrate(flow, incomingBps, nowMs);
+        m_lastUpdateMs[flow] = nowMs;
+    }
+}
+
+uint32_t GccBatchEngine::changeBitrate(size_t flow, uint32_t incomingBps, int64_t nowMs) {
+    const uint32_t current = m_bitrate[flow];
+    uint32_t newBitrate = current;
+
+    // An overuse before the first estimate only reduces the rate once the
+    // estimate is valid
+    if (!m_rateInitialized[flow] && m_hypothesis[flow] == 'O') {
+        return current;
+    }
+
+    gccChangeState(m_hypothesis[flow], nowMs, m_rateState[flow], m_timeLastChangeMs[flow]);
+
+    const float incomingKbps = incomingBps / 1000.0f;
+    const float stdMaxKbps = std::sqrt(m_varMaxKbps[flow] * m_avgMaxKbps[flow]);
+    switch (m_rateState[flow]) {
+        case 'H':
+            break;
+
+        case 'I': {
+            if (m_avgMaxKbps[flow] >= 0 &&
+                incomingKbps > m_avgMaxKbps[flow] + 3 * stdMaxKbps) {
+                m_rateRegion[flow] = 'M';
+                m_avgMaxKbps[flow] = -1.0f;
+            }
+            const int64_t lastMs = m_timeLastChangeMs[flow];
+            if (m_rateRegion[flow] == 'N') {
+                // Approximate the over-use estimator delay to 100 ms
+                const int increaseRateBps =
+                        gccNearMaxIncreaseRateBps(m_config, current, m_rttMs[flow] + 100);
+                newBitrate += uint32_t((nowMs - lastMs) * increaseRateBps / 1000);
+            } else {
+                newBitrate += gccMultiplicativeIncreaseBps(m_config, nowMs, lastMs, current);
+            }
+            m_timeLastChangeMs[flow] = nowMs;
+            break;
+        }
+
+        case 'D':
+            newBitrate = uint32_t(m_config.beta * incomingBps + 0.5);
+            if (newBitrate > current) {
+                if (m_rateRegion[flow] != 'M') {
+                    newBitrate = uint32_t(m_config.beta * m_avgMaxKbps[flow] * 1000 + 0.5f);
+                }
+                newBitrate = std::min(newBitrate, current);
+            }
+            m_rateRegion[flow] = 'N';
+            if (incomingKbps < m_avgMaxKbps[flow] - 3 * stdMaxKbps) {
+                m_avgMaxKbps[flow] = -1.0f;
+            }
+            m_rateInitialized[flow] = 1;
+            gccUpdateMaxBitrateEstimate(m_config, incomingKbps,
+                                        m_avgMaxKbps[flow], m_varMaxKbps[flow]);
+            m_rateState[flow] = 'H';
+            m_timeLastChangeMs[flow] = nowMs;
+            break;
+
+        default:
+            assert(false);
+    }
+
+    newBitrate = gccClampToIncoming(newBitrate, current, incomingBps);
+    return std::min(std::max(newBitrate, m_minBps[flow]), m_maxBps[flow]);
+}
+
+uint32_t GccBatchEngine::getBitrate(size_t flow) const {
+    return m_bitrate.at(flow);
+}
+
+char GccBatchEngine::getHypothesis(size_t flow) const {
+    return m_hypothesis.at(flow);
+}
+
+double GccBatchEngine::getOffset(size_t flow) const {
+    return m_offset.at(flow);
+}
+
+double GccBatchEngine::getModifiedOffset(size_t flow) const {
+    return gccModifiedOffset(m_config, m_numDeltas.at(flow), m_offset.at(flow));
+}
+
+double GccBatchEngine::getThreshold(size_t flow) const {
+    return m_threshold.at(flow);
+}
+
+double GccBatchEngine::getNoiseVar(size_t flow) const {
+    return m_varNoise.at(flow);
+}
+
+GccBatchController::GccBatchController(std::shared_ptr<GccBatchEngine> engine) :
+    SenderBasedController{},
+    m_engine{engine},
+    m_flow{0},
+    m_flowValid{false},
+    m_RecvR{0.f} {
+    assert(m_engine);
+}
+
+GccBatchController::~GccBatchController() {}
+
+void GccBatchController::setCurrentBw(float newBw) {
+    if (!m_flowValid) {
+        m_initBw = newBw;
+        return;
+    }
+    // E.g., the rate assigned by a flow state exchange: the rate control
+    // goes on from it
+    m_engine->setBitrate(m_flow, uint32_t(newBw));
+}
+
+void GccBatchController::reset() {
+    if (m_flowValid) {
+        m_engine->resetFlow(m_flow);
+    }
+    m_RecvR = 0.f;
+    SenderBasedController::reset();
+}
+
+bool GccBatchController::processFeedback(uint64_t nowUs,
+                                         uint16_t sequence,
+                                         uint64_t rxTimestampUs,
+                                         uint64_t l_inter_arrival,
+                                         uint64_t l_inter_departure,
+                                         int64_t l_inter_delay_var,
+                                         int l_inter_group_size,
+                                         int64_t l_arrival_time,
+                                         uint8_t ecn) {
+    // First of all, call the superclass
+    const bool res = SenderBasedController::processFeedback(nowUs, sequence,
+                                                            rxTimestampUs,
+                                                            l_inter_arrival,
+                                                            l_inter_departure,
+                                                            l_inter_delay_var,
+                                                            l_inter_group_size,
+                                                            l_arrival_time,
+                                                            ecn);
+    if (!res) return false;
+
+    // The flow is allocated lazily, once min/max/init rates are configured
+    if (!m_flowValid) {
+        m_flow = m_engine->addFlow(uint32_t(m_initBw), uint32_t(m_minBw),
+                                   uint32_t(m_maxBw));
+        m_flowValid = true;
+    }
+
+    float rrate;
+    if (getCurrentRecvRate(rrate)) m_RecvR = rrate;
+
+    GccBatchEngine::Sample sample;
+    sample.flow = m_flow;
+    sample.tDeltaMs = int64_t(l_inter_arrival / 1000);
+    sample.tsDeltaMs = double(uint32_t(l_inter_departure / 1000));
+    sample.sizeDelta = l_inter_group_size;
+    sample.arrivalMs = l_arrival_time / 1000;
+    sample.incomingBps = uint32_t(m_RecvR);
+    m_engine->submit(sample, int64_t(nowUs / 1000));
+    return true;
+}
+
+void GccBatchController::processReceiverReport(uint64_t nowUs,
+                                               uint64_t rttUs,
+                                               uint8_t fractionLost,
+                                               uint32_t packetsExpected) {
+    // The RTT drives the rate control's response times, as in GccController
+    if (m_flowValid && rttUs > 0) {
+        m_engine->setRtt(m_flow, std::max<int64_t>(rttUs / 1000, 1));
+    }
+}
+
+float GccBatchController::getBandwidth(uint64_t nowUs) const {
+    return float(getSendBps());
+}
+
+uint32_t GccBatchController::getSendBps() const {
+    if (!m_flowValid) {
+        return uint32_t(m_initBw);
+    }
+    return m_engine->getBitrate(m_flow);
+}
+
+void GccBatchController::flush() {
+    m_engine->flush();
+}
+
+bool GccBatchController::getFlow(size_t& flow) const {
+    flow = m_flow;
+    return m_flowValid;
+}
+
+}
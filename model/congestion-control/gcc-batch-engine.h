@@ -0,0 +1,269 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Batch (structure-of-arrays) GCC engine interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef GCC_BATCH_ENGINE_H
+#define GCC_BATCH_ENGINE_H
+
+#include "sender-based-controller.h"
+#include "gcc-config.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rmcat {
+
+/**
+ * Delay-based part of GCC (overuse estimator, overuse detector and AIMD
+ * rate control) for many flows at once.
+ *
+ * The per-flow state that #GccController keeps in scattered member
+ * variables is stored here in structure-of-arrays form: one contiguous
+ * array per state variable, indexed by flow. Feedback samples are queued
+ * with #submit ; all samples queued during the same tick are processed by
+ * #flush , then the rate control runs once for every flow that got
+ * samples.
+ *
+ * The estimator, detector and rate control steps are those of
+ * #GccController (see gcc-kernels.h), with the same #GccConfig
+ * parameters; only the memory layout differs. The loss-based controller,
+ * probing and the ALR are not part of the engine.
+ * Like the rest of the controllers, this class is independent from NS3.
+ */
+class GccBatchEngine {
+public:
+    /** Per-group delay sample of one flow, as computed by the sender */
+    struct Sample {
+        size_t flow;          /**< flow index returned by #addFlow */
+        int64_t tDeltaMs;     /**< inter-arrival time of the packet groups */
+        double tsDeltaMs;     /**< inter-departure time of the packet groups */
+        int sizeDelta;        /**< size difference of the packet groups, in bytes */
+        int64_t arrivalMs;    /**< arrival time of the current group */
+        uint32_t incomingBps; /**< current receive rate, 0 if unknown */
+    };
+
+    /** Class constructor, with the default #GccConfig */
+    GccBatchEngine();
+
+    /**
+     * Class constructor
+     *
+     * @param [in] config Parameters of all the flows of the engine
+     */
+    explicit GccBatchEngine(const GccConfig& config);
+
+    /** Class destructor */
+    ~GccBatchEngine();
+
+    /**
+     * Add a new flow to the engine
+     *
+     * @param [in] initBps Initial (start) bitrate in bps
+     * @param [in] minBps Minimal bitrate in bps
+     * @param [in] maxBps Maximal bitrate in bps
+     * @retval the index of the new flow, to be used in samples and getters
+     */
+    size_t addFlow(uint32_t initBps, uint32_t minBps, uint32_t maxBps);
+
+    /**
+     * Reset the state of one flow to that of a freshly added flow
+     *
+     * @param [in] flow Index of the flow to reset
+     */
+    void resetFlow(size_t flow);
+
+    /** Number of flows added so far */
+    size_t numFlows() const;
+
+    /** Parameters of all the flows of the engine */
+    const GccConfig& getConfig() const;
+
+    /**
+     * Override the rate of one flow; the rate control goes on from it.
+     * The queued samples are flushed first
+     *
+     * @param [in] flow Index of the flow
+     * @param [in] bps New rate in bps, clamped to the flow's min/max
+     */
+    void setBitrate(size_t flow, uint32_t bps);
+
+    /**
+     * Set the RTT of one flow, which drives its rate control's response times
+     *
+     * @param [in] flow Index of the flow
+     * @param [in] rttMs Round-trip time in milliseconds
+     */
+    void setRtt(size_t flow, int64_t rttMs);
+
+    /**
+     * Queue a sample for processing. If the sample belongs to a later tick
+     * than the samples already queued, these are flushed first
+     *
+     * @param [in] sample Delay sample of one flow
+     * @param [in] nowMs Current time in milliseconds (tick)
+     */
+    void submit(const Sample& sample, int64_t nowMs);
+
+    /** Number of samples waiting to be processed */
+    size_t pending() const;
+
+    /**
+     * Process all the queued samples: estimator and detector kernels for
+     * every sample, then AIMD rate control for every flow that got feedback
+     */
+    void flush();
+
+    uint32_t getBitrate(size_t flow) const;
+    char getHypothesis(size_t flow) const;
+    double getOffset(size_t flow) const;
+    /** Offset scaled by the number of deltas, as compared to the threshold */
+    double getModifiedOffset(size_t flow) const;
+    double getThreshold(size_t flow) const;
+    double getNoiseVar(size_t flow) const;
+
+private:
+    void processSample(const Sample& sample);
+    void updateRate(size_t flow, int64_t nowMs);
+    uint32_t changeBitrate(size_t flow, uint32_t incomingBps, int64_t nowMs);
+
+    GccConfig m_config;
+
+    /* Samples of the current tick */
+    std::vector<Sample> m_pending;
+    int64_t m_tickMs;
+
+    /* Overuse estimator, one entry per flow */
+    std::vector<uint16_t> m_numDeltas;
+    std::vector<double> m_slope;
+    std::vector<double> m_offset;
+    std::vector<double> m_prevOffset;
+    std::vector<double> m_E00;
+    std::vector<double> m_E01;
+    std::vector<double> m_E10;
+    std::vector<double> m_E11;
+    std::vector<double> m_avgNoise;
+    std::vector<double> m_varNoise;
+    std::vector<double> m_tsDeltaHist;   /**< kMinFramePeriodHistoryLength entries per flow */
+    std::vector<uint8_t> m_tsDeltaHistLen;
+    std::vector<uint8_t> m_tsDeltaHistPos;
+
+    /* Overuse detector, one entry per flow */
+    std::vector<double> m_threshold;
+    std::vector<int64_t> m_utLastUpdateMs;
+    std::vector<double> m_detPrevOffset;
+    std::vector<double> m_timeOverUsing;
+    std::vector<int> m_overuseCounter;
+    std::vector<char> m_hypothesis;  /**< O : Overusing, N : Normal, U : Underusing */
+
+    /* AIMD rate control, one entry per flow */
+    std::vector<uint32_t> m_minBps;
+    std::vector<uint32_t> m_maxBps;
+    std::vector<uint32_t> m_bitrate;
+    std::vector<uint32_t> m_incomingBps;
+    std::vector<int64_t> m_rttMs;
+    std::vector<uint8_t> m_rateInitialized;   /**< the estimate is valid */
+    std::vector<int64_t> m_timeFirstIncomingMs;
+    std::vector<float> m_avgMaxKbps;
+    std::vector<float> m_varMaxKbps;
+    std::vector<char> m_rateState;   /**< H : Hold, I : Increase, D : Decrease */
+    std::vector<char> m_rateRegion;  /**< M : MaxUnknown, N : NearMax */
+    std::vector<int64_t> m_timeLastChangeMs;
+    std::vector<int64_t> m_lastUpdateMs;
+    std::vector<uint8_t> m_dirty;    /**< flow got samples in the current tick */
+};
+
+/**
+ * Adapter exposing one flow of a (shared) #GccBatchEngine through the
+ * #SenderBasedController interface, so that it can be plugged into the
+ * sender applications like any other controller.
+ *
+ * Feedback is only queued in the engine; it is processed when the engine
+ * moves on to a later tick, or when #flush is called (e.g., by the sender
+ * before it reads the rate). Hence, the feedback of all the flows received
+ * in the same tick before the flush is processed in one batch. #getSendBps
+ * only reads the rate computed by the last flush. Rate overrides
+ * (#setCurrentBw) and the RTT of receiver reports go to the engine as well.
+ */
+class GccBatchController: public SenderBasedController
+{
+public:
+    /**
+     * Class constructor
+     *
+     * @param [in] engine The engine shared by all the batched flows
+     */
+    GccBatchController(std::shared_ptr<GccBatchEngine> engine);
+
+    /** Class destructor */
+    virtual ~GccBatchController();
+
+    virtual void setCurrentBw(float newBw);
+
+    virtual void reset();
+
+    virtual bool processFeedback(uint64_t nowUs,
+                                 uint16_t sequence,
+                                 uint64_t rxTimestampUs,
+                                 uint64_t l_inter_arrival,
+                                 uint64_t l_inter_departure,
+                                 int64_t l_inter_delay_var,
+                                 int l_inter_group_size,
+                                 int64_t l_arrival_time,
+                                 uint8_t ecn=0);
+
+    virtual void processReceiverReport(uint64_t nowUs,
+                                       uint64_t rttUs,
+                                       uint8_t fractionLost,
+                                       uint32_t packetsExpected);
+
+    virtual float getBandwidth(uint64_t nowUs) const;
+
+    virtual uint32_t getSendBps() const;
+
+    /**
+     * Process the feedback queued in the engine so far, by this flow or any
+     * other sharing the engine
+     */
+    void flush();
+
+    /**
+     * Index of this controller's flow in the engine
+     *
+     * @param [out] flow The index, valid once the first feedback arrived
+     * @retval true if the flow has been allocated
+     */
+    bool getFlow(size_t& flow) const;
+
+private:
+    std::shared_ptr<GccBatchEngine> m_engine;
+    size_t m_flow;
+    bool m_flowValid;
+    float m_RecvR;     /**< updated receiving rate in bps */
+};
+
+}
+
+#endif /* GCC_BATCH_ENGINE_H */
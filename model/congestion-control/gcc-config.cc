@@ -0,0 +1,236 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Configuration of the GCC congestion controller for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "gcc-config.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <limits>
+
+namespace rmcat {
+
+/* Name and valid range of a parameter */
+struct GccParam {
+    const char* name;
+    double GccConfig::* field;
+    double min;
+    double max;
+};
+
+static const double kInf = std::numeric_limits<double>::infinity();
+
+static const GccParam kGccParams[] = {
+    {"process_noise_slope",         &GccConfig::processNoiseSlope,        0., kInf},
+    {"process_noise_offset",        &GccConfig::processNoiseOffset,       0., kInf},
+    {"initial_slope",               &GccConfig::initialSlope,             0., kInf},
+    {"initial_var_noise",           &GccConfig::initialVarNoise,          1., kInf},
+    {"noise_alpha_startup",         &GccConfig::noiseAlphaStartup,        0., 1.},
+    {"noise_alpha",                 &GccConfig::noiseAlpha,               0., 1.},
+    {"noise_startup_deltas",        &GccConfig::noiseStartupDeltas,       0., 1000.},
+    {"initial_threshold_ms",        &GccConfig::initialThresholdMs,       0., kInf},
+    {"min_threshold_ms",            &GccConfig::minThresholdMs,           0., kInf},
+    {"max_threshold_ms",            &GccConfig::maxThresholdMs,           0., kInf},
+    {"k_up",                        &GccConfig::kUp,                      0., 1.},
+    {"k_down",                      &GccConfig::kDown,                    0., 1.},
+    {"max_adapt_offset_ms",         &GccConfig::maxAdaptOffsetMs,         0., kInf},
+    {"overusing_time_threshold_ms", &GccConfig::overusingTimeThresholdMs, 0., kInf},
+    {"min_num_deltas",              &GccConfig::minNumDeltas,             1., 1000.},
+    {"beta",                        &GccConfig::beta,                     0., 1.},
+    {"increase_factor",             &GccConfig::increaseFactor,           1., 2.},
+    {"min_increase_rate_bps",       &GccConfig::minIncreaseRateBps,       0., kInf},
+    {"max_bitrate_alpha",           &GccConfig::maxBitrateAlpha,          0., 1.},
+    {"initialization_time_ms",      &GccConfig::initializationTimeMs,     0., kInf},
+    {"update_interval_ms",          &GccConfig::updateIntervalMs,         0., kInf},
+    {"low_loss_threshold",          &GccConfig::lowLossThreshold,         0., 1.},
+    {"high_loss_threshold",         &GccConfig::highLossThreshold,        0., 1.},
+    {"bitrate_threshold_kbps",      &GccConfig::bitrateThresholdKbps,     0., kInf},
+    {"loss_increase_factor",        &GccConfig::lossIncreaseFactor,       1., 2.},
+    {"increase_interval_ms",        &GccConfig::increaseIntervalMs,       1., kInf},
+    {"decrease_interval_ms",        &GccConfig::decreaseIntervalMs,       0., kInf},
+    {"start_phase_ms",              &GccConfig::startPhaseMs,             0., kInf},
+    {"feedback_timeout_intervals",  &GccConfig::feedbackTimeoutIntervals, 0., kInf},
+    {"feedback_interval_ms",        &GccConfig::feedbackIntervalMs,       1., kInf},
+    {"timeout_interval_ms",         &GccConfig::timeoutIntervalMs,        0., kInf},
+    {"timeout_backoff_factor",      &GccConfig::timeoutBackoffFactor,     0., 1.},
+};
+
+static const GccParam* findParam(const std::string& name) {
+    for (const auto& param : kGccParams) {
+        if (name == param.name) {
+            return &param;
+        }
+    }
+    return NULL;
+}
+
+GccConfig::GccConfig() :
+    processNoiseSlope{1e-13},
+    processNoiseOffset{1e-3},
+    initialSlope{8.0 / 512.0},
+    initialVarNoise{50.},
+    noiseAlphaStartup{0.01},
+    noiseAlpha{0.002},
+    noiseStartupDeltas{10 * 30},
+    initialThresholdMs{12.5},
+    minThresholdMs{6.},
+    maxThresholdMs{600.},
+    kUp{0.0087},
+    kDown{0.039},
+    maxAdaptOffsetMs{15.},
+    overusingTimeThresholdMs{100.},
+    minNumDeltas{60},
+    beta{0.85},
+    increaseFactor{1.08},
+    minIncreaseRateBps{4000.},
+    maxBitrateAlpha{0.05},
+    initializationTimeMs{5000.},
+    updateIntervalMs{1000.},
+    lowLossThreshold{0.02},
+    highLossThreshold{0.1},
+    bitrateThresholdKbps{0.},
+    lossIncreaseFactor{1.08},
+    increaseIntervalMs{1000.},
+    decreaseIntervalMs{300.},
+    startPhaseMs{2000.},
+    // Timeout off by default. When on, feedback_interval_ms has to cover the
+    // actual feedback period: 100 ms per-packet feedback (RMCAT_FEEDBACK_PERIOD_US),
+    // up to 1 s with REMB
+    feedbackTimeoutIntervals{0},
+    feedbackIntervalMs{100.},
+    timeoutIntervalMs{1000.},
+    timeoutBackoffFactor{0.8} {}
+
+bool GccConfig::set(const std::string& name, double value) {
+    const GccParam* param = findParam(name);
+    if (param == NULL) {
+        std::cerr << "GccConfig: unknown parameter " << name << std::endl;
+        return false;
+    }
+    if (!(value >= param->min && value <= param->max)) {
+        std::cerr << "GccConfig: value " << value << " of " << name
+                  << " out of range [" << param->min << ", " << param->max << "]" << std::endl;
+        return false;
+    }
+    this->*(param->field) = value;
+    return true;
+}
+
+bool GccConfig::get(const std::string& name, double& value) const {
+    const GccParam* param = findParam(name);
+    if (param == NULL) {
+        return false;
+    }
+    value = this->*(param->field);
+    return true;
+}
+
+bool GccConfig::parse(const std::string& list) {
+    std::istringstream items(list);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        const auto eq = item.find('=');
+        std::istringstream value(eq == std::string::npos ? "" : item.substr(eq + 1));
+        double v = 0.;
+        if (!(value >> v)) {
+            std::cerr << "GccConfig: malformed parameter " << item << std::endl;
+            return false;
+        }
+        if (!set(item.substr(0, eq), v)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GccConfig::load(std::istream& is) {
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(is, line)) {
+        ++lineNo;
+        line = line.substr(0, line.find('#'));
+        for (auto& c : line) {
+            if (c == '=') {
+                c = ' ';
+            }
+        }
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name)) {
+            continue; // blank or comment
+        }
+        double value = 0.;
+        std::string extra;
+        if (!(fields >> value) || (fields >> extra)) {
+            std::cerr << "GccConfig: malformed line " << lineNo << ": " << line << std::endl;
+            return false;
+        }
+        if (!set(name, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GccConfig::loadFile(const std::string& filename) {
+    std::ifstream file(filename.c_str());
+    if (!file) {
+        std::cerr << "GccConfig: cannot open " << filename << std::endl;
+        return false;
+    }
+    return load(file);
+}
+
+void GccConfig::save(std::ostream& os) const {
+    const auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+    for (const auto& param : kGccParams) {
+        os << param.name << " " << this->*(param.field) << "\n";
+    }
+    os.precision(precision);
+}
+
+void GccConfig::saveState(std::ostream& os) const {
+    const auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+    bool first = true;
+    for (const auto& param : kGccParams) {
+        os << (first ? "" : " ") << this->*(param.field);
+        first = false;
+    }
+    os << "\n";
+    os.precision(precision);
+}
+
+bool GccConfig::restoreState(std::istream& is) {
+    for (const auto& param : kGccParams) {
+        is >> this->*(param.field);
+    }
+    return bool(is);
+}
+
+}
@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Configuration of the GCC congestion controller for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef GCC_CONFIG_H
+#define GCC_CONFIG_H
+
+#include <iosfwd>
+#include <string>
+
+namespace rmcat {
+
+/**
+ * Tunable parameters of #GccController: the delay-based estimator (Kalman
+ * filter) and overuse detector, the AIMD rate control, the loss-based
+ * controller and the reaction to missing feedback. Defaults are the
+ * values of the reference implementation.
+ *
+ * Parameters can also be accessed by name, which is how they are written
+ * in configuration files: one "name value" (or "name = value") per line,
+ * with '#' starting a comment. See #load for the names.
+ *
+ * Like the rest of the controllers, this class is independent from NS3.
+ */
+struct GccConfig {
+    /** Class constructor, with the default values */
+    GccConfig();
+
+    /* Overuse estimator (Kalman filter) */
+    double processNoiseSlope;       /**< process_noise_slope */
+    double processNoiseOffset;      /**< process_noise_offset */
+    double initialSlope;            /**< initial_slope, in ms/byte */
+    double initialVarNoise;         /**< initial_var_noise */
+    double noiseAlphaStartup;       /**< noise_alpha_startup: noise filter gain at start */
+    double noiseAlpha;              /**< noise_alpha: noise filter gain afterwards */
+    double noiseStartupDeltas;      /**< noise_startup_deltas: deltas before switching gains */
+
+    /* Overuse detector */
+    double initialThresholdMs;      /**< initial_threshold_ms */
+    double minThresholdMs;          /**< min_threshold_ms */
+    double maxThresholdMs;          /**< max_threshold_ms */
+    double kUp;                     /**< k_up: threshold gain when above it */
+    double kDown;                   /**< k_down: threshold gain when below it */
+    double maxAdaptOffsetMs;        /**< max_adapt_offset_ms: larger spikes do not adapt it */
+    double overusingTimeThresholdMs; /**< overusing_time_threshold_ms */
+    double minNumDeltas;            /**< min_num_deltas: max gain applied to the offset */
+
+    /* Delay-based (AIMD) rate control */
+    double beta;                    /**< beta: backoff factor on overuse */
+    double increaseFactor;          /**< increase_factor: multiplicative increase per second */
+    double minIncreaseRateBps;      /**< min_increase_rate_bps: additive increase floor */
+    double maxBitrateAlpha;         /**< max_bitrate_alpha: gain of the max bitrate average */
+    double initializationTimeMs;    /**< initialization_time_ms */
+    double updateIntervalMs;        /**< update_interval_ms: periodic estimate update */
+
+    /* Loss-based rate control */
+    double lowLossThreshold;        /**< low_loss_threshold: increase below it */
+    double highLossThreshold;       /**< high_loss_threshold: decrease above it */
+    double bitrateThresholdKbps;    /**< bitrate_threshold_kbps: loss ignored below it */
+    double lossIncreaseFactor;      /**< loss_increase_factor */
+    double increaseIntervalMs;      /**< increase_interval_ms: min history window */
+    double decreaseIntervalMs;      /**< decrease_interval_ms: min time between decreases */
+    double startPhaseMs;            /**< start_phase_ms: delay-based estimate trusted */
+
+    /* Feedback timeout */
+    double feedbackTimeoutIntervals; /**< feedback_timeout_intervals: 0 disables the timeout */
+    double feedbackIntervalMs;      /**< feedback_interval_ms: expected feedback period */
+    double timeoutIntervalMs;       /**< timeout_interval_ms: min time between backoffs */
+    double timeoutBackoffFactor;    /**< timeout_backoff_factor */
+
+    /**
+     * Set a parameter by name
+     *
+     * @param [in] name Name of the parameter (see the field comments)
+     * @param [in] value New value
+     *
+     * @retval false if the name is unknown or the value out of range
+     */
+    bool set(const std::string& name, double value);
+
+    /**
+     * Get a parameter by name
+     *
+     * @param [in] name Name of the parameter
+     * @param [out] value Current value
+     *
+     * @retval false if the name is unknown
+     */
+    bool get(const std::string& name, double& value) const;
+
+    /**
+     * Set parameters from a comma-separated list, e.g., "k_up=0.01,beta=0.9"
+     *
+     * @retval false if an item is malformed, or cannot be set
+     */
+    bool parse(const std::string& list);
+
+    /**
+     * Set parameters from a configuration file's contents. Parameters
+     * missing from the file keep their value
+     *
+     * @retval false if a line is malformed, or cannot be set
+     */
+    bool load(std::istream& is);
+
+    /** Same as #load , from the file named @p filename */
+    bool loadFile(const std::string& filename);
+
+    /** Write all parameters in the configuration file format */
+    void save(std::ostream& os) const;
+
+    /** Write all parameters as a single line, for the controller's state */
+    void saveState(std::ostream& os) const;
+
+    /** Read the parameters written by #saveState */
+    bool restoreState(std::istream& is);
+};
+
+}
+
+#endif /* GCC_CONFIG_H */
@@ -27,6 +27,7 @@
 
 #include "sender-based-controller.h"
 #include "gcc-controller.h"
+#include "gcc-kernels.h"
 #include <sstream>
 #include <cassert>
 #include <math.h>
@@ -48,36 +49,32 @@ namespace rmcat {
 enum { kMinFramePeriodHistoryLength = 60 };
 enum { kDeltaCounterMax = 1000 };
 
-const double kMaxAdaptOffsetMs = 15.0;
-const double kOverUsingTimeThreshold = 10;
-const int kMinNumDeltas = 60;
-
 static const int64_t kDefaultRttMs = 200;
 static const int64_t kMaxFeedbackIntervalMs = 1000;
-static const float kDefaultBackoffFactor = 0.85f;
 
-const int64_t kBweIncreaseIntervalMs = 1000;
-const int64_t kBweDecreaseIntervalMs = 300;
-const int64_t kStartPhaseMs = 2000;
 const int64_t kBweConverganceTimeMs = 20000;
 const int kLimitNumPackets = 20;
 const int kDefaultMaxBitrateBps = 1000000000;
 const int64_t kLowBitrateLogPeriodMs = 10000;
 const int64_t kRtcEventLogPeriodMs = 5000;
 
-// Expecting that RTCP feedback is sent uniformly within [0.5, 1.5]s intervals.
-const int64_t kFeedbackIntervalMs = 5000;
-const int64_t kFeedbackTimeoutIntervals = 3;
-const int64_t kTimeoutIntervalMs = 1000;
+const char* kGccStateTag = "gcc-controller";
+const int kGccStateVersion = 8;
 
-const float kDefaultLowLossThreshold = 0.02f;
-const float kDefaultHighLossThreshold = 0.1f;
-const int kDefaultBitrateThresholdKbps = 0;
+// ECN codepoints (RFC 3168), as carried in the feedback
+const uint8_t kEcnNotEct = 0x0;
+const uint8_t kEcnCe = 0x3;
+// Scalable congestion response, as in DCTCP (RFC 8257) and L4S
+const double kEcnAlphaGain = 1. / 16.;
+const int64_t kMinEcnWindowMs = 10;
 
-GccController::GccController() :
+GccController::GccController(const GccConfig& config) :
     SenderBasedController{},
+    config_{config},
+    observer_{NULL},
     m_lastTimeCalcUs{0},
     m_lastTimeCalcValid{false},
+    m_feedbackLoss{false},
     m_QdelayUs{0},
 	m_Pkt{0},
     m_ploss{0},
@@ -89,19 +86,15 @@ GccController::GccController() :
 	m_plrmoving_avg{0.f},	
 
     num_of_deltas_(0),
-    slope_(8.0/512.0),	//need initial value
+    slope_(config_.initialSlope),
     offset_(0),	//need initial value
     prev_offset_(0),	//need initial value
     E_(),
-    process_noise_(),
     avg_noise_(0.0),	//need initial value
-    var_noise_(50),	//need initial value
+    var_noise_(config_.initialVarNoise),
     ts_delta_hist_(),	
  
-    k_up_(0.0087),
-    k_down_(0.039),
-    overusing_time_threshold_(100),
-    threshold_(12.5),
+    threshold_(config_.initialThresholdMs),
     last_update_ms_(-1),
     ut_last_update_ms_(-1),
     D_prev_offset_(0.0),
@@ -120,7 +113,6 @@ GccController::GccController() :
     time_last_bitrate_change_(-1),
     time_first_incoming_estimate_(-1),
     bitrate_is_initialized_(false),
-    beta_(kDefaultBackoffFactor),
     rtt_(kDefaultRttMs),
     in_experiment_(false),  // need initial value
     smoothing_experiment_(false),
@@ -143,16 +135,22 @@ GccController::GccController() :
     first_report_time_ms_(-1),
     initially_lost_packets_(0),
     bitrate_at_2_seconds_kbps_(0),
-    in_timeout_experiment_(false),
-    low_loss_threshold_(kDefaultLowLossThreshold),
-    high_loss_threshold_(kDefaultHighLossThreshold),
-    bitrate_threshold_bps_(1000 * kDefaultBitrateThresholdKbps) 
+    in_feedback_timeout_(false),
+    first_unacked_send_ms_(-1),
+
+    probe_controller_(),
+    probe_bitrate_estimator_(),
+
+    alr_detector_(),
+
+    ecn_alpha_(0.),
+    ecn_packets_(0),
+    ecn_marked_(0),
+    ecn_window_start_ms_(-1)
 
 {	E_[0][0] = 100;
 	E_[1][1] = 1e-1;
 	E_[0][1] = E_[1][0] = 0;
-	process_noise_[0] = 1e-13;
-	process_noise_[1] = 1e-3;
 }
 
 GccController::~GccController() {}
@@ -190,6 +188,7 @@ int GccController::GetMinBitrate() const {
 
 void GccController::UpdatePacketsLost(int packets_lost, int number_of_packets, int64_t now_ms) {
   last_feedback_ms_ = now_ms;
+  first_unacked_send_ms_ = -1;
   if (first_report_time_ms_ == -1)
     first_report_time_ms_ = now_ms;
 
@@ -208,6 +207,9 @@ void GccController::UpdatePacketsLost(int packets_lost, int number_of_packets, i
     int64_t lost_q8 = lost_packets_since_last_loss_update_ << 8;
     int64_t expected = expected_packets_since_last_loss_update_;
     last_fraction_loss_ = std::min<int>(lost_q8 / expected, 255);
+    if (observer_ != NULL) {
+      observer_->onLossFraction(getLossFraction());
+    }
 	
     // Reset accumulators.
 
@@ -258,6 +260,7 @@ void GccController::UpdateEstimate(int64_t now_ms) {
   }
   int64_t time_since_packet_report_ms = now_ms - last_packet_report_ms_;
   int64_t time_since_feedback_ms = now_ms - last_feedback_ms_;
+  // Missing feedback is handled by processTimer
 //  if (time_since_packet_report_ms < 1.2 * kFeedbackIntervalMs) {
     // We only care about loss above a given bitrate threshold.
     //float loss = last_fraction_loss_ / 256.0f;
@@ -266,10 +269,10 @@ void GccController::UpdateEstimate(int64_t now_ms) {
     // We only make decisions based on loss when the bitrate is above a
     // threshold. This is a crude way of handling loss which is uncorrelated
     // to congestion.
-    if (current_bitrate_bps_ < bitrate_threshold_bps_ ||
-        loss <= low_loss_threshold_) {
+    if (current_bitrate_bps_ < 1000 * config_.bitrateThresholdKbps ||
+        loss <= config_.lowLossThreshold) {
       // Loss < 2%: Increase rate by 8% of the min bitrate in the last
-      // kBweIncreaseIntervalMs.
+      // increase_interval_ms.
       // Note that by remembering the bitrate over the last second one can
       // rampup up one second faster than if only allowed to start ramping
       // at 8% per second rate now. E.g.:
@@ -279,20 +282,20 @@ void GccController::UpdateEstimate(int64_t now_ms) {
       //   it would take over one second since the lower packet loss to achieve
       //   108kbps.
       new_bitrate = static_cast<uint32_t>(
-          min_bitrate_history_.front().second * 1.08 + 0.5);
+          min_bitrate_history_.front().second * config_.lossIncreaseFactor + 0.5);
       // Add 1 kbps extra, just to make sure that we do not get stuck
       // (gives a little extra increase at low rates, negligible at higher
       // rates).
       new_bitrate += 1000;
-    } else if (current_bitrate_bps_ > bitrate_threshold_bps_) {
-      if (loss <= high_loss_threshold_) {
+    } else if (current_bitrate_bps_ > 1000 * config_.bitrateThresholdKbps) {
+      if (loss <= config_.highLossThreshold) {
         // Loss between 2% - 10%: Do nothing.
       } else {
-        // Loss > 10%: Limit the rate decreases to once a kBweDecreaseIntervalMs
+        // Loss > 10%: Limit the rate decreases to once a decrease_interval_ms
         // + rtt.
         if (!has_decreased_since_last_fraction_loss_ &&
             (now_ms - time_last_decrease_ms_) >=
-                (kBweDecreaseIntervalMs + last_round_trip_time_ms_)) {
+                (config_.decreaseIntervalMs + last_round_trip_time_ms_)) {
           time_last_decrease_ms_ = now_ms;
 
           // Reduce rate:
@@ -306,26 +309,12 @@ void GccController::UpdateEstimate(int64_t now_ms) {
         }
       }
     }
-/*  } else if (time_since_feedback_ms >
-                 kFeedbackTimeoutIntervals * kFeedbackIntervalMs &&
-             (last_timeout_ms_ == -1 ||
-              now_ms - last_timeout_ms_ > kTimeoutIntervalMs)) {
-    if (in_timeout_experiment_) {
-      new_bitrate *= 0.8;
-      // Reset accumulators since we've already acted on missing feedback and
-      // shouldn't to act again on these old lost packets.
-      lost_packets_since_last_loss_update_ = 0;
-      expected_packets_since_last_loss_update_ = 0;
-      last_timeout_ms_ = now_ms;
-    }
-  }*/
-
   CapBitrateToThresholds(now_ms, new_bitrate);
 }
 
 bool GccController::IsInStartPhase(int64_t now_ms) const {
   return first_report_time_ms_ == -1 ||
-         now_ms - first_report_time_ms_ < kStartPhaseMs;
+         now_ms - first_report_time_ms_ < config_.startPhaseMs;
 }
 
 void GccController::UpdateMinHistory(int64_t now_ms) {
@@ -334,7 +323,7 @@ void GccController::UpdateMinHistory(int64_t now_ms) {
   // bitrate if it is off by as little as 0.5ms.
   while (!min_bitrate_history_.empty() &&
          now_ms - min_bitrate_history_.front().first + 1 >
-             kBweIncreaseIntervalMs) {
+             config_.increaseIntervalMs) {
     min_bitrate_history_.pop_front();
   }
 
@@ -381,12 +370,18 @@ void GccController::CapBitrateToThresholds(int64_t now_ms,
 
 
 void GccController::setCurrentBw(float newBw) {
-    m_initBw = newBw;
+    // The rate control and the loss-based controller go on from the new rate
+    const float bw = std::min(std::max(newBw, m_minBw), m_maxBw);
+    current_bitrate_bps_ = uint32_t(bw);
+    if (delay_based_bitrate_bps_ > 0) {
+        delay_based_bitrate_bps_ = current_bitrate_bps_;
+    }
 }
 
 void GccController::reset() {
     m_lastTimeCalcUs = 0;
     m_lastTimeCalcValid = false;
+    m_feedbackLoss = false;
 
 	
     m_QdelayUs = 0;
@@ -395,9 +390,41 @@ void GccController::reset() {
 	m_plr = 0.f;
     m_RecvR = 0.;
 
+    probe_controller_.reset();
+    probe_bitrate_estimator_.reset();
+
+    alr_detector_.reset();
+
+    ecn_alpha_ = 0.;
+    ecn_packets_ = 0;
+    ecn_marked_ = 0;
+    ecn_window_start_ms_ = -1;
+
+    last_feedback_ms_ = -1;
+    last_timeout_ms_ = -1;
+    first_unacked_send_ms_ = -1;
+    in_feedback_timeout_ = false;
+
     SenderBasedController::reset();
 }
 
+bool GccController::processSendPacket(uint64_t txTimestampUs,
+                                      uint16_t sequence,
+                                      uint32_t size,
+                                      int probeClusterId) {
+    const bool res = SenderBasedController::processSendPacket(txTimestampUs, sequence,
+                                                              size, probeClusterId);
+    if (res && probeClusterId == 0) {
+        // What the pacer actually sends, against the estimate
+        alr_detector_.setEstimatedBitrate(current_bitrate_bps_);
+        alr_detector_.onBytesSent(size, int64_t(txTimestampUs / 1000));
+    }
+    if (res && first_unacked_send_ms_ == -1) {
+        first_unacked_send_ms_ = int64_t(txTimestampUs / 1000);
+    }
+    return res;
+}
+
 bool GccController::processFeedback(uint64_t nowUs,
                                       uint16_t sequence,
                                       uint64_t rxTimestampUs,
@@ -413,18 +440,16 @@ bool GccController::processFeedback(uint64_t nowUs,
                                                             l_inter_arrival,
                                                             l_inter_departure,
                                                             l_inter_delay_var, l_inter_group_size, l_arrival_time,  ecn);		
-	static const int kMinBitrateBps = 10000;
-	static const int kMaxBitrateBps = 1500000;
-  	static const int kInitialBitrateBps = 300000;
 
 	uint64_t now_ms = ns3::Simulator::Now().GetMilliSeconds();
+	m_feedbackLoss = true;
 
 		if(prev_seq_loss == 0){
 			//initialize it
 			prev_seq_loss = sequence ;
 			m_timer = now_ms;
 		}else if(m_timer + LOSS_TIMER < now_ms){			
-			int delta_seq = sequence - prev_seq_loss;
+			int delta_seq = uint16_t(sequence - prev_seq_loss); // wraps properly
 		
 			if(delta_seq != 0){
 				float loss_ratio = (float)loss_counter / (float)delta_seq;
@@ -439,10 +464,28 @@ bool GccController::processFeedback(uint64_t nowUs,
 
 	    if(!res) return false;
 
+	    OnFeedbackResumed(now_ms);
+
+	    // Feedback of a probe packet: the probe estimator may now know at
+	    // which rate its cluster got through the bottleneck
+	    if (!m_packetHistory.empty() && m_packetHistory.back().sequence == sequence &&
+	        m_packetHistory.back().probeClusterId > 0) {
+	        ProbeCluster cluster;
+	        if (probe_controller_.getCluster(m_packetHistory.back().probeClusterId, cluster)) {
+	            const uint32_t probe_bitrate_bps =
+	                probe_bitrate_estimator_.handleProbeFeedback(m_packetHistory.back(), cluster);
+	            if (probe_bitrate_bps > 0 && m_lastTimeCalcValid) {
+	                ApplyProbeResult(probe_bitrate_bps, now_ms);
+	            }
+	        }
+	    }
+
+	    UpdateEcn(ecn, now_ms);
+	    const uint32_t prev_bitrate_bps = current_bitrate_bps_;
+
 	    if(!m_lastTimeCalcValid){
 	    	m_lastTimeCalcValid = true;
-		    SetMinMaxBitrate(kMinBitrateBps, kMaxBitrateBps);
-	 	    SetSendBitrate(nowUs, kInitialBitrateBps);
+		    ConfigureBitrates(now_ms);
 		    return true;
 	    }
 
@@ -470,7 +513,7 @@ bool GccController::processFeedback(uint64_t nowUs,
       	// Check if it's time for a periodic update or if we should update because
       	// of an over-use.
             
-			if (last_update_ms_ == -1 || (uint64_t)now_ms - last_update_ms_ > 1000){
+			if (last_update_ms_ == -1 || now_ms - last_update_ms_ > config_.updateIntervalMs){
    		     	update_estimate = true;
    		   	} else if (D_hypothesis_ == 'O') {
        		 	uint32_t incoming_rate = (uint32_t)m_RecvR; 
@@ -495,10 +538,256 @@ bool GccController::processFeedback(uint64_t nowUs,
 
 		UpdateDelayBasedEstimate(now_ms, current_bitrate_bps_);
         UpdatePacketsLost(m_ploss, m_Pkt, now_ms);
+        CapIncreaseInAlr(prev_bitrate_bps);
+        probe_controller_.setEstimatedBitrate(current_bitrate_bps_, now_ms);
 
 	return res;
 }
 
+/*
+ * While application-limited, the feedback only shows that the (low)
+ * sending rate goes through: increases of the estimate would not be backed
+ * by any measurement, and the queue would burst once the media needs the
+ * inflated rate. Decreases and probe results still apply
+ */
+void GccController::CapIncreaseInAlr(uint32_t prev_bitrate_bps) {
+    if (!alr_detector_.inAlr() || current_bitrate_bps_ <= prev_bitrate_bps) {
+        return;
+    }
+    current_bitrate_bps_ = prev_bitrate_bps;
+    if (delay_based_bitrate_bps_ > prev_bitrate_bps) {
+        delay_based_bitrate_bps_ = prev_bitrate_bps;
+    }
+}
+
+bool GccController::getProbeCluster(uint64_t nowUs, ProbeCluster& cluster) {
+    const int64_t now_ms = nowUs / 1000;
+    // Start-up probing is requested on the first call only
+    probe_controller_.setBitrates(m_minBw, m_initBw, m_maxBw, now_ms);
+    probe_controller_.setAlrStartTime(alr_detector_.getAlrStartTimeMs());
+    probe_controller_.process(now_ms);
+    return probe_controller_.popCluster(cluster);
+}
+
+void GccController::processRemb(uint64_t nowUs, uint32_t bitrateBps) {
+  const int64_t now_ms = nowUs / 1000;
+  if (!m_lastTimeCalcValid) {
+    m_lastTimeCalcValid = true;
+    ConfigureBitrates(now_ms);
+  }
+  // As in the REMB architecture: the remote estimate caps the loss-based
+  // estimate, which is updated at every report
+  OnFeedbackResumed(now_ms);
+  const uint32_t prev_bitrate_bps = current_bitrate_bps_;
+  UpdateDelayBasedEstimate(now_ms, bitrateBps);
+  if (first_report_time_ms_ == -1)
+    first_report_time_ms_ = now_ms;
+  last_feedback_ms_ = now_ms;
+  first_unacked_send_ms_ = -1;
+  last_packet_report_ms_ = now_ms;
+  UpdateEstimate(now_ms);
+  CapIncreaseInAlr(prev_bitrate_bps);
+  probe_controller_.setEstimatedBitrate(current_bitrate_bps_, now_ms);
+
+  std::ostringstream os;
+  os << " algo:gcc " << m_id
+     << " ts: " << now_ms
+     << " remb: " << bitrateBps
+     << " srate: " << current_bitrate_bps_;
+  logMessage(os.str());
+}
+
+void GccController::processReceiverReport(uint64_t nowUs,
+                                          uint64_t rttUs,
+                                          uint8_t fractionLost,
+                                          uint32_t packetsExpected) {
+  const int64_t now_ms = nowUs / 1000;
+  if (rttUs > 0) {
+    const int64_t rtt_ms = std::max<int64_t>(rttUs / 1000, 1);
+    SetRtt(rtt_ms);
+    last_round_trip_time_ms_ = rtt_ms;
+  }
+  // Without per-packet feedback (e.g., REMB), the reports are the only
+  // source of loss for the loss-based controller
+  if (!m_feedbackLoss && m_lastTimeCalcValid && packetsExpected > 0) {
+    const int packets_lost = (int(fractionLost) * int(packetsExpected)) >> 8;
+    const uint32_t prev_bitrate_bps = current_bitrate_bps_;
+    UpdatePacketsLost(packets_lost, packetsExpected, now_ms);
+    CapIncreaseInAlr(prev_bitrate_bps);
+  }
+
+  std::ostringstream os;
+  os << " algo:gcc " << m_id
+     << " ts: " << now_ms
+     << " rr-rtt: " << rttUs / 1000
+     << " rr-loss: " << int(fractionLost)
+     << " srate: " << current_bitrate_bps_;
+  logMessage(os.str());
+}
+
+void GccController::processTimer(uint64_t nowUs) {
+  const int64_t now_ms = nowUs / 1000;
+  if (config_.feedbackTimeoutIntervals <= 0 || !m_lastTimeCalcValid || last_feedback_ms_ == -1) {
+    return;
+  }
+  // Only packets sent since the last feedback can be missing feedback:
+  // an idle or app-limited sender gets none, and that is fine
+  if (first_unacked_send_ms_ == -1) {
+    return;
+  }
+  const int64_t waited_ms = now_ms - std::max(last_feedback_ms_, first_unacked_send_ms_);
+  if (waited_ms <= config_.feedbackTimeoutIntervals * config_.feedbackIntervalMs ||
+      (last_timeout_ms_ != -1 && now_ms - last_timeout_ms_ <= config_.timeoutIntervalMs)) {
+    return;
+  }
+  in_feedback_timeout_ = true;
+  last_timeout_ms_ = now_ms;
+  // Reset accumulators since we've already acted on missing feedback and
+  // shouldn't act again on these old lost packets.
+  lost_packets_since_last_loss_update_ = 0;
+  expected_packets_since_last_loss_update_ = 0;
+
+  // Both the delay-based and the loss-based estimates back off: nothing
+  // is known about the path until feedback comes back
+  SetEstimate(current_bitrate_bps_ * config_.timeoutBackoffFactor, now_ms);
+  if (delay_based_bitrate_bps_ > current_bitrate_bps_) {
+    delay_based_bitrate_bps_ = current_bitrate_bps_;
+  }
+  CapBitrateToThresholds(now_ms, current_bitrate_bps_);
+  min_bitrate_history_.clear();
+  min_bitrate_history_.push_back(std::make_pair(now_ms, current_bitrate_bps_));
+
+  std::ostringstream os;
+  os << " algo:gcc " << m_id
+     << " ts: " << now_ms
+     << " feedback-timeout: " << now_ms - last_feedback_ms_
+     << " srate: " << current_bitrate_bps_;
+  logMessage(os.str());
+}
+
+void GccController::restartFeedbackTimeout(uint64_t nowUs) {
+  last_feedback_ms_ = nowUs / 1000;
+  last_timeout_ms_ = -1;
+  first_unacked_send_ms_ = -1;
+  in_feedback_timeout_ = false;
+}
+
+bool GccController::setParameter(const std::string& name, double value) {
+  return config_.set(name, value);
+}
+
+void GccController::setConfig(const GccConfig& config) {
+  config_ = config;
+  if (!m_lastTimeCalcValid) {
+    // No feedback yet: the initial state of the estimator and detector
+    // comes from the new configuration as well
+    slope_ = config_.initialSlope;
+    var_noise_ = config_.initialVarNoise;
+    threshold_ = config_.initialThresholdMs;
+  }
+}
+
+bool GccController::usesTimer() const {
+  return config_.feedbackTimeoutIntervals > 0;
+}
+
+const GccConfig& GccController::getConfig() const {
+  return config_;
+}
+
+void GccController::setObserver(GccObserver* observer) {
+  observer_ = observer;
+}
+
+/*
+ * First feedback after a timeout: the rate control goes on from the
+ * backed-off rate, holding it until the detector has seen fresh delay
+ * samples, rather than jumping back to the rate before the outage
+ */
+void GccController::OnFeedbackResumed(int64_t now_ms) {
+  if (!in_feedback_timeout_) {
+    return;
+  }
+  in_feedback_timeout_ = false;
+  rate_control_state_ = 'H';
+  time_last_bitrate_change_ = now_ms;
+  min_bitrate_history_.clear();
+  min_bitrate_history_.push_back(std::make_pair(now_ms, current_bitrate_bps_));
+
+  std::ostringstream os;
+  os << " algo:gcc " << m_id
+     << " ts: " << now_ms
+     << " feedback-resumed: " << now_ms - last_feedback_ms_
+     << " srate: " << current_bitrate_bps_;
+  logMessage(os.str());
+}
+
+void GccController::UpdateEcn(uint8_t ecn, int64_t now_ms) {
+  if (ecn == kEcnNotEct) {
+    return;
+  }
+  ++ecn_packets_;
+  if (ecn == kEcnCe) {
+    ++ecn_marked_;
+  }
+  if (ecn_window_start_ms_ == -1) {
+    ecn_window_start_ms_ = now_ms;
+  }
+  // One observation window per RTT, as in DCTCP
+  if (now_ms - ecn_window_start_ms_ < std::max<int64_t>(rtt_, kMinEcnWindowMs)) {
+    return;
+  }
+  const double marked_fraction = double(ecn_marked_) / double(ecn_packets_);
+  ecn_alpha_ += kEcnAlphaGain * (marked_fraction - ecn_alpha_);
+  if (ecn_marked_ > 0 && m_lastTimeCalcValid) {
+    // Scalable decrease: proportional to the extent of marking, rather
+    // than the fixed back-off of the delay and loss-based controllers
+    const uint32_t bitrate_bps = current_bitrate_bps_ * (1. - ecn_alpha_ / 2.);
+    SetEstimate(bitrate_bps, now_ms);
+    CapBitrateToThresholds(now_ms, current_bitrate_bps_);
+    min_bitrate_history_.clear();
+    min_bitrate_history_.push_back(std::make_pair(now_ms, current_bitrate_bps_));
+
+    std::ostringstream os;
+    os << " algo:gcc " << m_id
+       << " ts: " << now_ms
+       << " ecn-marked: " << ecn_marked_ << "/" << ecn_packets_
+       << " ecn-alpha: " << ecn_alpha_
+       << " srate: " << current_bitrate_bps_;
+    logMessage(os.str());
+  }
+  ecn_packets_ = 0;
+  ecn_marked_ = 0;
+  ecn_window_start_ms_ = now_ms;
+}
+
+void GccController::ConfigureBitrates(int64_t now_ms) {
+  // Limits and start bitrate as configured via setMinBw, setMaxBw and
+  // setInitBw
+  min_bitrate_configured_ = m_minBw;
+  SetMinBitrate(m_minBw);
+  SetBitrates(m_initBw, m_minBw, m_maxBw, now_ms);
+}
+
+void GccController::ApplyProbeResult(uint32_t probe_bitrate_bps, int64_t now_ms) {
+  // Jump the delay-based estimate to the probed rate, rather than waiting
+  // for AIMD to ramp up to it.
+  SetEstimate(probe_bitrate_bps, now_ms);
+  // The loss-based controller follows. Its min history is reset so that it
+  // does not pull the estimate back to the pre-probe rate.
+  delay_based_bitrate_bps_ = 0;
+  CapBitrateToThresholds(now_ms, current_bitrate_bps_);
+  min_bitrate_history_.clear();
+  min_bitrate_history_.push_back(std::make_pair(now_ms, current_bitrate_bps_));
+
+  std::ostringstream os;
+  os << " algo:gcc " << m_id
+     << " ts: " << now_ms
+     << " probe: " << probe_bitrate_bps
+     << " srate: " << current_bitrate_bps_;
+  logMessage(os.str());
+}
+
 float GccController::getBandwidth(uint64_t nowUs) const {
 
     return m_initBw;
@@ -508,6 +797,163 @@ uint32_t GccController::getSendBps() const{
 	return current_bitrate_bps_;
 }
 
+float GccController::getLossFraction() const {
+    return last_fraction_loss_ / 256.f;
+}
+
+void GccController::saveState(std::ostream& os) const {
+    SenderBasedController::saveState(os);
+    os.precision(std::numeric_limits<double>::max_digits10);
+    os << kGccStateTag << " " << kGccStateVersion << "\n";
+    os << m_lastTimeCalcUs << " " << m_lastTimeCalcValid << " " << m_QdelayUs << " "
+       << m_Pkt << " " << m_ploss << " " << m_plr << " " << m_RecvR << " "
+       << m_timer << " " << prev_seq_loss << " " << loss_moving_avg << " "
+       << m_plrmoving_avg << " " << m_feedbackLoss << "\n";
+
+    // Configuration
+    config_.saveState(os);
+
+    // Overuse estimator
+    os << num_of_deltas_ << " " << slope_ << " " << offset_ << " " << prev_offset_ << " "
+       << E_[0][0] << " " << E_[0][1] << " " << E_[1][0] << " " << E_[1][1] << " "
+       << avg_noise_ << " " << var_noise_ << " " << ts_delta_hist_.size();
+    for (const double ts_delta : ts_delta_hist_) {
+        os << " " << ts_delta;
+    }
+    os << "\n";
+
+    // Overuse detector
+    os << threshold_ << " " << last_update_ms_ << " " << ut_last_update_ms_ << " "
+       << D_prev_offset_ << " " << time_over_using_ << " " << overuse_counter_ << " "
+       << int(D_hypothesis_) << "\n";
+
+    // Delay-based rate control
+    os << min_configured_bitrate_bps_ << " " << max_configured_bitrate_bps_ << " "
+       << current_bitrate_bps_ << " " << latest_incoming_bitrate_bps_ << " "
+       << avg_max_bitrate_kbps_ << " " << var_max_bitrate_kbps_ << " "
+       << int(rate_control_state_) << " " << int(rate_control_region_) << " "
+       << time_last_bitrate_change_ << " " << time_first_incoming_estimate_ << " "
+       << bitrate_is_initialized_ << " " << rtt_ << " "
+       << in_experiment_ << " " << smoothing_experiment_ << " " << last_decrease_ << "\n";
+
+    // Loss-based rate control
+    os << min_bitrate_history_.size();
+    for (const auto& entry : min_bitrate_history_) {
+        os << " " << entry.first << " " << entry.second;
+    }
+    os << "\n";
+    os << lost_packets_since_last_loss_update_ << " "
+       << expected_packets_since_last_loss_update_ << " "
+       << min_bitrate_configured_ << " " << max_bitrate_configured_ << " "
+       << last_low_bitrate_log_ms_ << " " << has_decreased_since_last_fraction_loss_ << " "
+       << last_feedback_ms_ << " " << last_packet_report_ms_ << " " << last_timeout_ms_ << " "
+       << int(last_fraction_loss_) << " " << int(last_logged_fraction_loss_) << " "
+       << last_round_trip_time_ms_ << " " << bwe_incoming_ << " "
+       << delay_based_bitrate_bps_ << " " << time_last_decrease_ms_ << " "
+       << first_report_time_ms_ << " " << initially_lost_packets_ << " "
+       << bitrate_at_2_seconds_kbps_ << " " << last_rtc_event_log_ms_ << "\n";
+
+    // Feedback timeout
+    os << in_feedback_timeout_ << " " << first_unacked_send_ms_ << "\n";
+
+    // ECN response
+    os << ecn_alpha_ << " " << ecn_packets_ << " " << ecn_marked_ << " "
+       << ecn_window_start_ms_ << "\n";
+
+    // Active probing
+    probe_controller_.saveState(os);
+    probe_bitrate_estimator_.saveState(os);
+
+    // Application-limited region
+    alr_detector_.saveState(os);
+}
+
+bool GccController::restoreState(std::istream& is) {
+    if (!SenderBasedController::restoreState(is)) {
+        return false;
+    }
+    std::string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != kGccStateTag || version != kGccStateVersion) {
+        std::cerr << "GccController::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    is >> m_lastTimeCalcUs >> m_lastTimeCalcValid >> m_QdelayUs
+       >> m_Pkt >> m_ploss >> m_plr >> m_RecvR
+       >> m_timer >> prev_seq_loss >> loss_moving_avg
+       >> m_plrmoving_avg >> m_feedbackLoss;
+
+    config_.restoreState(is);
+
+    size_t nHist = 0;
+    is >> num_of_deltas_ >> slope_ >> offset_ >> prev_offset_
+       >> E_[0][0] >> E_[0][1] >> E_[1][0] >> E_[1][1]
+       >> avg_noise_ >> var_noise_ >> nHist;
+    ts_delta_hist_.clear();
+    for (size_t i = 0; i < nHist && is; ++i) {
+        double ts_delta = 0.;
+        is >> ts_delta;
+        ts_delta_hist_.push_back(ts_delta);
+    }
+
+    int hypothesis = 'N';
+    is >> threshold_ >> last_update_ms_ >> ut_last_update_ms_
+       >> D_prev_offset_ >> time_over_using_ >> overuse_counter_
+       >> hypothesis;
+    D_hypothesis_ = char(hypothesis);
+
+    int state = 'H';
+    int region = 'M';
+    is >> min_configured_bitrate_bps_ >> max_configured_bitrate_bps_
+       >> current_bitrate_bps_ >> latest_incoming_bitrate_bps_
+       >> avg_max_bitrate_kbps_ >> var_max_bitrate_kbps_
+       >> state >> region
+       >> time_last_bitrate_change_ >> time_first_incoming_estimate_
+       >> bitrate_is_initialized_ >> rtt_
+       >> in_experiment_ >> smoothing_experiment_ >> last_decrease_;
+    rate_control_state_ = char(state);
+    rate_control_region_ = char(region);
+
+    size_t nMin = 0;
+    is >> nMin;
+    min_bitrate_history_.clear();
+    for (size_t i = 0; i < nMin && is; ++i) {
+        int64_t time_ms = 0;
+        uint32_t bitrate = 0;
+        is >> time_ms >> bitrate;
+        min_bitrate_history_.push_back(std::make_pair(time_ms, bitrate));
+    }
+    int fraction_loss = 0;
+    int logged_fraction_loss = 0;
+    is >> lost_packets_since_last_loss_update_
+       >> expected_packets_since_last_loss_update_
+       >> min_bitrate_configured_ >> max_bitrate_configured_
+       >> last_low_bitrate_log_ms_ >> has_decreased_since_last_fraction_loss_
+       >> last_feedback_ms_ >> last_packet_report_ms_ >> last_timeout_ms_
+       >> fraction_loss >> logged_fraction_loss
+       >> last_round_trip_time_ms_ >> bwe_incoming_
+       >> delay_based_bitrate_bps_ >> time_last_decrease_ms_
+       >> first_report_time_ms_ >> initially_lost_packets_
+       >> bitrate_at_2_seconds_kbps_ >> last_rtc_event_log_ms_;
+
+    is >> in_feedback_timeout_ >> first_unacked_send_ms_;
+    last_fraction_loss_ = uint8_t(fraction_loss);
+    last_logged_fraction_loss_ = uint8_t(logged_fraction_loss);
+
+    is >> ecn_alpha_ >> ecn_packets_ >> ecn_marked_ >> ecn_window_start_ms_;
+
+    if (!is ||
+        !probe_controller_.restoreState(is) ||
+        !probe_bitrate_estimator_.restoreState(is) ||
+        !alr_detector_.restoreState(is)) {
+        std::cerr << "GccController::restoreState,"
+                  << " truncated or corrupted state" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 void GccController::updateMetrics() {
     uint64_t qdelayUs;
     bool qdelayOK = getCurrentQdelay(qdelayUs);
@@ -558,9 +1004,7 @@ uint64_t GccController::GetFeedbackInterval() const {
 
 bool GccController::TimeToReduceFurther(int32_t time_now,
                                           uint32_t incoming_bitrate_bps) const {
-  const int64_t bitrate_reduction_interval =
-      std::max<int64_t>(std::min<int64_t>(rtt_, 200), 10);
-  if (time_now - time_last_bitrate_change_ >= bitrate_reduction_interval) {
+  if (time_now - time_last_bitrate_change_ >= gccReductionIntervalMs(rtt_)) {
     return true;
   }
   if (ValidEstimate()) {
@@ -582,23 +1026,13 @@ void GccController::SetRtt(int64_t rtt) {
 
 uint32_t GccController::Update(char bw_state, uint32_t incoming_bitrate, double noise_var,
                                  int64_t now_ms) {
-  // Set the initial bit rate value to what we're receiving the first half
-  // second.
-  // TODO(bugs.webrtc.org/9379): The comment above doesn't match to the code.
-  if (!bitrate_is_initialized_) {
-    const int64_t kInitializationTimeMs = 5000;
-    
-    if (time_first_incoming_estimate_ < 0) {
-      if (incoming_bitrate)
-        time_first_incoming_estimate_ = now_ms;
-    } else if (now_ms - time_first_incoming_estimate_ > kInitializationTimeMs &&
-               incoming_bitrate > 0) {
-      current_bitrate_bps_ = incoming_bitrate;
-      bitrate_is_initialized_ = true;
-    }
-  }
+  gccInitializeBitrate(config_, incoming_bitrate, now_ms, bitrate_is_initialized_,
+                       time_first_incoming_estimate_, current_bitrate_bps_);
 
   current_bitrate_bps_ = ChangeBitrate(current_bitrate_bps_, bw_state, incoming_bitrate, noise_var, now_ms);
+  if (observer_ != NULL) {
+    observer_->onRateControlUpdate(rate_control_state_, rate_control_region_);
+  }
   return current_bitrate_bps_;
 }
 
@@ -609,15 +1043,9 @@ void GccController::SetEstimate(int bitrate_bps, int64_t now_ms) {
 }
 
 int GccController::GetNearMaxIncreaseRateBps() const {
-  double bits_per_frame = static_cast<double>(current_bitrate_bps_) / 30.0;
-  double packets_per_frame = std::ceil(bits_per_frame / (8.0 * 1200.0));
-  double avg_packet_size_bits = bits_per_frame / packets_per_frame;
-
   // Approximate the over-use estimator delay to 100 ms.
   const int64_t response_time = in_experiment_ ? (rtt_ + 100) * 2 : rtt_ + 100;
-  constexpr double kMinIncreaseRateBps = 4000;
-  return static_cast<int>(std::max(
-      kMinIncreaseRateBps, (avg_packet_size_bits * 1000) / response_time));
+  return gccNearMaxIncreaseRateBps(config_, current_bitrate_bps_, response_time);
 }
 
 int GccController::GetExpectedBandwidthPeriodMs() const {
@@ -684,12 +1112,12 @@ uint32_t GccController::ChangeBitrate(uint32_t new_bitrate_bps,
       // Set bit rate to something slightly lower than max
       // to get rid of any self-induced delay.
       new_bitrate_bps =
-          static_cast<uint32_t>(beta_ * incoming_bitrate_bps + 0.5);
+          static_cast<uint32_t>(config_.beta * incoming_bitrate_bps + 0.5);
       if (new_bitrate_bps > current_bitrate_bps_) {
         // Avoid increasing the rate when over-using.
         if (rate_control_region_ != 'M') {
           new_bitrate_bps = static_cast<uint32_t>(
-              beta_ * avg_max_bitrate_kbps_ * 1000 + 0.5f);
+              config_.beta * avg_max_bitrate_kbps_ * 1000 + 0.5f);
         }
         new_bitrate_bps = std::min(new_bitrate_bps, current_bitrate_bps_);
       }
@@ -700,7 +1128,7 @@ uint32_t GccController::ChangeBitrate(uint32_t new_bitrate_bps,
         constexpr float kDegradationFactor = 0.9f;
         if (smoothing_experiment_ &&
             new_bitrate_bps <
-                kDegradationFactor * beta_ * current_bitrate_bps_) {
+                kDegradationFactor * config_.beta * current_bitrate_bps_) {
           // If bitrate decreases more than a normal back off after overuse, it
           // indicates a real network degradation. We do not let such a decrease
           // to determine the bandwidth estimation period.
@@ -729,15 +1157,8 @@ uint32_t GccController::ChangeBitrate(uint32_t new_bitrate_bps,
 
 uint32_t GccController::ClampBitrate(uint32_t new_bitrate_bps,
                                        uint32_t incoming_bitrate_bps) const {
-  // Don't change the bit rate if the send side is too far off.
-  // We allow a bit more lag at very low rates to not too easily get stuck if
-  // the encoder produces uneven outputs.
-  const uint32_t max_bitrate_bps =
-      static_cast<uint32_t>(1.5f * incoming_bitrate_bps) + 10000;
-  if (new_bitrate_bps > current_bitrate_bps_ &&
-      new_bitrate_bps > max_bitrate_bps) {
-    new_bitrate_bps = std::max(current_bitrate_bps_, max_bitrate_bps);
-  }
+  new_bitrate_bps = gccClampToIncoming(new_bitrate_bps, current_bitrate_bps_,
+                                       incoming_bitrate_bps);
   new_bitrate_bps = std::max(new_bitrate_bps, min_configured_bitrate_bps_);
   return new_bitrate_bps;
 }
@@ -746,15 +1167,7 @@ uint32_t GccController::MultiplicativeRateIncrease(
     int64_t now_ms,
     int64_t last_ms,
     uint32_t current_bitrate_bps) const {
-  double alpha = 1.08;
-  if (last_ms > -1) {
-    auto time_since_last_update_ms =
-        rtc::SafeMin<int64_t>(now_ms - last_ms, 1000);
-    alpha = pow(alpha, time_since_last_update_ms / 1000.0);
-  }
-  uint32_t multiplicative_increase_bps =
-      std::max(current_bitrate_bps * (alpha - 1.0), 1000.0);
-  return multiplicative_increase_bps;
+  return gccMultiplicativeIncreaseBps(config_, now_ms, last_ms, current_bitrate_bps);
 }
 
 uint32_t GccController::AdditiveRateIncrease(int64_t now_ms,
@@ -764,51 +1177,13 @@ uint32_t GccController::AdditiveRateIncrease(int64_t now_ms,
 }
 
 void GccController::UpdateMaxBitRateEstimate(float incoming_bitrate_kbps) {
-  const float alpha = 0.05f;
-  if (avg_max_bitrate_kbps_ == -1.0f) {
-    avg_max_bitrate_kbps_ = incoming_bitrate_kbps;
-  } else {
-    avg_max_bitrate_kbps_ =
-        (1 - alpha) * avg_max_bitrate_kbps_ + alpha * incoming_bitrate_kbps;
-  }
-  // Estimate the max bit rate variance and normalize the variance
-  // with the average max bit rate.
-  const float norm = std::max(avg_max_bitrate_kbps_, 1.0f);
-  var_max_bitrate_kbps_ =
-      (1 - alpha) * var_max_bitrate_kbps_ +
-      alpha * (avg_max_bitrate_kbps_ - incoming_bitrate_kbps) *
-          (avg_max_bitrate_kbps_ - incoming_bitrate_kbps) / norm;
-  // 0.4 ~= 14 kbit/s at 500 kbit/s
-  if (var_max_bitrate_kbps_ < 0.4f) {
-    var_max_bitrate_kbps_ = 0.4f;
-  }
-  // 2.5f ~= 35 kbit/s at 500 kbit/s
-  if (var_max_bitrate_kbps_ > 2.5f) {
-    var_max_bitrate_kbps_ = 2.5f;
-  }
+  gccUpdateMaxBitrateEstimate(config_, incoming_bitrate_kbps,
+                              avg_max_bitrate_kbps_, var_max_bitrate_kbps_);
 }
 
 void GccController::ChangeState(char bw_state,
                                   int64_t now_ms) {
-  
-   switch (bw_state) {
-    case 'N':
-      if (rate_control_state_ == 'H') {
-        time_last_bitrate_change_ = now_ms;
-        rate_control_state_ = 'I';
-      }
-      break;
-    case 'O':
-      if (rate_control_state_ != 'D') {
-        rate_control_state_ = 'D';
-      }
-      break;
-    case 'U':
-      rate_control_state_ = 'H';
-      break;
-    default:
-      assert(false);
-  }
+  gccChangeState(bw_state, now_ms, rate_control_state_, time_last_bitrate_change_);
 }
 
 void GccController::ChangeRegion(char region) {
@@ -844,61 +1219,9 @@ void GccController::OveruseEstimatorUpdate(int64_t t_delta, double ts_delta, int
    		num_of_deltas_ = kDeltaCounterMax;
   	}
 
-  	// Update the Kalman filter.
-  	E_[0][0] += process_noise_[0];
-  	E_[1][1] += process_noise_[1];
-
-  	if ((current_hypothesis == 'O' && offset_ < prev_offset_) ||
-            (current_hypothesis == 'U' && offset_ > prev_offset_)) {
-    		E_[1][1] += 10 * process_noise_[1];
-  	}
-
-  	const double h[2] = {fs_delta, 1.0};
-	
-  	const double Eh[2] = {E_[0][0] * h[0] + E_[0][1] * h[1],
-                        E_[1][0] * h[0] + E_[1][1] * h[1]};
-
- 	const double residual = t_ts_delta - slope_ * h[0] - offset_;
-
-  	const bool in_stable_state = (current_hypothesis == 'N');
-  	const double max_residual = 3.0 * sqrt(var_noise_);
-
-  	// We try to filter out very late frames. For instance periodic key
-  	// frames doesn't fit the Gaussian model well.
-  	if (fabs(residual) < max_residual) {
-    		UpdateNoiseEstimate(residual, min_frame_period, in_stable_state);
-  	} else {
-    		UpdateNoiseEstimate(residual < 0 ? -max_residual : max_residual,
-                        min_frame_period, in_stable_state);
-  	}
-
-  	const double denom = var_noise_ + h[0] * Eh[0] + h[1] * Eh[1];
-
-  	const double K[2] = {Eh[0] / denom, Eh[1] / denom};
-
-  	const double IKh[2][2] = {{1.0 - K[0] * h[0], -K[0] * h[1]},
-                            {-K[1] * h[0], 1.0 - K[1] * h[1]}};
-  	const double e00 = E_[0][0];
-	const double e01 = E_[0][1];
-                              
-	  // Update state.            
-  	E_[0][0] = e00 * IKh[0][0] + E_[1][0] * IKh[0][1];
-  	E_[0][1] = e01 * IKh[0][0] + E_[1][1] * IKh[0][1];
-  	E_[1][0] = e00 * IKh[1][0] + E_[1][0] * IKh[1][1];
-  	E_[1][1] = e01 * IKh[1][0] + E_[1][1] * IKh[1][1];
-  
- 	// The covariance matrix must be positive semi-definite.
-  	bool positive_semi_definite =
-      		E_[0][0] + E_[1][1] >= 0 &&
-      		E_[0][0] * E_[1][1] - E_[0][1] * E_[1][0] >= 0 && E_[0][0] >= 0;
-  	
-
-    assert(positive_semi_definite);
-  
-
-  	slope_ = slope_ + K[0] * residual;
-  	prev_offset_ = offset_;
-  	offset_ = offset_ + K[1] * residual;
+	gccEstimatorUpdate(config_, t_ts_delta, fs_delta, min_frame_period, num_of_deltas_,
+	                   current_hypothesis, slope_, offset_, prev_offset_, E_,
+	                   avg_noise_, var_noise_);
 }
 
 double GccController::UpdateMinFramePeriod(double ts_delta) {
@@ -913,49 +1236,8 @@ double GccController::UpdateMinFramePeriod(double ts_delta) {
   return min_frame_period;
 }
 
-void GccController::UpdateNoiseEstimate(double residual,
-                                           double ts_delta,
-                                           bool stable_state) {
-  if (!stable_state) {
-    return;
-  }
-  // Faster filter during startup to faster adapt to the jitter level
-  // of the network. |alpha| is tuned for 30 frames per second, but is scaled
-  // according to |ts_delta|.
-  double alpha = 0.01;
-  if (num_of_deltas_ > 10 * 30) {
-    alpha = 0.002;
-  }
-  // Only update the noise estimate if we're not over-using. |beta| is a
-  // function of alpha and the time delta since the previous update.
-  const double beta = pow(1 - alpha, ts_delta * 30.0 / 1000.0);
-  avg_noise_ = beta * avg_noise_ + (1 - beta) * residual;
-  var_noise_ = beta * var_noise_ +
-               (1 - beta) * (avg_noise_ - residual) * (avg_noise_ - residual);
-  if (var_noise_ < 1) {
-    var_noise_ = 1;
-  }
-}
-
 void GccController::UpdateThreshold(double modified_offset, int64_t now_ms){
-
-  if (ut_last_update_ms_ == -1)
-    ut_last_update_ms_ = now_ms;
-
-  if (fabs(modified_offset) > threshold_ + kMaxAdaptOffsetMs) {
-    // Avoid adapting the threshold to big latency spikes, caused e.g.,
-    // by a sudden capacity drop.
-    ut_last_update_ms_ = now_ms;
-    return;
-  }
-
-  const double k = fabs(modified_offset) < threshold_ ? k_down_ : k_up_;
-  const int64_t kMaxTimeDeltaMs = 100;
-  int64_t time_delta_ms = std::min(now_ms - ut_last_update_ms_, kMaxTimeDeltaMs);
-  threshold_ += k * (fabs(modified_offset) - threshold_) * time_delta_ms;
-  threshold_ = rtc::SafeClamp(threshold_, 6.f, 600.f);
-  ut_last_update_ms_ = now_ms;
-	
+  gccUpdateThreshold(config_, modified_offset, now_ms, threshold_, ut_last_update_ms_);
 }
 
 char GccController::State() const {
@@ -968,49 +1250,19 @@ char GccController::OveruseDetectorDetect(double offset, double ts_delta, int nu
     return 'N';
   }
 
-	
-  const double T = std::min(num_of_deltas, kMinNumDeltas) * offset;
-  if (T > threshold_) {
-    if (time_over_using_ == -1) {
-      // Initialize the timer. Assume that we've been
-      // over-using half of the time since the previous
-      // sample.
-      time_over_using_ = ts_delta / 2;
-    } else {
-      // Increment timer
-      time_over_using_ += ts_delta;
-    }
-    overuse_counter_++;
-
-    if (time_over_using_ > overusing_time_threshold_ && overuse_counter_ > 1) {
-      if (offset >= D_prev_offset_) {
-        time_over_using_ = 0;
-        overuse_counter_ = 0;
-        D_hypothesis_ = 'O';
-	
-      }
-    }
-  } else if (T < -threshold_) {
-    time_over_using_ = -1;
-    overuse_counter_ = 0;
-    D_hypothesis_ = 'U';
-  } else {
-    time_over_using_ = -1;
-    overuse_counter_ = 0;
-    D_hypothesis_ = 'N';
-	
-  }
-  D_prev_offset_ = offset;
-
+  const double T = gccModifiedOffset(config_, num_of_deltas, offset);
+  D_hypothesis_ = gccDetect(config_, T, offset, ts_delta, threshold_, D_hypothesis_,
+                            time_over_using_, overuse_counter_, D_prev_offset_);
 
   UpdateThreshold(T, now_ms);
+  if (observer_ != NULL) {
+    observer_->onDetectorUpdate(T, threshold_, D_hypothesis_);
+  }
 
-    
 
   return D_hypothesis_;
 
 }
 
 
-
 }
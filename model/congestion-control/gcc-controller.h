@@ -29,6 +29,9 @@
 #define GCC_CONTROLLER_H
 
 #include "sender-based-controller.h"
+#include "probe-controller.h"
+#include "alr-detector.h"
+#include "gcc-config.h"
 #include <sstream>
 #include <cassert>
 #include <math.h>
@@ -48,6 +51,42 @@
 
 namespace rmcat {
 
+/**
+ * Receives the internal state of a #GccController as it is updated, e.g.,
+ * to feed ns-3 trace sources. The controller only calls the observer from
+ * within its process* calls, and does nothing if no observer is set
+ */
+class GccObserver
+{
+public:
+    virtual ~GccObserver() {}
+
+    /**
+     * Output of the overuse detector, for every group of packets
+     *
+     * @param [in] offsetMs Delay-gradient offset estimate, scaled by the
+     *                      number of deltas as compared to the threshold
+     * @param [in] thresholdMs Adaptive threshold of the detector
+     * @param [in] hypothesis 'O' (overusing), 'N' (normal) or 'U' (underusing)
+     */
+    virtual void onDetectorUpdate(double offsetMs, double thresholdMs, char hypothesis) = 0;
+
+    /**
+     * State of the delay-based rate control, after every update
+     *
+     * @param [in] state 'H' (hold), 'I' (increase) or 'D' (decrease)
+     * @param [in] region 'M' (max unknown) or 'N' (near max)
+     */
+    virtual void onRateControlUpdate(char state, char region) = 0;
+
+    /**
+     * New loss fraction fed to the loss-based controller
+     *
+     * @param [in] lossFraction Fraction of packets lost, in [0, 1]
+     */
+    virtual void onLossFraction(float lossFraction) = 0;
+};
+
 /**
  * Simplistic implementation of a sender-based congestion controller. The
  * algorithm simply returns a constant, hard-coded bandwidth when queried.
@@ -55,8 +94,12 @@ namespace rmcat {
 class GccController: public SenderBasedController
 {
 public:
-    /** Class constructor */
-    GccController();
+    /**
+     * Class constructor
+     *
+     * @param [in] config Tunable parameters of the controller
+     */
+    explicit GccController(const GccConfig& config = GccConfig());
 
     /** Class destructor */
     virtual ~GccController();
@@ -74,6 +117,15 @@ public:
      */
     virtual void reset();
 
+    /**
+     * GCC's implementation of the #processSendPacket API: media packets
+     * (not probes) also feed the application-limited region detector
+     */
+    virtual bool processSendPacket(uint64_t txTimestampUs,
+                                   uint16_t sequence,
+                                   uint32_t size,
+                                   int probeClusterId=0);
+
     /**
      * Simplistic implementation of feedback packet processing. It simply
      * prints calculated metrics at regular intervals
@@ -95,6 +147,93 @@ public:
 
 	virtual uint32_t getSendBps() const;	
 
+    /**
+     * GCC's implementation of the #getProbeCluster API: probe clusters at
+     * start-up, exponential probing while the probes get through, and a
+     * recovery probe after large drops of the estimate
+     */
+    virtual bool getProbeCluster(uint64_t nowUs, ProbeCluster& cluster);
+
+    /**
+     * GCC's implementation of the #processRemb API: the receiver's estimate
+     * replaces the sender-side delay-based estimate, and drives the
+     * loss-based controller
+     */
+    virtual void processRemb(uint64_t nowUs, uint32_t bitrateBps);
+
+    /**
+     * GCC's implementation of the #processReceiverReport API: the RTT
+     * drives the rate control's response times. The reported loss feeds
+     * the loss-based controller, unless per-packet feedback already does
+     */
+    virtual void processReceiverReport(uint64_t nowUs,
+                                       uint64_t rttUs,
+                                       uint8_t fractionLost,
+                                       uint32_t packetsExpected);
+
+    /**
+     * GCC's implementation of the #processTimer API: after the configured
+     * number of feedback intervals without any feedback for packets in
+     * flight (e.g., feedback lost on a congested reverse path), the
+     * estimate is backed off, and again every second while the feedback
+     * stays away. Once feedback resumes, the estimate ramps up from the
+     * backed-off rate. Off by default (see #GccConfig)
+     */
+    virtual void processTimer(uint64_t nowUs);
+
+    /** True if the feedback timeout is configured */
+    virtual bool usesTimer() const;
+
+    /**
+     * Restart the feedback timeout (see #processTimer ), e.g., when the
+     * flow resumes after a pause: the time without feedback counts from now
+     *
+     * @param [in] nowUs Current time, in microseconds
+     */
+    void restartFeedbackTimeout(uint64_t nowUs);
+
+    /**
+     * Override one of the parameters of the controller, e.g., when tuning
+     * them offline. See #GccConfig for the names
+     *
+     * @param [in] name Name of the parameter
+     * @param [in] value New value of the parameter
+     *
+     * @retval false if the name is unknown or the value out of range
+     */
+    bool setParameter(const std::string& name, double value);
+
+    /**
+     * Replace all the parameters of the controller. The initial state of
+     * the estimator and detector only changes if no feedback was received
+     *
+     * @param [in] config Tunable parameters of the controller
+     */
+    void setConfig(const GccConfig& config);
+
+    /** Current parameters of the controller */
+    const GccConfig& getConfig() const;
+
+    /**
+     * Set the observer of the controller's internal state, NULL for none.
+     * The controller does not own the observer
+     *
+     * @param [in] observer Observer, called on every update of the state
+     */
+    void setObserver(GccObserver* observer);
+
+    /**
+     * GCC's implementation of the #getLossFraction API: the loss fraction
+     * last fed to the loss-based controller
+     */
+    virtual float getLossFraction() const;
+
+    /** GCC's implementation of the #saveState API */
+    virtual void saveState(std::ostream& os) const;
+
+    /** GCC's implementation of the #restoreState API */
+    virtual bool restoreState(std::istream& is);
+
 /*Overuse Estimator Function */
     void OveruseEstimatorUpdate(int64_t t_delta, double ts_delta, int size_delta, char current_hypothesis, int64_t now_ms);
 	
@@ -140,7 +279,6 @@ public:
 private:
 /*Overuse Estimator Function */
     double UpdateMinFramePeriod(double ts_delta);
-    void UpdateNoiseEstimate(double residual, double ts_delta, bool stable_state);
 
 /*Overuse Detector Function */
     void UpdateThreshold(double modified_offset, int64_t now_ms);
@@ -157,6 +295,19 @@ private:
 
     void updateMetrics();
     void logStats(uint64_t nowUs) const;
+    void ConfigureBitrates(int64_t now_ms);
+
+/*Active probing Function */
+    void ApplyProbeResult(uint32_t probe_bitrate_bps, int64_t now_ms);
+
+/*ALR Function */
+    void CapIncreaseInAlr(uint32_t prev_bitrate_bps);
+
+/*ECN Function */
+    void UpdateEcn(uint8_t ecn, int64_t now_ms);
+
+/*Feedback timeout Function */
+    void OnFeedbackResumed(int64_t now_ms);
 
 /*Loss Based Rate controller Function*/
   bool IsInStartPhase(int64_t now_ms) const;
@@ -165,8 +316,12 @@ private:
 
 /* private variables */
 
+    GccConfig config_;
+    GccObserver* observer_;
+
     uint64_t m_lastTimeCalcUs;
     bool m_lastTimeCalcValid;
+    bool m_feedbackLoss; /**< loss is measured from per-packet feedback rather than RTCP reports */
 
     uint64_t m_QdelayUs; /**< estimated queuing delay in microseconds */
     uint32_t m_Pkt;
@@ -184,15 +339,11 @@ private:
     double offset_;
     double prev_offset_;
     double E_[2][2];
-    double process_noise_[2];
     double avg_noise_;
     double var_noise_;
     std::deque<double> ts_delta_hist_;
 
 /*Overuse Detector variable*/
-    double k_up_;
-    double k_down_;
-    double overusing_time_threshold_;
     double threshold_;
     int64_t last_update_ms_;
     int64_t ut_last_update_ms_;
@@ -214,7 +365,6 @@ private:
     int64_t time_last_bitrate_change_;
     int64_t time_first_incoming_estimate_;
     bool bitrate_is_initialized_;
-    float beta_;
     int64_t rtt_;
     bool in_experiment_;
     bool smoothing_experiment_;
@@ -246,10 +396,21 @@ private:
   	int initially_lost_packets_;
   	int bitrate_at_2_seconds_kbps_;
  	int64_t last_rtc_event_log_ms_;
-  	bool in_timeout_experiment_;
-  	float low_loss_threshold_;
-  	float high_loss_threshold_;
-  	uint32_t bitrate_threshold_bps_;
+  	bool in_feedback_timeout_;     // backed off, no feedback since
+  	int64_t first_unacked_send_ms_; // first packet sent since the last feedback
+
+/*Active probing variable*/
+    ProbeController probe_controller_;
+    ProbeBitrateEstimator probe_bitrate_estimator_;
+
+/*ALR variable: no estimate increase while application-limited*/
+    AlrDetector alr_detector_;
+
+/*ECN variable: scalable (L4S-style) response to CE marks*/
+    double ecn_alpha_;           /**< smoothed fraction of CE-marked packets */
+    uint32_t ecn_packets_;       /**< ECN-capable packets in the current window */
+    uint32_t ecn_marked_;        /**< CE-marked packets in the current window */
+    int64_t ecn_window_start_ms_;
 
 };
 
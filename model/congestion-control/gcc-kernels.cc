@@ -0,0 +1,278 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Delay-based GCC update steps for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "gcc-kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "ns3/safe_minmax.h"
+
+namespace rmcat {
+
+static void UpdateNoiseEstimate(const GccConfig& config, double residual, double ts_delta,
+                                uint16_t num_of_deltas, double& avg_noise, double& var_noise) {
+  // Faster filter during startup to faster adapt to the jitter level
+  // of the network. |alpha| is tuned for 30 frames per second, but is scaled
+  // according to |ts_delta|.
+  double alpha = config.noiseAlphaStartup;
+  if (num_of_deltas > config.noiseStartupDeltas) {
+    alpha = config.noiseAlpha;
+  }
+  // Only update the noise estimate if we're not over-using. |beta| is a
+  // function of alpha and the time delta since the previous update.
+  const double beta = pow(1 - alpha, ts_delta * 30.0 / 1000.0);
+  avg_noise = beta * avg_noise + (1 - beta) * residual;
+  var_noise = beta * var_noise +
+              (1 - beta) * (avg_noise - residual) * (avg_noise - residual);
+  if (var_noise < 1) {
+    var_noise = 1;
+  }
+}
+
+void gccEstimatorUpdate(const GccConfig& config, double tTsDelta, double sizeDelta,
+                        double minFramePeriod, uint16_t numDeltas, char hypothesis,
+                        double& slope, double& offset, double& prevOffset,
+                        double E[2][2], double& avgNoise, double& varNoise) {
+  // Update the Kalman filter.
+  E[0][0] += config.processNoiseSlope;
+  E[1][1] += config.processNoiseOffset;
+
+  if ((hypothesis == 'O' && offset < prevOffset) ||
+      (hypothesis == 'U' && offset > prevOffset)) {
+    E[1][1] += 10 * config.processNoiseOffset;
+  }
+
+  const double h[2] = {sizeDelta, 1.0};
+  const double Eh[2] = {E[0][0] * h[0] + E[0][1] * h[1],
+                        E[1][0] * h[0] + E[1][1] * h[1]};
+
+  const double residual = tTsDelta - slope * h[0] - offset;
+
+  const bool in_stable_state = (hypothesis == 'N');
+  const double max_residual = 3.0 * sqrt(varNoise);
+
+  // We try to filter out very late frames. For instance periodic key
+  // frames doesn't fit the Gaussian model well.
+  if (in_stable_state) {
+    UpdateNoiseEstimate(config,
+                        fabs(residual) < max_residual ? residual :
+                        (residual < 0 ? -max_residual : max_residual),
+                        minFramePeriod, numDeltas, avgNoise, varNoise);
+  }
+
+  const double denom = varNoise + h[0] * Eh[0] + h[1] * Eh[1];
+
+  const double K[2] = {Eh[0] / denom, Eh[1] / denom};
+
+  const double IKh[2][2] = {{1.0 - K[0] * h[0], -K[0] * h[1]},
+                            {-K[1] * h[0], 1.0 - K[1] * h[1]}};
+  const double e00 = E[0][0];
+  const double e01 = E[0][1];
+
+  // Update state.
+  E[0][0] = e00 * IKh[0][0] + E[1][0] * IKh[0][1];
+  E[0][1] = e01 * IKh[0][0] + E[1][1] * IKh[0][1];
+  E[1][0] = e00 * IKh[1][0] + E[1][0] * IKh[1][1];
+  E[1][1] = e01 * IKh[1][0] + E[1][1] * IKh[1][1];
+
+  // The covariance matrix must be positive semi-definite.
+  const bool positive_semi_definite =
+      E[0][0] + E[1][1] >= 0 &&
+      E[0][0] * E[1][1] - E[0][1] * E[1][0] >= 0 && E[0][0] >= 0;
+  assert(positive_semi_definite);
+  (void) positive_semi_definite;
+
+  slope = slope + K[0] * residual;
+  prevOffset = offset;
+  offset = offset + K[1] * residual;
+}
+
+char gccDetect(const GccConfig& config, double modifiedOffset, double offset,
+               double tsDelta, double threshold, char hypothesis,
+               double& timeOverUsing, int& overuseCounter, double& prevOffset) {
+  const double T = modifiedOffset;
+  if (T > threshold) {
+    if (timeOverUsing == -1) {
+      // Initialize the timer. Assume that we've been
+      // over-using half of the time since the previous
+      // sample.
+      timeOverUsing = tsDelta / 2;
+    } else {
+      // Increment timer
+      timeOverUsing += tsDelta;
+    }
+    overuseCounter++;
+
+    if (timeOverUsing > config.overusingTimeThresholdMs && overuseCounter > 1) {
+      if (offset >= prevOffset) {
+        timeOverUsing = 0;
+        overuseCounter = 0;
+        hypothesis = 'O';
+      }
+    }
+  } else if (T < -threshold) {
+    timeOverUsing = -1;
+    overuseCounter = 0;
+    hypothesis = 'U';
+  } else {
+    timeOverUsing = -1;
+    overuseCounter = 0;
+    hypothesis = 'N';
+  }
+  prevOffset = offset;
+  return hypothesis;
+}
+
+double gccModifiedOffset(const GccConfig& config, int numDeltas, double offset) {
+  return std::min<double>(numDeltas, config.minNumDeltas) * offset;
+}
+
+void gccUpdateThreshold(const GccConfig& config, double modifiedOffset, int64_t nowMs,
+                        double& threshold, int64_t& lastUpdateMs) {
+  if (lastUpdateMs == -1)
+    lastUpdateMs = nowMs;
+
+  if (fabs(modifiedOffset) > threshold + config.maxAdaptOffsetMs) {
+    // Avoid adapting the threshold to big latency spikes, caused e.g.,
+    // by a sudden capacity drop.
+    lastUpdateMs = nowMs;
+    return;
+  }
+
+  const double k = fabs(modifiedOffset) < threshold ? config.kDown : config.kUp;
+  const int64_t kMaxTimeDeltaMs = 100;
+  int64_t time_delta_ms = std::min(nowMs - lastUpdateMs, kMaxTimeDeltaMs);
+  threshold += k * (fabs(modifiedOffset) - threshold) * time_delta_ms;
+  threshold = rtc::SafeClamp(threshold, config.minThresholdMs, config.maxThresholdMs);
+  lastUpdateMs = nowMs;
+}
+
+void gccInitializeBitrate(const GccConfig& config, uint32_t incomingBps, int64_t nowMs,
+                          bool& initialized, int64_t& timeFirstIncomingMs,
+                          uint32_t& bitrateBps) {
+  // Set the initial bit rate value to what we're receiving the first half
+  // second.
+  // TODO(bugs.webrtc.org/9379): The comment above doesn't match to the code.
+  if (initialized) {
+    return;
+  }
+  if (timeFirstIncomingMs < 0) {
+    if (incomingBps)
+      timeFirstIncomingMs = nowMs;
+  } else if (nowMs - timeFirstIncomingMs > config.initializationTimeMs &&
+             incomingBps > 0) {
+    bitrateBps = incomingBps;
+    initialized = true;
+  }
+}
+
+int64_t gccReductionIntervalMs(int64_t rttMs) {
+  return std::max<int64_t>(std::min<int64_t>(rttMs, 200), 10);
+}
+
+void gccChangeState(char hypothesis, int64_t nowMs, char& state,
+                    int64_t& timeLastChangeMs) {
+  switch (hypothesis) {
+    case 'N':
+      if (state == 'H') {
+        timeLastChangeMs = nowMs;
+        state = 'I';
+      }
+      break;
+    case 'O':
+      if (state != 'D') {
+        state = 'D';
+      }
+      break;
+    case 'U':
+      state = 'H';
+      break;
+    default:
+      assert(false);
+  }
+}
+
+int gccNearMaxIncreaseRateBps(const GccConfig& config, uint32_t bitrateBps,
+                              int64_t responseTimeMs) {
+  double bits_per_frame = static_cast<double>(bitrateBps) / 30.0;
+  double packets_per_frame = std::ceil(bits_per_frame / (8.0 * 1200.0));
+  double avg_packet_size_bits = bits_per_frame / packets_per_frame;
+
+  return static_cast<int>(std::max(
+      config.minIncreaseRateBps, (avg_packet_size_bits * 1000) / responseTimeMs));
+}
+
+uint32_t gccMultiplicativeIncreaseBps(const GccConfig& config, int64_t nowMs,
+                                      int64_t lastMs, uint32_t bitrateBps) {
+  double alpha = config.increaseFactor;
+  if (lastMs > -1) {
+    auto time_since_last_update_ms =
+        rtc::SafeMin<int64_t>(nowMs - lastMs, 1000);
+    alpha = pow(alpha, time_since_last_update_ms / 1000.0);
+  }
+  uint32_t multiplicative_increase_bps =
+      std::max(bitrateBps * (alpha - 1.0), 1000.0);
+  return multiplicative_increase_bps;
+}
+
+uint32_t gccClampToIncoming(uint32_t newBitrateBps, uint32_t bitrateBps,
+                            uint32_t incomingBps) {
+  // Don't change the bit rate if the send side is too far off.
+  // We allow a bit more lag at very low rates to not too easily get stuck if
+  // the encoder produces uneven outputs.
+  const uint32_t max_bitrate_bps =
+      static_cast<uint32_t>(1.5f * incomingBps) + 10000;
+  if (newBitrateBps > bitrateBps && newBitrateBps > max_bitrate_bps) {
+    newBitrateBps = std::max(bitrateBps, max_bitrate_bps);
+  }
+  return newBitrateBps;
+}
+
+void gccUpdateMaxBitrateEstimate(const GccConfig& config, float incomingKbps,
+                                 float& avgMaxKbps, float& varMaxKbps) {
+  const float alpha = config.maxBitrateAlpha;
+  if (avgMaxKbps == -1.0f) {
+    avgMaxKbps = incomingKbps;
+  } else {
+    avgMaxKbps = (1 - alpha) * avgMaxKbps + alpha * incomingKbps;
+  }
+  // Estimate the max bit rate variance and normalize the variance
+  // with the average max bit rate.
+  const float norm = std::max(avgMaxKbps, 1.0f);
+  varMaxKbps = (1 - alpha) * varMaxKbps +
+               alpha * (avgMaxKbps - incomingKbps) * (avgMaxKbps - incomingKbps) / norm;
+  // 0.4 ~= 14 kbit/s at 500 kbit/s
+  if (varMaxKbps < 0.4f) {
+    varMaxKbps = 0.4f;
+  }
+  // 2.5f ~= 35 kbit/s at 500 kbit/s
+  if (varMaxKbps > 2.5f) {
+    varMaxKbps = 2.5f;
+  }
+}
+
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Delay-based GCC update steps for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef GCC_KERNELS_H
+#define GCC_KERNELS_H
+
+#include "gcc-config.h"
+#include <cstdint>
+
+namespace rmcat {
+
+/*
+ * The per-flow steps of GCC's delay-based estimation (overuse estimator,
+ * overuse detector and AIMD rate control), on state passed by reference.
+ * #GccController keeps that state in member variables and
+ * #GccBatchEngine in per-flow arrays; both run these functions, so that
+ * their math is the same by construction.
+ */
+
+/**
+ * Kalman filter update of the overuse estimator, with the noise estimate
+ *
+ * @param [in] config GCC parameters
+ * @param [in] tTsDelta Inter-arrival minus inter-departure time, in ms
+ * @param [in] sizeDelta Size difference of the packet groups, in bytes
+ * @param [in] minFramePeriod Minimal inter-departure time of the recent groups, in ms
+ * @param [in] numDeltas Number of deltas so far, this one included
+ * @param [in] hypothesis Current detector state ('O', 'N' or 'U')
+ * @param [in,out] slope, offset, prevOffset, E, avgNoise, varNoise Estimator state
+ */
+void gccEstimatorUpdate(const GccConfig& config, double tTsDelta, double sizeDelta,
+                        double minFramePeriod, uint16_t numDeltas, char hypothesis,
+                        double& slope, double& offset, double& prevOffset,
+                        double E[2][2], double& avgNoise, double& varNoise);
+
+/**
+ * Overuse detector state machine, on the offset scaled by the number of
+ * deltas (see #gccModifiedOffset ). Uses the threshold before adaptation
+ *
+ * @retval the new detector state ('O', 'N' or 'U')
+ */
+char gccDetect(const GccConfig& config, double modifiedOffset, double offset,
+               double tsDelta, double threshold, char hypothesis,
+               double& timeOverUsing, int& overuseCounter, double& prevOffset);
+
+/** Offset as compared to the detector's threshold */
+double gccModifiedOffset(const GccConfig& config, int numDeltas, double offset);
+
+/** Adaptive threshold of the overuse detector */
+void gccUpdateThreshold(const GccConfig& config, double modifiedOffset, int64_t nowMs,
+                        double& threshold, int64_t& lastUpdateMs);
+
+/**
+ * Start the rate control from the receive rate, once it has been known
+ * for a while
+ */
+void gccInitializeBitrate(const GccConfig& config, uint32_t incomingBps, int64_t nowMs,
+                          bool& initialized, int64_t& timeFirstIncomingMs,
+                          uint32_t& bitrateBps);
+
+/** Time between two reductions of the rate while overusing, in ms */
+int64_t gccReductionIntervalMs(int64_t rttMs);
+
+/** Rate control state ('H', 'I' or 'D') transition on a detector state */
+void gccChangeState(char hypothesis, int64_t nowMs, char& state,
+                    int64_t& timeLastChangeMs);
+
+/**
+ * Additive increase rate near the maximal rate: about one packet
+ * per response time
+ */
+int gccNearMaxIncreaseRateBps(const GccConfig& config, uint32_t bitrateBps,
+                              int64_t responseTimeMs);
+
+/** Multiplicative increase since the last rate change */
+uint32_t gccMultiplicativeIncreaseBps(const GccConfig& config, int64_t nowMs,
+                                      int64_t lastMs, uint32_t bitrateBps);
+
+/** Keep an increased rate from getting too far ahead of the receive rate */
+uint32_t gccClampToIncoming(uint32_t newBitrateBps, uint32_t bitrateBps,
+                            uint32_t incomingBps);
+
+/** Average and normalized variance of the receive rate at overuse */
+void gccUpdateMaxBitrateEstimate(const GccConfig& config, float incomingKbps,
+                                 float& avgMaxKbps, float& varMaxKbps);
+
+}
+
+#endif /* GCC_KERNELS_H */
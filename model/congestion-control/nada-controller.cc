@@ -87,17 +87,34 @@ const float NADA_PARAM_LAMBDA = 0.5; /**< Exponent of the non-linear warping (di
  */
 const float NADA_PARAM_DLOSS = 10.;
 const float NADA_PARAM_PLRREF = 0.01; /**> Reference packet loss ratio (dimensionless) */
+/**
+ * Reference delay penalty (in ms) in terms of value
+ * of congestion price when packet marking ratio is at PMRREF
+ */
+const float NADA_PARAM_DMARK = 2.;
+const float NADA_PARAM_PMRREF = 0.02; /**> Reference packet marking ratio (dimensionless) */
 const float NADA_PARAM_XMAX = 500.; /**> Maximum value of aggregate congestion signal (in ms) */
 
 /** Smoothing factor in exponential smoothing of packet loss and marking ratios */
 const float NADA_PARAM_ALPHA = 0.1;
 
+/** Tag and version of the saved controller state */
+const char* NADA_STATE_TAG = "nada-controller";
+const int NADA_STATE_VERSION = 2;
+
+/** ECN codepoints (RFC 3168), as carried in the feedback */
+const uint8_t NADA_ECN_NOT_ECT = 0x0;
+const uint8_t NADA_ECN_CE = 0x3;
+
 namespace rmcat {
 
 NadaController::NadaController() :
     SenderBasedController{},
     m_ploss{0},
     m_plr{0.f},
+    m_pmr{0.f},
+    m_ectPkts{0},
+    m_markedPkts{0},
     m_warpMode{false},
     m_lastTimeCalcUs{0},
     m_lastTimeCalcValid{false},
@@ -124,6 +141,9 @@ void NadaController::setCurrentBw(float newBw) {
 void NadaController::reset() {
     m_ploss = 0;
     m_plr = 0.f;
+    m_pmr = 0.f;
+    m_ectPkts = 0;
+    m_markedPkts = 0;
     m_warpMode = false;
     m_lastTimeCalcUs = 0;
     m_lastTimeCalcValid = false;
@@ -142,8 +162,6 @@ void NadaController::reset() {
 /**
  * Implementation of the #processFeedback API
  * in the SenderBasedController class
- *
- * TODO (deferred): Add support for ECN marking
  */
 bool NadaController::processFeedback(uint64_t nowUs,
                                      uint16_t sequence,
@@ -162,10 +180,19 @@ bool NadaController::processFeedback(uint64_t nowUs,
                                                 l_inter_departure,
                                                 l_inter_delay_var,
 												l_inter_group_size,
+                                                l_arrival_time,
                                                 ecn)) {
         return false;
     }
 
+    /* Account for ECN marking of ECN-capable packets */
+    if (ecn != NADA_ECN_NOT_ECT) {
+        ++m_ectPkts;
+        if (ecn == NADA_ECN_CE) {
+            ++m_markedPkts;
+        }
+    }
+
     /* Update calculation of reference rate (r_ref)
      * if last calculation occurred more than NADA_PARAM_DELTA
      * (target update interval in ms) ago
@@ -205,6 +232,42 @@ uint32_t NadaController::getSendBps() const{
 	return 0;
 }
 
+void NadaController::saveState(std::ostream& os) const {
+    SenderBasedController::saveState(os);
+    os << NADA_STATE_TAG << " " << NADA_STATE_VERSION << "\n";
+    os << m_ploss << " " << m_plr << " " << m_pmr << " "
+       << m_ectPkts << " " << m_markedPkts << " " << m_warpMode << " "
+       << m_lastTimeCalcUs << " " << m_lastTimeCalcValid << " "
+       << m_currBw << " " << m_QdelayUs << " " << m_RttUs << " "
+       << m_Xcurr << " " << m_Xprev << " " << m_RecvR << " "
+       << m_avgInt << " " << m_currInt << " " << m_lossesSeen << "\n";
+}
+
+bool NadaController::restoreState(std::istream& is) {
+    if (!SenderBasedController::restoreState(is)) {
+        return false;
+    }
+    std::string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != NADA_STATE_TAG || version != NADA_STATE_VERSION) {
+        std::cerr << "NadaController::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    is >> m_ploss >> m_plr >> m_pmr
+       >> m_ectPkts >> m_markedPkts >> m_warpMode
+       >> m_lastTimeCalcUs >> m_lastTimeCalcValid
+       >> m_currBw >> m_QdelayUs >> m_RttUs
+       >> m_Xcurr >> m_Xprev >> m_RecvR
+       >> m_avgInt >> m_currInt >> m_lossesSeen;
+    if (!is) {
+        std::cerr << "NadaController::restoreState,"
+                  << " truncated or corrupted state" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 /**
  * The following implements the core congestion
  * control algorithm as specified in the rmcat-nada
@@ -255,6 +318,14 @@ void NadaController::updateMetrics(uint64_t nowUs) {
         m_plr += NADA_PARAM_ALPHA * (plr - m_plr);
     }
 
+    if (m_ectPkts > 0) {
+        // Exponential filtering of marking stats
+        const float pmr = float(m_markedPkts) / float(m_ectPkts);
+        m_pmr += NADA_PARAM_ALPHA * (pmr - m_pmr);
+        m_ectPkts = 0;
+        m_markedPkts = 0;
+    }
+
     float avgInt;
     uint16_t currentInt;
     bool avgIntOK = getLossIntervalInfo(avgInt, currentInt);
@@ -287,6 +358,7 @@ void NadaController::logStats(uint64_t nowUs) const {
        << " rtt: "    << (m_RttUs / 1000)
        << " ploss: "  << m_ploss
        << " plr: "    << m_plr
+       << " pmr: "    << m_pmr
        << " xcurr: "  << m_Xcurr
        << " rrate: "  << m_RecvR
        << " srate: "  << m_currBw
@@ -375,6 +447,10 @@ void NadaController::updateXcurr() {
     float plr0 = m_plr / NADA_PARAM_PLRREF;
     m_Xcurr += NADA_PARAM_DLOSS * plr0 * plr0;
 
+    /* Likewise, add the ECN marking penalty (Eq.(2)) */
+    float pmr0 = m_pmr / NADA_PARAM_PMRREF;
+    m_Xcurr += NADA_PARAM_DMARK * pmr0 * pmr0;
+
     /* Clip final congestion signal within range */
     if (m_Xcurr > NADA_PARAM_XMAX) {
         m_Xcurr = NADA_PARAM_XMAX;
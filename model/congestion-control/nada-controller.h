@@ -79,6 +79,12 @@ public:
     virtual float getBandwidth(uint64_t nowUs) const;
 	virtual uint32_t getSendBps() const;
 
+    /** NADA's implementation of the #saveState API */
+    virtual void saveState(std::ostream& os) const;
+
+    /** NADA's implementation of the #restoreState API */
+    virtual bool restoreState(std::istream& is);
+
 private:
 
     /**
@@ -171,6 +177,9 @@ private:
      */
     uint32_t m_ploss; /**< packet loss count within configured window */
     float m_plr;     /**< packet loss ratio within packet history window */
+    float m_pmr;     /**< smoothed ratio of ECN-capable packets marked CE */
+    uint32_t m_ectPkts;    /**< ECN-capable packets since the last rate update */
+    uint32_t m_markedPkts; /**< CE-marked packets since the last rate update */
     bool m_warpMode;  /**< whether to perform non-linear warping of queuing delay */
 
     /** timestamp of when r_ref is last calculated (t_last in rmcat-nada), in microseconds  */
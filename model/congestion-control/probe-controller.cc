@@ -0,0 +1,390 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Active bandwidth probing (probe controller and probe bitrate estimator)
+ * implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "probe-controller.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+namespace rmcat {
+
+/* Probe controller tunables (same values as WebRTC's) */
+static const double kInitialProbeFactor1 = 3.;       /**< first start-up cluster, x start bitrate */
+static const double kInitialProbeFactor2 = 6.;       /**< second start-up cluster, x start bitrate */
+static const double kFurtherProbeFactor = 2.;        /**< exponential probing, x last result */
+static const double kRepeatedProbeMinRatio = 0.7;    /**< result/probed rate to keep probing */
+static const int64_t kMaxWaitingTimeForProbingResultMs = 1000;
+static const double kBitrateDropThreshold = 0.66;    /**< estimate ratio that counts as large drop */
+static const int64_t kBitrateDropTimeoutMs = 5000;   /**< recovery probes only this soon after a drop */
+static const int64_t kRecoveryProbeDelayMs = 1000;   /**< let queues drain before probing again */
+static const int64_t kMinTimeBetweenRecoveryProbesMs = 5000;
+static const double kProbeFractionAfterDrop = 0.85;  /**< recovery probe, x estimate before the drop */
+static const int64_t kAlrProbingIntervalMs = 5000;   /**< periodic probes while application-limited */
+static const double kAlrProbeFactor = 2.;            /**< ALR probes, x estimate */
+static const uint32_t kMinProbePackets = 5;          /**< minimal number of packets in a cluster */
+static const int64_t kMinProbeDurationMs = 15;       /**< minimal duration of a cluster */
+static const size_t kMaxIssuedClusters = 16;         /**< clusters kept for #getCluster */
+
+/* Probe bitrate estimator tunables */
+static const double kMinReceivedProbesRatio = 0.8;
+static const double kMinReceivedBytesRatio = 0.8;
+static const double kMaxValidRatio = 2.;             /**< receive rate/send rate above this is bogus */
+static const double kMinRatioForUnsaturatedLink = 0.9;
+static const double kTargetUtilizationFraction = 0.95;
+static const uint64_t kMaxClusterHistoryUs = 1000 * 1000;
+static const uint64_t kMaxProbeIntervalUs = 1000 * 1000;
+
+static const char* kProbeControllerStateTag = "probe-controller";
+static const char* kProbeEstimatorStateTag = "probe-estimator";
+static const int kProbeStateVersion = 2;
+
+ProbeController::ProbeController() {
+    reset();
+}
+
+void ProbeController::reset() {
+    m_state = STATE_INIT;
+    m_minBps = 0;
+    m_maxBps = 0;
+    m_estimatedBps = 0;
+    m_minBpsToProbeFurther = 0;
+    m_timeLastProbingMs = -1;
+    m_bpsBeforeLastLargeDrop = 0;
+    m_timeOfLastLargeDropMs = -1;
+    m_timeLastRecoveryProbeMs = -1;
+    m_alrStartMs = -1;
+    m_nextClusterId = 1;
+    m_pending.clear();
+    m_issued.clear();
+}
+
+void ProbeController::setBitrates(uint32_t minBps, uint32_t startBps,
+                                  uint32_t maxBps, int64_t nowMs) {
+    if (m_state != STATE_INIT) {
+        return;
+    }
+    m_minBps = minBps;
+    m_maxBps = maxBps;
+    m_estimatedBps = startBps;
+    initiateProbing(nowMs, uint32_t(kInitialProbeFactor1 * startBps), false);
+    initiateProbing(nowMs, uint32_t(kInitialProbeFactor2 * startBps), true);
+}
+
+void ProbeController::setEstimatedBitrate(uint32_t bitrateBps, int64_t nowMs) {
+    if (m_state == STATE_WAITING_RESULT &&
+            m_minBpsToProbeFurther > 0 &&
+            bitrateBps > m_minBpsToProbeFurther) {
+        initiateProbing(nowMs, uint32_t(kFurtherProbeFactor * bitrateBps), true);
+    }
+
+    if (bitrateBps < kBitrateDropThreshold * m_estimatedBps) {
+        m_timeOfLastLargeDropMs = nowMs;
+        m_bpsBeforeLastLargeDrop = m_estimatedBps;
+    }
+    m_estimatedBps = bitrateBps;
+}
+
+void ProbeController::setAlrStartTime(int64_t alrStartMs) {
+    m_alrStartMs = alrStartMs;
+}
+
+void ProbeController::process(int64_t nowMs) {
+    if (m_state == STATE_WAITING_RESULT &&
+            nowMs - m_timeLastProbingMs > kMaxWaitingTimeForProbingResultMs) {
+        // Too late: the estimate has not followed the probes
+        m_state = STATE_DONE;
+        m_minBpsToProbeFurther = 0;
+    }
+
+    if (m_state == STATE_DONE && m_alrStartMs >= 0 && m_estimatedBps > 0 &&
+            nowMs - std::max(m_alrStartMs, m_timeLastProbingMs) >= kAlrProbingIntervalMs) {
+        // The estimate does not grow while application-limited: probe instead
+        initiateProbing(nowMs, uint32_t(kAlrProbeFactor * m_estimatedBps), true);
+    }
+
+    if (m_state != STATE_DONE || m_timeOfLastLargeDropMs < 0) {
+        return;
+    }
+    const int64_t timeSinceDropMs = nowMs - m_timeOfLastLargeDropMs;
+    const uint32_t recoveryBps = uint32_t(kProbeFractionAfterDrop * m_bpsBeforeLastLargeDrop);
+    if (timeSinceDropMs > kBitrateDropTimeoutMs) {
+        m_timeOfLastLargeDropMs = -1;
+        return;
+    }
+    if (timeSinceDropMs >= kRecoveryProbeDelayMs &&
+            m_estimatedBps < recoveryBps &&
+            (m_timeLastRecoveryProbeMs < 0 ||
+             nowMs - m_timeLastRecoveryProbeMs >= kMinTimeBetweenRecoveryProbesMs)) {
+        m_timeLastRecoveryProbeMs = nowMs;
+        m_timeOfLastLargeDropMs = -1;
+        initiateProbing(nowMs, recoveryBps, false);
+    }
+}
+
+bool ProbeController::popCluster(SenderBasedController::ProbeCluster& cluster) {
+    if (m_pending.empty()) {
+        return false;
+    }
+    cluster = m_pending.front();
+    m_pending.pop_front();
+    return true;
+}
+
+bool ProbeController::getCluster(int id, SenderBasedController::ProbeCluster& cluster) const {
+    for (const auto& c : m_issued) {
+        if (c.id == id) {
+            cluster = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProbeController::initiateProbing(int64_t nowMs, uint32_t bitrateBps, bool probeFurther) {
+    if (m_maxBps > 0 && bitrateBps > m_maxBps) {
+        // No point in probing above the max bitrate
+        bitrateBps = m_maxBps;
+        probeFurther = false;
+    }
+    bitrateBps = std::max(bitrateBps, m_minBps);
+
+    SenderBasedController::ProbeCluster cluster{};
+    cluster.id = m_nextClusterId++;
+    if (m_nextClusterId <= 0) {
+        m_nextClusterId = 1; // 0 means "not a probe"
+    }
+    cluster.bitrateBps = bitrateBps;
+    cluster.minPackets = kMinProbePackets;
+    cluster.minBytes = uint32_t(uint64_t(bitrateBps) * kMinProbeDurationMs / 8000);
+    m_pending.push_back(cluster);
+    m_issued.push_back(cluster);
+    if (m_issued.size() > kMaxIssuedClusters) {
+        m_issued.pop_front();
+    }
+
+    m_timeLastProbingMs = nowMs;
+    if (probeFurther) {
+        m_state = STATE_WAITING_RESULT;
+        m_minBpsToProbeFurther = uint32_t(kRepeatedProbeMinRatio * bitrateBps);
+    } else {
+        m_state = STATE_DONE;
+        m_minBpsToProbeFurther = 0;
+    }
+}
+
+static void saveClusters(std::ostream& os,
+                         const std::deque<SenderBasedController::ProbeCluster>& clusters) {
+    os << clusters.size();
+    for (const auto& c : clusters) {
+        os << " " << c.id << " " << c.bitrateBps << " " << c.minPackets << " " << c.minBytes;
+    }
+    os << "\n";
+}
+
+static bool restoreClusters(std::istream& is,
+                            std::deque<SenderBasedController::ProbeCluster>& clusters) {
+    size_t n = 0;
+    if (!(is >> n)) {
+        return false;
+    }
+    clusters.clear();
+    for (size_t i = 0; i < n; ++i) {
+        SenderBasedController::ProbeCluster c{};
+        if (!(is >> c.id >> c.bitrateBps >> c.minPackets >> c.minBytes)) {
+            return false;
+        }
+        clusters.push_back(c);
+    }
+    return true;
+}
+
+void ProbeController::saveState(std::ostream& os) const {
+    os << kProbeControllerStateTag << " " << kProbeStateVersion << "\n";
+    os << int(m_state) << " " << m_minBps << " " << m_maxBps << " "
+       << m_estimatedBps << " " << m_minBpsToProbeFurther << " "
+       << m_timeLastProbingMs << " " << m_bpsBeforeLastLargeDrop << " "
+       << m_timeOfLastLargeDropMs << " " << m_timeLastRecoveryProbeMs << " "
+       << m_alrStartMs << " " << m_nextClusterId << "\n";
+    saveClusters(os, m_pending);
+    saveClusters(os, m_issued);
+}
+
+bool ProbeController::restoreState(std::istream& is) {
+    std::string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != kProbeControllerStateTag ||
+            version != kProbeStateVersion) {
+        std::cerr << "ProbeController::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    int state = STATE_INIT;
+    is >> state >> m_minBps >> m_maxBps
+       >> m_estimatedBps >> m_minBpsToProbeFurther
+       >> m_timeLastProbingMs >> m_bpsBeforeLastLargeDrop
+       >> m_timeOfLastLargeDropMs >> m_timeLastRecoveryProbeMs
+       >> m_alrStartMs >> m_nextClusterId;
+    m_state = State(state);
+    if (!is || !restoreClusters(is, m_pending) || !restoreClusters(is, m_issued)) {
+        std::cerr << "ProbeController::restoreState,"
+                  << " truncated or corrupted state" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ProbeBitrateEstimator::ProbeBitrateEstimator()
+: m_clusters{} {}
+
+void ProbeBitrateEstimator::reset() {
+    m_clusters.clear();
+}
+
+uint32_t ProbeBitrateEstimator::handleProbeFeedback(const SenderBasedController::PacketRecord& packet,
+                                                    const SenderBasedController::ProbeCluster& cluster) {
+    // The one way delay may wrap, but the receive timestamp will be right
+    const uint64_t sendUs = packet.txTimestampUs;
+    const uint64_t recvUs = packet.txTimestampUs + packet.owdUs;
+
+    eraseOldClusters(sendUs);
+
+    auto it = m_clusters.find(cluster.id);
+    if (it == m_clusters.end()) {
+        AggregatedCluster agg{};
+        agg.firstSendUs = sendUs;
+        agg.lastSendUs = sendUs;
+        agg.firstRecvUs = recvUs;
+        agg.lastRecvUs = recvUs;
+        agg.sizeFirstRecv = packet.size;
+        it = m_clusters.insert(std::make_pair(cluster.id, agg)).first;
+    }
+    AggregatedCluster& agg = it->second;
+
+    if (sendUs < agg.firstSendUs) {
+        agg.firstSendUs = sendUs;
+    }
+    if (sendUs >= agg.lastSendUs) {
+        agg.lastSendUs = sendUs;
+        agg.sizeLastSend = packet.size;
+    }
+    if (recvUs < agg.firstRecvUs) {
+        agg.firstRecvUs = recvUs;
+        agg.sizeFirstRecv = packet.size;
+    }
+    if (recvUs > agg.lastRecvUs) {
+        agg.lastRecvUs = recvUs;
+    }
+    agg.sizeTotal += packet.size;
+    ++agg.numProbes;
+
+    const uint32_t minProbes = uint32_t(cluster.minPackets * kMinReceivedProbesRatio);
+    const uint32_t minBytes = uint32_t(cluster.minBytes * kMinReceivedBytesRatio);
+    if (agg.numProbes < minProbes || agg.sizeTotal < minBytes) {
+        return 0;
+    }
+
+    const uint64_t sendIntervalUs = agg.lastSendUs - agg.firstSendUs;
+    const uint64_t recvIntervalUs = agg.lastRecvUs - agg.firstRecvUs;
+    if (sendIntervalUs == 0 || sendIntervalUs > kMaxProbeIntervalUs ||
+            recvIntervalUs == 0 || recvIntervalUs > kMaxProbeIntervalUs) {
+        // Packets bunched up or spread out too much: not a valid measurement
+        return 0;
+    }
+
+    // The size of the last sent packet does not count for the send rate, as
+    // its transmission started at the end of the send interval. Likewise, the
+    // first received packet was already in when the receive interval started
+    assert(agg.sizeTotal >= agg.sizeLastSend && agg.sizeTotal >= agg.sizeFirstRecv);
+    const double sendBps = double(agg.sizeTotal - agg.sizeLastSend) * 8. * 1e6 / sendIntervalUs;
+    const double recvBps = double(agg.sizeTotal - agg.sizeFirstRecv) * 8. * 1e6 / recvIntervalUs;
+
+    if (recvBps > kMaxValidRatio * sendBps) {
+        return 0;
+    }
+    double resBps = std::min(sendBps, recvBps);
+    if (recvBps < kMinRatioForUnsaturatedLink * sendBps) {
+        // The probe saturated the link: the receive rate is the capacity.
+        // Aim slightly below it so that the queue built by the probe drains
+        resBps = kTargetUtilizationFraction * recvBps;
+    }
+    return uint32_t(resBps);
+}
+
+void ProbeBitrateEstimator::eraseOldClusters(uint64_t sendUs) {
+    for (auto it = m_clusters.begin(); it != m_clusters.end();) {
+        if (it->second.lastSendUs + kMaxClusterHistoryUs < sendUs) {
+            it = m_clusters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ProbeBitrateEstimator::saveState(std::ostream& os) const {
+    os << kProbeEstimatorStateTag << " " << kProbeStateVersion << "\n";
+    os << m_clusters.size() << "\n";
+    for (const auto& entry : m_clusters) {
+        const AggregatedCluster& agg = entry.second;
+        os << entry.first << " " << agg.numProbes << " "
+           << agg.firstSendUs << " " << agg.lastSendUs << " "
+           << agg.firstRecvUs << " " << agg.lastRecvUs << " "
+           << agg.sizeLastSend << " " << agg.sizeFirstRecv << " "
+           << agg.sizeTotal << "\n";
+    }
+}
+
+bool ProbeBitrateEstimator::restoreState(std::istream& is) {
+    std::string tag;
+    int version = 0;
+    size_t n = 0;
+    if (!(is >> tag >> version >> n) || tag != kProbeEstimatorStateTag ||
+            version != kProbeStateVersion) {
+        std::cerr << "ProbeBitrateEstimator::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    m_clusters.clear();
+    for (size_t i = 0; i < n; ++i) {
+        int id = 0;
+        AggregatedCluster agg{};
+        if (!(is >> id >> agg.numProbes
+                 >> agg.firstSendUs >> agg.lastSendUs
+                 >> agg.firstRecvUs >> agg.lastRecvUs
+                 >> agg.sizeLastSend >> agg.sizeFirstRecv
+                 >> agg.sizeTotal)) {
+            std::cerr << "ProbeBitrateEstimator::restoreState,"
+                      << " truncated or corrupted state" << std::endl;
+            return false;
+        }
+        m_clusters[id] = agg;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,197 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Active bandwidth probing (probe controller and probe bitrate estimator)
+ * interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef PROBE_CONTROLLER_H
+#define PROBE_CONTROLLER_H
+
+#include "sender-based-controller.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <iosfwd>
+
+namespace rmcat {
+
+/**
+ * Decides when the sender has to send probe clusters, and at which rate.
+ *
+ * A probe cluster is a short burst of packets paced at a rate higher than
+ * the current estimate. Clusters are requested:
+ *  - at start-up: two clusters, at 3x and 6x the start bitrate
+ *  - after a probe result: while the result keeps getting close to the
+ *    probed rate, exponentially (2x the result), up to the max bitrate
+ *  - after a large drop of the estimate: once, to check whether the
+ *    bitrate before the drop is available again
+ *  - periodically while the sender is application-limited (2x the
+ *    estimate), as the media alone says nothing about higher rates
+ *
+ * Like the rest of the controllers, this class is independent from NS3.
+ */
+class ProbeController {
+public:
+    /** Class constructor */
+    ProbeController();
+
+    /** Reset to the state of a freshly constructed object */
+    void reset();
+
+    /**
+     * Configure the bitrates and request the initial probe clusters. Only
+     * the first call has an effect until #reset is called
+     *
+     * @param [in] minBps Minimal bitrate in bps
+     * @param [in] startBps Start bitrate in bps
+     * @param [in] maxBps Maximal bitrate in bps
+     * @param [in] nowMs Current time in milliseconds
+     */
+    void setBitrates(uint32_t minBps, uint32_t startBps, uint32_t maxBps, int64_t nowMs);
+
+    /**
+     * Inform of the current bandwidth estimate. Used to decide whether to
+     * probe further and to detect large drops
+     *
+     * @param [in] bitrateBps Current estimate in bps
+     * @param [in] nowMs Current time in milliseconds
+     */
+    void setEstimatedBitrate(uint32_t bitrateBps, int64_t nowMs);
+
+    /**
+     * Inform of whether the sender is application-limited (see
+     * #AlrDetector )
+     *
+     * @param [in] alrStartMs Time the sender became application-limited,
+     *                        in milliseconds; -1 if it is not
+     */
+    void setAlrStartTime(int64_t alrStartMs);
+
+    /**
+     * Periodic processing: gives up waiting for probe results that take too
+     * long, requests periodic probes while application-limited, and a
+     * recovery probe after a large drop
+     *
+     * @param [in] nowMs Current time in milliseconds
+     */
+    void process(int64_t nowMs);
+
+    /**
+     * Get the next cluster the sender has to send, if any
+     *
+     * @param [out] cluster Description of the cluster to send
+     * @retval true if a cluster was pending (and is now removed), false otherwise
+     */
+    bool popCluster(SenderBasedController::ProbeCluster& cluster);
+
+    /**
+     * Look up a cluster requested recently (sent or not)
+     *
+     * @param [in] id Id of the cluster
+     * @param [out] cluster Description of the cluster
+     * @retval true if the cluster was found, false otherwise
+     */
+    bool getCluster(int id, SenderBasedController::ProbeCluster& cluster) const;
+
+    /** Write the state of the object to a stream (text format) */
+    void saveState(std::ostream& os) const;
+
+    /** Load the state written by #saveState . Returns false on error */
+    bool restoreState(std::istream& is);
+
+private:
+    void initiateProbing(int64_t nowMs, uint32_t bitrateBps, bool probeFurther);
+
+    enum State {
+        STATE_INIT = 0,            /**< #setBitrates not called yet */
+        STATE_WAITING_RESULT = 1,  /**< clusters sent, waiting for the estimate */
+        STATE_DONE = 2,            /**< no exponential probing in progress */
+    };
+
+    State m_state;
+    uint32_t m_minBps;
+    uint32_t m_maxBps;
+    uint32_t m_estimatedBps;
+    uint32_t m_minBpsToProbeFurther; /**< 0 if the last probe is not to be followed up */
+    int64_t m_timeLastProbingMs;
+    uint32_t m_bpsBeforeLastLargeDrop;
+    int64_t m_timeOfLastLargeDropMs;
+    int64_t m_timeLastRecoveryProbeMs;
+    int64_t m_alrStartMs;             /**< -1 if not application-limited */
+    int m_nextClusterId;
+    std::deque<SenderBasedController::ProbeCluster> m_pending;
+    std::deque<SenderBasedController::ProbeCluster> m_issued; /**< recently requested clusters */
+};
+
+/**
+ * Computes the bitrate at which probe clusters went through the bottleneck,
+ * based on the send and receive timestamps of their packets
+ */
+class ProbeBitrateEstimator {
+public:
+    /** Class constructor */
+    ProbeBitrateEstimator();
+
+    /** Reset to the state of a freshly constructed object */
+    void reset();
+
+    /**
+     * Account for the feedback of a probe packet
+     *
+     * @param [in] packet Record of the probe packet (with its size, send
+     *                    timestamp, and one way delay already filled in)
+     * @param [in] cluster Cluster the packet belongs to
+     * @retval the estimated bitrate of the cluster in bps, or 0 if no valid
+     *         estimate is available (yet)
+     */
+    uint32_t handleProbeFeedback(const SenderBasedController::PacketRecord& packet,
+                                 const SenderBasedController::ProbeCluster& cluster);
+
+    /** Write the state of the object to a stream (text format) */
+    void saveState(std::ostream& os) const;
+
+    /** Load the state written by #saveState . Returns false on error */
+    bool restoreState(std::istream& is);
+
+private:
+    struct AggregatedCluster {
+        uint32_t numProbes;
+        uint64_t firstSendUs;
+        uint64_t lastSendUs;
+        uint64_t firstRecvUs;
+        uint64_t lastRecvUs;
+        uint32_t sizeLastSend;
+        uint32_t sizeFirstRecv;
+        uint32_t sizeTotal;
+    };
+
+    void eraseOldClusters(uint64_t sendUs);
+
+    std::map<int, AggregatedCluster> m_clusters;
+};
+
+}
+
+#endif /* PROBE_CONTROLLER_H */
@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receive-side (REMB) bitrate estimator implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "remote-bitrate-estimator.h"
+#include <algorithm>
+#include <cassert>
+
+namespace rmcat {
+
+static const uint64_t kGroupLengthUs = 5000;        /**< same burst time as the sender-side grouping */
+static const uint64_t kRateWindowUs = 1000 * 1000;  /**< window of the incoming rate */
+static const uint64_t kRembIntervalUs = 1000 * 1000; /**< period of REMB messages */
+static const float kRembDecreaseRatio = 0.97f;      /**< drop that triggers an immediate REMB */
+
+/* Returns true if a < b, taking wrapping of 64-bit timestamps into account */
+static bool lessThan(uint64_t a, uint64_t b) {
+    return int64_t(a - b) < 0;
+}
+
+RemoteBitrateEstimator::RemoteBitrateEstimator() :
+    m_engine{},
+    m_flow{0},
+    m_initBps{0},
+    m_minBps{0},
+    m_maxBps{0},
+    m_hasEstimate{false},
+    m_sendTsValid{false},
+    m_lastSendTs{0},
+    m_lastSendUs{0},
+    m_currGroup{},
+    m_prevGroup{},
+    m_rateWindow{},
+    m_rateWindowBytes{0},
+    m_firstArrivalUs{0},
+    m_rembSent{false},
+    m_lastRembUs{0},
+    m_lastRembBps{0} {
+    setBitrates(150000, 150000, 1500000);
+}
+
+RemoteBitrateEstimator::~RemoteBitrateEstimator() {}
+
+void RemoteBitrateEstimator::setBitrates(uint32_t initBps, uint32_t minBps, uint32_t maxBps) {
+    m_initBps = initBps;
+    m_minBps = minBps;
+    m_maxBps = maxBps;
+    m_engine.reset(new GccBatchEngine{});
+    m_flow = m_engine->addFlow(m_initBps, m_minBps, m_maxBps);
+    m_hasEstimate = false;
+    m_sendTsValid = false;
+    m_lastSendTs = 0;
+    m_lastSendUs = 0;
+    m_currGroup = PacketGroup{};
+    m_prevGroup = PacketGroup{};
+    m_rateWindow.clear();
+    m_rateWindowBytes = 0;
+    m_firstArrivalUs = 0;
+    m_rembSent = false;
+    m_lastRembUs = 0;
+    m_lastRembBps = 0;
+}
+
+void RemoteBitrateEstimator::processPacket(uint64_t arrivalUs,
+                                           uint32_t sendTimestampUs,
+                                           uint32_t size) {
+    // Unwrap the send timestamp
+    if (!m_sendTsValid) {
+        m_sendTsValid = true;
+        m_lastSendUs = sendTimestampUs;
+        m_firstArrivalUs = arrivalUs;
+    } else {
+        m_lastSendUs += int32_t(sendTimestampUs - m_lastSendTs); // wraps properly
+    }
+    m_lastSendTs = sendTimestampUs;
+    const uint64_t sendUs = m_lastSendUs;
+
+    updateIncomingRate(arrivalUs, size);
+
+    if (!m_currGroup.valid) {
+        m_currGroup = PacketGroup{true, sendUs, sendUs, arrivalUs, 0};
+    } else if (lessThan(sendUs, m_currGroup.firstSendUs)) {
+        return; // reordered packet from a previous group: ignored
+    } else if (lessThan(sendUs, m_currGroup.firstSendUs + kGroupLengthUs) ||
+               belongsToBurst(arrivalUs, sendUs)) {
+        // Same group: sent within the burst time of its first packet
+        m_currGroup.lastSendUs = std::max(m_currGroup.lastSendUs, sendUs);
+    } else {
+        // New group: the current one is complete
+        if (m_prevGroup.valid) {
+            GccBatchEngine::Sample sample;
+            sample.flow = m_flow;
+            // Difference of truncated arrival times, so that rounding errors
+            // do not accumulate into a bias against the exact send delta
+            sample.tDeltaMs = int64_t(m_currGroup.lastArrivalUs / 1000) -
+                              int64_t(m_prevGroup.lastArrivalUs / 1000);
+            sample.tsDeltaMs = double(m_currGroup.lastSendUs - m_prevGroup.lastSendUs) / 1000.;
+            sample.sizeDelta = int(m_currGroup.size) - int(m_prevGroup.size);
+            sample.arrivalMs = int64_t(m_currGroup.lastArrivalUs / 1000);
+            sample.incomingBps = 0;
+            if (!lessThan(arrivalUs, m_firstArrivalUs + kRateWindowUs)) {
+                sample.incomingBps = uint32_t(m_rateWindowBytes * 8 * 1000 * 1000 / kRateWindowUs);
+            }
+            m_engine->submit(sample, int64_t(arrivalUs / 1000));
+            m_engine->flush();
+            m_hasEstimate = true;
+        }
+        m_prevGroup = m_currGroup;
+        m_currGroup = PacketGroup{true, sendUs, sendUs, arrivalUs, 0};
+    }
+    m_currGroup.size += size;
+    m_currGroup.lastArrivalUs = arrivalUs;
+}
+
+bool RemoteBitrateEstimator::belongsToBurst(uint64_t arrivalUs, uint64_t sendUs) const {
+    // Packets arriving back to back, faster than they were sent, are part
+    // of the same burst (e.g., released together from a queue)
+    const int64_t arrivalDeltaUs = int64_t(arrivalUs - m_currGroup.lastArrivalUs);
+    const int64_t sendDeltaUs = int64_t(sendUs - m_currGroup.lastSendUs);
+    const int64_t propagationDeltaUs = arrivalDeltaUs - sendDeltaUs;
+    return propagationDeltaUs < 0 && arrivalDeltaUs <= int64_t(kGroupLengthUs);
+}
+
+void RemoteBitrateEstimator::updateIncomingRate(uint64_t arrivalUs, uint32_t size) {
+    m_rateWindow.push_back(std::make_pair(arrivalUs, size));
+    m_rateWindowBytes += size;
+    while (!lessThan(arrivalUs, m_rateWindow.front().first + kRateWindowUs)) {
+        assert(m_rateWindowBytes >= m_rateWindow.front().second);
+        m_rateWindowBytes -= m_rateWindow.front().second;
+        m_rateWindow.pop_front();
+    }
+}
+
+uint32_t RemoteBitrateEstimator::getBitrate() const {
+    return m_engine->getBitrate(m_flow);
+}
+
+bool RemoteBitrateEstimator::rembDue(uint64_t nowUs, uint32_t& bitrateBps) {
+    if (!m_hasEstimate) {
+        return false;
+    }
+    const uint32_t bitrate = getBitrate();
+    if (m_rembSent &&
+        lessThan(nowUs, m_lastRembUs + kRembIntervalUs) &&
+        bitrate >= kRembDecreaseRatio * m_lastRembBps) {
+        return false;
+    }
+    m_rembSent = true;
+    m_lastRembUs = nowUs;
+    m_lastRembBps = bitrate;
+    bitrateBps = bitrate;
+    return true;
+}
+
+}
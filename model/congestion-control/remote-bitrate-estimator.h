@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Receive-side (REMB) bitrate estimator interface for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef REMOTE_BITRATE_ESTIMATOR_H
+#define REMOTE_BITRATE_ESTIMATOR_H
+
+#include "gcc-batch-engine.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+namespace rmcat {
+
+/**
+ * Delay-based part of GCC running at the receiver, as in the REMB
+ * architecture: the receiver groups the incoming packets, runs the overuse
+ * estimator, detector and AIMD rate control, and only sends the resulting
+ * bitrate back to the sender.
+ *
+ * Packet grouping follows the sender-side grouping of #ns3::GccSender
+ * (5 ms bursts by send time). The estimator, detector and rate control
+ * are those of a single-flow #GccBatchEngine , so that both architectures
+ * share the same math.
+ *
+ * Like the rest of the controllers, this class is independent from NS3.
+ */
+class RemoteBitrateEstimator {
+public:
+    /** Class constructor */
+    RemoteBitrateEstimator();
+
+    /** Class destructor */
+    ~RemoteBitrateEstimator();
+
+    /**
+     * Configure the bitrates and restart the estimation from scratch
+     *
+     * @param [in] initBps Initial bitrate in bps
+     * @param [in] minBps Minimal bitrate in bps
+     * @param [in] maxBps Maximal bitrate in bps
+     */
+    void setBitrates(uint32_t initBps, uint32_t minBps, uint32_t maxBps);
+
+    /**
+     * Account for a received media packet
+     *
+     * @param [in] arrivalUs Arrival time of the packet, in microseconds
+     * @param [in] sendTimestampUs Send timestamp carried by the packet, in
+     *                             microseconds. Only the lower 32 bits are
+     *                             needed; they are unwrapped internally
+     * @param [in] size Size of the packet in bytes
+     */
+    void processPacket(uint64_t arrivalUs, uint32_t sendTimestampUs, uint32_t size);
+
+    /** Current estimate in bps (the initial bitrate until the first sample) */
+    uint32_t getBitrate() const;
+
+    /**
+     * Decide whether a REMB message has to be sent now: once a second, or
+     * right away if the estimate dropped noticeably since the last one.
+     * If so, the message is assumed to be sent
+     *
+     * @param [in] nowUs Current time in microseconds
+     * @param [out] bitrateBps Bitrate to put in the REMB message
+     * @retval true if a REMB message is due, false otherwise
+     */
+    bool rembDue(uint64_t nowUs, uint32_t& bitrateBps);
+
+private:
+    struct PacketGroup {
+        bool valid;
+        uint64_t firstSendUs;
+        uint64_t lastSendUs;
+        uint64_t lastArrivalUs;
+        uint32_t size;
+    };
+
+    bool belongsToBurst(uint64_t arrivalUs, uint64_t sendUs) const;
+    void updateIncomingRate(uint64_t arrivalUs, uint32_t size);
+
+    std::unique_ptr<GccBatchEngine> m_engine;
+    size_t m_flow;
+    uint32_t m_initBps;
+    uint32_t m_minBps;
+    uint32_t m_maxBps;
+    bool m_hasEstimate;
+
+    /* Unwrapping of the 32-bit send timestamps */
+    bool m_sendTsValid;
+    uint32_t m_lastSendTs;
+    uint64_t m_lastSendUs;
+
+    PacketGroup m_currGroup;
+    PacketGroup m_prevGroup;
+
+    /* Incoming rate over the last second */
+    std::deque<std::pair<uint64_t, uint32_t> > m_rateWindow;
+    uint64_t m_rateWindowBytes;
+    uint64_t m_firstArrivalUs;
+
+    /* REMB throttling */
+    bool m_rembSent;
+    uint64_t m_lastRembUs;
+    uint32_t m_lastRembBps;
+};
+
+}
+
+#endif /* REMOTE_BITRATE_ESTIMATOR_H */
@@ -26,11 +26,13 @@
  * @author Xiaoqing Zhu
  */
 #include "sender-based-controller.h"
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <cassert>
+#include <limits>
 
 
 namespace rmcat {
@@ -38,13 +40,18 @@ namespace rmcat {
 const int MIN_PACKET_LOGLEN = 1;             /**< minimum # of packets in log for stats to be meaningful */
 const uint64_t MAX_INTER_PACKET_TIME_US = 500 * 1000;  /**< maximum interval between packets, in microseconds */
 const uint64_t DEFAULT_HISTORY_LENGTH_US = 500 * 1000; /**< default time window for logging history of packets, in microseconds */
+const uint64_t MAX_TRANSIT_HISTORY_US = 10 * MAX_INTER_PACKET_TIME_US; /**< time window of the sent packets kept for departure lookups */
+const uint64_t MAX_RECV_HISTORY_US = 2 * 1000 * 1000; /**< time window of the receive rate history (twice the rate window) */
+const size_t MAX_HISTORY_PACKETS = 1u << 15; /**< hard bound on records per container: half the sequence space */
 const float RMCAT_CC_DEFAULT_RINIT = 150000.; /**< Initial BW in bps: 150Kbps */
 const float RMCAT_CC_DEFAULT_RMIN = 150000.;  /**< in bps: 150Kbps */
 const float RMCAT_CC_DEFAULT_RMAX = 1500000.; /**< in bps: 1.5Mbps */
+const char* SBC_STATE_TAG = "sender-based-controller"; /**< tag of saved states */
+const int SBC_STATE_VERSION = 3;  /**< version of the saved state format */
 
 InterLossState::InterLossState()
 : intervals{}
-, expectedSeq{0}
+, expectedId{0}
 , initialized{false}
 {
     intervals.push_front(0);
@@ -60,12 +67,14 @@ void SenderBasedController::setDefaultId() {
 SenderBasedController::SenderBasedController()
 : m_firstSend{true},
   m_lastSequence{0},
+  m_lastId{0},
   m_baseDelayUs{0},
   m_inTransitPackets{},
   m_PacketTransitHistory{},
   m_packetHistory{},
   m_recvHistory{},
   m_pktSizeSum{0},
+  m_recvSizeSum{0},
   m_id{},
   m_initBw{RMCAT_CC_DEFAULT_RINIT},
   m_minBw{RMCAT_CC_DEFAULT_RMIN},
@@ -74,7 +83,12 @@ SenderBasedController::SenderBasedController()
   m_ilState{},
   m_lost{0},
   loss_counter{0},
-  m_historyLengthUs{DEFAULT_HISTORY_LENGTH_US} {
+  m_historyLengthUs{DEFAULT_HISTORY_LENGTH_US},
+  m_peakInTransit{0},
+  m_peakTransitHistory{0},
+  m_peakPacketHistory{0},
+  m_peakRecvHistory{0},
+  m_peakTotal{0} {
       setDefaultId();
 }
 
@@ -103,16 +117,25 @@ void SenderBasedController::setLogCallback(logCallback f) {
 void SenderBasedController::reset() {
     m_firstSend = true;
     m_lastSequence = 0;
+    m_lastId = 0;
     m_baseDelayUs = 0;
     m_inTransitPackets.clear();
+    m_PacketTransitHistory.clear();
+    m_packetHistory.clear();
     m_recvHistory.clear();
     m_pktSizeSum = 0;
+    m_recvSizeSum = 0;
     m_initBw = RMCAT_CC_DEFAULT_RINIT;
     m_minBw = RMCAT_CC_DEFAULT_RMIN;
     m_maxBw = RMCAT_CC_DEFAULT_RMAX;
     m_logCallback = NULL;
     m_ilState = InterLossState{};
     m_historyLengthUs = DEFAULT_HISTORY_LENGTH_US;
+    m_peakInTransit = 0;
+    m_peakTransitHistory = 0;
+    m_peakPacketHistory = 0;
+    m_peakRecvHistory = 0;
+    m_peakTotal = 0;
     setDefaultId();
 }
 
@@ -120,56 +143,62 @@ void SenderBasedController::reset() {
 void SenderBasedController::updateInterLossData(const PacketRecord& packet) {
     if (m_packetHistory.empty()) {
         m_ilState = InterLossState{}; // Reset
-        m_ilState.expectedSeq = packet.sequence;
+        m_ilState.expectedId = packet.id;
     }
 
     // update state for TFRC-style inter-loss interval calculation
-    if (packet.sequence == m_ilState.expectedSeq) {
+    if (packet.id == m_ilState.expectedId) {
         ++m_ilState.intervals[0];
-        ++m_ilState.expectedSeq;
+        ++m_ilState.expectedId;
         return;
     }
-    assert(packet.sequence > m_ilState.expectedSeq);
+    assert(packet.id > m_ilState.expectedId);
     m_ilState.intervals.push_front(1); // Start new interval; shift the existing ones
     if (m_ilState.intervals.size() > 9) {
         m_ilState.intervals.pop_back();
     }
 
-    m_ilState.expectedSeq = packet.sequence + 1;
+    m_ilState.expectedId = packet.id + 1;
     m_ilState.initialized = true;
 }
 
 bool SenderBasedController::processSendPacket(uint64_t txTimestampUs,
                                               uint16_t sequence,
-                                              uint32_t size) {
+                                              uint32_t size,
+                                              int probeClusterId) {
     if (m_firstSend) {
         m_lastSequence = sequence - 1;
+        m_lastId = uint64_t(sequence) - 1; // ids start at the first sequence
         m_firstSend = false;
     }
 
-    ++m_lastSequence;
-    
-    if (sequence != m_lastSequence) {
+    if (sequence != uint16_t(m_lastSequence + 1)) {
         std::cerr << "SenderBasedController::ProcessSendPacket,"
                   << " illegal sequence: " << sequence
-                  << ", should be " << m_lastSequence << std::endl;
+                  << ", should be " << uint16_t(m_lastSequence + 1) << std::endl;
         return false;
     }
+    ++m_lastSequence;
+    ++m_lastId;
 
     // std::cout << m_lastSequence << " " << txTimestampUs << " " << size << "\n";
 
     // record sent packets in local record
     m_inTransitPackets.push_back(PacketRecord{m_lastSequence,
+                                              m_lastId,
                                               txTimestampUs,
                                               size,
                                               0,
-                                              0});
+                                              0,
+                                              probeClusterId});
     // Record all sent packets.
     m_PacketTransitHistory.push_back(PacketRecord{m_lastSequence,
+                                                  m_lastId,
                                                   txTimestampUs,
                                                   size,
                                                   0,
-                                                  0});
+                                                  0,
+                                                  probeClusterId});
     // Memory safety: timestamps of in-transit packets must be
     //  within (10 * MAX_INTER_PACKET_TIME)
     while (true) {
@@ -181,6 +210,22 @@ bool SenderBasedController::processSendPacket(uint64_t txTimestampUs,
             break;
         }
     }
+    // Same for the sent packets kept for departure lookups. Senders that
+    // never call #PrunTransitHistory rely on this to keep the history short
+    while (lessThan(m_PacketTransitHistory.front().txTimestampUs + MAX_TRANSIT_HISTORY_US,
+                    txTimestampUs)) {
+        m_PacketTransitHistory.pop_front();
+    }
+    // At very high packet rates, the time windows are not enough: the number
+    // of records is bounded too (beyond half the sequence space, lookups by
+    // sequence would be ambiguous anyway)
+    while (m_inTransitPackets.size() > MAX_HISTORY_PACKETS) {
+        m_inTransitPackets.pop_front();
+    }
+    while (m_PacketTransitHistory.size() > MAX_HISTORY_PACKETS) {
+        m_PacketTransitHistory.pop_front();
+    }
+    updateHistoryPeaks();
     return true;
 }
 
@@ -208,10 +253,11 @@ bool SenderBasedController::processFeedback(uint64_t nowUs,
         return true;
     }
 
-    assert(m_inTransitPackets.back().sequence == m_lastSequence);
+    assert(m_inTransitPackets.back().id == m_lastId);
+    const uint64_t id = unwrapSequence(sequence);
 
     m_lost = 0;
-    while (lessThan(m_inTransitPackets.front().sequence, sequence)) {
+    while (!m_inTransitPackets.empty() && m_inTransitPackets.front().id < id) {
         // Packet lost or out of order. Remove stale entry
         m_lost++;
 		loss_counter++;
@@ -225,7 +271,7 @@ bool SenderBasedController::processFeedback(uint64_t nowUs,
         m_PacketTransitHistory.pop_front();
     }*/
 
-    if (lessThan(sequence, m_inTransitPackets.front().sequence)) {
+    if (m_inTransitPackets.empty() || id < m_inTransitPackets.front().id) {
         std::cerr << "SenderBasedController::ProcessFeedback,"
                   << " sequence: " << sequence
                   << " out of order" << std::endl;
@@ -234,7 +280,7 @@ bool SenderBasedController::processFeedback(uint64_t nowUs,
 
     PacketRecord packet = m_inTransitPackets.front();
     m_inTransitPackets.pop_front();
-    assert(sequence == packet.sequence);
+    assert(id == packet.id);
 
     if (!m_packetHistory.empty()) {
         const PacketRecord& lastPacket = m_packetHistory.back();
@@ -273,6 +319,7 @@ bool SenderBasedController::processFeedback(uint64_t nowUs,
     m_packetHistory.push_back(packet);
     m_recvHistory.push_back(packet);
     m_pktSizeSum += packet.size;
+    m_recvSizeSum += packet.size;
 
     // Garbage collect history to keep its length within limits
     while (true) {
@@ -287,66 +334,234 @@ bool SenderBasedController::processFeedback(uint64_t nowUs,
         assert(m_pktSizeSum >= firstSize);
         m_pktSizeSum -= firstSize;
     }
+    while (m_packetHistory.size() > MAX_HISTORY_PACKETS) {
+        const uint32_t firstSize = m_packetHistory.front().size;
+        m_packetHistory.pop_front();
+        assert(m_pktSizeSum >= firstSize);
+        m_pktSizeSum -= firstSize;
+    }
+
+    // The receive rate history is trimmed by #getCurrentRecvRate , but
+    // controllers may not call it (regularly)
+    const uint64_t lastRxUs = packet.txTimestampUs + packet.owdUs;
+    while (m_recvHistory.size() > MAX_HISTORY_PACKETS ||
+           lessThan(m_recvHistory.front().txTimestampUs + m_recvHistory.front().owdUs
+                        + MAX_RECV_HISTORY_US,
+                    lastRxUs)) {
+        m_recvSizeSum -= m_recvHistory.front().size;
+        m_recvHistory.pop_front();
+    }
+    updateHistoryPeaks();
     return true;
 }
 
-void SenderBasedController::PrunTransitHistory(uint32_t tar_seq) {
-    while(m_PacketTransitHistory.front().sequence < tar_seq) {
-        // std::cout << "PrunTransitHistory:: " << m_PacketTransitHistory.front().sequence  << "\n";
-        // std::cout << "PrunTransitHistory:: " << tar_seq << "\n";
+bool SenderBasedController::getProbeCluster(uint64_t nowUs, ProbeCluster& cluster) {
+    return false;
+}
+
+void SenderBasedController::processRemb(uint64_t nowUs, uint32_t bitrateBps) {}
+
+void SenderBasedController::processReceiverReport(uint64_t nowUs,
+                                                  uint64_t rttUs,
+                                                  uint8_t fractionLost,
+                                                  uint32_t packetsExpected) {}
+
+void SenderBasedController::processTimer(uint64_t nowUs) {}
+
+bool SenderBasedController::usesTimer() const {
+    return false;
+}
+
+float SenderBasedController::getLossFraction() const {
+    return 0.f;
+}
+
+uint64_t SenderBasedController::unwrapSequence(uint16_t sequence) const {
+    // Sequences are at most 2^16 - 1 packets behind the last one sent
+    return m_lastId - uint16_t(m_lastSequence - sequence);
+}
+
+const SenderBasedController::PacketRecord* SenderBasedController::findSentPacket(uint64_t id) const {
+    if (m_PacketTransitHistory.empty() || id < m_PacketTransitHistory.front().id) {
+        return NULL;
+    }
+    const uint64_t index = id - m_PacketTransitHistory.front().id;
+    if (index >= m_PacketTransitHistory.size()) {
+        return NULL;
+    }
+    const PacketRecord& packet = m_PacketTransitHistory[index];
+    assert(packet.id == id);
+    return &packet;
+}
+
+void SenderBasedController::PrunTransitHistory(uint64_t tar_id) {
+    while (!m_PacketTransitHistory.empty() &&
+           m_PacketTransitHistory.front().id < tar_id) {
         m_PacketTransitHistory.pop_front();
     }
 }
 
-uint64_t SenderBasedController::GetPacketTxTimestamp(uint16_t sequence){
-    uint32_t i = 0;
-    uint32_t qsize = m_PacketTransitHistory.size();
+uint64_t SenderBasedController::GetPacketTxTimestamp(uint64_t id) {
+    const PacketRecord* packet = findSentPacket(id);
+    if (packet == NULL) {
+        return -1;
+    }
+    return packet->txTimestampUs;
+}
 
-    // std::cout << "GETPKT::at(0):: " << m_PacketTransitHistory.at(0).sequence << "\n";
-    for(i = 0; i < qsize; i++){
-        if(m_PacketTransitHistory.at(i).sequence == sequence){
-            // std::cout << "GetPacketTxTimestamp:: " << m_PacketTransitHistory.at(i).txTimestampUs << "\n"; 
-            return m_PacketTransitHistory.at(i).txTimestampUs;
-        }
+uint64_t SenderBasedController::UpdateDepartureTime(uint64_t prev_id, uint64_t now_id) {
+    const PacketRecord* prevPacket = findSentPacket(prev_id);
+    const PacketRecord* nowPacket = findSentPacket(now_id);
+    const uint64_t prev_t = (prevPacket != NULL) ? prevPacket->txTimestampUs : 0;
+    const uint64_t now_t = (nowPacket != NULL) ? nowPacket->txTimestampUs : 0;
+    return (now_t - prev_t);
+}
+
+uint64_t SenderBasedController::GetPacketSize(uint64_t id) {
+    const PacketRecord* packet = findSentPacket(id);
+    if (packet == NULL) {
+        return -1;
     }
-    return -1;
+    return packet->size;
 }
 
-uint64_t SenderBasedController::UpdateDepartureTime(uint32_t prev_s, uint32_t now_s){
-    uint32_t qsize = m_PacketTransitHistory.size();
-    uint64_t prev_t = 0, now_t = 0;
+static void saveRecords(std::ostream& os,
+                        const std::deque<SenderBasedController::PacketRecord>& records) {
+    os << records.size() << "\n";
+    for (const auto& r : records) {
+        os << r.sequence << " " << r.id << " " << r.txTimestampUs << " " << r.size << " "
+           << r.owdUs << " " << r.rttUs << " " << r.probeClusterId << "\n";
+    }
+}
 
-    uint32_t i = 0;
-    // std::cout << "UpdateDepartureTime:: " << prev_s << ", " << now_s << "\n";
-    // std::cout << "UPDATEPKT::at(0):: " << m_PacketTransitHistory.at(0).sequence << "\n";
-    for(i = 0; i < qsize; i++){
-        
-        if(m_PacketTransitHistory.at(i).sequence == prev_s){
-	    prev_t = m_PacketTransitHistory.at(i).txTimestampUs;
-     //       std::cout << "prev_t:: " << prev_t << "\n";
-	}
-	
-	if(m_PacketTransitHistory.at(i).sequence == now_s){
-	    now_t = m_PacketTransitHistory.at(i).txTimestampUs;
-   //         std::cout << "now_t:: " << now_t << "\n";
-	}
+static bool restoreRecords(std::istream& is,
+                           std::deque<SenderBasedController::PacketRecord>& records) {
+    size_t n = 0;
+    if (!(is >> n)) {
+        return false;
     }
+    records.clear();
+    for (size_t i = 0; i < n; ++i) {
+        SenderBasedController::PacketRecord r{};
+        if (!(is >> r.sequence >> r.id >> r.txTimestampUs >> r.size >> r.owdUs >> r.rttUs >> r.probeClusterId)) {
+            return false;
+        }
+        records.push_back(r);
+    }
+    return true;
+}
 
-    return (now_t - prev_t);
+void SenderBasedController::saveState(std::ostream& os) const {
+    os.precision(std::numeric_limits<float>::max_digits10);
+    os << SBC_STATE_TAG << " " << SBC_STATE_VERSION << "\n";
+    os << m_firstSend << " " << m_lastSequence << " " << m_lastId << " " << m_baseDelayUs << " "
+       << m_pktSizeSum << " " << m_initBw << " " << m_minBw << " " << m_maxBw << " "
+       << m_lost << " " << loss_counter << " " << m_historyLengthUs << "\n";
+    os << m_ilState.expectedId << " " << m_ilState.initialized << " "
+       << m_ilState.intervals.size();
+    for (const auto interval : m_ilState.intervals) {
+        os << " " << interval;
+    }
+    os << "\n";
+    saveRecords(os, m_inTransitPackets);
+    saveRecords(os, m_PacketTransitHistory);
+    saveRecords(os, m_packetHistory);
+    saveRecords(os, m_recvHistory);
 }
 
-uint64_t SenderBasedController::GetPacketSize(uint16_t sequence) {
-    uint32_t i = 0;
-    uint32_t qsize = m_PacketTransitHistory.size();
+bool SenderBasedController::restoreState(std::istream& is) {
+    std::string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != SBC_STATE_TAG || version != SBC_STATE_VERSION) {
+        std::cerr << "SenderBasedController::restoreState,"
+                  << " bad state header: " << tag << " " << version << std::endl;
+        return false;
+    }
+    size_t nIntervals = 0;
+    is >> m_firstSend >> m_lastSequence >> m_lastId >> m_baseDelayUs
+       >> m_pktSizeSum >> m_initBw >> m_minBw >> m_maxBw
+       >> m_lost >> loss_counter >> m_historyLengthUs;
+    is >> m_ilState.expectedId >> m_ilState.initialized >> nIntervals;
+    m_ilState.intervals.clear();
+    for (size_t i = 0; i < nIntervals && is; ++i) {
+        uint16_t interval = 0;
+        is >> interval;
+        m_ilState.intervals.push_back(interval);
+    }
+    if (!is ||
+        !restoreRecords(is, m_inTransitPackets) ||
+        !restoreRecords(is, m_PacketTransitHistory) ||
+        !restoreRecords(is, m_packetHistory) ||
+        !restoreRecords(is, m_recvHistory)) {
+        std::cerr << "SenderBasedController::restoreState,"
+                  << " truncated or corrupted state" << std::endl;
+        return false;
+    }
+    m_recvSizeSum = 0;
+    for (const auto& r : m_recvHistory) {
+        m_recvSizeSum += r.size;
+    }
+    return true;
+}
 
-    // std::cout << "GETPKT::at(0):: " << m_PacketTransitHistory.at(0).sequence << "\n";
-    for(i = 0; i < qsize; i++){
-        if(m_PacketTransitHistory.at(i).sequence == sequence){
-            // std::cout << "GetPacketTxTimestamp:: " << m_PacketTransitHistory.at(i).txTimestampUs << "\n"; 
-            return m_PacketTransitHistory.at(i).size;
+uint16_t SenderBasedController::forgetInTransitPackets() {
+    if (!m_inTransitPackets.empty()) {
+        // Roll the sequence back to the last packet sent before the
+        // in-transit ones, so that sequences stay contiguous
+        m_lastSequence = m_inTransitPackets.front().sequence - 1;
+        m_lastId = m_inTransitPackets.front().id - 1;
+        while (!m_PacketTransitHistory.empty() &&
+               m_lastId < m_PacketTransitHistory.back().id) {
+            m_PacketTransitHistory.pop_back();
         }
+        m_inTransitPackets.clear();
     }
-    return -1;
+    return m_lastSequence + 1;
+}
+
+void SenderBasedController::updateHistoryPeaks() {
+    m_peakInTransit = std::max(m_peakInTransit, m_inTransitPackets.size());
+    m_peakTransitHistory = std::max(m_peakTransitHistory, m_PacketTransitHistory.size());
+    m_peakPacketHistory = std::max(m_peakPacketHistory, m_packetHistory.size());
+    m_peakRecvHistory = std::max(m_peakRecvHistory, m_recvHistory.size());
+    const size_t total = m_inTransitPackets.size() + m_PacketTransitHistory.size() +
+                         m_packetHistory.size() + m_recvHistory.size();
+    m_peakTotal = std::max(m_peakTotal, total);
+}
+
+static SenderBasedController::ContainerStats makeContainerStats(size_t entries,
+                                                                size_t peakEntries) {
+    const size_t recordSize = sizeof(SenderBasedController::PacketRecord);
+    SenderBasedController::ContainerStats stats{};
+    stats.entries = entries;
+    stats.peakEntries = peakEntries;
+    stats.bytes = entries * recordSize;
+    stats.peakBytes = peakEntries * recordSize;
+    return stats;
+}
+
+SenderBasedController::HistoryStats SenderBasedController::getHistoryStats() const {
+    HistoryStats stats{};
+    stats.inTransit = makeContainerStats(m_inTransitPackets.size(), m_peakInTransit);
+    stats.transitHistory = makeContainerStats(m_PacketTransitHistory.size(), m_peakTransitHistory);
+    stats.packetHistory = makeContainerStats(m_packetHistory.size(), m_peakPacketHistory);
+    stats.recvHistory = makeContainerStats(m_recvHistory.size(), m_peakRecvHistory);
+    stats.bytes = stats.inTransit.bytes + stats.transitHistory.bytes +
+                  stats.packetHistory.bytes + stats.recvHistory.bytes;
+    stats.peakBytes = m_peakTotal * sizeof(PacketRecord);
+    return stats;
+}
+
+void SenderBasedController::logHistoryStats() const {
+    const HistoryStats stats = getHistoryStats();
+    std::ostringstream os;
+    os << " history " << m_id
+       << " intransit: " << stats.inTransit.entries << "/" << stats.inTransit.peakEntries
+       << " transit: " << stats.transitHistory.entries << "/" << stats.transitHistory.peakEntries
+       << " acked: " << stats.packetHistory.entries << "/" << stats.packetHistory.peakEntries
+       << " recv: " << stats.recvHistory.entries << "/" << stats.recvHistory.peakEntries
+       << " bytes: " << stats.bytes << "/" << stats.peakBytes;
+    logMessage(os.str());
 }
 
 void SenderBasedController::setHistoryLength(uint64_t lenUs) {
@@ -429,9 +644,8 @@ bool SenderBasedController::getPktLossInfo(uint32_t& nLoss, float& plr, uint32_t
         return false;
     }
 
-    // This will wrap properly
-    const uint16_t seqSpan = 1u + m_packetHistory.back().sequence
-                             - m_packetHistory.front().sequence;
+    const uint64_t seqSpan = 1u + m_packetHistory.back().id
+                             - m_packetHistory.front().id;
     assert(seqSpan >= m_packetHistory.size());
     nLoss = seqSpan - m_packetHistory.size();
 //    nLoss = m_lost;
@@ -463,30 +677,27 @@ bool SenderBasedController::getCurrentRecvRate(float& rrateBps) {
         return false;
     }
 
-    uint64_t curr = lastRxUs;
-    uint32_t pktcnt = 0;
-    size_t i = m_recvHistory.size() - 1;
-
-    while ((lastRxUs - curr) < 1000000){
-        pktcnt += m_recvHistory.at(i).size;
-        curr = m_recvHistory.at(i).txTimestampUs + m_recvHistory.at(i).owdUs;
-       
-       if(i == 0)
-          return false;
-        i--;
-     }
-
-     for(uint32_t j = 0;j<=i;j++)
+    // Drop the packets received before the one that starts the 1-second
+    // window. Done incrementally, with a running sum of the packet sizes, so
+    // that the cost per call does not grow with the receive rate
+    auto rxUs = [](const PacketRecord& r) { return r.txTimestampUs + r.owdUs; };
+    while (m_recvHistory.size() > 1 &&
+           lessThan(rxUs(m_recvHistory[1]) + 1000000, lastRxUs + 1)) {
+        assert(m_recvSizeSum >= m_recvHistory.front().size);
+        m_recvSizeSum -= m_recvHistory.front().size;
         m_recvHistory.pop_front();
-    
-      // Technically, the first packet is out of the calculated time span
-      assert(front.size <= m_pktSizeSum);
-      const uint32_t bytes = pktcnt;
-      rrateBps = float(bytes * 8) * 1000.f * 1000.f / (lastRxUs - curr);
-      // std::cout << "getCUrrentRecvRate:: rrateBps( " << rrateBps << "\n";
-      return true;
-}
+    }
+    if (m_recvHistory.empty() ||
+        lessThan(lastRxUs, rxUs(m_recvHistory.front()) + 1000000)) {
+        return false; // less than one second of history
+    }
 
+    // Technically, the first packet is out of the calculated time span
+    assert(front.size <= m_pktSizeSum);
+    const uint64_t spanUs = lastRxUs - rxUs(m_recvHistory.front());
+    rrateBps = float(m_recvSizeSum * 8) * 1000.f * 1000.f / spanUs;
+    return true;
+}
 
 bool SenderBasedController::getLossIntervalInfo(float& avgInterval, uint16_t& currentInterval) const {
     if (!m_ilState.initialized) {
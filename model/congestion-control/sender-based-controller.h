@@ -33,6 +33,7 @@
 #include <string>
 #include <deque>
 #include <utility>
+#include <iosfwd>
 
 
 namespace rmcat {
@@ -47,7 +48,7 @@ class InterLossState {
 public:
     InterLossState();
     std::deque<uint16_t> intervals;
-    uint16_t expectedSeq;
+    uint64_t expectedId; // unwrapped sequence of the next packet expected
     bool initialized; // did the first loss happen?
 };
 
@@ -92,7 +93,9 @@ public:
 
     /** To avoid future complexity and defects, we make the following
      *  assumptions regarding wrapping of unsigned integers:
-     *    - sequences, uint16_t, can wrap (just like TCP)
+     *    - sequences, uint16_t, can wrap (just like TCP). Internally, each
+     *      packet is also identified by an unwrapped, monotonic, 64-bit
+     *      sequence id (see #unwrapSequence ), which never wraps
      *    - timestamps (microseconds), uint64_t, can wrap (despite being 64 bits long)
      *    - delays (microseconds), uint64_t, can wrap (easily), as they are
      *      obtained from subtraction of timestamps obtained at different endpoints,
@@ -100,10 +103,45 @@ public:
      */
     struct PacketRecord {
         uint16_t sequence;
+        uint64_t id;        /**< unwrapped sequence */
         uint64_t txTimestampUs;
         uint32_t size;
         uint64_t owdUs;
         uint64_t rttUs;
+        int probeClusterId; /**< probe cluster of the packet, 0 if not a probe */
+    };
+
+    /**
+     * A probe cluster is a burst of packets that the sender paces at a
+     * given rate, higher than the current estimate, so that the controller
+     * can measure whether that rate is available
+     */
+    struct ProbeCluster {
+        int id;              /**< cluster id (> 0), to be passed to #processSendPacket */
+        uint32_t bitrateBps; /**< rate at which the packets are to be paced */
+        uint32_t minPackets; /**< minimal number of packets to send */
+        uint32_t minBytes;   /**< minimal number of bytes to send */
+    };
+
+    /** Memory accounting of one per-packet container */
+    struct ContainerStats {
+        size_t entries;     /**< current number of records */
+        size_t peakEntries; /**< maximal number of records so far */
+        size_t bytes;       /**< current size of the records, in bytes */
+        size_t peakBytes;   /**< maximal size of the records so far, in bytes */
+    };
+
+    /**
+     * Memory accounting of all per-packet containers. Sizes account for the
+     * records only, not for the containers' own bookkeeping
+     */
+    struct HistoryStats {
+        ContainerStats inTransit;      /**< packets waiting for feedback */
+        ContainerStats transitHistory; /**< all sent packets (departure lookups) */
+        ContainerStats packetHistory;  /**< acked packets used for the metrics */
+        ContainerStats recvHistory;    /**< acked packets used for the receive rate */
+        size_t bytes;                  /**< current size of all the records */
+        size_t peakBytes;              /**< maximal size of all the records so far */
     };
 
     /** Class constructor */
@@ -185,6 +223,9 @@ public:
      *                  application denotes the size of the payload (i.e.,
      *                  without accounting for any RTP/UDP/IP overheads).
      *                  This can be changed, though
+     * @param [in] probeClusterId Id of the probe cluster the packet belongs
+     *                            to (see #getProbeCluster ), 0 for media
+     *                            packets
      * @retval true if all went well, false if there was an error
      *
      * @note There are two ways this function can fail:
@@ -195,7 +236,8 @@ public:
      */
     virtual bool processSendPacket(uint64_t txTimestampUs,
                                    uint16_t sequence,
-                                   uint32_t size); // in Bytes
+                                   uint32_t size, // in Bytes
+                                   int probeClusterId=0);
 
     /**
      * Upon arrival of a feedback packet from the receiver endpoint, the send
@@ -232,13 +274,155 @@ public:
 								 int64_t l_arrival_time,
                                  uint8_t ecn=0);
 
-    virtual void PrunTransitHistory(uint32_t tar_seq);
+    /**
+     * The sender application calls this function to know whether the
+     * controller wants a probe cluster to be sent. The packets of the
+     * cluster are to be passed to #processSendPacket with the cluster's id.
+     * The default implementation never asks for probes
+     *
+     * @param [in] nowUs The time (in microseconds) at which this function is called
+     * @param [out] cluster Description of the cluster to send
+     * @retval true if a cluster is to be sent, false otherwise
+     */
+    virtual bool getProbeCluster(uint64_t nowUs, ProbeCluster& cluster);
+
+    /**
+     * The sender application calls this function when it receives a
+     * receiver-side estimate (REMB message) rather than per-packet feedback.
+     * The default implementation ignores it
+     *
+     * @param [in] nowUs The time (in microseconds) at which the message was received
+     * @param [in] bitrateBps Bitrate estimated by the receiver, in bps
+     */
+    virtual void processRemb(uint64_t nowUs, uint32_t bitrateBps);
+
+    /**
+     * The sender application calls this function when it receives an RTCP
+     * receiver report (RFC 3550) about its stream. Reports are sent every
+     * few hundred milliseconds to seconds, and provide a cheap RTT sample
+     * (from the LSR and DLSR fields) and the loss since the previous report.
+     * The default implementation ignores it
+     *
+     * @param [in] nowUs The time (in microseconds) at which the report was received
+     * @param [in] rttUs Round-trip time in microseconds, 0 if the receiver
+     *                   has not received any sender report yet
+     * @param [in] fractionLost Fraction of packets lost since the previous
+     *                          report, in 1/256 units
+     * @param [in] packetsExpected Number of packets expected since the
+     *                             previous report
+     */
+    virtual void processReceiverReport(uint64_t nowUs,
+                                       uint64_t rttUs,
+                                       uint8_t fractionLost,
+                                       uint32_t packetsExpected);
+
+    /**
+     * The sender application calls this function periodically (every few
+     * tens of milliseconds), whether or not feedback arrives, so that the
+     * controller can act upon the absence of feedback. The default
+     * implementation does nothing
+     *
+     * @param [in] nowUs The time (in microseconds) at which this function is called
+     */
+    virtual void processTimer(uint64_t nowUs);
+
+    /**
+     * Whether #processTimer does anything, so that the sender application
+     * only runs the timer when needed. The default implementation returns
+     * false
+     */
+    virtual bool usesTimer() const;
+
+    /**
+     * The sender application calls this function to adapt its protection
+     * against losses (e.g., forward error correction) to the loss rate the
+     * congestion controller currently acts upon. The default implementation
+     * reports no loss
+     *
+     * @retval Fraction of packets lost, in [0, 1]
+     */
+    virtual float getLossFraction() const;
+
+    /**
+     * Map a 16-bit sequence number, as carried in RTP packets and in the
+     * feedback, to the unwrapped 64-bit sequence id of the packet. The
+     * sequence is unwrapped relative to the last packet sent, so it must
+     * belong to a packet already sent (less than 2^16 packets ago)
+     *
+     * @param [in] sequence The (wrapping) sequence number of a sent packet
+     * @retval the sequence id, monotonic across wraps
+     */
+    uint64_t unwrapSequence(uint16_t sequence) const;
+
+    /*
+     * Lookups in the history of sent packets, by sequence id (see
+     * #unwrapSequence ). Ids are contiguous in the history, so these are
+     * direct accesses. Packets no longer in the history yield -1 (size,
+     * timestamp) or 0 (departure time)
+     */
+
+    /** Forget sent packets with an id smaller than tar_id */
+    virtual void PrunTransitHistory(uint64_t tar_id);
+
+    /** Departure time difference between two sent packets, in microseconds */
+    virtual uint64_t UpdateDepartureTime(uint64_t prev_id, uint64_t now_id);
+
+    /** Size of a sent packet, in bytes */
+    virtual uint64_t GetPacketSize(uint64_t id);
+
+    /** Send timestamp of a sent packet, in microseconds */
+    virtual uint64_t GetPacketTxTimestamp(uint64_t id);
+
+    /**
+     * Write the complete state of the controller (packet histories,
+     * derived metrics and algorithm-specific state) to a stream, so that
+     * it can be loaded later on into another instance with #restoreState .
+     * The id and the logging callback are not part of the state
+     *
+     * Subclasses with state of their own must override this function and
+     * call the superclass's method first
+     *
+     * @param [out] os Stream the state is written to (text format)
+     */
+    virtual void saveState(std::ostream& os) const;
+
+    /**
+     * Load the state previously written by #saveState . After a successful
+     * call, the controller behaves exactly as the saved one did
+     *
+     * Subclasses with state of their own must override this function and
+     * call the superclass's method first
+     *
+     * @param [in] is Stream the state is read from
+     * @retval true if all went well, false if the stream does not contain
+     *         a valid state for this controller
+     */
+    virtual bool restoreState(std::istream& is);
+
+    /**
+     * Forget about the packets that are still in transit, as if they had
+     * never been sent. This is used when a restored controller is plugged
+     * into a new network (e.g., a scenario forked from a snapshot), where
+     * those packets will never get any feedback
+     *
+     * @retval the sequence number the next sent packet must have
+     */
+    uint16_t forgetInTransitPackets();
 
-    virtual uint64_t UpdateDepartureTime(uint32_t prev_s, uint32_t now_s);
+    /**
+     * Get the current and peak memory used by the per-packet containers.
+     * Every container is bounded both in time and in number of records, so
+     * these figures stay flat in long simulations
+     *
+     * @retval memory accounting of all per-packet containers
+     */
+    HistoryStats getHistoryStats() const;
 
-    virtual uint64_t GetPacketSize(uint16_t sequence);
+    /**
+     * Log the memory accounting returned by #getHistoryStats
+     */
+    void logHistoryStats() const;
 
-    virtual uint64_t GetPacketTxTimestamp(uint16_t sequence);
     /**
      * The sender application will call this function every time it needs to
      * know what is the current bandwidth as estimated by the congestion
@@ -352,6 +536,7 @@ protected:
 
     bool m_firstSend; /**< true if at least one packet has been sent */
     uint16_t m_lastSequence; /**< sequence of the last packet sent */
+    uint64_t m_lastId; /**< unwrapped sequence of the last packet sent */
     /**
      * Estimation of the network propagation delay, plus clock difference
      * between sender and receiver endpoints. In microseconds
@@ -374,6 +559,8 @@ protected:
      * This is done for efficiency reasons
      */
     uint32_t m_pktSizeSum;
+    /** Same as #m_pktSizeSum , for #m_recvHistory */
+    uint64_t m_recvSizeSum;
 
     std::string m_id; /**< Id used for logging, and can be used for plotting */
 
@@ -393,6 +580,15 @@ private:
 
     void setDefaultId();
     void updateInterLossData(const PacketRecord& packet);
+    void updateHistoryPeaks();
+    const PacketRecord* findSentPacket(uint64_t id) const;
+
+    /* Peak number of records of the per-packet containers */
+    size_t m_peakInTransit;
+    size_t m_peakTransitHistory;
+    size_t m_peakPacketHistory;
+    size_t m_peakRecvHistory;
+    size_t m_peakTotal;
 };
 
 }
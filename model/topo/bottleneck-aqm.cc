@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Queue management options at the bottleneck link implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "bottleneck-aqm.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+/* Device queue in front of an AQM: room for the packet being transmitted
+ * and the next one, so that packets wait (and are managed) in the AQM */
+static const uint32_t kAqmDeviceQueueBytes = 2 * DEFAULT_MTU;
+
+static const struct {
+    BottleneckAqm aqm;
+    const char* name;
+} kAqmNames[] = {
+    {AQM_DROPTAIL, "droptail"},
+    {AQM_CODEL, "codel"},
+    {AQM_FQ_CODEL, "fqcodel"},
+    {AQM_PIE, "pie"},
+    {AQM_STEP_MARKING, "step"},
+    {AQM_DUALQ, "dualq"},
+};
+
+uint32_t BottleneckAqmHelper::GetDeviceQueueBytes (BottleneckAqm aqm, uint32_t bufSize)
+{
+    return aqm == AQM_DROPTAIL ? bufSize : kAqmDeviceQueueBytes;
+}
+
+void BottleneckAqmHelper::Install (NetDeviceContainer devices, BottleneckAqm aqm, uint32_t bufSize)
+{
+    // Disable tc for drop-tail, some bug in ns3 causes extra delay
+    TrafficControlHelper tch;
+    tch.Uninstall (devices);
+
+    // Packet-limited AQMs get as many full-sized packets as fit in bufSize
+    const uint32_t maxPackets = std::max<uint32_t> (1, bufSize / DEFAULT_MTU);
+
+    switch (aqm) {
+        case AQM_DROPTAIL:
+            return;
+        case AQM_CODEL:
+            tch.SetRootQueueDisc ("ns3::CoDelQueueDisc",
+                                  "Mode", StringValue ("QUEUE_MODE_BYTES"),
+                                  "MaxBytes", UintegerValue (bufSize));
+            break;
+        case AQM_FQ_CODEL:
+            tch.SetRootQueueDisc ("ns3::FqCoDelQueueDisc",
+                                  "PacketLimit", UintegerValue (maxPackets));
+            break;
+        case AQM_PIE:
+            tch.SetRootQueueDisc ("ns3::PieQueueDisc",
+                                  "Mode", StringValue ("QUEUE_MODE_BYTES"),
+                                  "QueueLimit", UintegerValue (bufSize));
+            break;
+        case AQM_STEP_MARKING:
+            tch.SetRootQueueDisc ("ns3::StepMarkingQueueDisc",
+                                  "MaxBytes", UintegerValue (bufSize));
+            break;
+        case AQM_DUALQ:
+            tch.SetRootQueueDisc ("ns3::DualQCoupledQueueDisc",
+                                  "MaxBytes", UintegerValue (bufSize));
+            break;
+        default:
+            NS_ASSERT_MSG (false, "Unknown AQM " << aqm);
+    }
+    tch.Install (devices);
+}
+
+bool BottleneckAqmHelper::Parse (const std::string& name, BottleneckAqm& aqm)
+{
+    for (const auto& entry : kAqmNames) {
+        if (name == entry.name) {
+            aqm = entry.aqm;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string BottleneckAqmHelper::GetName (BottleneckAqm aqm)
+{
+    for (const auto& entry : kAqmNames) {
+        if (aqm == entry.aqm) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+}
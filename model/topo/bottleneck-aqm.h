@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Queue management options at the bottleneck link for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef BOTTLENECK_AQM_H
+#define BOTTLENECK_AQM_H
+
+#include "ns3/net-device-container.h"
+#include "ns3/rmcat-constants.h"
+#include <string>
+
+namespace ns3 {
+
+/**
+ * Helper configuring the queue at a bottleneck link. With #AQM_DROPTAIL,
+ * packets queue in the devices and traffic control is disabled, as in the
+ * original topologies; otherwise they queue in the AQM, installed as root
+ * queue disc, and the device queues only hold a couple of packets.
+ */
+class BottleneckAqmHelper
+{
+public:
+    /**
+     * Size of the device queue to configure for @p aqm
+     *
+     * @param [in] aqm Queue management at the bottleneck
+     * @param [in] bufSize Capacity of the bottleneck queue (in bytes)
+     *
+     * @retval Size of the device queue (in bytes)
+     */
+    static uint32_t GetDeviceQueueBytes (BottleneckAqm aqm, uint32_t bufSize);
+
+    /**
+     * Install the queue disc implementing @p aqm on @p devices, replacing
+     * any queue disc previously installed. To be called after the IPv4
+     * addresses have been assigned
+     *
+     * @param [in] devices Devices at both ends of the bottleneck link
+     * @param [in] aqm Queue management at the bottleneck
+     * @param [in] bufSize Capacity of the bottleneck queue (in bytes)
+     */
+    static void Install (NetDeviceContainer devices, BottleneckAqm aqm, uint32_t bufSize);
+
+    /**
+     * Parse the name of an AQM: "droptail", "codel", "fqcodel", "pie",
+     * "step" or "dualq"
+     *
+     * @param [in] name Name of the AQM
+     * @param [out] aqm Parsed AQM
+     *
+     * @retval true if the name is valid
+     */
+    static bool Parse (const std::string& name, BottleneckAqm& aqm);
+
+    /**
+     * Name of @p aqm, as accepted by #Parse
+     */
+    static std::string GetName (BottleneckAqm aqm);
+};
+
+}
+
+#endif /* BOTTLENECK_AQM_H */
@@ -0,0 +1,258 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * DualQ coupled (L4S/classic) queue disc implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "dualq-coupled-queue-disc.h"
+#include "step-marking-queue-disc.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("DualQCoupledQueueDisc");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DualQCoupledQueueDisc);
+
+TypeId DualQCoupledQueueDisc::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("ns3::DualQCoupledQueueDisc")
+        .SetParent<QueueDisc> ()
+        .SetGroupName ("TrafficControl")
+        .AddConstructor<DualQCoupledQueueDisc> ()
+        .AddAttribute ("MaxBytes",
+                       "The maximum number of bytes accepted by both queues.",
+                       UintegerValue (100 * 1000),
+                       MakeUintegerAccessor (&DualQCoupledQueueDisc::m_maxBytes),
+                       MakeUintegerChecker<uint32_t> ())
+        .AddAttribute ("Target",
+                       "Target queuing delay of the PI controller.",
+                       TimeValue (MilliSeconds (15)),
+                       MakeTimeAccessor (&DualQCoupledQueueDisc::m_target),
+                       MakeTimeChecker ())
+        .AddAttribute ("Tupdate",
+                       "Update interval of the PI controller.",
+                       TimeValue (MilliSeconds (16)),
+                       MakeTimeAccessor (&DualQCoupledQueueDisc::m_tUpdate),
+                       MakeTimeChecker ())
+        .AddAttribute ("Alpha",
+                       "Integral gain of the PI controller (in Hz).",
+                       DoubleValue (0.16),
+                       MakeDoubleAccessor (&DualQCoupledQueueDisc::m_alpha),
+                       MakeDoubleChecker<double> (0.))
+        .AddAttribute ("Beta",
+                       "Proportional gain of the PI controller (in Hz).",
+                       DoubleValue (3.2),
+                       MakeDoubleAccessor (&DualQCoupledQueueDisc::m_beta),
+                       MakeDoubleChecker<double> (0.))
+        .AddAttribute ("CouplingFactor",
+                       "Coupling factor between the base and the L4S marking probabilities.",
+                       DoubleValue (2.),
+                       MakeDoubleAccessor (&DualQCoupledQueueDisc::m_coupling),
+                       MakeDoubleChecker<double> (0.))
+        .AddAttribute ("StepThreshold",
+                       "Sojourn time above which L4S packets are always marked.",
+                       TimeValue (MilliSeconds (1)),
+                       MakeTimeAccessor (&DualQCoupledQueueDisc::m_stepThreshold),
+                       MakeTimeChecker ())
+        .AddAttribute ("TimeShift",
+                       "Head start given to the L4S queue by the scheduler.",
+                       TimeValue (MilliSeconds (30)),
+                       MakeTimeAccessor (&DualQCoupledQueueDisc::m_timeShift),
+                       MakeTimeChecker ())
+        ;
+    return tid;
+}
+
+DualQCoupledQueueDisc::DualQCoupledQueueDisc ()
+: QueueDisc{},
+  m_maxBytes{0},
+  m_target{},
+  m_tUpdate{},
+  m_alpha{0.},
+  m_beta{0.},
+  m_coupling{0.},
+  m_stepThreshold{},
+  m_timeShift{},
+  m_lQueue{},
+  m_cQueue{},
+  m_bytes{0},
+  m_baseProb{0.},
+  m_prevQDelay{},
+  m_lastUpdate{},
+  m_marked{0},
+  m_uv{CreateObject<UniformRandomVariable> ()}
+{}
+
+DualQCoupledQueueDisc::~DualQCoupledQueueDisc ()
+{}
+
+uint32_t DualQCoupledQueueDisc::GetMarkedPackets (void) const
+{
+    return m_marked;
+}
+
+double DualQCoupledQueueDisc::GetBaseProbability (void) const
+{
+    return m_baseProb;
+}
+
+bool DualQCoupledQueueDisc::IsL4s (Ptr<QueueDiscItem> item)
+{
+    auto ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+    if (!ipv4Item) {
+        return false;
+    }
+    const auto ecn = ipv4Item->GetHeader ().GetEcn ();
+    return ecn == Ipv4Header::ECN_ECT1 || ecn == Ipv4Header::ECN_CE;
+}
+
+bool DualQCoupledQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+    if (m_bytes + item->GetPacketSize () > m_maxBytes) {
+        NS_LOG_LOGIC ("Queue full -- dropping pkt");
+        Drop (item);
+        return false;
+    }
+    auto& queue = IsL4s (item) ? m_lQueue : m_cQueue;
+    queue.push_back (std::make_pair (item, Simulator::Now ()));
+    m_bytes += item->GetPacketSize ();
+    return true;
+}
+
+bool DualQCoupledQueueDisc::ServeL4s (void) const
+{
+    if (m_lQueue.empty ()) {
+        return false;
+    }
+    if (m_cQueue.empty ()) {
+        return true;
+    }
+    // Time-shifted FIFO: the L4S head goes first unless the classic head
+    // has waited longer than the time shift
+    return m_lQueue.front ().second <= m_cQueue.front ().second + m_timeShift;
+}
+
+void DualQCoupledQueueDisc::UpdateProbability (void)
+{
+    const Time now = Simulator::Now ();
+    if (now < m_lastUpdate + m_tUpdate) {
+        return;
+    }
+    m_lastUpdate = now;
+
+    Time qDelay{};
+    if (!m_cQueue.empty ()) {
+        qDelay = now - m_cQueue.front ().second;
+    }
+    if (!m_lQueue.empty ()) {
+        qDelay = std::max (qDelay, now - m_lQueue.front ().second);
+    }
+    m_baseProb += m_alpha * (qDelay - m_target).GetSeconds () +
+                  m_beta * (qDelay - m_prevQDelay).GetSeconds ();
+    m_baseProb = std::min (std::max (m_baseProb, 0.), 1.);
+    m_prevQDelay = qDelay;
+}
+
+Ptr<QueueDiscItem> DualQCoupledQueueDisc::DoDequeue (void)
+{
+    UpdateProbability ();
+    while (!m_lQueue.empty () || !m_cQueue.empty ()) {
+        const bool l4s = ServeL4s ();
+        auto& queue = l4s ? m_lQueue : m_cQueue;
+        auto item = queue.front ().first;
+        const Time sojourn = Simulator::Now () - queue.front ().second;
+        queue.pop_front ();
+        m_bytes -= item->GetPacketSize ();
+
+        if (l4s) {
+            const double prob = std::min (m_coupling * m_baseProb, 1.);
+            if (sojourn > m_stepThreshold || m_uv->GetValue () < prob) {
+                auto marked = StepMarkingQueueDisc::Mark (item);
+                if (marked) {
+                    ++m_marked;
+                    return marked;
+                }
+            }
+            return item;
+        }
+
+        // Classic queue: squared probability, as a classic (Reno-like)
+        // flow's rate is inversely proportional to sqrt(p)
+        if (m_uv->GetValue () < m_baseProb * m_baseProb) {
+            auto marked = StepMarkingQueueDisc::Mark (item);
+            if (marked) {
+                ++m_marked;
+                return marked;
+            }
+            NS_LOG_LOGIC ("Classic packet dropped with p = " << m_baseProb * m_baseProb);
+            Drop (item);
+            continue;
+        }
+        return item;
+    }
+    NS_LOG_LOGIC ("Queue empty");
+    return 0;
+}
+
+Ptr<const QueueDiscItem> DualQCoupledQueueDisc::DoPeek (void) const
+{
+    if (m_lQueue.empty () && m_cQueue.empty ()) {
+        return 0;
+    }
+    return ServeL4s () ? m_lQueue.front ().first : m_cQueue.front ().first;
+}
+
+bool DualQCoupledQueueDisc::CheckConfig (void)
+{
+    if (GetNQueueDiscClasses () > 0) {
+        NS_LOG_ERROR ("DualQCoupledQueueDisc cannot have classes");
+        return false;
+    }
+    if (GetNPacketFilters () > 0) {
+        NS_LOG_ERROR ("DualQCoupledQueueDisc cannot have packet filters");
+        return false;
+    }
+    if (GetNInternalQueues () > 0) {
+        NS_LOG_ERROR ("DualQCoupledQueueDisc keeps its own queues");
+        return false;
+    }
+    return true;
+}
+
+void DualQCoupledQueueDisc::InitializeParams (void)
+{
+    m_baseProb = 0.;
+    m_prevQDelay = Time{};
+    m_lastUpdate = Simulator::Now ();
+    m_marked = 0;
+}
+
+}
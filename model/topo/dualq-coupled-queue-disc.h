@@ -0,0 +1,114 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * DualQ coupled (L4S/classic) queue disc for the bottleneck of rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef DUALQ_COUPLED_QUEUE_DISC_H
+#define DUALQ_COUPLED_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <deque>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * Simplified DualPI2 coupled AQM (RFC 9332).
+ *
+ * Packets carrying ECT(1) or CE go to the L4S queue, all others to the
+ * classic queue; both share one byte limit. A PI controller driven by the
+ * queuing delay computes a base probability p'. Classic packets are
+ * dropped (or CE-marked, if ECT(0)) with probability p'^2, while L4S
+ * packets are marked with the coupled probability k*p', or always when
+ * their own sojourn time exceeds a shallow step threshold. The queues are
+ * served by a time-shifted FIFO that favors the L4S queue.
+ */
+class DualQCoupledQueueDisc: public QueueDisc
+{
+public:
+    static TypeId GetTypeId (void);
+
+    /** Class constructor */
+    DualQCoupledQueueDisc ();
+
+    /** Class destructor */
+    virtual ~DualQCoupledQueueDisc ();
+
+    /**
+     * Get the number of packets marked CE since the queue disc was created
+     *
+     * @retval Number of marked packets
+     */
+    uint32_t GetMarkedPackets (void) const;
+
+    /**
+     * Get the current base probability p' of the PI controller
+     *
+     * @retval Base probability, in [0, 1]
+     */
+    double GetBaseProbability (void) const;
+
+private:
+    typedef std::deque<std::pair<Ptr<QueueDiscItem>, Time> > FifoQueue;
+
+    virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+    virtual Ptr<QueueDiscItem> DoDequeue (void);
+    virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+    virtual bool CheckConfig (void);
+    virtual void InitializeParams (void);
+
+    /** Whether @p item belongs in the L4S queue */
+    static bool IsL4s (Ptr<QueueDiscItem> item);
+
+    /** Whether the next packet to serve is the head of the L4S queue */
+    bool ServeL4s (void) const;
+
+    /** Run the PI controller, if an update interval has elapsed */
+    void UpdateProbability (void);
+
+    uint32_t m_maxBytes;        /**< capacity shared by both queues, in bytes */
+    Time m_target;              /**< target queuing delay of the PI controller */
+    Time m_tUpdate;             /**< update interval of the PI controller */
+    double m_alpha;             /**< integral gain (in Hz) */
+    double m_beta;              /**< proportional gain (in Hz) */
+    double m_coupling;          /**< coupling factor k between p' and L4S marking */
+    Time m_stepThreshold;       /**< L4S sojourn time above which packets are always marked */
+    Time m_timeShift;           /**< head start of the L4S queue in the scheduler */
+
+    FifoQueue m_lQueue;         /**< L4S packets, with their enqueue time */
+    FifoQueue m_cQueue;         /**< classic packets, with their enqueue time */
+    uint32_t m_bytes;           /**< bytes in both queues */
+    double m_baseProb;          /**< base probability p' */
+    Time m_prevQDelay;          /**< queuing delay at the previous update */
+    Time m_lastUpdate;          /**< time of the previous update */
+    uint32_t m_marked;          /**< number of packets marked CE */
+    Ptr<UniformRandomVariable> m_uv; /**< random variable for drop/mark decisions */
+};
+
+}
+
+#endif /* DUALQ_COUPLED_QUEUE_DISC_H */
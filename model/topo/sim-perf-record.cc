@@ -0,0 +1,314 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Performance record of the simulator itself implementation for rmcat
+ * ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "sim-perf-record.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/global-value.h"
+#include "ns3/object-factory.h"
+#include "ns3/config.h"
+#include "ns3/node-list.h"
+#include "ns3/udp-server.h"
+
+#include <sys/resource.h>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+/**
+ * Scheduler counting the events it hands over to the simulator, as ns-3.26
+ * does not expose the number of events processed. The events are kept by
+ * a scheduler of the type selected with the "SchedulerType" global value,
+ * so that the choice of scheduler is not changed by the measurement
+ */
+class CountingScheduler : public Scheduler
+{
+public:
+    static TypeId GetTypeId ()
+    {
+        static TypeId tid = TypeId ("ns3::CountingScheduler")
+          .SetParent<Scheduler> ()
+          .AddConstructor<CountingScheduler> ()
+        ;
+        return tid;
+    }
+
+    CountingScheduler ()
+    {
+        TypeIdValue type;
+        GlobalValue::GetValueByName ("SchedulerType", type);
+        ObjectFactory factory;
+        factory.SetTypeId (type.Get ());
+        m_scheduler = factory.Create<Scheduler> ();
+    }
+
+    virtual void Insert (const Scheduler::Event& ev)
+    {
+        m_scheduler->Insert (ev);
+    }
+
+    virtual bool IsEmpty () const
+    {
+        return m_scheduler->IsEmpty ();
+    }
+
+    virtual Scheduler::Event PeekNext () const
+    {
+        return m_scheduler->PeekNext ();
+    }
+
+    virtual Scheduler::Event RemoveNext ()
+    {
+        ++s_events;
+        return m_scheduler->RemoveNext ();
+    }
+
+    virtual void Remove (const Scheduler::Event& ev)
+    {
+        m_scheduler->Remove (ev);
+    }
+
+    static uint64_t s_events;
+
+private:
+    Ptr<Scheduler> m_scheduler;
+};
+
+uint64_t CountingScheduler::s_events = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (CountingScheduler);
+
+/*
+ * Peak resident set size, in KiB, since the last ResetPeakRss. Linux only:
+ * elsewhere, the peak of the whole process is reported instead
+ */
+static const char* const kClearRefsFile = "/proc/self/clear_refs";
+static const char* const kStatusFile = "/proc/self/status";
+
+static bool ResetPeakRss ()
+{
+    // "5" resets the peak RSS (VmHWM) to the current RSS
+    std::ofstream ofs (kClearRefsFile);
+    ofs << "5" << std::flush;
+    return bool (ofs);
+}
+
+static long ReadPeakRssKb ()
+{
+    std::ifstream ifs (kStatusFile);
+    std::string line;
+    while (std::getline (ifs, line)) {
+        long kb = 0;
+        if (std::sscanf (line.c_str (), "VmHWM: %ld kB", &kb) == 1) {
+            return kb;
+        }
+    }
+    return -1;
+}
+
+uint64_t SimPerfRecord::s_components[SimPerfRecord::NUM_COMPONENTS] = {0};
+bool SimPerfRecord::s_recording = false;
+double SimPerfRecord::s_controllerSeconds = 0.;
+
+SimPerfRecord::ControllerScope::ControllerScope ()
+: m_active{s_recording}
+, m_start{}
+{
+    if (m_active) {
+        m_start = std::chrono::steady_clock::now ();
+    }
+}
+
+SimPerfRecord::ControllerScope::~ControllerScope ()
+{
+    if (m_active) {
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now () - m_start;
+        s_controllerSeconds += elapsed.count ();
+    }
+}
+
+SimPerfRecord::SimPerfRecord ()
+: m_wallStart{}
+, m_simStart{}
+, m_wallSeconds{0.}
+, m_simTime{}
+, m_events{0}
+, m_componentEvents{0}
+, m_tcpPackets{0}
+, m_cbrPackets{0}
+, m_peakRssKb{0}
+, m_peakRssProcess{true}
+, m_controllerSeconds{0.}
+{}
+
+void SimPerfRecord::Start ()
+{
+    // Events already scheduled are moved to the new scheduler
+    ObjectFactory factory;
+    factory.SetTypeId ("ns3::CountingScheduler");
+    Simulator::SetScheduler (factory);
+    CountingScheduler::s_events = 0;
+
+    for (auto& count : s_components) {
+        count = 0;
+    }
+    m_tcpPackets = 0;
+    Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::BulkSendApplication/Tx",
+                                   MakeCallback (&SimPerfRecord::TcpSent, this));
+    Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                                   MakeCallback (&SimPerfRecord::TcpReceived, this));
+
+    m_peakRssProcess = !ResetPeakRss ();
+
+    s_controllerSeconds = 0.;
+    s_recording = true;
+    m_simStart = Simulator::Now ();
+    m_wallStart = std::chrono::steady_clock::now ();
+}
+
+void SimPerfRecord::Stop ()
+{
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now () - m_wallStart;
+    m_wallSeconds = elapsed.count ();
+    m_simTime = Simulator::Now () - m_simStart;
+    m_events = CountingScheduler::s_events;
+    s_recording = false;
+    m_controllerSeconds = s_controllerSeconds;
+    Config::DisconnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::BulkSendApplication/Tx",
+                                      MakeCallback (&SimPerfRecord::TcpSent, this));
+    Config::DisconnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                                      MakeCallback (&SimPerfRecord::TcpReceived, this));
+
+    for (size_t i = 0; i < NUM_COMPONENTS; ++i) {
+        m_componentEvents[i] = s_components[i];
+    }
+    m_cbrPackets = 0;
+    for (auto node = NodeList::Begin (); node != NodeList::End (); ++node) {
+        for (uint32_t i = 0; i < (*node)->GetNApplications (); ++i) {
+            auto server = DynamicCast<UdpServer> ((*node)->GetApplication (i));
+            if (server) {
+                m_cbrPackets += server->GetReceived ();
+            }
+        }
+    }
+
+    if (!m_peakRssProcess) {
+        m_peakRssKb = ReadPeakRssKb ();
+        m_peakRssProcess = m_peakRssKb < 0;
+    }
+    if (!m_peakRssProcess) {
+        return;
+    }
+    // Peak of the whole process, i.e., of all the runs so far
+    struct rusage usage;
+    m_peakRssKb = 0;
+    if (getrusage (RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        m_peakRssKb = usage.ru_maxrss / 1024;   // bytes
+#else
+        m_peakRssKb = usage.ru_maxrss;
+#endif
+    }
+}
+
+uint64_t SimPerfRecord::GetEvents () const
+{
+    return m_events;
+}
+
+double SimPerfRecord::GetWallSeconds () const
+{
+    return m_wallSeconds;
+}
+
+void SimPerfRecord::Print (std::ostream& os, const std::string& scenario) const
+{
+    static const char* const names[NUM_COMPONENTS] = {
+        "pacer", "feedback", "codec"
+    };
+    std::string name{};
+    for (const char c : scenario) {
+        if (c == '"' || c == '\\') {
+            name += '\\';
+        }
+        name += c;
+    }
+    const double simSeconds = m_simTime.GetSeconds ();
+    os << "{\"scenario\": \"" << name << "\""
+       << ", \"timestamp\": " << std::time (NULL)
+       << ", \"wall_s\": " << m_wallSeconds
+       << ", \"sim_s\": " << simSeconds
+       << ", \"sim_per_wall\": " << (m_wallSeconds > 0. ? simSeconds / m_wallSeconds : 0.)
+       << ", \"events\": " << m_events
+       << ", \"events_per_s\": " << (m_wallSeconds > 0. ? m_events / m_wallSeconds : 0.)
+       << ", \"component_events\": {";
+    for (size_t i = 0; i < NUM_COMPONENTS; ++i) {
+        os << (i > 0 ? ", " : "") << "\"" << names[i] << "\": " << m_componentEvents[i];
+    }
+    os << "}"
+       << ", \"cross_traffic_packets\": {\"tcp\": " << m_tcpPackets
+       << ", \"cbr\": " << m_cbrPackets << "}"
+       << ", \"peak_rss_kb\": " << m_peakRssKb
+       << ", \"peak_rss_scope\": \"" << (m_peakRssProcess ? "process" : "run") << "\""
+       << ", \"controller_s\": " << m_controllerSeconds
+       << "}" << std::endl;
+}
+
+bool SimPerfRecord::Append (const std::string& filename, const std::string& scenario) const
+{
+    // A single write per record, as parallel runs may share the file
+    std::ostringstream os;
+    Print (os, scenario);
+    std::ofstream ofs (filename.c_str (), std::ios_base::out | std::ios_base::app);
+    ofs << os.str () << std::flush;
+    return bool (ofs);
+}
+
+std::string SimPerfRecord::GetDefaultFile ()
+{
+    const char* filename = std::getenv ("RMCAT_PERF_FILE");
+    return filename != NULL ? filename : "rmcat-perf.jsonl";
+}
+
+void SimPerfRecord::TcpSent (Ptr<const Packet> packet)
+{
+    ++m_tcpPackets;
+}
+
+void SimPerfRecord::TcpReceived (Ptr<const Packet> packet, const Address& from)
+{
+    ++m_tcpPackets;
+}
+
+}
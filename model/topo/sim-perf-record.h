@@ -0,0 +1,155 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Performance record of the simulator itself for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef SIM_PERF_RECORD_H
+#define SIM_PERF_RECORD_H
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/address.h"
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * Measures how expensive a run of the simulator (e.g., a test case or an
+ * example) is: wall-clock and simulated time, simulator events processed,
+ * in total and by the main components, packets of the cross traffic, peak
+ * memory and time spent in the congestion controllers. The peak memory is that of the run on Linux, and
+ * that of the whole process so far elsewhere ("peak_rss_scope").
+ *
+ * Records are appended to a file as one JSON object per line, so that the
+ * performance of the scenarios can be tracked over time.
+ */
+class SimPerfRecord
+{
+public:
+    /** Components whose events are counted */
+    enum Component {
+        PACER = 0,      /**< Media, retransmission and probe packets sent */
+        FEEDBACK,       /**< Feedback and RTCP packets, sent or received */
+        CODEC,          /**< Media packets produced by the codecs */
+        NUM_COMPONENTS
+    };
+
+    /**
+     * While a record is being measured, the wall-clock time spent in the
+     * scope of a ControllerScope is accounted as controller time. The
+     * simulator runs in a single thread, so that this is also CPU time
+     */
+    class ControllerScope
+    {
+    public:
+        ControllerScope ();
+        ~ControllerScope ();
+    private:
+        bool m_active;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /** Class constructor */
+    SimPerfRecord ();
+
+    /**
+     * Start measuring. Must be called right before Simulator::Run, once
+     * the applications are installed. The simulator's scheduler is
+     * replaced with one counting the events, which keeps them in a
+     * scheduler of the type set with the "SchedulerType" global value.
+     * Hence, a non-default scheduler has to be selected with that global
+     * value (not with Simulator::SetScheduler) to be kept. On Linux, the
+     * peak memory is reset as well, so that it is the peak of this run
+     */
+    void Start ();
+
+    /** Stop measuring. Must be called right after Simulator::Run */
+    void Stop ();
+
+    /**
+     * Count an event of a component (i.e., a handler of the component is
+     * run). The packets of the TCP and CBR cross traffic are counted by
+     * the record itself
+     *
+     * @param [in] component Component the event belongs to
+     */
+    static void Count (Component component) { ++s_components[component]; }
+
+    /** @retval Total number of events processed */
+    uint64_t GetEvents () const;
+
+    /** @retval Wall-clock time of the run, in seconds */
+    double GetWallSeconds () const;
+
+    /**
+     * Write the record as a single line of JSON
+     *
+     * @param [in,out] os Stream the record is written to
+     * @param [in] scenario Name of the scenario run
+     */
+    void Print (std::ostream& os, const std::string& scenario) const;
+
+    /**
+     * Append the record to a file
+     *
+     * @param [in] filename File the record is appended to
+     * @param [in] scenario Name of the scenario run
+     *
+     * @retval false if the file could not be written
+     */
+    bool Append (const std::string& filename, const std::string& scenario) const;
+
+    /**
+     * @retval File named by the RMCAT_PERF_FILE environment variable,
+     *         or "rmcat-perf.jsonl" if not set
+     */
+    static std::string GetDefaultFile ();
+
+private:
+    void TcpSent (Ptr<const Packet> packet);
+    void TcpReceived (Ptr<const Packet> packet, const Address& from);
+
+    static uint64_t s_components[NUM_COMPONENTS];
+    static bool s_recording;
+    static double s_controllerSeconds;
+
+    std::chrono::steady_clock::time_point m_wallStart;
+    Time m_simStart;
+    double m_wallSeconds;
+    Time m_simTime;
+    uint64_t m_events;
+    uint64_t m_componentEvents[NUM_COMPONENTS];
+    uint64_t m_tcpPackets;      // sent and received by the TCP applications
+    uint64_t m_cbrPackets;      // received by the CBR applications
+    long m_peakRssKb;
+    bool m_peakRssProcess;      // peak of the whole process, not of this run
+    double m_controllerSeconds;
+};
+
+}
+
+#endif /* SIM_PERF_RECORD_H */
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Queue sojourn time statistics implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "sojourn-time-stats.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/queue.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+static const size_t kHistogramBins = 1001; /**< 0 ms to 1 s, then one open-ended bin */
+
+SojournTimeStats::SojournTimeStats ()
+: m_enqueueTimes{},
+  m_histogram (kHistogramBins, 0),
+  m_count{0},
+  m_drops{0},
+  m_sum{},
+  m_max{}
+{}
+
+void SojournTimeStats::Attach (Ptr<NetDevice> device)
+{
+    auto tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+    Ptr<QueueDisc> disc = tc ? tc->GetRootQueueDiscOnDevice (device) : 0;
+    if (disc) {
+        disc->TraceConnectWithoutContext ("Enqueue", MakeCallback (&SojournTimeStats::DiscEnqueue, this));
+        disc->TraceConnectWithoutContext ("Dequeue", MakeCallback (&SojournTimeStats::DiscDequeue, this));
+        disc->TraceConnectWithoutContext ("Drop", MakeCallback (&SojournTimeStats::DiscDrop, this));
+        return;
+    }
+    auto p2pDevice = DynamicCast<PointToPointNetDevice> (device);
+    NS_ASSERT_MSG (p2pDevice, "No queue to track on this device");
+    auto queue = p2pDevice->GetQueue ();
+    queue->TraceConnectWithoutContext ("Enqueue", MakeCallback (&SojournTimeStats::DeviceEnqueue, this));
+    queue->TraceConnectWithoutContext ("Dequeue", MakeCallback (&SojournTimeStats::DeviceDequeue, this));
+    queue->TraceConnectWithoutContext ("Drop", MakeCallback (&SojournTimeStats::DeviceDrop, this));
+}
+
+uint64_t SojournTimeStats::GetCount () const
+{
+    return m_count;
+}
+
+uint64_t SojournTimeStats::GetDrops () const
+{
+    return m_drops;
+}
+
+Time SojournTimeStats::GetMean () const
+{
+    if (m_count == 0) {
+        return Time{};
+    }
+    return NanoSeconds (m_sum.GetNanoSeconds () / int64_t (m_count));
+}
+
+Time SojournTimeStats::GetMax () const
+{
+    return m_max;
+}
+
+Time SojournTimeStats::GetPercentile (double percentile) const
+{
+    const double target = m_count * std::min (std::max (percentile, 0.), 100.) / 100.;
+    uint64_t cumulative = 0;
+    for (size_t bin = 0; bin < m_histogram.size (); ++bin) {
+        cumulative += m_histogram[bin];
+        if (cumulative > 0 && cumulative >= target) {
+            return bin + 1 < m_histogram.size () ? MilliSeconds (bin + 1) : m_max;
+        }
+    }
+    return m_max;
+}
+
+void SojournTimeStats::Print (std::ostream& os) const
+{
+    os << "sojourn:"
+       << " pkts: " << m_count
+       << " drops: " << m_drops
+       << " mean(ms): " << GetMean ().GetMilliSeconds ()
+       << " p50(ms): " << GetPercentile (50.).GetMilliSeconds ()
+       << " p95(ms): " << GetPercentile (95.).GetMilliSeconds ()
+       << " p99(ms): " << GetPercentile (99.).GetMilliSeconds ()
+       << " max(ms): " << m_max.GetMilliSeconds ()
+       << std::endl;
+}
+
+void SojournTimeStats::Enqueued (uint64_t uid)
+{
+    m_enqueueTimes[uid] = Simulator::Now ();
+}
+
+void SojournTimeStats::Dequeued (uint64_t uid)
+{
+    auto it = m_enqueueTimes.find (uid);
+    if (it == m_enqueueTimes.end ()) {
+        return; // enqueued before the stats were attached
+    }
+    const Time sojourn = Simulator::Now () - it->second;
+    m_enqueueTimes.erase (it);
+
+    const size_t bin = std::min<int64_t> (sojourn.GetMilliSeconds (), kHistogramBins - 1);
+    ++m_histogram[bin];
+    ++m_count;
+    m_sum += sojourn;
+    m_max = std::max (m_max, sojourn);
+}
+
+void SojournTimeStats::Dropped (uint64_t uid)
+{
+    // AQMs may also drop packets at dequeue time, after they were enqueued
+    m_enqueueTimes.erase (uid);
+    ++m_drops;
+}
+
+void SojournTimeStats::DiscEnqueue (Ptr<const QueueDiscItem> item)
+{
+    Enqueued (item->GetPacket ()->GetUid ());
+}
+
+void SojournTimeStats::DiscDequeue (Ptr<const QueueDiscItem> item)
+{
+    Dequeued (item->GetPacket ()->GetUid ());
+}
+
+void SojournTimeStats::DiscDrop (Ptr<const QueueDiscItem> item)
+{
+    Dropped (item->GetPacket ()->GetUid ());
+}
+
+void SojournTimeStats::DeviceEnqueue (Ptr<const Packet> packet)
+{
+    Enqueued (packet->GetUid ());
+}
+
+void SojournTimeStats::DeviceDequeue (Ptr<const Packet> packet)
+{
+    Dequeued (packet->GetUid ());
+}
+
+void SojournTimeStats::DeviceDrop (Ptr<const Packet> packet)
+{
+    Dropped (packet->GetUid ());
+}
+
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Queue sojourn time statistics of the bottleneck for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef SOJOURN_TIME_STATS_H
+#define SOJOURN_TIME_STATS_H
+
+#include "ns3/net-device.h"
+#include "ns3/packet.h"
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * Collects the time packets spend in the queue of a network device.
+ * If a root queue disc is installed on the device, its queue is the one
+ * tracked; otherwise the device's own queue is.
+ *
+ * Sojourn times are kept in a histogram with 1-ms bins, so that memory
+ * does not grow with the number of packets.
+ */
+class SojournTimeStats
+{
+public:
+    /** Class constructor */
+    SojournTimeStats ();
+
+    /**
+     * Start tracking the queue of @p device. Must be called once traffic
+     * control has been configured on the device
+     *
+     * @param [in] device Network device whose queue is to be tracked
+     */
+    void Attach (Ptr<NetDevice> device);
+
+    /** @retval Number of packets that left the queue */
+    uint64_t GetCount () const;
+
+    /** @retval Number of packets dropped by the queue */
+    uint64_t GetDrops () const;
+
+    /** @retval Mean sojourn time */
+    Time GetMean () const;
+
+    /** @retval Maximum sojourn time */
+    Time GetMax () const;
+
+    /**
+     * Get a percentile of the sojourn time, with a 1-ms resolution
+     *
+     * @param [in] percentile Percentile to compute, in [0, 100]
+     *
+     * @retval Upper bound of the histogram bin containing the percentile
+     */
+    Time GetPercentile (double percentile) const;
+
+    /**
+     * Write a one-line summary of the statistics
+     *
+     * @param [in,out] os Stream the summary is written to
+     */
+    void Print (std::ostream& os) const;
+
+private:
+    void Enqueued (uint64_t uid);
+    void Dequeued (uint64_t uid);
+    void Dropped (uint64_t uid);
+
+    void DiscEnqueue (Ptr<const QueueDiscItem> item);
+    void DiscDequeue (Ptr<const QueueDiscItem> item);
+    void DiscDrop (Ptr<const QueueDiscItem> item);
+    void DeviceEnqueue (Ptr<const Packet> packet);
+    void DeviceDequeue (Ptr<const Packet> packet);
+    void DeviceDrop (Ptr<const Packet> packet);
+
+    std::unordered_map<uint64_t, Time> m_enqueueTimes; /**< packets in the queue, by uid */
+    std::vector<uint64_t> m_histogram;  /**< 1-ms bins, the last one is open-ended */
+    uint64_t m_count;
+    uint64_t m_drops;
+    Time m_sum;
+    Time m_max;
+};
+
+}
+
+#endif /* SOJOURN_TIME_STATS_H */
@@ -0,0 +1,161 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * ECN step-marking queue disc implementation for rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "step-marking-queue-disc.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+NS_LOG_COMPONENT_DEFINE ("StepMarkingQueueDisc");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (StepMarkingQueueDisc);
+
+TypeId StepMarkingQueueDisc::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("ns3::StepMarkingQueueDisc")
+        .SetParent<QueueDisc> ()
+        .SetGroupName ("TrafficControl")
+        .AddConstructor<StepMarkingQueueDisc> ()
+        .AddAttribute ("MaxBytes",
+                       "The maximum number of bytes accepted by this queue disc.",
+                       UintegerValue (100 * 1000),
+                       MakeUintegerAccessor (&StepMarkingQueueDisc::m_maxBytes),
+                       MakeUintegerChecker<uint32_t> ())
+        .AddAttribute ("MarkingThreshold",
+                       "Sojourn time above which ECN-capable packets are marked CE.",
+                       TimeValue (MilliSeconds (1)),
+                       MakeTimeAccessor (&StepMarkingQueueDisc::m_markingThreshold),
+                       MakeTimeChecker ())
+        ;
+    return tid;
+}
+
+StepMarkingQueueDisc::StepMarkingQueueDisc ()
+: QueueDisc{},
+  m_maxBytes{0},
+  m_markingThreshold{},
+  m_queue{},
+  m_bytes{0},
+  m_marked{0}
+{}
+
+StepMarkingQueueDisc::~StepMarkingQueueDisc ()
+{}
+
+uint32_t StepMarkingQueueDisc::GetMarkedPackets (void) const
+{
+    return m_marked;
+}
+
+bool StepMarkingQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+    if (m_bytes + item->GetPacketSize () > m_maxBytes) {
+        NS_LOG_LOGIC ("Queue full -- dropping pkt");
+        Drop (item);
+        return false;
+    }
+    m_queue.push_back (std::make_pair (item, Simulator::Now ()));
+    m_bytes += item->GetPacketSize ();
+    return true;
+}
+
+Ptr<QueueDiscItem> StepMarkingQueueDisc::DoDequeue (void)
+{
+    if (m_queue.empty ()) {
+        NS_LOG_LOGIC ("Queue empty");
+        return 0;
+    }
+    auto item = m_queue.front ().first;
+    const Time sojourn = Simulator::Now () - m_queue.front ().second;
+    m_queue.pop_front ();
+    m_bytes -= item->GetPacketSize ();
+    if (sojourn > m_markingThreshold) {
+        auto marked = Mark (item);
+        if (marked) {
+            ++m_marked;
+            return marked;
+        }
+    }
+    return item;
+}
+
+Ptr<const QueueDiscItem> StepMarkingQueueDisc::DoPeek (void) const
+{
+    if (m_queue.empty ()) {
+        return 0;
+    }
+    return m_queue.front ().first;
+}
+
+Ptr<QueueDiscItem> StepMarkingQueueDisc::Mark (Ptr<QueueDiscItem> item)
+{
+    auto ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+    if (!ipv4Item) {
+        return 0;
+    }
+    const auto ecn = ipv4Item->GetHeader ().GetEcn ();
+    if (ecn == Ipv4Header::ECN_NotECT || ecn == Ipv4Header::ECN_CE) {
+        return 0;
+    }
+    // Queue disc items cannot be marked in place: rebuild the item with a
+    // modified copy of its (not yet serialized) IPv4 header
+    Ipv4Header header = ipv4Item->GetHeader ();
+    header.SetEcn (Ipv4Header::ECN_CE);
+    Ptr<Ipv4QueueDiscItem> marked = Create<Ipv4QueueDiscItem> (ipv4Item->GetPacket (),
+                                                               ipv4Item->GetAddress (),
+                                                               ipv4Item->GetProtocol (),
+                                                               header);
+    marked->SetTxQueueIndex (ipv4Item->GetTxQueueIndex ());
+    return marked;
+}
+
+bool StepMarkingQueueDisc::CheckConfig (void)
+{
+    if (GetNQueueDiscClasses () > 0) {
+        NS_LOG_ERROR ("StepMarkingQueueDisc cannot have classes");
+        return false;
+    }
+    if (GetNPacketFilters () > 0) {
+        NS_LOG_ERROR ("StepMarkingQueueDisc cannot have packet filters");
+        return false;
+    }
+    if (GetNInternalQueues () > 0) {
+        NS_LOG_ERROR ("StepMarkingQueueDisc keeps its own queue");
+        return false;
+    }
+    return true;
+}
+
+void StepMarkingQueueDisc::InitializeParams (void)
+{
+    m_marked = 0;
+}
+
+}
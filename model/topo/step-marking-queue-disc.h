@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * ECN step-marking queue disc for the bottleneck of rmcat ns3 module.
+ *
+ * @version 0.1.1
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef STEP_MARKING_QUEUE_DISC_H
+#define STEP_MARKING_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include <deque>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * Drop-tail FIFO queue disc that marks ECN-capable packets with CE when
+ * their sojourn time exceeds a (shallow) threshold, as the L4S queue of
+ * a DualQ AQM does (RFC 9332). Packets that are not ECN-capable are
+ * never marked; they are only dropped when the queue is full.
+ *
+ * Install it on the bottleneck device with a small device queue, so that
+ * packets wait here rather than in the device.
+ */
+class StepMarkingQueueDisc: public QueueDisc
+{
+public:
+    static TypeId GetTypeId (void);
+
+    /** Class constructor */
+    StepMarkingQueueDisc ();
+
+    /** Class destructor */
+    virtual ~StepMarkingQueueDisc ();
+
+    /**
+     * Get the number of packets marked CE since the queue disc was created
+     *
+     * @retval Number of marked packets
+     */
+    uint32_t GetMarkedPackets (void) const;
+
+    /**
+     * Return a copy of @p item carrying the CE codepoint, or a null pointer
+     * if @p item is not an ECN-capable IPv4 packet (or is already marked)
+     */
+    static Ptr<QueueDiscItem> Mark (Ptr<QueueDiscItem> item);
+
+private:
+    virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+    virtual Ptr<QueueDiscItem> DoDequeue (void);
+    virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+    virtual bool CheckConfig (void);
+    virtual void InitializeParams (void);
+
+    uint32_t m_maxBytes;        /**< capacity of the queue, in bytes */
+    Time m_markingThreshold;    /**< sojourn time above which ECT packets are marked */
+    std::deque<std::pair<Ptr<QueueDiscItem>, Time> > m_queue; /**< packets, with their enqueue time */
+    uint32_t m_bytes;           /**< bytes in m_queue */
+    uint32_t m_marked;          /**< number of packets marked CE */
+};
+
+}
+
+#endif /* STEP_MARKING_QUEUE_DISC_H */
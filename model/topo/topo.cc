@@ -28,6 +28,8 @@
 #include "topo.h"
 #include "ns3/rmcat-sender.h"
 #include "ns3/rmcat-receiver.h"
+#include "ns3/gcc-sender.h"
+#include "ns3/gcc-receiver.h"
 #include "ns3/nada-controller.h"
 #include "ns3/gcc-controller.h"
 #include <memory>
@@ -107,6 +109,7 @@ static void PacketSinkLogging (const std::string& nameAndId,
  * -- InstallTCP
  * -- InstallCBR
  * -- InstallRMCAT
+ * -- InstallGCC
  */
 
 ApplicationContainer Topo::InstallTCP (const std::string& flowId,
@@ -206,6 +209,38 @@ ApplicationContainer Topo::InstallRMCAT (const std::string& flowId,
     return apps;
 }
 
+ApplicationContainer Topo::InstallGCC (const std::string& flowId,
+                                       Ptr<Node> sender,
+                                       Ptr<Node> receiver,
+                                       uint16_t serverPort)
+{
+    auto gccAppSend = CreateObject<GccSender> ();
+    auto gccAppRecv = CreateObject<GccReceiver> ();
+    sender->AddApplication (gccAppSend);
+    receiver->AddApplication (gccAppRecv);
+
+    Ipv4Address serverIP = GetIpv4AddressOfNode (receiver, 1, 0);
+    gccAppSend->Setup (serverIP, serverPort);
+
+    /* configure congestion controller */
+    auto controller = std::make_shared<rmcat::GccController> ();
+    controller->setLogCallback (logFromController);
+    controller->setId (flowId);
+    gccAppSend->SetController (controller);
+
+    gccAppSend->SetStartTime (Seconds (0));
+    gccAppSend->SetStopTime (Seconds (T_MAX_S));
+
+    gccAppRecv->Setup (serverPort);
+    gccAppRecv->SetStartTime (Seconds (0));
+    gccAppRecv->SetStopTime (Seconds (T_MAX_S));
+
+    ApplicationContainer apps;
+    apps.Add (gccAppSend);
+    apps.Add (gccAppRecv);
+    return apps;
+}
+
 void Topo::logFromController (const std::string& msg) {
     NS_LOG_INFO ("controller_log: " << msg);
 }
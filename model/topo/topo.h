@@ -120,6 +120,28 @@ protected:
                                               Ptr<Node> receiver,
                                               uint16_t serverPort);
 
+    /**
+     * Install two applications (sender and receiver) implementing a GCC
+     * flow, with per-packet feedback from the receiver.
+     * The sender of application data (resp. receiver) will be installed at the
+     * sender (resp. receiver) node.
+     *
+     * @param [in]     flowId A string denoting the flow's id. Useful for
+     *                        logging and plotting
+     * @param [in,out] sender ns3 node that is to contain the #GccSender
+     *                        application
+     * @param [in,out] receiver ns3 node that is to contain the #GccReceiver
+     *                          application
+     * @param [in]     serverPort UDP port where the receiver application is
+     *                            to read media packets
+     *
+     * @retval A container with the two applications (sender and receiver)
+     */
+    static ApplicationContainer InstallGCC (const std::string& flowId,
+                                            Ptr<Node> sender,
+                                            Ptr<Node> receiver,
+                                            uint16_t serverPort);
+
 
     /**
      * Simple logging callback to be passed to the congestion controller
@@ -26,6 +26,7 @@
  */
 
 #include "wired-topo.h"
+#include "bottleneck-aqm.h"
 
 namespace ns3 {
 
@@ -37,7 +38,8 @@ WiredTopo::WiredTopo ()
 WiredTopo::~WiredTopo ()
 {}
 
-void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDelay)
+void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDelay,
+                       BottleneckAqm aqm)
 {
     // Set up bottleneck link
     m_bottleneckNodes.Create (2);
@@ -50,9 +52,10 @@ void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDela
     // At least one full packet with default size must fit
     NS_ASSERT (m_bufSize >= DEFAULT_PACKET_SIZE + IPV4_UDP_OVERHEAD);
 
+    const uint32_t devBufSize = BottleneckAqmHelper::GetDeviceQueueBytes (aqm, m_bufSize);
     bottleneckLinkHlpr.SetQueue ("ns3::DropTailQueue",
                                  "Mode", StringValue ("QUEUE_MODE_BYTES"),
-                                 "MaxBytes", UintegerValue (m_bufSize));
+                                 "MaxBytes", UintegerValue (devBufSize));
 
     m_bottleneckDevices = bottleneckLinkHlpr.Install (m_bottleneckNodes);
 
@@ -77,13 +80,17 @@ void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDela
                             "Mode", StringValue ("QUEUE_MODE_BYTES"),
                             "MaxBytes", UintegerValue (m_bufSize));
 
-    // Disable tc now, some bug in ns3 causes extra delay
-    TrafficControlHelper tch;
-    tch.Uninstall (m_bottleneckDevices);
+    BottleneckAqmHelper::Install (m_bottleneckDevices, aqm, m_bufSize);
+    m_bottleneckStats.Attach (m_bottleneckDevices.Get (0));
 
     Packet::EnablePrinting ();
 }
 
+const SojournTimeStats& WiredTopo::GetBottleneckStats () const
+{
+    return m_bottleneckStats;
+}
+
 ApplicationContainer WiredTopo::InstallTCP (const std::string& flowId,
                                             uint16_t serverPort,
                                             bool newNode)
@@ -136,6 +143,25 @@ ApplicationContainer WiredTopo::InstallRMCAT (const std::string& flowId,
                                serverPort);
 }
 
+ApplicationContainer WiredTopo::InstallGCC (const std::string& flowId,
+                                            uint16_t serverPort,
+                                            uint32_t pDelayMs,
+                                            bool forward)
+{
+    auto appNodes = SetupAppNodes (pDelayMs, true);
+
+    auto sender = appNodes.Get (1);
+    auto receiver = appNodes.Get (0);
+    if (forward) {
+        std::swap (sender, receiver);
+    }
+
+    return Topo::InstallGCC (flowId,
+                             sender,
+                             receiver,
+                             serverPort);
+}
+
 void WiredTopo::SetupAppNode (Ptr<Node> node, int bottleneckIdx, uint32_t pDelayMs)
 {
     NodeContainer nodes (node, m_bottleneckNodes.Get (bottleneckIdx));
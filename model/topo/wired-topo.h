@@ -29,6 +29,7 @@
 #define WIRED_TOPO_H
 
 #include "topo.h"
+#include "sojourn-time-stats.h"
 
 namespace ns3 {
 
@@ -69,8 +70,17 @@ public:
      *                     right nodes
      * @param [in] msQDelay Capacity of the queue at the bottleneck
      *                      link (in ms)
+     * @param [in] aqm Queue management at the bottleneck link (in both
+     *                 directions)
      */
-    void Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDelay);
+    void Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDelay,
+                BottleneckAqm aqm = AQM_DROPTAIL);
+
+    /**
+     * Sojourn time statistics of the forward (left-to-right) bottleneck
+     * queue. Only valid after #Build
+     */
+    const SojournTimeStats& GetBottleneckStats () const;
 
     /**
      * Install a one-way bulk TCP flow in a pair of (left-to-right) nodes
@@ -132,6 +142,18 @@ public:
                                        uint32_t pDelayMs,
                                        bool forward);
 
+    /**
+     * Install a one-way GCC flow in a pair of (left-right) nodes. Same
+     * parameters as #InstallRMCAT , with the #GccSender and #GccReceiver
+     * applications
+     *
+     * @retval A container with the two applications (sender and receiver)
+     */
+    ApplicationContainer InstallGCC (const std::string& flowId,
+                                     uint16_t serverPort,
+                                     uint32_t pDelayMs,
+                                     bool forward);
+
 private:
     void SetupAppNode (Ptr<Node> node, int subnet, uint32_t pDelayMs);
     NodeContainer SetupAppNodes (uint32_t pDelayMs, bool newNode);
@@ -142,6 +164,7 @@ protected:
     NodeContainer m_bottleneckNodes;
     NodeContainer m_appNodes; // Last application node pair created
     NetDeviceContainer m_bottleneckDevices;
+    SojournTimeStats m_bottleneckStats;
     InternetStackHelper m_inetStackHlpr;
     PointToPointHelper m_appLinkHlpr;
 };
@@ -29,6 +29,7 @@
 #define RMCAT_COMMON_TEST_H
 
 #include "ns3/test.h"
+#include "ns3/sim-perf-record.h"
 #include <fstream>
 
 /* default simulation parameters */
@@ -80,6 +81,9 @@ protected:
     uint64_t m_capacity;   // bottleneck capacity (in bps)
     uint32_t m_delay;      // one-way propagation delay (in ms)
     uint32_t m_qdelay;     // bottleneck queue depth (in ms)
+
+    /* Performance of the simulation, appended to SimPerfRecord::GetDefaultFile () */
+    ns3::SimPerfRecord m_perf;
 };
 
 #endif /* RMCAT_COMMON_TEST_H */
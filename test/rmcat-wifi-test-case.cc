@@ -352,7 +352,10 @@ void RmcatWifiTestCase::DoRun ()
     /* Kick off simulation */
     NS_LOG_INFO ("Run Simulation.");
     Simulator::Stop (Seconds (m_simTime));
+    m_perf.Start ();
     Simulator::Run ();
+    m_perf.Stop ();
+    m_perf.Append (SimPerfRecord::GetDefaultFile (), GetName ());
     Simulator::Destroy ();
     NS_LOG_INFO ("Done.");
 }
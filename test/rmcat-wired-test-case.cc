@@ -52,6 +52,28 @@ static void SenderPauseResume (Ptr<RmcatSender> send, bool pause)
     send->PauseResume (pause);
 }
 
+static void SenderSaveState (Ptr<RmcatSender> send, std::string filename)
+{
+    std::ofstream ofs{filename.c_str ()};
+    NS_ASSERT_MSG (ofs.good (), "Cannot create checkpoint file " << filename);
+    send->SaveState (ofs);
+    NS_LOG_INFO ("Checkpoint written to " << filename);
+}
+
+/*
+ * Checkpoints go to a temporary directory, one per process: shared by the
+ * test cases run in it, and not left behind in the current directory
+ */
+static std::string SnapshotFileName (const std::string& prefix,
+                                     const std::string& flowId)
+{
+    static const std::string dir = SystemPath::MakeTemporaryDirectoryName ();
+    SystemPath::MakeDirectories (dir);
+    std::stringstream ss;
+    ss << prefix << "_" << flowId << ".ckpt";
+    return SystemPath::Append (dir, ss.str ());
+}
+
 /* Constructor */
 RmcatWiredTestCase::RmcatWiredTestCase (uint64_t capacity, // bottleneck capacity (in bps)
                                         uint32_t delay,    // one-way propagation delay (in ms)
@@ -65,7 +87,16 @@ RmcatWiredTestCase::RmcatWiredTestCase (uint64_t capacity, // bottleneck capacit
   m_numInitOnFlows{0},
   m_simTime{RMCAT_TC_SIMTIME},
   m_pauseFid{0},
-  m_codecType{SYNCODEC_TYPE_FIXFPS}
+  m_codecType{SYNCODEC_TYPE_FIXFPS},
+  m_aqm{AQM_DROPTAIL},
+  m_ecn{false},
+  m_gcc{false},
+  m_gccConfigFile{},
+  m_gccParameters{},
+  m_warmupTime{0},
+  m_snapshotPrefix{},
+  m_saveSnapshot{false},
+  m_warmStart{false}
 {}
 
 
@@ -169,6 +200,38 @@ void RmcatWiredTestCase::SetTCPShortFlows (size_t numFlows,
 
 }
 
+/*
+ * Warm-start forking, checkpoint side: the state of every forward RMCAT
+ * flow is saved once the warm-up period is over. Test cases configured
+ * with #SetWarmStart and the same prefix can then skip the warm-up.
+ */
+void RmcatWiredTestCase::SetSnapshot (uint32_t warmupTime,
+                                      const std::string& prefix)
+{
+    NS_ASSERT (!m_warmStart);
+    m_warmupTime = warmupTime;
+    m_snapshotPrefix = prefix;
+    m_saveSnapshot = true;
+}
+
+/*
+ * Warm-start forking, fork side: forward RMCAT flows are restored from
+ * the checkpoint and start at the end of the warm-up period. The network
+ * is idle until then, so the simulator jumps straight to the fork point.
+ *
+ * If no test case with the same prefix took the checkpoint earlier in
+ * this process (e.g., the test case is run on its own), the warm-up is
+ * run first, with the same network and forward RMCAT flows.
+ */
+void RmcatWiredTestCase::SetWarmStart (uint32_t warmupTime,
+                                       const std::string& prefix)
+{
+    NS_ASSERT (!m_saveSnapshot);
+    m_warmupTime = warmupTime;
+    m_snapshotPrefix = prefix;
+    m_warmStart = true;
+}
+
 /*
  * Inherited DoSetup function:
  * -- Build network topology
@@ -176,11 +239,88 @@ void RmcatWiredTestCase::SetTCPShortFlows (size_t numFlows,
  */
 void RmcatWiredTestCase::DoSetup ()
 {
+    if (m_warmStart && !HasSnapshot ()) {
+        RunWarmUp ();
+    }
     RmcatTestCase::DoSetup ();
-    m_topo.Build (m_capacity, m_delay, m_qdelay);
+    m_topo.Build (m_capacity, m_delay, m_qdelay, m_aqm);
     ns3::LogComponentEnable ("RmcatSimTestWired", LOG_LEVEL_INFO);
 }
 
+/*
+ * Whether the checkpoints of all the forward RMCAT flows exist
+ */
+bool RmcatWiredTestCase::HasSnapshot () const
+{
+    for (size_t i = 0; i < m_numFlowsFw; ++i) {
+        std::ifstream ifs{SnapshotFileName (m_snapshotPrefix, GetFlowId (i, true)).c_str ()};
+        if (!ifs.good ()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Run the warm-up of a warm-start test case as a test case of its own,
+ * taking the checkpoint. Runs before DoSetup, as the warm-up's simulation
+ * is destroyed at its end
+ */
+void RmcatWiredTestCase::RunWarmUp ()
+{
+    NS_LOG_INFO ("No checkpoint " << m_snapshotPrefix << ", running the warm-up");
+    RmcatWiredTestCase warmUp{m_capacity, m_delay, m_qdelay, m_snapshotPrefix};
+    warmUp.m_numFlowsFw = m_numFlowsFw;
+    warmUp.m_pDelays = m_pDelays;
+    warmUp.m_codecType = m_codecType;
+    warmUp.m_aqm = m_aqm;
+    warmUp.m_ecn = m_ecn;
+    warmUp.SetSimTime (m_warmupTime + 1);
+    warmUp.SetSnapshot (m_warmupTime, m_snapshotPrefix);
+    warmUp.DoSetup ();
+    warmUp.DoRun ();
+    warmUp.DoTeardown ();
+}
+
+/*
+ * Flow ID of the i-th RMCAT flow, which also names its checkpoint
+ */
+std::string RmcatWiredTestCase::GetFlowId (size_t i, bool fwd) const
+{
+    std::stringstream ss;
+    ss << "rmcat_";
+    switch (m_codecType) {
+        case SYNCODEC_TYPE_PERFECT:
+            ss << "cbr_";
+            break;
+        case SYNCODEC_TYPE_FIXFPS:
+            ss << "fixfps_";
+            break;
+        case SYNCODEC_TYPE_STATS:
+            ss << "stats_";
+            break;
+        case SYNCODEC_TYPE_TRACE:
+            ss << "tr_";
+            break;
+        case SYNCODEC_TYPE_SHARING:
+            ss << "cs_";
+            break;
+        case SYNCODEC_TYPE_HYBRID:
+            ss << "hybrid_";
+            break;
+        default:
+            ss << "other_";
+    }
+
+    if (fwd) {
+        ss << "fwd_";
+    } else {
+        ss << "bwd_";
+    }
+    ss << i;
+    return ss.str ();
+}
+
 /*
  * Inherited DoRun () function:
  * -- Instantiate RMCAT and TCP background flows
@@ -201,14 +341,19 @@ void RmcatWiredTestCase::DoRun ()
     /*
      * Configure forward direction path and traffic
     */
-    std::vector<Ptr<RmcatSender> > sendFw (m_numFlowsFw);
+    std::vector<Ptr<RmcatSender> > sendFw (m_gcc ? 0 : m_numFlowsFw);
+    std::vector<Ptr<GccSender> > gccSendFw (m_gcc ? m_numFlowsFw : 0);
     std::vector<std::shared_ptr<Timer> > ptimersFw;
     std::vector<std::shared_ptr<Timer> > rtimersFw;
     std::vector<Ptr<BulkSendApplication> > tcpLongSend (m_numTcpFlows);
     std::vector<Ptr<BulkSendApplication> > tcpShortSend;
 
     SetUpPath (m_timesFw, m_capacitiesFw, true);     // time-varying available BW
-    SetUpRMCAT (sendFw, ptimersFw, rtimersFw, true); // instantiate forward RMCAT flows
+    if (m_gcc) {
+        SetUpGCC (gccSendFw);                        // instantiate forward GCC flows
+    } else {
+        SetUpRMCAT (sendFw, ptimersFw, rtimersFw, true); // instantiate forward RMCAT flows
+    }
     SetUpTCPLong (m_numTcpFlows, tcpLongSend);       // instantiate background long lived TCP flows
     SetUpTCPShort (m_numShortTcpFlows,
                    m_numInitOnFlows,
@@ -230,7 +375,13 @@ void RmcatWiredTestCase::DoRun ()
     /* Kick off simulation */
     NS_LOG_INFO ("Run Simulation.");
     Simulator::Stop (Seconds (m_simTime));
+    m_perf.Start ();
     Simulator::Run ();
+    m_perf.Stop ();
+    m_perf.Append (SimPerfRecord::GetDefaultFile (), GetName ());
+    std::stringstream ss;
+    m_topo.GetBottleneckStats ().Print (ss);
+    NS_LOG_INFO ("Bottleneck " << ss.str ());
     Simulator::Destroy ();
     NS_LOG_INFO ("Done.");
 }
@@ -291,48 +442,13 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
     size_t numFlows = fwd ? m_numFlowsFw : m_numFlowsBw;
     uint32_t pDelayMs = 0;
 
-    // configure flowID as string
-    std::stringstream ss0;
-    ss0 << "rmcat_";
-    switch (m_codecType) {
-        case SYNCODEC_TYPE_PERFECT:
-            ss0 << "cbr_";
-            break;
-        case SYNCODEC_TYPE_FIXFPS:
-            ss0 << "fixfps_";
-            break;
-        case SYNCODEC_TYPE_STATS:
-            ss0 << "stats_";
-            break;
-        case SYNCODEC_TYPE_TRACE:
-            ss0 << "tr_";
-            break;
-        case SYNCODEC_TYPE_SHARING:
-            ss0 << "cs_";
-            break;
-        case SYNCODEC_TYPE_HYBRID:
-            ss0 << "hybrid_";
-            break;
-        default:
-            ss0 << "other_";
-    }
-
-    if (fwd) {
-        ss0 << "fwd_";
-    } else {
-        ss0 << "bwd_";
-    }
-
     for (size_t i = 0; i < numFlows; ++i) {
         // configure per-flow RTT
         if (fwd && m_pDelays.size () > 0) {
             pDelayMs = m_pDelays[i];
         }
 
-        std::stringstream ss;
-        ss << ss0.str () << i;
-
-        ApplicationContainer rmcatApps = m_topo.InstallRMCAT (ss.str (),          // Flow ID
+        ApplicationContainer rmcatApps = m_topo.InstallRMCAT (GetFlowId (i, fwd), // Flow ID
                                                               basePort + (i * 2), // port number
                                                               pDelayMs,           // path RTT
                                                               fwd);               // direction indicator
@@ -344,6 +460,9 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
         send[i]->SetRmax (RMCAT_TC_RMAX);
         send[i]->SetStartTime (Seconds (0));
         send[i]->SetStopTime (Seconds (m_simTime-1));
+        if (fwd && m_ecn) {
+            send[i]->EnableEcn ();
+        }
     }
 
     /* configure start/end times for forward flows */
@@ -366,6 +485,28 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
         }
     }
 
+    /* warm-start forking of forward flows */
+    if (fwd && (m_saveSnapshot || m_warmStart)) {
+        for (size_t i = 0; i < numFlows; ++i) {
+            const std::string filename = SnapshotFileName (m_snapshotPrefix, GetFlowId (i, fwd));
+            if (m_saveSnapshot) {
+                Simulator::Schedule (Seconds (m_warmupTime), &SenderSaveState,
+                                     send[i], filename);
+                continue;
+            }
+            std::ifstream ifs{filename.c_str ()};
+            NS_TEST_ASSERT_MSG_EQ (ifs.good (), true,
+                                   "Checkpoint file " << filename << " not found");
+            const bool res = send[i]->RestoreState (ifs);
+            NS_TEST_ASSERT_MSG_EQ (res, true,
+                                   "Cannot restore checkpoint file " << filename);
+            const uint32_t startTime = (m_startTimesFw.size () > 0) ?
+                                           std::max (m_startTimesFw[i], m_warmupTime) :
+                                           m_warmupTime;
+            send[i]->SetStartTime (Seconds (startTime));
+        }
+    }
+
     /* configure media pause/resume times for given flow */
     if (fwd && m_pauseTimes.size () > 0
             && m_resumeTimes.size () > 0) {
@@ -398,6 +539,58 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
     }
 }
 
+/*
+ *  Instantiate forward GCC flows
+ *
+ *  Media pause/resume and warm-start forking are not supported for them.
+ */
+void RmcatWiredTestCase::SetUpGCC (std::vector<Ptr<GccSender> >& send)
+{
+    NS_ASSERT (m_pauseTimes.size () == 0);
+    NS_ASSERT (!m_saveSnapshot && !m_warmStart);
+
+    const uint32_t basePort = RMCAT_TC_RMCAT_PORT;
+    uint32_t pDelayMs = 0;
+
+    for (size_t i = 0; i < m_numFlowsFw; ++i) {
+        // configure per-flow RTT
+        if (m_pDelays.size () > 0) {
+            pDelayMs = m_pDelays[i];
+        }
+
+        std::stringstream ss;
+        ss << "gcc_fwd_" << i;
+
+        ApplicationContainer gccApps = m_topo.InstallGCC (ss.str (),          // Flow ID
+                                                          basePort + (i * 2), // port number
+                                                          pDelayMs,           // path RTT
+                                                          true);              // direction indicator
+
+        send[i] = DynamicCast<GccSender> (gccApps.Get (0));
+        send[i]->SetCodecType (m_codecType);
+        send[i]->SetRinit (RMCAT_TC_RINIT);
+        send[i]->SetRmin (RMCAT_TC_RMIN);
+        send[i]->SetRmax (RMCAT_TC_RMAX);
+        send[i]->SetStartTime (Seconds (0));
+        send[i]->SetStopTime (Seconds (m_simTime-1));
+        if (!m_gccConfigFile.empty ()) {
+            send[i]->SetAttribute ("GccConfigFile", StringValue (m_gccConfigFile));
+        }
+        if (!m_gccParameters.empty ()) {
+            send[i]->SetAttribute ("GccParameters", StringValue (m_gccParameters));
+        }
+        if (m_ecn) {
+            send[i]->EnableEcn ();
+        }
+
+        /* configure start/end times */
+        if (m_startTimesFw.size () > 0) {
+            send[i]->SetStartTime (Seconds (m_startTimesFw[i]));
+            send[i]->SetStopTime (Seconds (m_endTimesFw[i]));
+        }
+    }
+}
+
 /*
  * Instantiate long lived background TCP flows
  * (only forward direction is supported for now)
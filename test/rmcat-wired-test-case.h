@@ -30,13 +30,16 @@
 
 
 #include "ns3/wired-topo.h"
+#include "ns3/bottleneck-aqm.h"
 #include "ns3/rmcat-sender.h"
 #include "ns3/rmcat-receiver.h"
+#include "ns3/gcc-sender.h"
 #include "ns3/rmcat-constants.h"
 #include "ns3/bulk-send-application.h"
 #include "ns3/application-container.h"
 #include "ns3/log.h"
 #include "ns3/timer.h"
+#include "ns3/system-path.h"
 #include "rmcat-common-test.h"
 #include <fstream>
 
@@ -72,6 +75,19 @@ public:
     void SetSimTime (uint32_t simTime) {m_simTime = simTime; };
     void SetCodec (SyncodecType codecType) { m_codecType = codecType; };
     void SetPropDelays (const std::vector<uint32_t>& pDelays) { m_pDelays = pDelays; } ;
+    void SetAqm (BottleneckAqm aqm) { m_aqm = aqm; };
+
+    /* forward media flows send ECN-capable (ECT(1)) packets */
+    void SetEcn (bool ecn) { m_ecn = ecn; };
+
+    /* forward media flows run GCC (GccSender) rather than NADA (RmcatSender) */
+    void SetGCC (bool gcc) { m_gcc = gcc; };
+
+    /* file of GCC controller parameters (see rmcat::GccConfig) for the GCC flows */
+    void SetGccConfigFile (const std::string& filename) { m_gccConfigFile = filename; };
+
+    /* GCC controller parameters, as name=value[,name=value...], applied after the file's */
+    void SetGccParameters (const std::string& params) { m_gccParameters = params; };
 
     /* configure time-varying BW */
     void SetBW (const std::vector<uint32_t>& times,
@@ -102,6 +118,15 @@ public:
                            size_t numInitOnFlows,
                            bool fwd);
 
+    /* warm-start forking: checkpoint forward RMCAT flows
+     * once the warm-up period is over */
+    void SetSnapshot (uint32_t warmupTime, const std::string& prefix);
+
+    /* warm-start forking: start forward RMCAT flows at the
+     * end of the warm-up period, from a previous checkpoint
+     * (the warm-up is run first if there is none) */
+    void SetWarmStart (uint32_t warmupTime, const std::string& prefix);
+
 protected:
     /* Instantiate flows in DoRun () */
     void SetUpPath (const std::vector<uint32_t>& timesFw,
@@ -113,6 +138,8 @@ protected:
                      std::vector<std::shared_ptr<Timer> >& rtimers,
                      bool fwd);
 
+    void SetUpGCC (std::vector< Ptr<GccSender> >& send);
+
     void SetUpTCPLong (size_t numFlows,
                        std::vector<Ptr<BulkSendApplication> >& tcpSend);
 
@@ -124,6 +151,10 @@ protected:
     WiredTopo m_topo;
 
 private:
+    std::string GetFlowId (size_t i, bool fwd) const;
+    bool HasSnapshot () const;
+    void RunWarmUp ();
+
     /* Member variables specifying test case configuration */
     size_t m_numFlowsFw;        // # of RMCAT flows on forward path
     size_t m_numFlowsBw;        // # of RMCAT flows on backward path
@@ -161,6 +192,21 @@ private:
     std::vector<uint32_t> m_resumeTimes;
 
     SyncodecType m_codecType;
+
+    /* queue management at the bottleneck */
+    BottleneckAqm m_aqm;
+    bool m_ecn;
+
+    /* congestion control of the forward media flows */
+    bool m_gcc;
+    std::string m_gccConfigFile;
+    std::string m_gccParameters;
+
+    /* warm-start forking: checkpoint time (in seconds) and file prefix */
+    uint32_t m_warmupTime;
+    std::string m_snapshotPrefix;
+    bool m_saveSnapshot;
+    bool m_warmStart;
 };
 
 #endif /* RMCAT_WIRED_TEST_CASE_H */
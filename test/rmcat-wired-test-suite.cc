@@ -26,6 +26,7 @@
  */
 
 #include "rmcat-wired-test-case.h"
+#include <cstdlib>
 
 /*
  * Implementation of the RmcatTestSuite class,
@@ -150,6 +151,29 @@ RmcatTestSuite::RmcatTestSuite ()
     tc53->SetRMCATFlows (1, t0s, t0s, true);     // Forward path
     tc53->SetRMCATFlows (1, t0s, t0s, false);    // Backward path
 
+    // Same, with a GCC forward flow and the backward path congested down
+    // to a fraction of the feedback rate for a while: GCC backs off while
+    // its feedback is lost, and ramps up again once it gets through
+    std::vector<uint32_t> timeTC53gccbwd;
+    std::vector<uint64_t> bwTC53gccbwd;
+    timeTC53gccbwd.push_back (0);  bwTC53gccbwd.push_back (2 * (1u << 20)); // 2 Mbps
+    timeTC53gccbwd.push_back (35); bwTC53gccbwd.push_back (20 * (1u << 10)); // 20 Kbps
+    timeTC53gccbwd.push_back (50); bwTC53gccbwd.push_back (2 * (1u << 20)); // 2 Mbps
+
+    RmcatWiredTestCase * tc53gcc = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.3-fixfps-gcc-feedback-timeout"};
+    tc53gcc->SetSimTime (simT);
+    tc53gcc->SetGCC (true);
+    tc53gcc->SetGccParameters ("feedback_timeout_intervals=3");  // off by default
+    // GCC parameters can be changed without recompiling, e.g., for sweeps:
+    // RMCAT_GCC_CONFIG=<file> ./test.py -s rmcat-wired
+    if (const char * gccConfig = std::getenv ("RMCAT_GCC_CONFIG")) {
+        tc53gcc->SetGccConfigFile (gccConfig);
+    }
+    tc53gcc->SetBW (timeTC53fwd, bwTC53fwd, true);         // Forward path
+    tc53gcc->SetBW (timeTC53gccbwd, bwTC53gccbwd, false);  // Backward path
+    tc53gcc->SetRMCATFlows (1, t0s, t0s, true);            // Forward path
+    tc53gcc->SetRMCATFlows (1, t0s, t0s, false);           // Backward path
+
     // -----------------------
     // Test Case 5.4: Competing Media Flows with same Congestion Control Algorithm
     // -----------------------
@@ -195,6 +219,21 @@ RmcatTestSuite::RmcatTestSuite ()
     tc56->SetSimTime (300);                 // Simulation time: 300s
     tc56->SetTCPLongFlows (1, tstartTC56, tstopTC56, true);    // Forward path
 
+    // Same, with queue management at the bottleneck instead of drop-tail
+    std::vector<RmcatWiredTestCase *> tc56aqm;
+    const BottleneckAqm aqmsTC56[] = {AQM_CODEL, AQM_FQ_CODEL, AQM_PIE, AQM_DUALQ};
+    for (const auto aqm : aqmsTC56) {
+        std::stringstream ss;
+        ss << "rmcat-test-case-5.6-fixfps-" << BottleneckAqmHelper::GetName (aqm);
+        RmcatWiredTestCase * tc = new RmcatWiredTestCase{bw, pdel, qdel, ss.str ()};
+        tc->SetCapacity (2 * (1u << 20));   // Bottleneck capacity: 2Mbps
+        tc->SetSimTime (300);               // Simulation time: 300s
+        tc->SetTCPLongFlows (1, tstartTC56, tstopTC56, true);  // Forward path
+        tc->SetAqm (aqm);
+        tc->SetEcn (aqm == AQM_DUALQ);      // L4S flows go to DualQ's marking queue
+        tc56aqm.push_back (tc);
+    }
+
     // -----------------------
     // Test Case 5.7: Media Flow Competing with Short TCP Flows
     // -----------------------
@@ -235,9 +274,13 @@ RmcatTestSuite::RmcatTestSuite ()
     AddTestCase (tc52, TestCase::QUICK);
 
     AddTestCase (tc53, TestCase::QUICK);
+    AddTestCase (tc53gcc, TestCase::QUICK);
     AddTestCase (tc54, TestCase::QUICK);
     AddTestCase (tc55, TestCase::QUICK);
     AddTestCase (tc56, TestCase::QUICK);
+    for (auto tc : tc56aqm) {
+        AddTestCase (tc, TestCase::QUICK);
+    }
     AddTestCase (tc57, TestCase::QUICK);
     AddTestCase (tc58, TestCase::QUICK);
 }
@@ -113,6 +113,48 @@ RmcatVaryParamTestSuite::RmcatVaryParamTestSuite ()
             AddTestCase (tc56tmp, TestCase::QUICK);
         }
     }
+
+    // -----------------------
+    // Warm-start variants: a single warm-up run is checkpointed after
+    // warmT seconds; every variant forks from that checkpoint instead of
+    // ramping up from R_init again
+    // -----------------------
+    const uint64_t bwWarm = 1000 * (1u << 10);   // 1 Mbps
+    const uint32_t pdelWarm = 50;                // 50 ms
+    const uint32_t warmT = 60;                   // warm-up period: 60s
+    const std::string warmPrefix{"rmcat-test-case-warmup-C1000-pdel50"};
+
+    RmcatWiredTestCase * tcWarm = new RmcatWiredTestCase{bwWarm, pdelWarm, qdel, warmPrefix};
+    tcWarm->SetSimTime (warmT + 1);
+    tcWarm->SetSnapshot (warmT, warmPrefix);
+    AddTestCase (tcWarm, TestCase::QUICK);
+
+    // Variant: one or two long TCP flows joining right after the fork
+    for (size_t ntcp = 1; ntcp <= 2; ++ntcp) {
+        std::vector<uint32_t> tstart (ntcp, warmT);
+        std::vector<uint32_t> tstop (ntcp, warmT + 120);
+        std::stringstream ss;
+        ss << "rmcat-test-case-warm-C1000-pdel50-tcp" << ntcp;
+        RmcatWiredTestCase * tc = new RmcatWiredTestCase{bwWarm, pdelWarm, qdel, ss.str ()};
+        tc->SetSimTime (warmT + 120);
+        tc->SetTCPLongFlows (ntcp, tstart, tstop, true);
+        tc->SetWarmStart (warmT, warmPrefix);
+        AddTestCase (tc, TestCase::QUICK);
+    }
+
+    // Variant: capacity drops to 50% and 25% 30s after the fork
+    const uint64_t dropList[] = {500 * (1u << 10), 250 * (1u << 10)};
+    for (const uint64_t drop : dropList) {
+        std::vector<uint32_t> times{0, warmT + 30, warmT + 60};
+        std::vector<uint64_t> capacities{bwWarm, drop, bwWarm};
+        std::stringstream ss;
+        ss << "rmcat-test-case-warm-C1000-pdel50-drop" << drop / (1u << 10);
+        RmcatWiredTestCase * tc = new RmcatWiredTestCase{bwWarm, pdelWarm, qdel, ss.str ()};
+        tc->SetSimTime (warmT + 120);
+        tc->SetBW (times, capacities, true);
+        tc->SetWarmStart (warmT, warmPrefix);
+        AddTestCase (tc, TestCase::QUICK);
+    }
 }
 
 static RmcatVaryParamTestSuite rmcatVparamTestSuite;
@@ -0,0 +1,308 @@
+#!/usr/bin/python
+
+###############################################################################
+#  Copyright 2016-2017 Cisco Systems, Inc.                                    #
+#                                                                             #
+#  Licensed under the Apache License, Version 2.0 (the "License");            #
+#  you may not use this file except in compliance with the License.           #
+#                                                                             #
+#  You may obtain a copy of the License at                                    #
+#                                                                             #
+#      http://www.apache.org/licenses/LICENSE-2.0                             #
+#                                                                             #
+#  Unless required by applicable law or agreed to in writing, software        #
+#  distributed under the License is distributed on an "AS IS" BASIS,          #
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+#  See the License for the specific language governing permissions and        #
+#  limitations under the License.                                             #
+###############################################################################
+
+# Tuning of the GCC controller's constants over the wired rmcat scenarios.
+#
+# Each configuration is evaluated by running the gcc-tune-eval example on
+# every scenario (and seed), in parallel worker processes. Configurations
+# are scored by a weighted combination of the bottleneck queuing delay,
+# the utilization of the available capacity and the fairness across flows
+# (lower is better), and the Pareto front of the three is written out.
+#
+# Run from the ns3 root directory (ns-3.xx/) once the examples are built:
+#
+# python ./src/ns3-rmcat/tools/gcc_tune.py random --samples 50 --jobs 8
+# python ./src/ns3-rmcat/tools/gcc_tune.py grid --params k_up,k_down --points 5
+# python ./src/ns3-rmcat/tools/gcc_tune.py bayes --init 16 --iterations 8 --jobs 8
+
+from __future__ import print_function
+
+import os
+import sys
+import re
+import csv
+import json
+import glob
+import math
+import random
+import argparse
+import itertools
+import subprocess
+import multiprocessing
+
+import numpy as np
+
+# name: (default, low, high, log scale)
+PARAMS = {
+    'max_adapt_offset_ms':         (15.,    5.,     50.,    False),
+    'overusing_time_threshold_ms': (100.,   10.,    300.,   False),
+    'k_up':                        (0.0087, 0.001,  0.05,   True),
+    'k_down':                      (0.039,  0.005,  0.2,    True),
+    'beta':                        (0.85,   0.5,    0.95,   False),
+    'process_noise_slope':         (1e-13,  1e-15,  1e-11,  True),
+    'process_noise_offset':        (1e-3,   1e-4,   1e-2,   True),
+    'low_loss_threshold':          (0.02,   0.,     0.05,   False),
+    'high_loss_threshold':         (0.1,    0.05,   0.3,    False),
+}
+
+SCENARIOS = ['5.1', '5.2', '5.4', '5.6']
+METRICS = ['util', 'qdelay_mean_ms', 'qdelay_p95_ms', 'latency_ms', 'loss', 'fairness']
+
+RESULT_RE = re.compile(r'tune_result scenario: (\S+)((?: \w+: \S+)+)')
+
+
+# -- Parameter space: parameters are mapped to [0, 1] for sampling and the GP
+
+def to_value(name, x):
+    _, low, high, log = PARAMS[name]
+    if log:
+        return math.exp(math.log(low) + x * (math.log(high) - math.log(low)))
+    return low + x * (high - low)
+
+def to_unit(name, value):
+    _, low, high, log = PARAMS[name]
+    if log:
+        return (math.log(value) - math.log(low)) / (math.log(high) - math.log(low))
+    return (value - low) / (high - low)
+
+def make_config(names, xs):
+    config = dict((name, PARAMS[name][0]) for name in PARAMS)
+    for name, x in zip(names, xs):
+        config[name] = to_value(name, x)
+    # The loss thresholds must stay ordered for the controller to take them
+    if config['low_loss_threshold'] > config['high_loss_threshold']:
+        config['low_loss_threshold'] = config['high_loss_threshold']
+    return config
+
+
+# -- Evaluation of one configuration on one scenario (in a worker process)
+
+def run_eval(task):
+    binary, config_id, config, scenario, seed = task
+    params = ','.join('{}={!r}'.format(k, v) for k, v in sorted(config.items()))
+    cmd = [binary, '--scenario=' + scenario, '--seed=' + str(seed), '--params=' + params]
+    try:
+        out = subprocess.check_output(cmd, stderr=subprocess.STDOUT)
+    except (subprocess.CalledProcessError, OSError) as e:
+        print('Run failed: {} ({})'.format(' '.join(cmd), e), file=sys.stderr)
+        return config_id, scenario, None
+    for line in out.decode('utf-8', 'replace').splitlines():
+        match = RESULT_RE.search(line)
+        if match:
+            fields = match.group(2).split()
+            metrics = dict((k.rstrip(':'), float(v)) for k, v in zip(fields[::2], fields[1::2]))
+            return config_id, scenario, metrics
+    print('No result in the output of: {}'.format(' '.join(cmd)), file=sys.stderr)
+    return config_id, scenario, None
+
+
+class Tuner(object):
+    def __init__(self, args):
+        self.args = args
+        self.results = []  # dicts: id, config, metrics, score
+        self.pool = multiprocessing.Pool(args.jobs)
+
+    def score(self, m):
+        a = self.args
+        return (a.w_delay * min(1., m['qdelay_p95_ms'] / a.delay_ref) +
+                a.w_util * (1. - m['util']) +
+                a.w_fair * (1. - m['fairness']))
+
+    def evaluate(self, configs):
+        'Evaluate a batch of configurations, all scenarios and seeds in parallel'
+        first = len(self.results)
+        tasks = []
+        for i, config in enumerate(configs):
+            for scenario in self.args.scenarios:
+                for seed in range(1, self.args.seeds + 1):
+                    tasks.append((self.args.binary, first + i, config, scenario, seed))
+        runs = dict((first + i, []) for i in range(len(configs)))
+        for config_id, scenario, metrics in self.pool.imap_unordered(run_eval, tasks):
+            runs[config_id].append(metrics)
+        batch = []
+        for i, config in enumerate(configs):
+            ms = runs[first + i]
+            if any(m is None for m in ms):
+                metrics, score = None, float('inf')
+            else:
+                metrics = dict((k, float(np.mean([m[k] for m in ms]))) for k in METRICS)
+                score = self.score(metrics)
+            res = {'id': first + i, 'config': config, 'metrics': metrics, 'score': score}
+            print('config {:4d}: score {:.4f} {}'.format(res['id'], score, metrics))
+            batch.append(res)
+        self.results.extend(batch)
+        return batch
+
+    def close(self):
+        self.pool.close()
+        self.pool.join()
+
+
+# -- Search strategies
+
+def grid_search(tuner, names, args):
+    axis = [i / float(args.points - 1) for i in range(args.points)] if args.points > 1 else [0.5]
+    configs = [make_config(names, xs) for xs in itertools.product(axis, repeat=len(names))]
+    tuner.evaluate(configs)
+
+def random_search(tuner, names, args, rng):
+    configs = [make_config(names, [rng.random() for _ in names]) for _ in range(args.samples)]
+    tuner.evaluate(configs)
+
+def gp_posterior(X, y, Xs, length, noise):
+    'Posterior mean and std deviation of a GP with a squared exponential kernel'
+    def kernel(A, B):
+        d = ((A[:, None, :] - B[None, :, :]) ** 2).sum(-1)
+        return np.exp(-0.5 * d / length ** 2)
+    K = kernel(X, X) + noise * np.eye(len(X))
+    L = np.linalg.cholesky(K)
+    alpha = np.linalg.solve(L.T, np.linalg.solve(L, y))
+    Ks = kernel(X, Xs)
+    mu = Ks.T.dot(alpha)
+    v = np.linalg.solve(L, Ks)
+    var = np.maximum(1. - (v ** 2).sum(0), 1e-12)
+    return mu, np.sqrt(var)
+
+def expected_improvement(mu, sigma, best):
+    'EI for minimization'
+    z = (best - mu) / sigma
+    cdf = 0.5 * (1. + np.vectorize(math.erf)(z / math.sqrt(2.)))
+    pdf = np.exp(-0.5 * z ** 2) / math.sqrt(2. * math.pi)
+    return (best - mu) * cdf + sigma * pdf
+
+def bayes_search(tuner, names, args, rng):
+    random_search(tuner, names, argparse.Namespace(samples=args.init), rng)
+    nprng = np.random.RandomState(args.seed)
+    for it in range(args.iterations):
+        done = [r for r in tuner.results if r['metrics'] is not None]
+        if len(done) < 2:
+            random_search(tuner, names, argparse.Namespace(samples=args.jobs), rng)
+            continue
+        X = np.array([[to_unit(n, r['config'][n]) for n in names] for r in done])
+        y = np.array([r['score'] for r in done])
+        y_mean, y_std = y.mean(), max(y.std(), 1e-9)
+        yn = (y - y_mean) / y_std
+        # Batch of #jobs points: "kriging believer", each pick is added to the
+        # GP with its predicted mean before picking the next one
+        batch = []
+        for _ in range(args.jobs):
+            cand = nprng.rand(args.candidates, len(names))
+            mu, sigma = gp_posterior(X, yn, cand, args.length, args.noise)
+            ei = expected_improvement(mu, sigma, yn.min())
+            best = int(np.argmax(ei))
+            batch.append(cand[best])
+            X = np.vstack([X, cand[best]])
+            yn = np.append(yn, mu[best])
+        print('bayes iteration {}/{}'.format(it + 1, args.iterations))
+        tuner.evaluate([make_config(names, xs) for xs in batch])
+
+
+# -- Output
+
+def pareto_front(results):
+    'Non-dominated results on (queuing delay, 1 - utilization, 1 - fairness)'
+    def objectives(r):
+        m = r['metrics']
+        return (m['qdelay_p95_ms'], 1. - m['util'], 1. - m['fairness'])
+    valid = [r for r in results if r['metrics'] is not None]
+    front = []
+    for r in valid:
+        o = objectives(r)
+        dominated = any(all(a <= b for a, b in zip(objectives(q), o)) and objectives(q) != o
+                        for q in valid)
+        if not dominated:
+            front.append(r)
+    return sorted(front, key=lambda r: r['score'])
+
+def save_results(results, front, outdir):
+    if not os.path.isdir(outdir):
+        os.makedirs(outdir)
+    names = sorted(PARAMS)
+    with open(os.path.join(outdir, 'results.csv'), 'w') as f:
+        writer = csv.writer(f)
+        writer.writerow(['id'] + names + METRICS + ['score'])
+        for r in results:
+            m = r['metrics'] or {}
+            writer.writerow([r['id']] + [r['config'][n] for n in names] +
+                            [m.get(k, 'NaN') for k in METRICS] + [r['score']])
+    with open(os.path.join(outdir, 'pareto.json'), 'w') as f:
+        json.dump(front, f, indent=2, sort_keys=True)
+    print('Results in {}, Pareto front ({} configurations) in {}'.format(
+        os.path.join(outdir, 'results.csv'), len(front), os.path.join(outdir, 'pareto.json')))
+
+
+def find_binary():
+    found = sorted(glob.glob('build/src/ns3-rmcat/examples/ns3*-gcc-tune-eval*'))
+    return os.path.abspath(found[0]) if found else None
+
+def main():
+    parser = argparse.ArgumentParser(description='Tune the GCC controller constants')
+    parser.add_argument('mode', choices=['grid', 'random', 'bayes'])
+    parser.add_argument('--params', default=','.join(sorted(PARAMS)),
+                        help='comma-separated parameters to tune (others keep their default)')
+    parser.add_argument('--scenarios', default=','.join(SCENARIOS))
+    parser.add_argument('--seeds', type=int, default=1, help='runs per scenario')
+    parser.add_argument('--jobs', type=int, default=multiprocessing.cpu_count())
+    parser.add_argument('--binary', default=find_binary(), help='gcc-tune-eval executable')
+    parser.add_argument('--libdir', default='build/lib', help='ns3 shared libraries')
+    parser.add_argument('--out', default='gcc-tune')
+    parser.add_argument('--seed', type=int, default=1, help='seed of the search')
+    parser.add_argument('--points', type=int, default=3, help='grid: points per parameter')
+    parser.add_argument('--samples', type=int, default=50, help='random: configurations')
+    parser.add_argument('--init', type=int, default=16, help='bayes: initial random configurations')
+    parser.add_argument('--iterations', type=int, default=8, help='bayes: batches of --jobs configurations')
+    parser.add_argument('--candidates', type=int, default=2000, help='bayes: EI candidates per pick')
+    parser.add_argument('--length', type=float, default=0.3, help='bayes: GP kernel length scale')
+    parser.add_argument('--noise', type=float, default=1e-2, help='bayes: GP noise (normalized)')
+    parser.add_argument('--w-delay', dest='w_delay', type=float, default=1.)
+    parser.add_argument('--w-util', dest='w_util', type=float, default=1.)
+    parser.add_argument('--w-fair', dest='w_fair', type=float, default=0.5)
+    parser.add_argument('--delay-ref', dest='delay_ref', type=float, default=300.,
+                        help='queuing delay (ms) counted as the worst case')
+    args = parser.parse_args()
+
+    names = [n for n in args.params.split(',') if n]
+    for n in names:
+        if n not in PARAMS:
+            parser.error('unknown parameter: {}'.format(n))
+    args.scenarios = [s for s in args.scenarios.split(',') if s]
+    if args.binary is None or not os.path.isfile(args.binary):
+        parser.error('gcc-tune-eval not found, build the examples or use --binary')
+    libdir = os.path.abspath(args.libdir)
+    os.environ['LD_LIBRARY_PATH'] = libdir + os.pathsep + os.environ.get('LD_LIBRARY_PATH', '')
+
+    rng = random.Random(args.seed)
+    tuner = Tuner(args)
+    try:
+        if args.mode == 'grid':
+            grid_search(tuner, names, args)
+        elif args.mode == 'random':
+            random_search(tuner, names, args, rng)
+        else:
+            bayes_search(tuner, names, args, rng)
+    finally:
+        tuner.close()
+
+    front = pareto_front(tuner.results)
+    save_results(tuner.results, front, args.out)
+    for r in front:
+        print('pareto {:4d}: score {:.4f} {}'.format(r['id'], r['score'], r['metrics']))
+
+if __name__ == '__main__':
+    main()